@@ -0,0 +1,315 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/AISightSubsystem.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "AI/VisibilityGridSubsystem.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Enemies/BaseEnemy.h"
+#include "HAL/IConsoleManager.h"
+#include "InstancedFoliageActor.h"
+#include "Kismet/GameplayStatics.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "RTP.h"
+
+DECLARE_CYCLE_STAT(TEXT("AI Sight Trace"), STAT_AISightTrace, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<float> CVarSightBlockerMinHeight(
+    TEXT("rtp.AI.SightBlockerMinHeight"),
+    250.0f,
+    TEXT("Instanced meshes at least this tall block AI sight, in centimeters."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSightBlockerMinWidth(
+    TEXT("rtp.AI.SightBlockerMinWidth"),
+    150.0f,
+    TEXT("Instanced meshes at least this wide on both horizontal axes block AI sight, in centimeters."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarSightConcealment(
+    TEXT("rtp.AI.SightConcealment"),
+    false,
+    TEXT("Accumulate foliage density along AI sight traces for soft concealment. Takes effect on the next classification."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSightConcealmentPerFoliage(
+    TEXT("rtp.AI.SightConcealmentPerFoliage"),
+    0.25f,
+    TEXT("Concealment added by each foliage instance an AI sight trace passes through."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorld ClassifySightFoliageCommand(
+    TEXT("rtp.AI.ClassifySightFoliage"),
+    TEXT("Reclassify the foliage and PCG instanced meshes for AI sight, e.g. after runtime PCG generation."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (UAISightSubsystem* Subsystem = World ? World->GetSubsystem<UAISightSubsystem>() : nullptr)
+        {
+            Subsystem->ClassifyWorld();
+        }
+    }));
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkSightCommand(
+    TEXT("rtp.AI.BenchmarkSight"),
+    TEXT("Trace from every enemy to the player on ECC_Visibility and ECC_AISight and compare cost and results. Usage: rtp.AI.BenchmarkSight [Iterations]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        const UAISightSubsystem* Subsystem = World ? World->GetSubsystem<UAISightSubsystem>() : nullptr;
+        const APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0);
+        if (!Subsystem || !Player)
+        {
+            return;
+        }
+        
+        const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100;
+        
+        TArray<FVector> EyeLocations;
+        TArray<const AActor*> Enemies;
+        for (TActorIterator<ABaseEnemy> It(World); It; ++It)
+        {
+            EyeLocations.Add(It->GetActorLocation() + FVector(0, 0, It->BaseEyeHeight));
+            Enemies.Add(*It);
+        }
+        
+        if (Enemies.Num() == 0)
+        {
+            UE_LOG(LogRTP, Warning, TEXT("rtp.AI.BenchmarkSight needs at least one enemy in the level"));
+            return;
+        }
+        
+        const FVector PlayerLocation = Player->GetActorLocation();
+        TBitArray<> VisibilityResults(false, Enemies.Num());
+        TBitArray<> SightResults(false, Enemies.Num());
+        
+        const double VisibilityStart = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            for (int32 Index = 0; Index < Enemies.Num(); ++Index)
+            {
+                FHitResult Hit;
+                FCollisionQueryParams Params(SCENE_QUERY_STAT(AISightBenchmark), false, Enemies[Index]);
+                const bool bHit = World->LineTraceSingleByChannel(Hit, EyeLocations[Index], PlayerLocation, ECC_Visibility, Params);
+                VisibilityResults[Index] = bHit && Hit.GetActor() != Player;
+            }
+        }
+        const double VisibilitySeconds = FPlatformTime::Seconds() - VisibilityStart;
+        
+        const double SightStart = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            for (int32 Index = 0; Index < Enemies.Num(); ++Index)
+            {
+                SightResults[Index] = Subsystem->TraceSight(EyeLocations[Index], Player, Enemies[Index]).bBlocked;
+            }
+        }
+        const double SightSeconds = FPlatformTime::Seconds() - SightStart;
+        
+        int32 NumDiffering = 0;
+        for (int32 Index = 0; Index < Enemies.Num(); ++Index)
+        {
+            NumDiffering += VisibilityResults[Index] != SightResults[Index] ? 1 : 0;
+        }
+        
+        const int32 NumTraces = Iterations * Enemies.Num();
+        UE_LOG(LogRTP, Display, TEXT("AI sight benchmark, %d traces each: ECC_Visibility %.2f us/trace, ECC_AISight %.2f us/trace (%.1fx), %d of %d enemies see the player differently"),
+            NumTraces,
+            VisibilitySeconds * 1e6 / NumTraces,
+            SightSeconds * 1e6 / NumTraces,
+            SightSeconds > 0.0 ? VisibilitySeconds / SightSeconds : 0.0,
+            NumDiffering, Enemies.Num());
+    }));
+
+const FName UAISightSubsystem::BlockerTag(TEXT("AISightBlocker"));
+const FName UAISightSubsystem::FoliageTag(TEXT("AISightFoliage"));
+
+// Tag PCG puts on the components it generates, matched by name to avoid depending on the PCG plugin
+const FName UAISightSubsystem::PCGGeneratedTag(TEXT("PCG Generated Component"));
+
+bool UAISightSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UAISightSubsystem::IsConcealmentEnabled()
+{
+    return CVarSightConcealment.GetValueOnAnyThread();
+}
+
+void UAISightSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+    
+    ClassifyWorld();
+}
+
+void UAISightSubsystem::ClassifyWorld()
+{
+    const double StartTime = FPlatformTime::Seconds();
+    
+    NumBlockers = 0;
+    NumFoliage = 0;
+    
+    // Only this world's actors, and of their instanced meshes only the scattered content
+    for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+    {
+        TInlineComponentArray<UInstancedStaticMeshComponent*> Components(*It);
+        for (UInstancedStaticMeshComponent* Component : Components)
+        {
+            if (Component->IsRegistered() && IsScatteredComponent(Component))
+            {
+                ClassifyComponent(Component);
+            }
+        }
+    }
+    
+    UE_LOG(LogRTP, Log, TEXT("AI sight: %d blocking and %d foliage instanced meshes classified in %.2f ms"),
+        NumBlockers, NumFoliage, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+bool UAISightSubsystem::IsScatteredComponent(const UInstancedStaticMeshComponent* Component)
+{
+    // Painted foliage, PCG output, or anything a designer tagged for AI sight
+    const AActor* Owner = Component->GetOwner();
+    return (Owner && Owner->IsA<AInstancedFoliageActor>())
+        || Component->ComponentHasTag(PCGGeneratedTag)
+        || Component->ComponentHasTag(BlockerTag)
+        || Component->ComponentHasTag(FoliageTag);
+}
+
+EAISightOcclusion UAISightSubsystem::Classify(const UInstancedStaticMeshComponent* Component)
+{
+    if (Component->ComponentHasTag(BlockerTag))
+    {
+        return EAISightOcclusion::Blocker;
+    }
+    if (Component->ComponentHasTag(FoliageTag))
+    {
+        return EAISightOcclusion::Foliage;
+    }
+    
+    const UStaticMesh* Mesh = Component->GetStaticMesh();
+    if (!Mesh)
+    {
+        return EAISightOcclusion::Foliage;
+    }
+    
+    // Tall meshes are trees, wide and deep ones are rocks and ruins, everything else is undergrowth
+    const FVector Size = Mesh->GetBounds().BoxExtent * 2.0 * Component->GetComponentScale().GetAbs();
+    const bool bTall = Size.Z >= CVarSightBlockerMinHeight.GetValueOnGameThread();
+    const bool bWide = FMath::Min(Size.X, Size.Y) >= CVarSightBlockerMinWidth.GetValueOnGameThread();
+    return bTall || bWide ? EAISightOcclusion::Blocker : EAISightOcclusion::Foliage;
+}
+
+void UAISightSubsystem::ClassifyComponent(UInstancedStaticMeshComponent* Component)
+{
+    if (!Component || Component->GetCollisionEnabled() == ECollisionEnabled::NoCollision)
+    {
+        return;
+    }
+    
+    if (Classify(Component) == EAISightOcclusion::Blocker)
+    {
+        NumBlockers++;
+        Component->SetCollisionResponseToChannel(ECC_AISight, ECR_Block);
+        
+        // Sight traces only test simple shapes, a mesh without any would never block
+        const UStaticMesh* Mesh = Component->GetStaticMesh();
+        const UBodySetup* BodySetup = Mesh ? Mesh->GetBodySetup() : nullptr;
+        if (BodySetup && BodySetup->AggGeom.GetElementCount() == 0)
+        {
+            UE_LOG(LogRTP, Warning, TEXT("AI sight blocker %s has no simple collision and will not block sight"), *GetNameSafe(Mesh));
+        }
+        return;
+    }
+    
+    // Only the sight channel changes, the player and physics still collide with foliage as authored
+    NumFoliage++;
+    Component->SetCollisionResponseToChannel(ECC_AISight, IsConcealmentEnabled() ? ECR_Overlap : ECR_Ignore);
+}
+
+bool UAISightSubsystem::TestGrid(TConstArrayView<FVector> Starts, TConstArrayView<FVector> Ends, TArrayView<EAISightGridResult> OutResults) const
+{
+    const UVisibilityGridSubsystem* GridSubsystem = GetWorld()->GetSubsystem<UVisibilityGridSubsystem>();
+    if (IsConcealmentEnabled() || !GridSubsystem || !GridSubsystem->IsActive())
+    {
+        return false;
+    }
+    
+    TArray<bool, TInlineAllocator<64>> Clear;
+    Clear.SetNumUninitialized(Starts.Num());
+    GridSubsystem->TestSegments(Starts, Ends, Clear);
+    
+    for (int32 Index = 0; Index < Clear.Num(); ++Index)
+    {
+        OutResults[Index] = Clear[Index] ? EAISightGridResult::Clear : EAISightGridResult::Blocked;
+    }
+    return true;
+}
+
+FAISightResult UAISightSubsystem::TraceSight(const FVector& Start, const AActor* Target, const AActor* IgnoredActor, EAISightGridResult GridResult) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_AISightTrace);
+    
+    FAISightResult Result;
+    if (!Target)
+    {
+        Result.bBlocked = true;
+        return Result;
+    }
+    
+    const UWorld* World = GetWorld();
+    const FVector End = Target->GetActorLocation();
+    
+    // Simple collision only, trunks and rocks block through their proxy shapes
+    const FCollisionQueryParams Params(SCENE_QUERY_STAT(AISight), false, IgnoredActor);
+    
+    if (!IsConcealmentEnabled())
+    {
+        // The baked grid covers static occluders, physics is only asked about dynamic ones
+        const UVisibilityGridSubsystem* GridSubsystem = World->GetSubsystem<UVisibilityGridSubsystem>();
+        if (GridResult == EAISightGridResult::Untested && GridSubsystem && GridSubsystem->IsActive())
+        {
+            GridResult = GridSubsystem->IsSegmentClear(Start, End) ? EAISightGridResult::Clear : EAISightGridResult::Blocked;
+        }
+        
+        // Voxels are conservative: a ray grazing the landscape or passing a wall within a voxel reads as blocked,
+        // so a blocked grid result only sends the ray to the full trace below
+        if (GridResult == EAISightGridResult::Clear)
+        {
+            FCollisionQueryParams DynamicParams = Params;
+            DynamicParams.MobilityType = EQueryMobilityType::Dynamic;
+            
+            FHitResult Hit;
+            const bool bHit = World->LineTraceSingleByChannel(Hit, Start, End, ECC_AISight, DynamicParams);
+            Result.bBlocked = bHit && Hit.GetActor() != Target;
+            return Result;
+        }
+        
+        FHitResult Hit;
+        const bool bHit = World->LineTraceSingleByChannel(Hit, Start, End, ECC_AISight, Params);
+        Result.bBlocked = bHit && Hit.GetActor() != Target;
+        return Result;
+    }
+    
+    // Foliage overlaps the channel, so the multi trace returns every plant in front of the first blocker
+    TArray<FHitResult> Hits;
+    World->LineTraceMultiByChannel(Hits, Start, End, ECC_AISight, Params);
+    
+    const float ConcealmentPerFoliage = CVarSightConcealmentPerFoliage.GetValueOnAnyThread();
+    for (const FHitResult& Hit : Hits)
+    {
+        if (Hit.bBlockingHit)
+        {
+            Result.bBlocked |= Hit.GetActor() != Target;
+        }
+        else
+        {
+            Result.Concealment += ConcealmentPerFoliage;
+        }
+    }
+    
+    return Result;
+}
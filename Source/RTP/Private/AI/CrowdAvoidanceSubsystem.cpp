@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/CrowdAvoidanceSubsystem.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/EnemyMovementComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "RTP.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Avoidance"), STAT_CrowdAvoidance, STATGROUP_RTPAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Agents"), STAT_CrowdAgents, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<bool> CVarCrowdAvoidance(
+    TEXT("rtp.AI.CrowdAvoidance"),
+    true,
+    TEXT("Steer enemies around each other with batched velocity obstacles and let enemy capsules pass through each other."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCrowdNeighborRadius(
+    TEXT("rtp.AI.CrowdNeighborRadius"),
+    500.0f,
+    TEXT("Enemies within this distance of each other avoid each other."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCrowdMaxNeighbors(
+    TEXT("rtp.AI.CrowdMaxNeighbors"),
+    10,
+    TEXT("Closest enemies each enemy avoids."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCrowdTimeHorizon(
+    TEXT("rtp.AI.CrowdTimeHorizon"),
+    1.0f,
+    TEXT("Seconds ahead in which enemies avoid colliding with each other."),
+    ECVF_Default);
+
+static FAutoConsoleCommand BenchmarkCrowdCommand(
+    TEXT("rtp.AI.BenchmarkCrowd"),
+    TEXT("Simulate enemies converging on one target with and without crowd avoidance and compare cost and overlaps. Usage: rtp.AI.BenchmarkCrowd [Count] [Steps]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        const int32 Count = Args.Num() > 0 ? FMath::Max(2, FCString::Atoi(*Args[0])) : 200;
+        const int32 Steps = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 300;
+        constexpr float DeltaTime = 1.0f / 30.0f;
+        constexpr float StartRadius = 3000.0f;
+        constexpr float ArriveRadius = 150.0f;
+        
+        const FCrowdAvoidanceSettings Settings = UCrowdAvoidanceSubsystem::GetSettings();
+        
+        auto Run = [&](bool bAvoid, double& OutSolveSeconds, int32& OutOverlaps, float& OutMaxPenetration)
+        {
+            // Evenly spread on a ring around the target, all heading for its center
+            TArray<FCrowdAgent> Agents;
+            Agents.SetNum(Count);
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                const float Angle = UE_TWO_PI * Index / Count;
+                Agents[Index].Position = FVector2f(FMath::Cos(Angle), FMath::Sin(Angle)) * StartRadius;
+                Agents[Index].MaxSpeed = 450.0f;
+            }
+            
+            FCrowdAvoidance Solver;
+            TArray<FVector2f> Velocities;
+            OutSolveSeconds = 0.0;
+            
+            for (int32 Step = 0; Step < Steps; ++Step)
+            {
+                for (FCrowdAgent& Agent : Agents)
+                {
+                    const float Distance = Agent.Position.Size();
+                    Agent.PreferredVelocity = Distance > ArriveRadius ? -Agent.Position / Distance * Agent.MaxSpeed : FVector2f::ZeroVector;
+                }
+                
+                if (bAvoid)
+                {
+                    const double SolveStart = FPlatformTime::Seconds();
+                    Solver.Solve(Agents, Settings, DeltaTime, Velocities);
+                    OutSolveSeconds += FPlatformTime::Seconds() - SolveStart;
+                }
+                
+                for (int32 Index = 0; Index < Count; ++Index)
+                {
+                    FCrowdAgent& Agent = Agents[Index];
+                    Agent.Velocity = bAvoid ? Velocities[Index] : Agent.PreferredVelocity;
+                    Agent.Position += Agent.Velocity * DeltaTime;
+                }
+            }
+            
+            OutOverlaps = 0;
+            OutMaxPenetration = 0.0f;
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                for (int32 Other = Index + 1; Other < Count; ++Other)
+                {
+                    const float Penetration = Agents[Index].Radius + Agents[Other].Radius - FVector2f::Distance(Agents[Index].Position, Agents[Other].Position);
+                    if (Penetration > 1.0f)
+                    {
+                        ++OutOverlaps;
+                        OutMaxPenetration = FMath::Max(OutMaxPenetration, Penetration);
+                    }
+                }
+            }
+        };
+        
+        double SolveSeconds = 0.0;
+        int32 AvoidOverlaps = 0;
+        int32 DirectOverlaps = 0;
+        float AvoidPenetration = 0.0f;
+        float DirectPenetration = 0.0f;
+        Run(false, SolveSeconds, DirectOverlaps, DirectPenetration);
+        Run(true, SolveSeconds, AvoidOverlaps, AvoidPenetration);
+        
+        UE_LOG(LogRTP, Display, TEXT("Crowd benchmark, %d agents over %d steps: avoidance %.3f ms/step (%.2f us/agent), overlapping pairs %d (max %.0f cm) vs %d (max %.0f cm) without avoidance"),
+            Count, Steps, SolveSeconds * 1000.0 / Steps, SolveSeconds * 1.e6 / (Steps * Count),
+            AvoidOverlaps, AvoidPenetration, DirectOverlaps, DirectPenetration);
+    }));
+
+bool UCrowdAvoidanceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UCrowdAvoidanceSubsystem::IsEnabled()
+{
+    return CVarCrowdAvoidance.GetValueOnGameThread();
+}
+
+FCrowdAvoidanceSettings UCrowdAvoidanceSubsystem::GetSettings()
+{
+    FCrowdAvoidanceSettings Settings;
+    Settings.NeighborRadius = FMath::Max(CVarCrowdNeighborRadius.GetValueOnAnyThread(), 100.0f);
+    Settings.MaxNeighbors = FMath::Clamp(CVarCrowdMaxNeighbors.GetValueOnAnyThread(), 1, 32);
+    Settings.TimeHorizon = FMath::Max(CVarCrowdTimeHorizon.GetValueOnAnyThread(), 0.1f);
+    return Settings;
+}
+
+void UCrowdAvoidanceSubsystem::Deinitialize()
+{
+    DEC_DWORD_STAT_BY(STAT_CrowdAgents, Agents.Num());
+    
+    Members.Reset();
+    Agents.Reset();
+    AgentMovements.Reset();
+    Velocities.Reset();
+    
+    Super::Deinitialize();
+}
+
+TStatId UCrowdAvoidanceSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UCrowdAvoidanceSubsystem, STATGROUP_Tickables);
+}
+
+void UCrowdAvoidanceSubsystem::SetEnemyCollisionRelaxed(UEnemyMovementComponent* Movement, bool bRelaxed)
+{
+    if (const ACharacter* Character = Movement->GetCharacterOwner())
+    {
+        Character->GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Enemy, bRelaxed ? ECR_Ignore : ECR_Block);
+    }
+}
+
+void UCrowdAvoidanceSubsystem::RegisterAgent(UEnemyMovementComponent* Movement)
+{
+    if (!Movement || Members.Contains(Movement))
+    {
+        return;
+    }
+    
+    Members.Add(Movement);
+    SetEnemyCollisionRelaxed(Movement, bAppliedEnabled);
+}
+
+void UCrowdAvoidanceSubsystem::UnregisterAgent(UEnemyMovementComponent* Movement)
+{
+    if (Members.RemoveSwap(Movement) > 0)
+    {
+        Movement->ClearAvoidanceVelocity();
+        SetEnemyCollisionRelaxed(Movement, false);
+    }
+}
+
+void UCrowdAvoidanceSubsystem::Tick(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_CrowdAvoidance);
+    
+    Super::Tick(DeltaTime);
+    
+    const bool bEnabled = IsEnabled();
+    if (bEnabled != bAppliedEnabled)
+    {
+        bAppliedEnabled = bEnabled;
+        for (const TWeakObjectPtr<UEnemyMovementComponent>& Member : Members)
+        {
+            if (UEnemyMovementComponent* Movement = Member.Get())
+            {
+                Movement->ClearAvoidanceVelocity();
+                SetEnemyCollisionRelaxed(Movement, bEnabled);
+            }
+        }
+    }
+    
+    if (!bEnabled)
+    {
+        return;
+    }
+    
+    Agents.Reset();
+    AgentMovements.Reset();
+    for (const TWeakObjectPtr<UEnemyMovementComponent>& Member : Members)
+    {
+        UEnemyMovementComponent* Movement = Member.Get();
+        if (!Movement || !Movement->UpdatedComponent || !Movement->IsMovingOnGround())
+        {
+            continue;
+        }
+        
+        const FVector Location = Movement->UpdatedComponent->GetComponentLocation();
+        const ACharacter* Character = Movement->GetCharacterOwner();
+        
+        // Enemies standing still, attacking or dormant are obstacles the moving ones steer around
+        FCrowdAgent& Agent = Agents.AddDefaulted_GetRef();
+        Agent.Position = FVector2f(Location.X, Location.Y);
+        Agent.Velocity = FVector2f(Movement->Velocity.X, Movement->Velocity.Y);
+        Agent.PreferredVelocity = Movement->GetPreferredVelocity();
+        Agent.Radius = Character ? Character->GetCapsuleComponent()->GetScaledCapsuleRadius() : Agent.Radius;
+        Agent.MaxSpeed = Movement->GetMaxSpeed();
+        Agent.bResponsive = Movement->IsComponentTickEnabled() && Movement->HasPreferredVelocity();
+        AgentMovements.Add(Movement);
+    }
+    
+    Solver.Solve(Agents, GetSettings(), DeltaTime, Velocities);
+    
+    for (int32 Index = 0; Index < Agents.Num(); ++Index)
+    {
+        if (Agents[Index].bResponsive)
+        {
+            AgentMovements[Index]->SetAvoidanceVelocity(Velocities[Index]);
+        }
+        else
+        {
+            AgentMovements[Index]->ClearAvoidanceVelocity();
+        }
+    }
+    
+    SET_DWORD_STAT(STAT_CrowdAgents, Agents.Num());
+}
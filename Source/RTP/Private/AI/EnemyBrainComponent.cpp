@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyBrainComponent.h"
+#include "AI/EnemyStateTreeSchema.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "StateTree.h"
+#include "StateTreeExecutionContext.h"
+#include "HAL/IConsoleManager.h"
+
+UE_DEFINE_GAMEPLAY_TAG_COMMENT(TAG_AI_Enemy_StateChanged, "AI.Enemy.StateChanged", "Sent to an enemy brain whenever the enemy's state changes");
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Brain Tree Ticks"), STAT_EnemyBrainTicks, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<bool> CVarStateTreeBrain(
+    TEXT("rtp.AI.StateTreeBrain"),
+    true,
+    TEXT("Drive enemies that have a brain StateTree from the tree instead of the hand-written decision rules."),
+    ECVF_Default);
+
+UEnemyBrainComponent::UEnemyBrainComponent()
+{
+    // Advanced by the enemy's decision update, never by the component tick
+    PrimaryComponentTick.bCanEverTick = false;
+}
+
+bool UEnemyBrainComponent::IsEnabled()
+{
+    return CVarStateTreeBrain.GetValueOnGameThread();
+}
+
+void UEnemyBrainComponent::SetEnabled(bool bEnabled)
+{
+    IConsoleVariable* Variable = CVarStateTreeBrain.AsVariable();
+    Variable->Set(bEnabled, static_cast<EConsoleVariableFlags>(Variable->GetFlags() & ECVF_SetByMask));
+}
+
+void UEnemyBrainComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    if (!StateTree)
+    {
+        return;
+    }
+
+    FStateTreeExecutionContext Context(*GetOwner(), *StateTree, InstanceData);
+    if (SetContextRequirements(Context))
+    {
+        bRunning = Context.Start() == EStateTreeRunStatus::Running;
+    }
+
+    // The tree starts in its first state, the first update moves it to the enemy's
+    NotifyStateChanged();
+}
+
+void UEnemyBrainComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (bRunning)
+    {
+        FStateTreeExecutionContext Context(*GetOwner(), *StateTree, InstanceData);
+        if (SetContextRequirements(Context))
+        {
+            Context.Stop();
+        }
+        bRunning = false;
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void UEnemyBrainComponent::UpdateBrain(float DeltaTime)
+{
+    // Idle, investigating, attacking, stunned and dead enemies cost nothing until their state changes
+    if (!bRunning || (!bStateChangePending && !bNeedsTick))
+    {
+        return;
+    }
+
+    bStateChangePending = false;
+
+    FStateTreeExecutionContext Context(*GetOwner(), *StateTree, InstanceData);
+    if (SetContextRequirements(Context))
+    {
+        INC_DWORD_STAT(STAT_EnemyBrainTicks);
+        Context.Tick(DeltaTime);
+    }
+}
+
+void UEnemyBrainComponent::NotifyStateChanged()
+{
+    // The tree re-selects from the enemy's current state, so one pending event covers any number of changes
+    if (bRunning && !bStateChangePending)
+    {
+        InstanceData.GetMutableEventQueue().SendEvent(this, TAG_AI_Enemy_StateChanged);
+        bStateChangePending = true;
+    }
+}
+
+bool UEnemyBrainComponent::SetContextRequirements(FStateTreeExecutionContext& Context)
+{
+    if (!Context.IsValid())
+    {
+        return false;
+    }
+
+    Context.SetContextDataByName(UEnemyStateTreeSchema::EnemyContextName, FStateTreeDataView(GetOwner()));
+    Context.SetCollectExternalDataCallback(FOnCollectStateTreeExternalData::CreateUObject(this, &UEnemyBrainComponent::CollectExternalData));
+    return true;
+}
+
+bool UEnemyBrainComponent::CollectExternalData(const FStateTreeExecutionContext& Context, const UStateTree* Tree,
+    TArrayView<const FStateTreeExternalDataDesc> ExternalDataDescs, TArrayView<FStateTreeDataView> OutDataViews) const
+{
+    for (int32 Index = 0; Index < ExternalDataDescs.Num(); ++Index)
+    {
+        const UStruct* Struct = ExternalDataDescs[Index].Struct;
+        if (!Struct)
+        {
+            continue;
+        }
+
+        if (Struct->IsChildOf(ABaseEnemy::StaticClass()))
+        {
+            OutDataViews[Index] = FStateTreeDataView(GetOwner());
+        }
+        else if (Struct->IsChildOf(UEnemyBrainComponent::StaticClass()))
+        {
+            OutDataViews[Index] = FStateTreeDataView(const_cast<UEnemyBrainComponent*>(this));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemySpatialHash.h"
+
+FEnemySpatialHash::FEnemySpatialHash(float InCellSize)
+{
+    SetCellSize(InCellSize);
+}
+
+void FEnemySpatialHash::SetCellSize(float InCellSize)
+{
+    CellSize = FMath::Max(InCellSize, 100.0f);
+    InvCellSize = 1.0f / CellSize;
+    Cells.Reset();
+    NumEntries = 0;
+}
+
+void FEnemySpatialHash::Reset()
+{
+    for (TPair<FIntPoint, TArray<FEntry>>& Cell : Cells)
+    {
+        Cell.Value.Reset();
+    }
+    NumEntries = 0;
+}
+
+FIntPoint FEnemySpatialHash::GetCell(const FVector& Location) const
+{
+    return FIntPoint(FMath::FloorToInt32(Location.X * InvCellSize), FMath::FloorToInt32(Location.Y * InvCellSize));
+}
+
+void FEnemySpatialHash::Add(ABaseEnemy* Enemy, const FVector& Location)
+{
+    Cells.FindOrAdd(GetCell(Location)).Add({ Enemy, Location });
+    NumEntries++;
+}
+
+void FEnemySpatialHash::Gather(const FVector& Location, float Radius, TArray<ABaseEnemy*>& OutEnemies) const
+{
+    const FIntPoint MinCell = GetCell(Location - FVector(Radius));
+    const FIntPoint MaxCell = GetCell(Location + FVector(Radius));
+    const float RadiusSquared = Radius * Radius;
+
+    for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+    {
+        for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+        {
+            const TArray<FEntry>* Cell = Cells.Find(FIntPoint(CellX, CellY));
+            if (!Cell)
+            {
+                continue;
+            }
+
+            for (const FEntry& Entry : *Cell)
+            {
+                if (FVector::DistSquared(Entry.Location, Location) <= RadiusSquared)
+                {
+                    OutEnemies.Add(Entry.Enemy);
+                }
+            }
+        }
+    }
+}
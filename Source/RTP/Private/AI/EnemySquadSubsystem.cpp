@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemySquadSubsystem.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "AI/NoiseSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "RTP.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Squad Alerts"), STAT_SquadAlerts, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<bool> CVarSquadsEnable(
+    TEXT("rtp.AI.Squads"),
+    true,
+    TEXT("Share player sightings between squad members and alert nearby members."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSquadAlertRadius(
+    TEXT("rtp.AI.SquadAlertRadius"),
+    2000.0f,
+    TEXT("Squad mates within this distance of a member that saw or heard the player are alerted, in centimeters."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSquadAlertInterval(
+    TEXT("rtp.AI.SquadAlertInterval"),
+    1.0f,
+    TEXT("Shortest time between two alerts of the same squad, in seconds."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSquadSightingLifetime(
+    TEXT("rtp.AI.SquadSightingLifetime"),
+    0.25f,
+    TEXT("How long a shared sighting lets chasing squad mates skip their own sight traces, in seconds."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSquadRegionSize(
+    TEXT("rtp.AI.SquadRegionSize"),
+    4000.0f,
+    TEXT("Enemies without a squad name share memory with the others that spawned in the same square region of this size, in centimeters."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorld DumpSquadsCommand(
+    TEXT("rtp.AI.DumpSquads"),
+    TEXT("Log every enemy squad and its shared player memory."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (const UEnemySquadSubsystem* Subsystem = World ? World->GetSubsystem<UEnemySquadSubsystem>() : nullptr)
+        {
+            Subsystem->LogSquads();
+        }
+    }));
+
+bool UEnemySquadSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEnemySquadSubsystem::Deinitialize()
+{
+    Squads.Empty();
+    SquadIndices.Empty();
+    Super::Deinitialize();
+}
+
+bool UEnemySquadSubsystem::IsEnabled()
+{
+    return CVarSquadsEnable.GetValueOnGameThread();
+}
+
+int32 UEnemySquadSubsystem::JoinSquad(const ABaseEnemy* Enemy)
+{
+    FName Name = Enemy->GetSquadName();
+    if (Name.IsNone())
+    {
+        const float RegionSize = FMath::Max(CVarSquadRegionSize.GetValueOnGameThread(), 100.0f);
+        const FVector Location = Enemy->GetActorLocation();
+        Name = *FString::Printf(TEXT("Region_%d_%d"), FMath::FloorToInt32(Location.X / RegionSize), FMath::FloorToInt32(Location.Y / RegionSize));
+    }
+    
+    if (const int32* SquadIndex = SquadIndices.Find(Name))
+    {
+        return *SquadIndex;
+    }
+    
+    const int32 SquadIndex = Squads.AddDefaulted();
+    Squads[SquadIndex].Name = Name;
+    SquadIndices.Add(Name, SquadIndex);
+    return SquadIndex;
+}
+
+void UEnemySquadSubsystem::ReportPlayer(ABaseEnemy* Observer, APawn* Player, const FVector& Location, bool bSeen)
+{
+    if (!IsEnabled() || !Squads.IsValidIndex(Observer->GetSquadIndex()))
+    {
+        return;
+    }
+    
+    const int32 SquadIndex = Observer->GetSquadIndex();
+    FSquadMemory& Squad = Squads[SquadIndex];
+    const double Now = GetWorld()->GetTimeSeconds();
+    
+    Squad.LastKnownPlayerLocation = Location;
+    if (bSeen)
+    {
+        Squad.SightingFreshUntil = Now + CVarSquadSightingLifetime.GetValueOnGameThread();
+    }
+    
+    if (Now < Squad.NextAlertTime)
+    {
+        return;
+    }
+    Squad.NextAlertTime = Now + CVarSquadAlertInterval.GetValueOnGameThread();
+    
+    UNoiseSubsystem* NoiseSubsystem = GetWorld()->GetSubsystem<UNoiseSubsystem>();
+    if (!NoiseSubsystem)
+    {
+        return;
+    }
+    
+    // Alerted enemies react as if they had perceived the player themselves, without alerting in turn
+    NearbyEnemies.Reset();
+    NoiseSubsystem->GatherEnemiesInRadius(Observer->GetActorLocation(), CVarSquadAlertRadius.GetValueOnGameThread(), NearbyEnemies);
+    for (ABaseEnemy* Enemy : NearbyEnemies)
+    {
+        if (Enemy != Observer && Enemy->GetSquadIndex() == SquadIndex && !Enemy->IsDead())
+        {
+            INC_DWORD_STAT(STAT_SquadAlerts);
+            Enemy->ReceiveSquadAlert(Player, Location, bSeen);
+        }
+    }
+}
+
+void UEnemySquadSubsystem::LogSquads() const
+{
+    const double Now = GetWorld()->GetTimeSeconds();
+    UE_LOG(LogRTP, Log, TEXT("%d enemy squads"), Squads.Num());
+    for (const FSquadMemory& Squad : Squads)
+    {
+        UE_LOG(LogRTP, Log, TEXT("  %s: last known player location %s, sighting %s"),
+            *Squad.Name.ToString(), *Squad.LastKnownPlayerLocation.ToCompactString(), Now < Squad.SightingFreshUntil ? TEXT("fresh") : TEXT("stale"));
+    }
+}
+
+bool UEnemySquadSubsystem::HasFreshSighting(int32 SquadIndex, double WorldTime) const
+{
+    return Squads.IsValidIndex(SquadIndex) && WorldTime < Squads[SquadIndex].SightingFreshUntil;
+}
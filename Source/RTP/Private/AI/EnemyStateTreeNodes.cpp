@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyStateTreeNodes.h"
+#include "AI/EnemyBrainComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "StateTreeExecutionContext.h"
+#include "StateTreeLinker.h"
+
+bool FEnemyStateCondition::Link(FStateTreeLinker& Linker)
+{
+    Linker.LinkExternalData(EnemyHandle);
+    return true;
+}
+
+bool FEnemyStateCondition::TestCondition(FStateTreeExecutionContext& Context) const
+{
+    return (Context.GetExternalData(EnemyHandle).GetEnemyState() == State) != bInvert;
+}
+
+bool FEnemySeesPlayerCondition::Link(FStateTreeLinker& Linker)
+{
+    Linker.LinkExternalData(EnemyHandle);
+    return true;
+}
+
+bool FEnemySeesPlayerCondition::TestCondition(FStateTreeExecutionContext& Context) const
+{
+    const ABaseEnemy& Enemy = Context.GetExternalData(EnemyHandle);
+    return Enemy.HasLineOfSightTo(UGameplayStatics::GetPlayerPawn(&Enemy, 0));
+}
+
+bool FEnemyCanAttackCondition::Link(FStateTreeLinker& Linker)
+{
+    Linker.LinkExternalData(EnemyHandle);
+    return true;
+}
+
+bool FEnemyCanAttackCondition::TestCondition(FStateTreeExecutionContext& Context) const
+{
+    const ABaseEnemy& Enemy = Context.GetExternalData(EnemyHandle);
+    return Enemy.CanAttack(UGameplayStatics::GetPlayerPawn(&Enemy, 0));
+}
+
+FEnemyChaseTask::FEnemyChaseTask()
+{
+    // The enemy's own state change event re-selects this state, which must not resume the chase again
+    bShouldStateChangeOnReselect = false;
+}
+
+bool FEnemyChaseTask::Link(FStateTreeLinker& Linker)
+{
+    Linker.LinkExternalData(EnemyHandle);
+    Linker.LinkExternalData(BrainHandle);
+    return true;
+}
+
+EStateTreeRunStatus FEnemyChaseTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+    Context.GetExternalData(BrainHandle).SetNeedsTick(true);
+
+    // Selected by the tree rather than by a state change, i.e. the player was seen again while investigating
+    ABaseEnemy& Enemy = Context.GetExternalData(EnemyHandle);
+    APawn* Player = UGameplayStatics::GetPlayerPawn(&Enemy, 0);
+    if (Player && Enemy.GetEnemyState() != EEnemyState::Chasing)
+    {
+        Enemy.ResumeChase(Player);
+    }
+    return EStateTreeRunStatus::Running;
+}
+
+void FEnemyChaseTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+    Context.GetExternalData(BrainHandle).SetNeedsTick(false);
+}
+
+EStateTreeRunStatus FEnemyChaseTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
+{
+    ABaseEnemy& Enemy = Context.GetExternalData(EnemyHandle);
+    APawn* Player = UGameplayStatics::GetPlayerPawn(&Enemy, 0);
+
+    // Tasks tick before transitions, an enemy about to attack does not move this update
+    if (!Player || Enemy.CanAttack(Player))
+    {
+        return EStateTreeRunStatus::Running;
+    }
+
+    // A squad mate's sighting saves the trace and has already been reported
+    const bool bSquadSeesPlayer = Enemy.DoesSquadSeePlayer();
+    if (bSquadSeesPlayer || Enemy.HasLineOfSightTo(Player))
+    {
+        Enemy.PursuePlayer(Player, !bSquadSeesPlayer);
+    }
+    else
+    {
+        Enemy.PursueLastKnownLocation();
+    }
+    return EStateTreeRunStatus::Running;
+}
+
+FEnemyAttackTask::FEnemyAttackTask()
+{
+    // Only the swing's own state change re-selects this state, which must not attack again
+    bShouldCallTick = false;
+    bShouldStateChangeOnReselect = false;
+}
+
+bool FEnemyAttackTask::Link(FStateTreeLinker& Linker)
+{
+    Linker.LinkExternalData(EnemyHandle);
+    Linker.LinkExternalData(BrainHandle);
+    return true;
+}
+
+EStateTreeRunStatus FEnemyAttackTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+    // Already attacking when selected by the state change event of an attack started outside the tree
+    ABaseEnemy& Enemy = Context.GetExternalData(EnemyHandle);
+    if (Enemy.GetEnemyState() != EEnemyState::Attacking)
+    {
+        Enemy.PerformAttack();
+    }
+
+    if (Enemy.GetEnemyState() != EEnemyState::Attacking)
+    {
+        // Refused, the failure transition has to run on the next update
+        Context.GetExternalData(BrainHandle).SetNeedsTick(true);
+        return EStateTreeRunStatus::Failed;
+    }
+    return EStateTreeRunStatus::Running;
+}
+
+void FEnemyAttackTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+    Context.GetExternalData(BrainHandle).SetNeedsTick(false);
+}
+
+FEnemyWatchTask::FEnemyWatchTask()
+{
+    bShouldCallTick = false;
+    bShouldStateChangeOnReselect = false;
+}
+
+bool FEnemyWatchTask::Link(FStateTreeLinker& Linker)
+{
+    Linker.LinkExternalData(BrainHandle);
+    return true;
+}
+
+EStateTreeRunStatus FEnemyWatchTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+    Context.GetExternalData(BrainHandle).SetNeedsTick(true);
+    return EStateTreeRunStatus::Running;
+}
+
+void FEnemyWatchTask::ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+    Context.GetExternalData(BrainHandle).SetNeedsTick(false);
+}
+
+FEnemyHoldStateTask::FEnemyHoldStateTask()
+{
+    bShouldCallTick = false;
+}
+
+EStateTreeRunStatus FEnemyHoldStateTask::EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const
+{
+    return EStateTreeRunStatus::Running;
+}
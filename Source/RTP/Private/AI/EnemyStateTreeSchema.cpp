@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyStateTreeSchema.h"
+#include "AI/EnemyBrainComponent.h"
+#include "Enemies/BaseEnemy.h"
+#include "StateTreeConditionBase.h"
+#include "StateTreeEvaluatorBase.h"
+#include "StateTreeTaskBase.h"
+
+const FName UEnemyStateTreeSchema::EnemyContextName(TEXT("Enemy"));
+
+UEnemyStateTreeSchema::UEnemyStateTreeSchema()
+{
+    ContextDataDescs.Emplace(EnemyContextName, ABaseEnemy::StaticClass(), FGuid(0x7E3A1C52, 0x4B9D4F10, 0x9A6E2D83, 0x5C1F7B04));
+}
+
+bool UEnemyStateTreeSchema::IsStructAllowed(const UScriptStruct* InScriptStruct) const
+{
+    return InScriptStruct->IsChildOf(FStateTreeConditionCommonBase::StaticStruct())
+        || InScriptStruct->IsChildOf(FStateTreeEvaluatorCommonBase::StaticStruct())
+        || InScriptStruct->IsChildOf(FStateTreeTaskCommonBase::StaticStruct());
+}
+
+bool UEnemyStateTreeSchema::IsClassAllowed(const UClass* InClass) const
+{
+    return IsChildOfBlueprintBase(InClass);
+}
+
+bool UEnemyStateTreeSchema::IsExternalItemAllowed(const UStruct& InStruct) const
+{
+    // Only what UEnemyBrainComponent knows how to provide
+    return InStruct.IsChildOf(ABaseEnemy::StaticClass()) || InStruct.IsChildOf(UEnemyBrainComponent::StaticClass());
+}
@@ -0,0 +1,662 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyUpdateSubsystem.h"
+#include "AI/AISightSubsystem.h"
+#include "AI/EnemyBrainComponent.h"
+#include "Enemies/BaseEnemy.h"
+#include "Enemies/MovementLODSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/ParallelFor.h"
+#include "RTP.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Decision Pass"), STAT_EnemyDecisionPass, STATGROUP_RTPAI);
+DECLARE_CYCLE_STAT(TEXT("Enemy Decide Phase"), STAT_EnemyDecidePhase, STATGROUP_RTPAI);
+DECLARE_CYCLE_STAT(TEXT("Enemy Apply Phase"), STAT_EnemyApplyPhase, STATGROUP_RTPAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Updates"), STAT_EnemyUpdates, STATGROUP_RTPAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Registered Enemies"), STAT_RegisteredEnemies, STATGROUP_RTPAI);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Max Update Latency (s)"), STAT_MaxUpdateLatency, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<float> CVarEnemyUpdateBudgetMs(
+    TEXT("rtp.AI.UpdateBudgetMs"),
+    1.5f,
+    TEXT("Time budget per frame for enemy decision updates, in milliseconds."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarEnemyMinUpdatesPerFrame(
+    TEXT("rtp.AI.MinUpdatesPerFrame"),
+    1,
+    TEXT("Enemies updated every frame even when the budget is already spent, so the rotation never stalls."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarEnemyParallelDecide(
+    TEXT("rtp.AI.ParallelDecide"),
+    true,
+    TEXT("Run the enemy decide phase across worker threads and apply the results on the game thread."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarEnemyFixedStep(
+    TEXT("rtp.AI.FixedStep"),
+    true,
+    TEXT("Step enemy decisions at fixed per-tier rates instead of once per scheduled frame."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarEnemyStepRateCombat(
+    TEXT("rtp.AI.StepRateCombat"),
+    20.0f,
+    TEXT("Decision steps per second for chasing and attacking enemies."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarEnemyStepRate(
+    TEXT("rtp.AI.StepRate"),
+    10.0f,
+    TEXT("Decision steps per second for enemies in the full movement LOD tier."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarEnemyStepRateReduced(
+    TEXT("rtp.AI.StepRateReduced"),
+    5.0f,
+    TEXT("Decision steps per second for enemies in the reduced movement LOD tier."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarEnemyStepRateDormant(
+    TEXT("rtp.AI.StepRateDormant"),
+    2.0f,
+    TEXT("Decision steps per second for enemies in the dormant movement LOD tier."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarEnemyMaxCatchUpSteps(
+    TEXT("rtp.AI.MaxCatchUpSteps"),
+    2,
+    TEXT("Most decision steps an enemy runs in one frame to catch up, older simulated time is dropped."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorld DumpEnemyUpdateStatsCommand(
+    TEXT("rtp.AI.DumpUpdateStats"),
+    TEXT("Log enemy update scheduler stats and the worst per-enemy update latencies."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (const UEnemyUpdateSubsystem* Subsystem = World ? World->GetSubsystem<UEnemyUpdateSubsystem>() : nullptr)
+        {
+            Subsystem->DumpStats();
+        }
+    }));
+
+static FAutoConsoleCommandWithWorld VerifyParallelDecideCommand(
+    TEXT("rtp.AI.VerifyParallelDecide"),
+    TEXT("Run every enemy's decide phase serially and in parallel and report any difference."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (const UEnemyUpdateSubsystem* Subsystem = World ? World->GetSubsystem<UEnemyUpdateSubsystem>() : nullptr)
+        {
+            Subsystem->VerifyParallelDeterminism();
+        }
+    }));
+
+static FAutoConsoleCommandWithWorldAndArgs MeasureEnemyBrainCommand(
+    TEXT("rtp.AI.MeasureBrain"),
+    TEXT("Average the enemy decision pass over N frames on the hand-written rules, then N frames on the StateTree brains. Usage: rtp.AI.MeasureBrain [Frames]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        if (UEnemyUpdateSubsystem* Subsystem = World ? World->GetSubsystem<UEnemyUpdateSubsystem>() : nullptr)
+        {
+            Subsystem->StartBrainMeasurement(Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 300);
+        }
+    }));
+
+namespace
+{
+    bool IsInCombat(const ABaseEnemy* Enemy)
+    {
+        const EEnemyState State = Enemy->GetEnemyState();
+        return State == EEnemyState::Chasing || State == EEnemyState::Attacking;
+    }
+}
+
+bool UEnemyUpdateSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEnemyUpdateSubsystem::Deinitialize()
+{
+    if (BrainMeasurement.FramesRemaining > 0)
+    {
+        UEnemyBrainComponent::SetEnabled(BrainMeasurement.bWasEnabled);
+    }
+
+    Entries.Reset();
+    Super::Deinitialize();
+}
+
+TStatId UEnemyUpdateSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyUpdateSubsystem, STATGROUP_Tickables);
+}
+
+void UEnemyUpdateSubsystem::RegisterEnemy(ABaseEnemy* Enemy)
+{
+    if (!Enemy)
+    {
+        return;
+    }
+
+    const double WorldTime = GetWorld()->GetTimeSeconds();
+
+    FScheduledEnemy& Entry = Entries.AddDefaulted_GetRef();
+    Entry.Enemy = Enemy;
+    Entry.LastUpdateTime = WorldTime;
+
+    // Spread the first steps of enemies spawned together over an interval
+    Entry.StepInterval = GetStepInterval(Enemy, IsInCombat(Enemy), GetWorld()->GetSubsystem<UMovementLODSubsystem>());
+    Entry.Clock.Reset(WorldTime, Entry.StepInterval, (GetTypeHash(Enemy->GetFName()) & 0xffff) / 65536.0f);
+}
+
+float UEnemyUpdateSubsystem::GetStepInterval(const ABaseEnemy* Enemy, bool bCombat, const UMovementLODSubsystem* MovementLOD)
+{
+    float Rate = CVarEnemyStepRate.GetValueOnGameThread();
+    if (bCombat)
+    {
+        Rate = CVarEnemyStepRateCombat.GetValueOnGameThread();
+    }
+    else if (MovementLOD)
+    {
+        switch (MovementLOD->GetMovementLOD(Enemy))
+        {
+            case EEnemyMovementLOD::Reduced:
+                Rate = CVarEnemyStepRateReduced.GetValueOnGameThread();
+                break;
+            case EEnemyMovementLOD::Dormant:
+                Rate = CVarEnemyStepRateDormant.GetValueOnGameThread();
+                break;
+            default:
+                break;
+        }
+    }
+
+    return 1.0f / FMath::Max(Rate, 0.1f);
+}
+
+void UEnemyUpdateSubsystem::UnregisterEnemy(ABaseEnemy* Enemy)
+{
+    // Entries are only cleared here, the array is compacted at the start of the next Tick
+    // so an enemy destroyed from inside its own update never shifts the rotation
+    for (FScheduledEnemy& Entry : Entries)
+    {
+        if (Entry.Enemy.Get() == Enemy)
+        {
+            Entry.Enemy.Reset();
+            bHasStaleEntries = true;
+            break;
+        }
+    }
+}
+
+void UEnemyUpdateSubsystem::Tick(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_EnemyDecisionPass);
+
+    if (bHasStaleEntries)
+    {
+        CompactEntries();
+    }
+
+    const int32 NumEntries = Entries.Num();
+    SET_DWORD_STAT(STAT_RegisteredEnemies, NumEntries);
+    if (NumEntries == 0)
+    {
+        return;
+    }
+
+    const double WorldTime = GetWorld()->GetTimeSeconds();
+    const double BudgetSeconds = FMath::Max(0.0f, CVarEnemyUpdateBudgetMs.GetValueOnGameThread()) * 0.001;
+    const int32 MinUpdates = FMath::Max(0, CVarEnemyMinUpdatesPerFrame.GetValueOnGameThread());
+    const double StartTime = FPlatformTime::Seconds();
+    bFixedStep = CVarEnemyFixedStep.GetValueOnGameThread();
+
+    const int32 NumUpdated = CVarEnemyParallelDecide.GetValueOnGameThread()
+        ? RunParallelUpdates(WorldTime, StartTime, BudgetSeconds, MinUpdates)
+        : RunSerialUpdates(WorldTime, StartTime, BudgetSeconds, MinUpdates);
+
+    const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+    if (ElapsedSeconds > BudgetSeconds)
+    {
+        Stats.BudgetOverruns++;
+    }
+
+    Stats.FramesScheduled++;
+    Stats.UpdatesLastFrame = NumUpdated;
+    Stats.LastFrameMs = ElapsedSeconds * 1000.0;
+    Stats.WorstFrameMs = FMath::Max(Stats.WorstFrameMs, Stats.LastFrameMs);
+
+    SET_DWORD_STAT(STAT_EnemyUpdates, NumUpdated);
+    SET_FLOAT_STAT(STAT_MaxUpdateLatency, Stats.MaxUpdateLatency);
+
+    UpdateBrainMeasurement(ElapsedSeconds, NumUpdated);
+}
+
+void UEnemyUpdateSubsystem::BuildUpdateOrder(double WorldTime, int32 MaxUpdates)
+{
+    UpdateOrder.Reset();
+
+    const int32 NumEntries = Entries.Num();
+    const int32 MaxCatchUpSteps = FMath::Max(1, CVarEnemyMaxCatchUpSteps.GetValueOnGameThread());
+    const UMovementLODSubsystem* MovementLOD = GetWorld()->GetSubsystem<UMovementLODSubsystem>();
+    int32 NumSteps = 0;
+
+    auto AddIfDue = [&](int32 Index, bool bCombat)
+    {
+        FScheduledEnemy& Entry = Entries[Index];
+        int32 Steps = 1;
+
+        if (bFixedStep)
+        {
+            Entry.StepInterval = GetStepInterval(Entry.Enemy.Get(), bCombat, MovementLOD);
+            Entry.Clock.LimitCatchUp(WorldTime, Entry.StepInterval, MaxCatchUpSteps);
+            Steps = FMath::Min(Entry.Clock.GetDueSteps(WorldTime, Entry.StepInterval), MaxUpdates - NumSteps);
+        }
+        else if (!bCombat && Entry.LastUpdateTime >= WorldTime)
+        {
+            // Enemies registered this frame wait for the next one
+            Steps = 0;
+        }
+
+        if (Steps > 0)
+        {
+            UpdateOrder.Add({ Index, bCombat, Steps });
+            NumSteps += Steps;
+        }
+    };
+
+    // Combat pass: enemies that are chasing or attacking get the budget first
+    for (int32 Step = 0; Step < NumEntries && NumSteps < MaxUpdates; ++Step)
+    {
+        const int32 Index = (CombatCursor + Step) % NumEntries;
+        const ABaseEnemy* Enemy = Entries[Index].Enemy.Get();
+        if (Enemy && IsInCombat(Enemy))
+        {
+            AddIfDue(Index, true);
+        }
+    }
+
+    // Default pass: everyone else shares what is left of the budget
+    for (int32 Step = 0; Step < NumEntries && NumSteps < MaxUpdates; ++Step)
+    {
+        const int32 Index = (DefaultCursor + Step) % NumEntries;
+        const ABaseEnemy* Enemy = Entries[Index].Enemy.Get();
+        if (Enemy && !IsInCombat(Enemy))
+        {
+            AddIfDue(Index, false);
+        }
+    }
+}
+
+void UEnemyUpdateSubsystem::AdvanceCursors(int32 NumProcessed)
+{
+    const int32 NumEntries = Entries.Num();
+    for (int32 SlotIndex = 0; SlotIndex < NumProcessed; ++SlotIndex)
+    {
+        const FUpdateSlot& Slot = UpdateOrder[SlotIndex];
+        int32& Cursor = Slot.bCombat ? CombatCursor : DefaultCursor;
+        Cursor = (Slot.EntryIndex + 1) % NumEntries;
+    }
+}
+
+int32 UEnemyUpdateSubsystem::RunSerialUpdates(double WorldTime, double StartTime, double BudgetSeconds, int32 MinUpdates)
+{
+    BuildUpdateOrder(WorldTime, MAX_int32);
+
+    int32 NumUpdated = 0;
+    int32 NumProcessed = 0;
+    for (const FUpdateSlot& Slot : UpdateOrder)
+    {
+        if (NumUpdated >= MinUpdates && FPlatformTime::Seconds() - StartTime >= BudgetSeconds)
+        {
+            break;
+        }
+
+        // Steps left undone stay due, and are caught up next frame within the catch-up limit
+        FScheduledEnemy& Entry = Entries[Slot.EntryIndex];
+        for (int32 Step = 0; Step < Slot.Steps; ++Step)
+        {
+            if (ABaseEnemy* Enemy = Entry.Enemy.Get())
+            {
+                Enemy->UpdateDecision(BeginEntryUpdate(Entry, WorldTime));
+            }
+        }
+        NumUpdated += Slot.Steps;
+        ++NumProcessed;
+    }
+
+    AdvanceCursors(NumProcessed);
+    return NumUpdated;
+}
+
+int32 UEnemyUpdateSubsystem::RunParallelUpdates(double WorldTime, double StartTime, double BudgetSeconds, int32 MinUpdates)
+{
+    // The batch is sized up front from the measured cost of previous frames, since the
+    // decide phase cannot stop part way through once it is spread across workers
+    const int32 MaxUpdates = FMath::Max(MinUpdates, FMath::FloorToInt32(BudgetSeconds / AverageParallelUpdateSeconds));
+    BuildUpdateOrder(WorldTime, MaxUpdates);
+
+    const int32 NumSelected = UpdateOrder.Num();
+    if (NumSelected == 0)
+    {
+        return 0;
+    }
+
+    int32 NumRounds = 0;
+    for (const FUpdateSlot& Slot : UpdateOrder)
+    {
+        NumRounds = FMath::Max(NumRounds, Slot.Steps);
+    }
+
+    const FEnemyWorldSnapshot Snapshot = ABaseEnemy::CaptureWorldSnapshot(GetWorld());
+
+    // Catch-up steps run in rounds, each a full decide and apply pass over the enemies that still have a step due
+    TArray<ABaseEnemy*, TInlineAllocator<64>> Enemies;
+    TArray<int32, TInlineAllocator<64>> RoundSlots;
+    int32 NumUpdated = 0;
+    for (int32 Round = 0; Round < NumRounds; ++Round)
+    {
+        Enemies.Reset();
+        RoundSlots.Reset();
+        DeltaTimes.Reset();
+        BrainDriven.Reset();
+        for (int32 SlotIndex = 0; SlotIndex < NumSelected; ++SlotIndex)
+        {
+            if (UpdateOrder[SlotIndex].Steps > Round)
+            {
+                FScheduledEnemy& Entry = Entries[UpdateOrder[SlotIndex].EntryIndex];
+                Enemies.Add(Entry.Enemy.Get());
+                DeltaTimes.Add(BeginEntryUpdate(Entry, WorldTime));
+                BrainDriven.Add(Entry.Enemy.IsValid() && Entry.Enemy->IsBrainDriven());
+                RoundSlots.Add(SlotIndex);
+            }
+        }
+
+        const int32 NumInRound = RoundSlots.Num();
+        Decisions.Reset();
+        Decisions.SetNum(NumInRound);
+
+        {
+            SCOPE_CYCLE_COUNTER(STAT_EnemyDecidePhase);
+
+            // The round's sight segments walk the visibility grid together, four rays per SIMD register,
+            // so the workers only trace physics for what the grid leaves open
+            TestGridSight(Snapshot, Enemies, GridSight);
+
+            ParallelFor(TEXT("EnemyDecide"), NumInRound, 8, [&](int32 Index)
+            {
+                // Brains run their tree on the game thread in the apply pass
+                const ABaseEnemy* Enemy = Enemies[Index];
+                if (Enemy && !BrainDriven[Index])
+                {
+                    Enemy->DecideUpdate(Snapshot, DeltaTimes[Index], Decisions[Index], GridSight[Index]);
+                }
+            });
+        }
+
+        {
+            SCOPE_CYCLE_COUNTER(STAT_EnemyApplyPhase);
+            for (int32 Index = 0; Index < NumInRound; ++Index)
+            {
+                // Earlier apply calls can destroy other enemies, so re-check through the weak pointer
+                ABaseEnemy* Enemy = Entries[UpdateOrder[RoundSlots[Index]].EntryIndex].Enemy.Get();
+                if (!Enemy)
+                {
+                    continue;
+                }
+
+                if (BrainDriven[Index])
+                {
+                    Enemy->UpdateDecision(DeltaTimes[Index]);
+                }
+                else
+                {
+                    Enemy->ApplyDecision(Decisions[Index]);
+                }
+            }
+        }
+
+        NumUpdated += NumInRound;
+    }
+
+    AdvanceCursors(NumSelected);
+
+    const double CostPerUpdate = (FPlatformTime::Seconds() - StartTime) / NumUpdated;
+    AverageParallelUpdateSeconds = FMath::Max(1.0e-7, FMath::Lerp(AverageParallelUpdateSeconds, CostPerUpdate, 0.1));
+
+    return NumUpdated;
+}
+
+void UEnemyUpdateSubsystem::TestGridSight(const FEnemyWorldSnapshot& Snapshot, TConstArrayView<ABaseEnemy*> Enemies, TArray<EAISightGridResult>& OutGridSight) const
+{
+    OutGridSight.Reset();
+    OutGridSight.Init(EAISightGridResult::Untested, Enemies.Num());
+
+    const UAISightSubsystem* SightSubsystem = GetWorld()->GetSubsystem<UAISightSubsystem>();
+    if (!SightSubsystem || !Snapshot.Player)
+    {
+        return;
+    }
+
+    TArray<FVector, TInlineAllocator<64>> Starts;
+    TArray<FVector, TInlineAllocator<64>> Ends;
+    TArray<int32, TInlineAllocator<64>> Tested;
+    for (int32 Index = 0; Index < Enemies.Num(); ++Index)
+    {
+        FVector Start;
+        FVector End;
+        const ABaseEnemy* Enemy = Enemies[Index];
+        if (Enemy && !Enemy->IsBrainDriven() && Enemy->GetSightSegment(Snapshot, Start, End))
+        {
+            Starts.Add(Start);
+            Ends.Add(End);
+            Tested.Add(Index);
+        }
+    }
+
+    TArray<EAISightGridResult, TInlineAllocator<64>> Results;
+    Results.SetNumUninitialized(Tested.Num());
+    if (Tested.Num() > 0 && SightSubsystem->TestGrid(Starts, Ends, Results))
+    {
+        for (int32 Index = 0; Index < Tested.Num(); ++Index)
+        {
+            OutGridSight[Tested[Index]] = Results[Index];
+        }
+    }
+}
+
+float UEnemyUpdateSubsystem::BeginEntryUpdate(FScheduledEnemy& Entry, double WorldTime)
+{
+    // Latency is the real time between updates, catch-up steps within a frame do not lower it
+    const float Latency = static_cast<float>(WorldTime - Entry.LastUpdateTime);
+    if (Latency > 0.0f)
+    {
+        Entry.LastUpdateTime = WorldTime;
+        Entry.MaxLatency = FMath::Max(Entry.MaxLatency, Latency);
+        Stats.MaxUpdateLatency = FMath::Max(Stats.MaxUpdateLatency, Latency);
+    }
+
+    if (!bFixedStep)
+    {
+        // Pass through the real time since this enemy was last updated, not the frame delta
+        return Latency;
+    }
+
+    Entry.Clock.ConsumeSteps(1, Entry.StepInterval);
+    if (ABaseEnemy* Enemy = Entry.Enemy.Get())
+    {
+        Enemy->SetAIStepTiming(Entry.Clock.StepTime, Entry.StepInterval);
+    }
+    return Entry.StepInterval;
+}
+
+bool UEnemyUpdateSubsystem::VerifyParallelDeterminism(int32 NumParallelRuns) const
+{
+    TArray<ABaseEnemy*> Enemies;
+    for (const FScheduledEnemy& Entry : Entries)
+    {
+        if (ABaseEnemy* Enemy = Entry.Enemy.Get())
+        {
+            Enemies.Add(Enemy);
+        }
+    }
+
+    const FEnemyWorldSnapshot Snapshot = ABaseEnemy::CaptureWorldSnapshot(GetWorld());
+    const float FixedDeltaTime = 1.0f / 30.0f;
+
+    // Reference results from a plain serial loop on the game thread, each enemy tracing on its own
+    TArray<FEnemyDecision> SerialDecisions;
+    SerialDecisions.SetNum(Enemies.Num());
+    for (int32 Index = 0; Index < Enemies.Num(); ++Index)
+    {
+        Enemies[Index]->DecideUpdate(Snapshot, FixedDeltaTime, SerialDecisions[Index]);
+    }
+
+    // The parallel runs take the batched grid results, as the scheduler does
+    TArray<EAISightGridResult> BatchedGridSight;
+    TestGridSight(Snapshot, Enemies, BatchedGridSight);
+
+    int32 NumMismatches = 0;
+    TArray<FEnemyDecision> ParallelDecisions;
+    for (int32 Run = 0; Run < NumParallelRuns; ++Run)
+    {
+        ParallelDecisions.Reset();
+        ParallelDecisions.SetNum(Enemies.Num());
+
+        // Single-item batches so every run spreads the enemies over the workers differently
+        ParallelFor(TEXT("EnemyDecideVerify"), Enemies.Num(), 1, [&](int32 Index)
+        {
+            Enemies[Index]->DecideUpdate(Snapshot, FixedDeltaTime, ParallelDecisions[Index], BatchedGridSight[Index]);
+        });
+
+        for (int32 Index = 0; Index < Enemies.Num(); ++Index)
+        {
+            if (!(ParallelDecisions[Index] == SerialDecisions[Index]))
+            {
+                UE_LOG(LogRTP, Error, TEXT("Parallel decide mismatch for %s on run %d"), *Enemies[Index]->GetName(), Run);
+                ++NumMismatches;
+            }
+        }
+    }
+
+    UE_LOG(LogRTP, Log, TEXT("Parallel decide determinism check: %d enemies, %d runs, %d mismatches"), Enemies.Num(), NumParallelRuns, NumMismatches);
+    return NumMismatches == 0;
+}
+
+void UEnemyUpdateSubsystem::StartBrainMeasurement(int32 FramesPerPhase)
+{
+    if (BrainMeasurement.FramesRemaining > 0)
+    {
+        UEnemyBrainComponent::SetEnabled(BrainMeasurement.bWasEnabled);
+    }
+
+    BrainMeasurement = FBrainMeasurement();
+    BrainMeasurement.FramesPerPhase = FramesPerPhase;
+    BrainMeasurement.FramesRemaining = FramesPerPhase;
+    BrainMeasurement.bWasEnabled = UEnemyBrainComponent::IsEnabled();
+    UEnemyBrainComponent::SetEnabled(false);
+
+    UE_LOG(LogRTP, Log, TEXT("Measuring enemy brains with %d enemies over 2x%d frames"), Entries.Num(), FramesPerPhase);
+}
+
+void UEnemyUpdateSubsystem::UpdateBrainMeasurement(double ElapsedSeconds, int32 NumUpdated)
+{
+    if (BrainMeasurement.FramesRemaining <= 0)
+    {
+        return;
+    }
+
+    const int32 Phase = BrainMeasurement.bBrainPhase ? 1 : 0;
+    BrainMeasurement.Seconds[Phase] += ElapsedSeconds;
+    BrainMeasurement.Updates[Phase] += NumUpdated;
+    if (--BrainMeasurement.FramesRemaining > 0)
+    {
+        return;
+    }
+
+    if (!BrainMeasurement.bBrainPhase)
+    {
+        // Brains re-select their state from the enemy on their first update, the changes made meanwhile are still queued
+        BrainMeasurement.bBrainPhase = true;
+        BrainMeasurement.FramesRemaining = BrainMeasurement.FramesPerPhase;
+        UEnemyBrainComponent::SetEnabled(true);
+        return;
+    }
+
+    UEnemyBrainComponent::SetEnabled(BrainMeasurement.bWasEnabled);
+
+    const double RulesMs = BrainMeasurement.Seconds[0] * 1000.0 / BrainMeasurement.FramesPerPhase;
+    const double BrainMs = BrainMeasurement.Seconds[1] * 1000.0 / BrainMeasurement.FramesPerPhase;
+    const double RulesUs = BrainMeasurement.Seconds[0] * 1.0e6 / FMath::Max(1, BrainMeasurement.Updates[0]);
+    const double BrainUs = BrainMeasurement.Seconds[1] * 1.0e6 / FMath::Max(1, BrainMeasurement.Updates[1]);
+    UE_LOG(LogRTP, Log, TEXT("Enemy brains with %d enemies: hand-written rules %.3f ms/frame (%.2f us/update), StateTree %.3f ms/frame (%.2f us/update)"),
+        Entries.Num(), RulesMs, RulesUs, BrainMs, BrainUs);
+}
+
+void UEnemyUpdateSubsystem::CompactEntries()
+{
+    Entries.RemoveAll([](const FScheduledEnemy& Entry)
+    {
+        return !Entry.Enemy.IsValid();
+    });
+
+    const int32 NumEntries = Entries.Num();
+    CombatCursor = NumEntries > 0 ? CombatCursor % NumEntries : 0;
+    DefaultCursor = NumEntries > 0 ? DefaultCursor % NumEntries : 0;
+    bHasStaleEntries = false;
+}
+
+void UEnemyUpdateSubsystem::ResetStats()
+{
+    Stats = FEnemyUpdateStats();
+
+    for (FScheduledEnemy& Entry : Entries)
+    {
+        Entry.MaxLatency = 0.0f;
+    }
+}
+
+float UEnemyUpdateSubsystem::GetMaxUpdateLatency(const ABaseEnemy* Enemy) const
+{
+    for (const FScheduledEnemy& Entry : Entries)
+    {
+        if (Entry.Enemy.Get() == Enemy)
+        {
+            return Entry.MaxLatency;
+        }
+    }
+
+    return 0.0f;
+}
+
+void UEnemyUpdateSubsystem::DumpStats() const
+{
+    UE_LOG(LogRTP, Log, TEXT("Enemy update scheduler: %d enemies, %d frames, %d budget overruns, last frame %.3f ms (%d updates), worst frame %.3f ms, max latency %.3f s"),
+        Entries.Num(), Stats.FramesScheduled, Stats.BudgetOverruns, Stats.LastFrameMs, Stats.UpdatesLastFrame, Stats.WorstFrameMs, Stats.MaxUpdateLatency);
+
+    TArray<const FScheduledEnemy*> SortedEntries;
+    SortedEntries.Reserve(Entries.Num());
+    for (const FScheduledEnemy& Entry : Entries)
+    {
+        if (Entry.Enemy.IsValid())
+        {
+            SortedEntries.Add(&Entry);
+        }
+    }
+
+    SortedEntries.Sort([](const FScheduledEnemy& A, const FScheduledEnemy& B)
+    {
+        return A.MaxLatency > B.MaxLatency;
+    });
+
+    const int32 NumToLog = FMath::Min(SortedEntries.Num(), 10);
+    for (int32 Index = 0; Index < NumToLog; ++Index)
+    {
+        const FScheduledEnemy& Entry = *SortedEntries[Index];
+        UE_LOG(LogRTP, Log, TEXT("  %s: max latency %.3f s"), *Entry.Enemy->GetName(), Entry.MaxLatency);
+    }
+}
@@ -0,0 +1,250 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/InfluenceMapSubsystem.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "NavigationSystem.h"
+#include "RTP.h"
+
+DECLARE_CYCLE_STAT(TEXT("Influence Map Step"), STAT_InfluenceMapStep, STATGROUP_RTPAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Influence Dirty Tiles"), STAT_InfluenceDirtyTiles, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<bool> CVarInfluenceMap(
+    TEXT("rtp.AI.InfluenceMap"),
+    true,
+    TEXT("Track player heat and enemy coverage in an influence map and pick search targets from it."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarInfluenceCellSize(
+    TEXT("rtp.AI.InfluenceCellSize"),
+    200.0f,
+    TEXT("Cell size of the influence map, in centimeters. Read when a level begins play."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarInfluenceExtent(
+    TEXT("rtp.AI.InfluenceExtent"),
+    20000.0f,
+    TEXT("Half size of the influence map around the world origin for levels without navigation bounds, in centimeters."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarInfluenceStepRate(
+    TEXT("rtp.AI.InfluenceStepRate"),
+    10.0f,
+    TEXT("Influence map diffusion and decay steps per second."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarInfluenceDiffusion(
+    TEXT("rtp.AI.InfluenceDiffusion"),
+    2.0f,
+    TEXT("Rate at which influence spreads to neighboring cells, fraction of a cell's value per second."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarInfluenceHeatDecay(
+    TEXT("rtp.AI.InfluenceHeatDecay"),
+    0.1f,
+    TEXT("Rate at which player heat fades, per second."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarInfluenceCoverageDecay(
+    TEXT("rtp.AI.InfluenceCoverageDecay"),
+    0.05f,
+    TEXT("Rate at which enemy coverage fades, per second."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarInfluenceCoverageRate(
+    TEXT("rtp.AI.InfluenceCoverageRate"),
+    1.0f,
+    TEXT("Enemy coverage added per second to the cell an enemy stands in, saturating at 1."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarInfluenceCoverageWeight(
+    TEXT("rtp.AI.InfluenceCoverageWeight"),
+    1.0f,
+    TEXT("How strongly enemy coverage steers search targets away from cells enemies have recently been in."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarInfluenceMinSearchScore(
+    TEXT("rtp.AI.InfluenceMinSearchScore"),
+    0.05f,
+    TEXT("Least player heat, net of coverage, worth searching. Below it enemies fall back to their default behavior."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorld DumpInfluenceCommand(
+    TEXT("rtp.AI.DumpInfluence"),
+    TEXT("Log the influence map's size, its dirty tiles and its hottest cells."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (const UInfluenceMapSubsystem* Subsystem = World ? World->GetSubsystem<UInfluenceMapSubsystem>() : nullptr)
+        {
+            Subsystem->LogInfluence();
+        }
+    }));
+
+bool UInfluenceMapSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UInfluenceMapSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+    
+    // The navigable area is where enemies can search, anything outside it is never a target
+    FBox Bounds(ForceInit);
+    if (const UNavigationSystemV1* NavSystem = UNavigationSystemV1::GetCurrent(&InWorld))
+    {
+        Bounds = NavSystem->GetNavigableWorldBounds();
+    }
+    if (!Bounds.IsValid)
+    {
+        const float Extent = FMath::Max(CVarInfluenceExtent.GetValueOnGameThread(), 1000.0f);
+        Bounds = FBox(FVector(-Extent), FVector(Extent));
+    }
+    
+    Map.Init(FVector2f(Bounds.Min.X, Bounds.Min.Y), FVector2f(Bounds.Max.X, Bounds.Max.Y), CVarInfluenceCellSize.GetValueOnGameThread());
+    Clock.Reset(InWorld.GetTimeSeconds(), 0.0f);
+    
+    UE_LOG(LogRTP, Log, TEXT("Influence map: %dx%d cells of %.0f cm in %d tiles"),
+        Map.GetSize().X, Map.GetSize().Y, Map.GetCellSize(), Map.GetNumTiles());
+}
+
+void UInfluenceMapSubsystem::Deinitialize()
+{
+    Map.Reset();
+    Enemies.Reset();
+    Super::Deinitialize();
+}
+
+TStatId UInfluenceMapSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UInfluenceMapSubsystem, STATGROUP_Tickables);
+}
+
+bool UInfluenceMapSubsystem::IsEnabled()
+{
+    return CVarInfluenceMap.GetValueOnGameThread();
+}
+
+void UInfluenceMapSubsystem::RegisterEnemy(ABaseEnemy* Enemy)
+{
+    if (Enemy)
+    {
+        Enemies.AddUnique(Enemy);
+    }
+}
+
+void UInfluenceMapSubsystem::UnregisterEnemy(ABaseEnemy* Enemy)
+{
+    Enemies.RemoveSingleSwap(Enemy);
+}
+
+FInfluenceMapSettings UInfluenceMapSubsystem::GetSettings(float StepInterval)
+{
+    FInfluenceMapSettings Settings;
+    Settings.Diffusion = FMath::Clamp(CVarInfluenceDiffusion.GetValueOnGameThread() * StepInterval, 0.0f, 1.0f);
+    Settings.Decay[static_cast<int32>(EInfluenceLayer::PlayerHeat)] = FMath::Exp(-FMath::Max(CVarInfluenceHeatDecay.GetValueOnGameThread(), 0.0f) * StepInterval);
+    Settings.Decay[static_cast<int32>(EInfluenceLayer::EnemyCoverage)] = FMath::Exp(-FMath::Max(CVarInfluenceCoverageDecay.GetValueOnGameThread(), 0.0f) * StepInterval);
+    return Settings;
+}
+
+void UInfluenceMapSubsystem::AddPlayerEvidence(const FVector& Location, float Strength)
+{
+    if (IsEnabled())
+    {
+        Map.Add(EInfluenceLayer::PlayerHeat, FVector2f(Location.X, Location.Y), FMath::Clamp(Strength, 0.0f, 1.0f));
+    }
+}
+
+bool UInfluenceMapSubsystem::FindSearchTarget(const FVector& From, float Radius, FVector& OutLocation) const
+{
+    FVector2f Target;
+    if (!IsEnabled() || !Map.FindBestCell(FVector2f(From.X, From.Y), Radius, CVarInfluenceCoverageWeight.GetValueOnGameThread(),
+        CVarInfluenceMinSearchScore.GetValueOnGameThread(), Target))
+    {
+        return false;
+    }
+    
+    // The map is 2D, the move request projects the cell center onto the navmesh
+    OutLocation = FVector(Target.X, Target.Y, From.Z);
+    return true;
+}
+
+void UInfluenceMapSubsystem::DepositEnemyCoverage(float StepInterval)
+{
+    const float Amount = FMath::Max(CVarInfluenceCoverageRate.GetValueOnGameThread(), 0.0f) * StepInterval;
+    
+    for (int32 Index = Enemies.Num() - 1; Index >= 0; --Index)
+    {
+        const ABaseEnemy* Enemy = Enemies[Index].Get();
+        if (!Enemy)
+        {
+            Enemies.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+            continue;
+        }
+        
+        if (!Enemy->IsDead())
+        {
+            const FVector Location = Enemy->GetActorLocation();
+            Map.Add(EInfluenceLayer::EnemyCoverage, FVector2f(Location.X, Location.Y), Amount);
+        }
+    }
+}
+
+void UInfluenceMapSubsystem::Tick(float DeltaTime)
+{
+    if (!Map.IsValid() || !IsEnabled())
+    {
+        return;
+    }
+    
+    const double Now = GetWorld()->GetTimeSeconds();
+    const float StepInterval = 1.0f / FMath::Clamp(CVarInfluenceStepRate.GetValueOnGameThread(), 1.0f, 60.0f);
+    
+    // The map only has to be roughly current, steps lost to a hitch are dropped rather than caught up
+    Clock.LimitCatchUp(Now, StepInterval, 2);
+    const int32 Steps = Clock.GetDueSteps(Now, StepInterval);
+    if (Steps == 0)
+    {
+        return;
+    }
+    Clock.ConsumeSteps(Steps, StepInterval);
+    
+    SCOPE_CYCLE_COUNTER(STAT_InfluenceMapStep);
+    
+    const FInfluenceMapSettings Settings = GetSettings(StepInterval);
+    for (int32 Step = 0; Step < Steps; ++Step)
+    {
+        DepositEnemyCoverage(StepInterval);
+        Map.Step(Settings);
+    }
+    
+    SET_DWORD_STAT(STAT_InfluenceDirtyTiles, Map.GetNumDirtyTiles());
+}
+
+void UInfluenceMapSubsystem::LogInfluence() const
+{
+    if (!Map.IsValid())
+    {
+        UE_LOG(LogRTP, Log, TEXT("No influence map"));
+        return;
+    }
+    
+    UE_LOG(LogRTP, Log, TEXT("Influence map: %dx%d cells of %.0f cm, %d of %d tiles dirty, %d enemies covering"),
+        Map.GetSize().X, Map.GetSize().Y, Map.GetCellSize(), Map.GetNumDirtyTiles(), Map.GetNumTiles(), Enemies.Num());
+    
+    FVector2f Position;
+    float Value;
+    if (Map.FindMaxCell(EInfluenceLayer::PlayerHeat, Position, Value))
+    {
+        UE_LOG(LogRTP, Log, TEXT("  Hottest player cell (%.0f, %.0f): %.3f, coverage %.3f"),
+            Position.X, Position.Y, Value, Map.GetValue(EInfluenceLayer::EnemyCoverage, Position));
+    }
+    if (Map.FindMaxCell(EInfluenceLayer::EnemyCoverage, Position, Value))
+    {
+        UE_LOG(LogRTP, Log, TEXT("  Most covered cell (%.0f, %.0f): %.3f, heat %.3f"),
+            Position.X, Position.Y, Value, Map.GetValue(EInfluenceLayer::PlayerHeat, Position));
+    }
+}
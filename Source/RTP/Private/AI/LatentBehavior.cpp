@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/LatentBehavior.h"
+#include "AI/LatentBehaviorSubsystem.h"
+#include "Engine/World.h"
+
+namespace
+{
+    // Frames are pooled in multiples of the granularity up to the largest class, bigger ones go to the heap
+    constexpr SIZE_T FrameGranularity = 64;
+    constexpr int32 NumFrameClasses = 16;
+
+    struct FFreeFrame
+    {
+        FFreeFrame* Next;
+    };
+
+    FFreeFrame* FreeFrames[NumFrameClasses] = {};
+    int32 NumLiveFrames = 0;
+    int32 NumPooledFrames = 0;
+    int32 NumHeapAllocations = 0;
+
+    int32 GetFrameClass(SIZE_T Size)
+    {
+        return static_cast<int32>((Size + FrameGranularity - 1) / FrameGranularity) - 1;
+    }
+}
+
+void* FLatentFramePool::Allocate(SIZE_T Size)
+{
+    check(IsInGameThread());
+    ++NumLiveFrames;
+
+    const int32 FrameClass = GetFrameClass(Size);
+    if (FrameClass >= NumFrameClasses)
+    {
+        ++NumHeapAllocations;
+        return FMemory::Malloc(Size);
+    }
+
+    if (FFreeFrame* Frame = FreeFrames[FrameClass])
+    {
+        FreeFrames[FrameClass] = Frame->Next;
+        --NumPooledFrames;
+        return Frame;
+    }
+
+    ++NumHeapAllocations;
+    return FMemory::Malloc((FrameClass + 1) * FrameGranularity);
+}
+
+void FLatentFramePool::Free(void* Frame, SIZE_T Size)
+{
+    check(IsInGameThread());
+    --NumLiveFrames;
+
+    const int32 FrameClass = GetFrameClass(Size);
+    if (FrameClass >= NumFrameClasses)
+    {
+        FMemory::Free(Frame);
+        return;
+    }
+
+    FFreeFrame* FreeFrame = static_cast<FFreeFrame*>(Frame);
+    FreeFrame->Next = FreeFrames[FrameClass];
+    FreeFrames[FrameClass] = FreeFrame;
+    ++NumPooledFrames;
+}
+
+int32 FLatentFramePool::GetNumLiveFrames()
+{
+    return NumLiveFrames;
+}
+
+int32 FLatentFramePool::GetNumPooledFrames()
+{
+    return NumPooledFrames;
+}
+
+int32 FLatentFramePool::GetNumHeapAllocations()
+{
+    return NumHeapAllocations;
+}
+
+FLatentBehavior& FLatentBehavior::operator=(FLatentBehavior&& Other)
+{
+    if (this != &Other)
+    {
+        Reset();
+        Handle = Other.Handle;
+        Other.Handle = nullptr;
+    }
+    return *this;
+}
+
+void FLatentBehavior::Start()
+{
+    if (Handle && !Handle.promise().bStarted)
+    {
+        Handle.promise().bStarted = true;
+        Handle.resume();
+    }
+}
+
+void FLatentBehavior::Reset()
+{
+    // Destroying a suspended frame destroys the wait or child behaviour it is suspended in
+    if (Handle)
+    {
+        Handle.destroy();
+        Handle = nullptr;
+    }
+}
+
+float FLatentBehavior::GetWaitRemaining(double Now) const
+{
+    if (!IsRunning())
+    {
+        return 0.0f;
+    }
+
+    const FLatentPromise* Promise = &Handle.promise();
+    while (Promise->Child)
+    {
+        Promise = Promise->Child;
+    }
+
+    return Promise->WakeTime >= 0.0 ? static_cast<float>(FMath::Max(0.0, Promise->WakeTime - Now)) : 0.0f;
+}
+
+std::coroutine_handle<> FLatentBehavior::await_suspend(FHandle Parent)
+{
+    FLatentPromise& Promise = Handle.promise();
+    Promise.Continuation = Parent;
+    Parent.promise().Child = &Promise;
+
+    // Run the child straight away, it transfers back to the parent when it finishes
+    Promise.bStarted = true;
+    return Handle;
+}
+
+void FLatentBehavior::await_resume()
+{
+    if (Handle && Handle.promise().Continuation)
+    {
+        Handle.promise().Continuation.promise().Child = nullptr;
+    }
+}
+
+std::coroutine_handle<> FLatentPromise::FFinalAwaiter::await_suspend(FLatentBehavior::FHandle Finished) noexcept
+{
+    if (FLatentBehavior::FHandle Parent = Finished.promise().Continuation)
+    {
+        return Parent;
+    }
+    return std::noop_coroutine();
+}
+
+FLatentWait::FLatentWait(const UObject* WorldContextObject, float InTimeout)
+    : Timeout(InTimeout)
+{
+    if (const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr)
+    {
+        Subsystem = World->GetSubsystem<ULatentBehaviorSubsystem>();
+    }
+}
+
+FLatentWait::~FLatentWait()
+{
+    DisarmTimeout();
+}
+
+void FLatentWait::Suspend(FLatentBehavior::FHandle InHandle)
+{
+    Handle = InHandle;
+
+    ULatentBehaviorSubsystem* TimeoutQueue = Subsystem.Get();
+    if (Timeout >= 0.0f && TimeoutQueue)
+    {
+        const double WakeTime = TimeoutQueue->GetWorld()->GetTimeSeconds() + Timeout;
+        TimeoutId = TimeoutQueue->AddTimeout(this, WakeTime);
+        Handle.promise().WakeTime = WakeTime;
+    }
+}
+
+void FLatentWait::Resume()
+{
+    DisarmTimeout();
+    Handle.promise().WakeTime = -1.0;
+
+    // The behaviour runs on from here, and usually destroys this wait as it does
+    Handle.resume();
+}
+
+void FLatentWait::DisarmTimeout()
+{
+    if (TimeoutId != INDEX_NONE)
+    {
+        if (ULatentBehaviorSubsystem* TimeoutQueue = Subsystem.Get())
+        {
+            TimeoutQueue->RemoveTimeout(TimeoutId);
+        }
+        TimeoutId = INDEX_NONE;
+    }
+}
+
+FLatentSignal::~FLatentSignal()
+{
+    // The waiting behaviour is left suspended, to be cancelled by its owner
+    if (Waiter)
+    {
+        Waiter->Signal = nullptr;
+    }
+}
+
+void FLatentSignal::Trigger(int32 Value)
+{
+    if (Waiter)
+    {
+        Waiter->Fire(Value);
+    }
+}
+
+void FLatentSignalWait::await_suspend(FLatentBehavior::FHandle InHandle)
+{
+    check(Signal && !Signal->Waiter);
+    Signal->Waiter = this;
+    Suspend(InHandle);
+}
+
+void FLatentSignalWait::Fire(int32 Value)
+{
+    Detach();
+    Result = Value;
+    Resume();
+}
+
+void FLatentSignalWait::OnTimeout()
+{
+    Detach();
+    Resume();
+}
+
+void FLatentSignalWait::Detach()
+{
+    if (Signal && Signal->Waiter == this)
+    {
+        Signal->Waiter = nullptr;
+    }
+    Signal = nullptr;
+}
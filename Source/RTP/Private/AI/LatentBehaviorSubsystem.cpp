@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/LatentBehaviorSubsystem.h"
+#include "AI/LatentBehavior.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "RTP.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Latent Timeouts"), STAT_LatentTimeouts, STATGROUP_RTPAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Latent Frames"), STAT_LatentFrames, STATGROUP_RTPAI);
+
+static FAutoConsoleCommandWithWorld DumpLatentBehaviorStatsCommand(
+    TEXT("rtp.AI.DumpLatentStats"),
+    TEXT("Log latent behaviour frame pool usage and pending timeouts."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        const ULatentBehaviorSubsystem* Subsystem = World ? World->GetSubsystem<ULatentBehaviorSubsystem>() : nullptr;
+        UE_LOG(LogRTP, Log, TEXT("Latent behaviours: %d live frames, %d pooled frames, %d heap allocations, %d pending timeouts"),
+            FLatentFramePool::GetNumLiveFrames(), FLatentFramePool::GetNumPooledFrames(), FLatentFramePool::GetNumHeapAllocations(),
+            Subsystem ? Subsystem->GetNumTimeouts() : 0);
+    }));
+
+bool ULatentBehaviorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void ULatentBehaviorSubsystem::Deinitialize()
+{
+    // Behaviours still waiting are destroyed with their owners, they must not call back into the queue
+    for (FTimeout& Timeout : Timeouts)
+    {
+        Timeout.Wait->TimeoutId = INDEX_NONE;
+    }
+
+    Timeouts.Empty();
+    Queue.Empty();
+    Super::Deinitialize();
+}
+
+TStatId ULatentBehaviorSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(ULatentBehaviorSubsystem, STATGROUP_Tickables);
+}
+
+int32 ULatentBehaviorSubsystem::AddTimeout(FLatentWait* Wait, double WakeTime)
+{
+    const uint64 Serial = NextSerial++;
+    const int32 TimeoutId = Timeouts.Add({ Wait, Serial });
+    Queue.HeapPush({ WakeTime, TimeoutId, Serial });
+    return TimeoutId;
+}
+
+void ULatentBehaviorSubsystem::RemoveTimeout(int32 TimeoutId)
+{
+    if (Timeouts.IsValidIndex(TimeoutId))
+    {
+        Timeouts.RemoveAt(TimeoutId);
+    }
+}
+
+void ULatentBehaviorSubsystem::Tick(float DeltaTime)
+{
+    SET_DWORD_STAT(STAT_LatentTimeouts, Timeouts.Num());
+    SET_DWORD_STAT(STAT_LatentFrames, FLatentFramePool::GetNumLiveFrames());
+
+    const double Now = GetWorld()->GetTimeSeconds();
+
+    // Timeouts added by the behaviours resumed below wait for the next frame, even when already due
+    const uint64 FirstNewSerial = NextSerial;
+
+    while (Queue.Num() > 0 && Queue.HeapTop().WakeTime <= Now && Queue.HeapTop().Serial < FirstNewSerial)
+    {
+        FQueuedTimeout Queued;
+        Queue.HeapPop(Queued, EAllowShrinking::No);
+
+        // Skip entries whose wait was removed, including slots since reused by a newer timeout
+        if (!Timeouts.IsValidIndex(Queued.TimeoutId) || Timeouts[Queued.TimeoutId].Serial != Queued.Serial)
+        {
+            continue;
+        }
+
+        FLatentWait* Wait = Timeouts[Queued.TimeoutId].Wait;
+        Timeouts.RemoveAt(Queued.TimeoutId);
+        Wait->TimeoutId = INDEX_NONE;
+        Wait->OnTimeout();
+    }
+}
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/NoiseSubsystem.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Noise Dispatch"), STAT_NoiseDispatch, STATGROUP_RTPAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Noise Events"), STAT_NoiseEvents, STATGROUP_RTPAI);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Noise Listener Checks"), STAT_NoiseListenerChecks, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<float> CVarEnemySpatialCellSize(
+    TEXT("rtp.AI.SpatialCellSize"),
+    1000.0f,
+    TEXT("Cell size of the enemy spatial hash used for noise and other radius queries, in centimeters."),
+    ECVF_Default);
+
+bool UNoiseSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UNoiseSubsystem::Deinitialize()
+{
+    Listeners.Reset();
+    PendingNoises.Reset();
+    SpatialHash.Reset();
+    Super::Deinitialize();
+}
+
+TStatId UNoiseSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UNoiseSubsystem, STATGROUP_Tickables);
+}
+
+void UNoiseSubsystem::RegisterListener(ABaseEnemy* Enemy)
+{
+    if (Enemy)
+    {
+        Listeners.AddUnique(Enemy);
+    }
+}
+
+void UNoiseSubsystem::UnregisterListener(ABaseEnemy* Enemy)
+{
+    Listeners.RemoveSingleSwap(Enemy);
+}
+
+void UNoiseSubsystem::ReportNoise(AActor* NoiseInstigator, const FVector& Location, float Loudness)
+{
+    Loudness = FMath::Clamp(Loudness, 0.0f, 1.0f);
+    if (Loudness > 0.0f)
+    {
+        PendingNoises.Add({ NoiseInstigator, Location, Loudness });
+    }
+}
+
+void UNoiseSubsystem::UpdateSpatialHash()
+{
+    if (SpatialHashFrame == GFrameCounter)
+    {
+        return;
+    }
+    SpatialHashFrame = GFrameCounter;
+    
+    const float CellSize = CVarEnemySpatialCellSize.GetValueOnGameThread();
+    if (CellSize != SpatialHash.GetCellSize())
+    {
+        SpatialHash.SetCellSize(CellSize);
+    }
+    else
+    {
+        SpatialHash.Reset();
+    }
+    
+    MaxHearingRange = 0.0f;
+    for (int32 Index = Listeners.Num() - 1; Index >= 0; --Index)
+    {
+        ABaseEnemy* Enemy = Listeners[Index].Get();
+        if (!Enemy)
+        {
+            Listeners.RemoveAtSwap(Index);
+            continue;
+        }
+        
+        SpatialHash.Add(Enemy, Enemy->GetActorLocation());
+        MaxHearingRange = FMath::Max(MaxHearingRange, Enemy->GetHearingRange());
+    }
+}
+
+void UNoiseSubsystem::GatherEnemiesInRadius(const FVector& Location, float Radius, TArray<ABaseEnemy*>& OutEnemies)
+{
+    UpdateSpatialHash();
+    SpatialHash.Gather(Location, Radius, OutEnemies);
+}
+
+void UNoiseSubsystem::Tick(float DeltaTime)
+{
+    SET_DWORD_STAT(STAT_NoiseEvents, PendingNoises.Num());
+    if (PendingNoises.Num() == 0)
+    {
+        return;
+    }
+    
+    SCOPE_CYCLE_COUNTER(STAT_NoiseDispatch);
+    
+    // Noises reported while reacting are delivered next frame
+    Swap(PendingNoises, DispatchNoises);
+    PendingNoises.Reset();
+    
+    UpdateSpatialHash();
+    
+    // Each enemy reacts at most once per frame, to the loudest noise it heard
+    LoudestNoiseByEnemy.Reset();
+    int32 NumChecks = 0;
+    
+    for (int32 NoiseIndex = 0; NoiseIndex < DispatchNoises.Num(); ++NoiseIndex)
+    {
+        const FNoiseEvent& Noise = DispatchNoises[NoiseIndex];
+        
+        NearbyEnemies.Reset();
+        SpatialHash.Gather(Noise.Location, MaxHearingRange * Noise.Loudness, NearbyEnemies);
+        NumChecks += NearbyEnemies.Num();
+        
+        for (ABaseEnemy* Enemy : NearbyEnemies)
+        {
+            const float Range = Enemy->GetHearingRange() * Noise.Loudness;
+            if (Enemy->IsDead() || FVector::DistSquared(Enemy->GetActorLocation(), Noise.Location) > Range * Range)
+            {
+                continue;
+            }
+            
+            int32& LoudestIndex = LoudestNoiseByEnemy.FindOrAdd(Enemy, NoiseIndex);
+            if (Noise.Loudness > DispatchNoises[LoudestIndex].Loudness)
+            {
+                LoudestIndex = NoiseIndex;
+            }
+        }
+    }
+    
+    SET_DWORD_STAT(STAT_NoiseListenerChecks, NumChecks);
+    
+    for (const TPair<ABaseEnemy*, int32>& Pair : LoudestNoiseByEnemy)
+    {
+        const FNoiseEvent& Noise = DispatchNoises[Pair.Value];
+        Pair.Key->HearNoise(Cast<APawn>(Noise.Instigator.Get()), Noise.Location, Noise.Loudness);
+    }
+    
+    DispatchNoises.Reset();
+}
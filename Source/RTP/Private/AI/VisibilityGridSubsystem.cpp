@@ -0,0 +1,311 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/VisibilityGridSubsystem.h"
+#include "AI/VisibilityGridAsset.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/PackageName.h"
+#include "RTP.h"
+
+DECLARE_CYCLE_STAT(TEXT("Visibility Grid Query"), STAT_VisibilityGridQuery, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<bool> CVarUseVisibilityGrid(
+    TEXT("rtp.AI.UseVisibilityGrid"),
+    true,
+    TEXT("Answer AI sight against the baked visibility grid when the level has one. Rays the grid finds clear trace physics for dynamic occluders only, the rest get a full trace."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs CompareVisibilityGridCommand(
+    TEXT("rtp.AI.CompareVisibilityGrid"),
+    TEXT("Cast random sight rays around the enemies through the visibility grid and through LineTraceSingleByChannel and compare results and throughput. Usage: rtp.AI.CompareVisibilityGrid [NumRays]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        const UVisibilityGridSubsystem* Subsystem = World ? World->GetSubsystem<UVisibilityGridSubsystem>() : nullptr;
+        if (!Subsystem || !Subsystem->HasGrid())
+        {
+            UE_LOG(LogRTP, Warning, TEXT("rtp.AI.CompareVisibilityGrid needs a baked visibility grid for this level"));
+            return;
+        }
+        
+        const int32 NumRays = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+        
+        // Rays start at enemy eye height and end anywhere within sight range
+        TArray<FVector> Eyes;
+        for (TActorIterator<ABaseEnemy> It(World); It; ++It)
+        {
+            Eyes.Add(It->GetActorLocation() + FVector(0, 0, It->BaseEyeHeight));
+        }
+        if (Eyes.Num() == 0)
+        {
+            if (const APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0))
+            {
+                Eyes.Add(Player->GetActorLocation());
+            }
+        }
+        if (Eyes.Num() == 0)
+        {
+            return;
+        }
+        
+        FRandomStream Random(NumRays);
+        TArray<FVector> Starts;
+        TArray<FVector> Ends;
+        Starts.Reserve(NumRays);
+        Ends.Reserve(NumRays);
+        for (int32 Index = 0; Index < NumRays; ++Index)
+        {
+            const FVector& Start = Eyes[Random.RandHelper(Eyes.Num())];
+            FVector Direction = Random.GetUnitVector();
+            Direction.Z *= 0.2;
+            Starts.Add(Start);
+            Ends.Add(Start + Direction.GetSafeNormal() * Random.FRandRange(200.0f, 2000.0f));
+        }
+        
+        TArray<bool> GridClear;
+        GridClear.SetNumUninitialized(NumRays);
+        const double GridStart = FPlatformTime::Seconds();
+        Subsystem->TestSegments(Starts, Ends, GridClear);
+        const double GridSeconds = FPlatformTime::Seconds() - GridStart;
+        
+        // Static geometry only, the grid does not know about anything else
+        FCollisionQueryParams Params(SCENE_QUERY_STAT(VisibilityGridCompare), false);
+        Params.MobilityType = EQueryMobilityType::Static;
+        
+        TArray<bool> TraceClear;
+        TraceClear.SetNumUninitialized(NumRays);
+        const double TraceStart = FPlatformTime::Seconds();
+        for (int32 Index = 0; Index < NumRays; ++Index)
+        {
+            TraceClear[Index] = !World->LineTraceTestByChannel(Starts[Index], Ends[Index], ECC_AISight, Params);
+        }
+        const double TraceSeconds = FPlatformTime::Seconds() - TraceStart;
+        
+        int32 FalseClear = 0;
+        int32 FalseBlocked = 0;
+        for (int32 Index = 0; Index < NumRays; ++Index)
+        {
+            FalseClear += GridClear[Index] && !TraceClear[Index] ? 1 : 0;
+            FalseBlocked += !GridClear[Index] && TraceClear[Index] ? 1 : 0;
+        }
+        
+        UE_LOG(LogRTP, Display, TEXT("Visibility grid vs physics, %d rays: agreement %.2f%% (%d clear only in the grid, %d blocked only in the grid), grid %.0f rays/ms, traces %.0f rays/ms (%.1fx)"),
+            NumRays,
+            100.0 * (NumRays - FalseClear - FalseBlocked) / NumRays,
+            FalseClear, FalseBlocked,
+            NumRays / FMath::Max(GridSeconds * 1000.0, UE_SMALL_NUMBER),
+            NumRays / FMath::Max(TraceSeconds * 1000.0, UE_SMALL_NUMBER),
+            TraceSeconds / FMath::Max(GridSeconds, UE_SMALL_NUMBER));
+    }));
+
+namespace
+{
+    // Stands in for an infinite crossing distance on axes the ray does not move along
+    constexpr float NoCrossing = 1e30f;
+    
+    constexpr int32 NumLanes = 4;
+}
+
+bool UVisibilityGridSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FString UVisibilityGridSubsystem::GetGridPackagePath(const FString& MapName)
+{
+    return FString::Printf(TEXT("/Game/AI/VisibilityGrids/VG_%s"), *MapName);
+}
+
+void UVisibilityGridSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+    
+    // Baked grids are found by convention, add /Game/AI/VisibilityGrids to the directories to always cook
+    const FString MapName = UWorld::RemovePIEPrefix(FPackageName::GetShortName(InWorld.GetOutermost()->GetName()));
+    const FString PackagePath = GetGridPackagePath(MapName);
+    const FString ObjectPath = PackagePath + TEXT(".") + FPackageName::GetShortName(PackagePath);
+    
+    Grid = LoadObject<UVisibilityGridAsset>(nullptr, *ObjectPath, nullptr, LOAD_NoWarn | LOAD_Quiet);
+    if (Grid && !Grid->HasValidLayout())
+    {
+        // Sight falls back to physics traces until the level is baked again
+        UE_LOG(LogRTP, Error, TEXT("Visibility grid %s does not match its %dx%dx%d bricks (%d table entries, %d words), rebake it with -run=BakeVisibilityGrid"),
+            *ObjectPath, Grid->BrickCounts.X, Grid->BrickCounts.Y, Grid->BrickCounts.Z, Grid->BrickTable.Num(), Grid->BrickBits.Num());
+        Grid = nullptr;
+    }
+    
+    if (Grid)
+    {
+        UE_LOG(LogRTP, Log, TEXT("Visibility grid %s: %dx%dx%d voxels of %.0f cm, %d of %d bricks stored"),
+            *ObjectPath, Grid->Dimensions.X, Grid->Dimensions.Y, Grid->Dimensions.Z, Grid->VoxelSize,
+            Grid->BrickBits.Num() / UVisibilityGridAsset::WordsPerBrick, Grid->BrickTable.Num());
+    }
+}
+
+bool UVisibilityGridSubsystem::IsActive() const
+{
+    return Grid && CVarUseVisibilityGrid.GetValueOnAnyThread();
+}
+
+bool UVisibilityGridSubsystem::IsSegmentClear(const FVector& Start, const FVector& End) const
+{
+    bool bClear = true;
+    TestSegments(MakeArrayView(&Start, 1), MakeArrayView(&End, 1), MakeArrayView(&bClear, 1));
+    return bClear;
+}
+
+void UVisibilityGridSubsystem::TestSegments(TConstArrayView<FVector> Starts, TConstArrayView<FVector> Ends, TArrayView<bool> OutClear) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_VisibilityGridQuery);
+    check(Starts.Num() == Ends.Num() && Starts.Num() == OutClear.Num());
+    
+    if (!Grid)
+    {
+        for (bool& bClear : OutClear)
+        {
+            bClear = true;
+        }
+        return;
+    }
+    
+    const FVector Origin = Grid->Origin;
+    const double InvVoxelSize = 1.0 / Grid->VoxelSize;
+    
+    const VectorRegister4Float Zero = VectorZeroFloat();
+    
+    for (int32 First = 0; First < Starts.Num(); First += NumLanes)
+    {
+        // Per-lane DDA state in voxel units, structure of arrays so each axis loads as one register
+        alignas(16) float Cell[3][NumLanes];
+        alignas(16) float Step[3][NumLanes];
+        alignas(16) float TMax[3][NumLanes];
+        alignas(16) float TDelta[3][NumLanes];
+        alignas(16) float Active[NumLanes];
+        int32 Remaining[NumLanes];
+        bool bBlocked[NumLanes];
+        
+        for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+        {
+            const int32 Index = First + Lane;
+            Remaining[Lane] = 0;
+            bBlocked[Lane] = false;
+            
+            for (int32 Axis = 0; Axis < 3; ++Axis)
+            {
+                Cell[Axis][Lane] = 0.0f;
+                Step[Axis][Lane] = 0.0f;
+                TMax[Axis][Lane] = NoCrossing;
+                TDelta[Axis][Lane] = NoCrossing;
+            }
+            
+            if (Index >= Starts.Num())
+            {
+                continue;
+            }
+            
+            const FVector P0 = (Starts[Index] - Origin) * InvVoxelSize;
+            const FVector P1 = (Ends[Index] - Origin) * InvVoxelSize;
+            
+            for (int32 Axis = 0; Axis < 3; ++Axis)
+            {
+                const double C0 = FMath::FloorToDouble(P0[Axis]);
+                const double C1 = FMath::FloorToDouble(P1[Axis]);
+                const double Delta = P1[Axis] - P0[Axis];
+                
+                Cell[Axis][Lane] = static_cast<float>(C0);
+                
+                // Total voxel steps is the Manhattan distance between the end cells, so every lane stops exactly
+                Remaining[Lane] += FMath::Abs(static_cast<int32>(C1 - C0));
+                
+                if (Delta > 0.0)
+                {
+                    Step[Axis][Lane] = 1.0f;
+                    TDelta[Axis][Lane] = static_cast<float>(1.0 / Delta);
+                    TMax[Axis][Lane] = static_cast<float>((C0 + 1.0 - P0[Axis]) / Delta);
+                }
+                else if (Delta < 0.0)
+                {
+                    Step[Axis][Lane] = -1.0f;
+                    TDelta[Axis][Lane] = static_cast<float>(-1.0 / Delta);
+                    TMax[Axis][Lane] = static_cast<float>((P0[Axis] - C0) / -Delta);
+                }
+            }
+            
+            // A wall inside the eye's voxel blocks the segment just like one further along it
+            bBlocked[Lane] = Grid->IsVoxelOccupied(
+                static_cast<int32>(Cell[0][Lane]),
+                static_cast<int32>(Cell[1][Lane]),
+                static_cast<int32>(Cell[2][Lane]));
+        }
+        
+        VectorRegister4Float CellX = VectorLoadAligned(Cell[0]);
+        VectorRegister4Float CellY = VectorLoadAligned(Cell[1]);
+        VectorRegister4Float CellZ = VectorLoadAligned(Cell[2]);
+        VectorRegister4Float TMaxX = VectorLoadAligned(TMax[0]);
+        VectorRegister4Float TMaxY = VectorLoadAligned(TMax[1]);
+        VectorRegister4Float TMaxZ = VectorLoadAligned(TMax[2]);
+        const VectorRegister4Float StepX = VectorLoadAligned(Step[0]);
+        const VectorRegister4Float StepY = VectorLoadAligned(Step[1]);
+        const VectorRegister4Float StepZ = VectorLoadAligned(Step[2]);
+        const VectorRegister4Float TDeltaX = VectorLoadAligned(TDelta[0]);
+        const VectorRegister4Float TDeltaY = VectorLoadAligned(TDelta[1]);
+        const VectorRegister4Float TDeltaZ = VectorLoadAligned(TDelta[2]);
+        
+        while (true)
+        {
+            bool bAnyActive = false;
+            for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+            {
+                const bool bActive = Remaining[Lane] > 0 && !bBlocked[Lane];
+                Active[Lane] = bActive ? 1.0f : 0.0f;
+                bAnyActive |= bActive;
+            }
+            
+            if (!bAnyActive)
+            {
+                break;
+            }
+            
+            const VectorRegister4Float ActiveMask = VectorCompareGT(VectorLoadAligned(Active), Zero);
+            
+            // Advance each active lane along the axis whose boundary it crosses first, ties go X, Y, Z
+            const VectorRegister4Float MaskX = VectorBitwiseAnd(VectorBitwiseAnd(VectorCompareLE(TMaxX, TMaxY), VectorCompareLE(TMaxX, TMaxZ)), ActiveMask);
+            const VectorRegister4Float MaskY = VectorBitwiseAnd(VectorBitwiseAnd(VectorCompareLT(TMaxY, TMaxX), VectorCompareLE(TMaxY, TMaxZ)), ActiveMask);
+            const VectorRegister4Float MaskZ = VectorBitwiseAnd(VectorBitwiseAnd(VectorCompareLT(TMaxZ, TMaxX), VectorCompareLT(TMaxZ, TMaxY)), ActiveMask);
+            
+            CellX = VectorAdd(CellX, VectorBitwiseAnd(StepX, MaskX));
+            CellY = VectorAdd(CellY, VectorBitwiseAnd(StepY, MaskY));
+            CellZ = VectorAdd(CellZ, VectorBitwiseAnd(StepZ, MaskZ));
+            TMaxX = VectorAdd(TMaxX, VectorBitwiseAnd(TDeltaX, MaskX));
+            TMaxY = VectorAdd(TMaxY, VectorBitwiseAnd(TDeltaY, MaskY));
+            TMaxZ = VectorAdd(TMaxZ, VectorBitwiseAnd(TDeltaZ, MaskZ));
+            
+            VectorStoreAligned(CellX, Cell[0]);
+            VectorStoreAligned(CellY, Cell[1]);
+            VectorStoreAligned(CellZ, Cell[2]);
+            
+            // Voxel lookups are gathers, done per lane. The end voxel is tested too, a wall sharing it with the
+            // target may still stand between the two
+            for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+            {
+                if (Active[Lane] != 0.0f)
+                {
+                    --Remaining[Lane];
+                    bBlocked[Lane] = Grid->IsVoxelOccupied(
+                        static_cast<int32>(Cell[0][Lane]),
+                        static_cast<int32>(Cell[1][Lane]),
+                        static_cast<int32>(Cell[2][Lane]));
+                }
+            }
+        }
+        
+        for (int32 Lane = 0; Lane < NumLanes && First + Lane < Starts.Num(); ++Lane)
+        {
+            OutClear[First + Lane] = !bBlocked[Lane];
+        }
+    }
+}
@@ -6,6 +6,26 @@
 #include "Characters/PlayerCharacter.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
+void FPlayerAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	Super::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Game thread: gather everything the worker-thread update needs
+	const UPlayerAnimationInstance* AnimInstance = CastChecked<UPlayerAnimationInstance>(InAnimInstance);
+	if (APlayerCharacter* PlayerCharacter = AnimInstance->PlayerCharacter)
+	{
+		bIsHoldingFlashlight = PlayerCharacter->GetIsHoldingFlashlight();
+		FlashlightMode = PlayerCharacter->GetFlashlightMode();
+		Speed = PlayerCharacter->GetVelocity().Size2D();
+	}
+}
+
+UPlayerAnimationInstance::UPlayerAnimationInstance()
+{
+	// Allow the update to leave the game thread, the graph only reads proxy-copied values
+	bUseMultiThreadedAnimationUpdate = true;
+}
+
 void UPlayerAnimationInstance::NativeInitializeAnimation()
 {
 	Super::NativeInitializeAnimation();
@@ -18,11 +38,12 @@ void UPlayerAnimationInstance::NativeInitializeAnimation()
 	}
 }
 
-void UPlayerAnimationInstance::NativeUpdateAnimation(float DeltaTime)
+void UPlayerAnimationInstance::NativeThreadSafeUpdateAnimation(float DeltaTime)
 {
-	Super::NativeUpdateAnimation(DeltaTime);
-	if (PlayerCharacterMovement)
-	{
-		isHoldingFlashlight = PlayerCharacter->GetIsHoldingFlashlight();
-	}
+	Super::NativeThreadSafeUpdateAnimation(DeltaTime);
+
+	const FPlayerAnimInstanceProxy& AnimProxy = GetProxyOnAnyThread<FPlayerAnimInstanceProxy>();
+	isHoldingFlashlight = AnimProxy.bIsHoldingFlashlight;
+	FlashlightMode = AnimProxy.FlashlightMode;
+	Speed = AnimProxy.Speed;
 }
@@ -1,10 +1,13 @@
 
 #include "Characters/BaseCharacter.h"
+#include "Components/ResourceComponent.h"
 
-ABaseCharacter::ABaseCharacter()
+ABaseCharacter::ABaseCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
 {
 	PrimaryActorTick.bCanEverTick = true;
 
+	Health = CreateDefaultSubobject<UResourceComponent>(TEXT("Health"));
 }
 
 void ABaseCharacter::Tick(float DeltaTime)
@@ -19,6 +22,19 @@ void ABaseCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 
 }
 
+float ABaseCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+
+	if (ActualDamage > 0.0f)
+	{
+		// Consuming restarts the health regen delay
+		Health->Consume(ActualDamage);
+	}
+
+	return ActualDamage;
+}
+
 
 void ABaseCharacter::BeginPlay()
 {
@@ -13,13 +13,22 @@
 #include "Blueprint/UserWidget.h"
 #include "Widgets/StaminaWidget.h"
 #include "Widgets/FlashlightWidget.h"
+#include "Widgets/PlayerHUDViewModel.h"
 #include "Components/SpotLightComponent.h"
+#include "Components/ResourceComponent.h"
+#include "Components/SprintMovementComponent.h"
+#include "Save/CheckpointTypes.h"
+#include "AI/NoiseSubsystem.h"
+#include "Engine/AssetManager.h"
 #include "Kismet/GameplayStatics.h"
 #include "Sound/SoundBase.h"
 
-APlayerCharacter::APlayerCharacter()
+APlayerCharacter::APlayerCharacter(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer.SetDefaultSubobjectClass<USprintMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
-    PrimaryActorTick.bCanEverTick = true;
+    // Stamina is simulated by the movement component, battery and health are computed on read
+    // and the flashlight ticks itself, so the player never ticks
+    PrimaryActorTick.bCanEverTick = false;
 
     ViewCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("ViewCamera"));
     ViewCamera->SetupAttachment(GetCapsuleComponent());
@@ -33,6 +42,8 @@ APlayerCharacter::APlayerCharacter()
     PlayerMesh->CastShadow = false;
     PlayerMesh->SetRelativeLocation(FVector(-30.f, 0.f, -150.f));
 
+    // Lights and sounds only exist where something renders and hears them
+#if !UE_SERVER
 	OuterFlashlight = CreateDefaultSubobject<USpotLightComponent>(TEXT("OuterFlashlight"));
     OuterFlashlight->SetupAttachment(ViewCamera);
     OuterFlashlight->SetRelativeLocation(FVector(-10.f, 0.f, 30.f));
@@ -50,59 +61,31 @@ APlayerCharacter::APlayerCharacter()
 	InnerFlashlight->OuterConeAngle = 45.f/2.f;
     InnerFlashlight->SetVisibility(false);
     
-    // Initialize audio component for flashlight
     FlashlightSound = CreateDefaultSubobject<UAudioComponent>(TEXT("FlashlightSound"));
     FlashlightSound->SetupAttachment(ViewCamera);
     FlashlightSound->bAutoActivate = false;
+#endif
+    
+    // Flashlight logic lives in its own component, which drives both spotlights where they exist
+    Flashlight = CreateDefaultSubobject<UFlashlightComponent>(TEXT("Flashlight"));
+    Flashlight->SetLights(InnerFlashlight, OuterFlashlight);
+    
+    // Battery recharges at 0.5 per second whenever the flashlight is off
+    Battery = CreateDefaultSubobject<UResourceComponent>(TEXT("Battery"));
+    Battery->InitializeResource(100.0f, 0.5f, 0.0f);
+    Battery->SetChangeNotifyStep(1.0f);
+    Flashlight->SetBattery(Battery);
 
-    bIsSprinting = false;
-    MaxStamina = 100.0f;
-    CurrentStamina = MaxStamina;
-    StaminaRecoveryRate = 5.0f;
-    StaminaRegenDelay = 2.0f;
-    StaminaRegenTimer = 0.0f;
-    StaminaRecoveryBuffer = 0.01f;
-    StaminaConsumptionRate = 10.0f;
-	StaminaConsumptionBuffer = 0.3f;
-
-    NormalSpeed = 450.0f;
-    SprintSpeed = 900.0f;
-    GetCharacterMovement()->MaxWalkSpeed = NormalSpeed;    MaxHealth = 100.0f;
-    CurrentHealth = 100.0f;
-    HealthRecoveryTimer = 3.0f;
-    HealthRecoveryRate = 5.0f;
+    // Sprinting and stamina run inside movement prediction so client and server agree on speed
+    SprintMovement = Cast<USprintMovementComponent>(GetCharacterMovement());
+    SprintMovement->MaxWalkSpeed = 450.0f;
+    SprintMovement->SprintSpeed = 900.0f;
+    
+    // Health regenerates at 5 per second, 3 seconds after the last damage
+    Health->InitializeResource(100.0f, 5.0f, 3.0f);
     
     // Initialize flashlight properties
     bIsHoldingFlashlight = false;
-    CurrentBatteryLife = MaxBatteryLife;
-    CurrentFlashlightMode = EFlashlightMode::Off;
-    LastUsedFlashlightMode = EFlashlightMode::Off;
-    bIsFlickering = false;
-}
-
-void APlayerCharacter::Tick(float DeltaTime)
-{
-    Super::Tick(DeltaTime);
-    if (GetWorld())
-    {
-        UpdateStamina(DeltaTime);
-        UpdateFlashlight(DeltaTime);
-
-    if (StaminaWidget)
-    {
-        StaminaWidget->UpdateStaminaBar(CurrentStamina / MaxStamina);
-    }
-    
-    if (FlashlightWidget)
-    {
-        // Update battery UI
-        float BatteryPercent = CurrentBatteryLife / MaxBatteryLife;
-        FlashlightWidget->UpdateBatteryPercentage(BatteryPercent);
-        
-        // Update flashlight mode UI
-        FlashlightWidget->UpdateFlashlightMode(CurrentFlashlightMode);
-    }
-    }
 }
 
 void APlayerCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -140,26 +123,98 @@ void APlayerCharacter::BeginPlay()
         }
     }
     
-    if (StaminaWidgetClass)
+    HUDViewModel = NewObject<UPlayerHUDViewModel>(this);
+    HUDViewModel->SetStaminaFraction(SprintMovement->GetStaminaFraction());
+    HUDViewModel->SetBatteryFraction(Battery->GetFraction());
+    HUDViewModel->SetFlashlightMode(Flashlight->GetMode());
+    
+    // Stamina and battery report once per displayed percent instead of the HUD polling every frame
+    SprintMovement->OnStaminaChanged.AddDynamic(this, &APlayerCharacter::HandleStaminaChanged);
+    Battery->OnValueChanged.AddDynamic(this, &APlayerCharacter::HandleBatteryChanged);
+    
+#if !UE_SERVER
+    // Sounds and widget classes are soft references, stream them in without blocking the level load
+    TArray<FSoftObjectPath> Assets;
+    Assets.Add(FlashlightToggleSound.ToSoftObjectPath());
+    Assets.Add(FlashlightLowBatterySound.ToSoftObjectPath());
+    Assets.Add(StaminaWidgetClass.ToSoftObjectPath());
+    Assets.Add(FlashlightWidgetClass.ToSoftObjectPath());
+    Assets.RemoveAll([](const FSoftObjectPath& Path) { return Path.IsNull(); });
+    if (Assets.Num() > 0)
     {
-        StaminaWidget = CreateWidget<UStaminaWidget>(GetWorld(), StaminaWidgetClass);
+        AssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Assets,
+            FStreamableDelegate::CreateUObject(this, &APlayerCharacter::CreateHUDWidgets), FStreamableManager::AsyncLoadHighPriority);
+    }
+#endif
+    
+    // Keep the held state in sync with the flashlight, including when the battery runs out
+    Flashlight->OnModeChanged.AddDynamic(this, &APlayerCharacter::HandleFlashlightModeChanged);
+    
+    // Footsteps are sampled on a timer since the player does not tick
+    LastFootstepCheckLocation = GetActorLocation();
+    GetWorldTimerManager().SetTimer(FootstepTimerHandle, this, &APlayerCharacter::UpdateFootsteps, 0.1f, true);
+}
+
+void APlayerCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (AssetsHandle.IsValid())
+    {
+        AssetsHandle->ReleaseHandle();
+        AssetsHandle.Reset();
+    }
+    
+    Super::EndPlay(EndPlayReason);
+}
+
+void APlayerCharacter::CreateHUDWidgets()
+{
+#if !UE_SERVER
+    if (UClass* WidgetClass = StaminaWidgetClass.Get())
+    {
+        StaminaWidget = CreateWidget<UStaminaWidget>(GetWorld(), WidgetClass);
         if (StaminaWidget)
         {
+            StaminaWidget->SetViewModel(HUDViewModel);
             StaminaWidget->AddToViewport();
         }
     }
     
-    if (FlashlightWidgetClass)
+    if (UClass* WidgetClass = FlashlightWidgetClass.Get())
     {
-        FlashlightWidget = CreateWidget<UFlashlightWidget>(GetWorld(), FlashlightWidgetClass);
+        FlashlightWidget = CreateWidget<UFlashlightWidget>(GetWorld(), WidgetClass);
         if (FlashlightWidget)
         {
+            FlashlightWidget->SetViewModel(HUDViewModel);
             FlashlightWidget->AddToViewport();
         }
     }
+#endif
+}
+
+void APlayerCharacter::WriteCheckpoint(FPlayerCheckpoint& OutCheckpoint) const
+{
+    OutCheckpoint.Location = GetActorLocation();
+    OutCheckpoint.ControlRotation = GetControlRotation();
+    OutCheckpoint.Health = Health->GetValue();
+    OutCheckpoint.Stamina = SprintMovement->GetStamina();
+    OutCheckpoint.Battery = Battery->GetValue();
+    OutCheckpoint.FlashlightMode = static_cast<uint8>(Flashlight->GetMode());
+}
+
+void APlayerCharacter::ReadCheckpoint(const FPlayerCheckpoint& Checkpoint)
+{
+    SetActorLocation(Checkpoint.Location, false, nullptr, ETeleportType::TeleportPhysics);
+    if (Controller)
+    {
+        Controller->SetControlRotation(Checkpoint.ControlRotation);
+    }
     
-    // Initialize battery life
-    CurrentBatteryLife = MaxBatteryLife;
+    Health->SetValue(Checkpoint.Health);
+    SprintMovement->SetStamina(Checkpoint.Stamina);
+    Battery->SetValue(Checkpoint.Battery);
+    
+    const EFlashlightMode Mode = Checkpoint.FlashlightMode <= static_cast<uint8>(EFlashlightMode::Strobe) ? static_cast<EFlashlightMode>(Checkpoint.FlashlightMode) : EFlashlightMode::Off;
+    Flashlight->SetMode(Mode);
 }
 
 void APlayerCharacter::Move(const FInputActionValue& Value)
@@ -186,379 +241,111 @@ void APlayerCharacter::Look(const FInputActionValue& Value)
 
 void APlayerCharacter::Jump()
 {
-    Super::Jump();
-}
-
-void APlayerCharacter::StartSprinting(const FInputActionValue& Value)
-{
-    if (CurrentStamina / MaxStamina > StaminaRecoveryBuffer && CurrentStamina / MaxStamina > StaminaConsumptionBuffer)
+    if (CanJump())
     {
-        bIsSprinting = true;
-        StaminaRegenTimer = 0.0f;
-        GetCharacterMovement()->MaxWalkSpeed = SprintSpeed;
+        EmitNoise(JumpNoiseLoudness);
     }
+    
+    Super::Jump();
 }
 
-void APlayerCharacter::StopSprinting(const FInputActionValue& Value)
+void APlayerCharacter::Landed(const FHitResult& Hit)
 {
-    bIsSprinting = false;
-    StaminaRegenTimer = 0.0f;
-    GetCharacterMovement()->MaxWalkSpeed = NormalSpeed;
+    Super::Landed(Hit);
+    
+    // Harder landings are louder
+    const float FallSpeed = FMath::Abs(GetCharacterMovement()->Velocity.Z);
+    EmitNoise(LandNoiseLoudness * FMath::Clamp(FallSpeed / LandNoiseFallSpeed, 0.25f, 1.0f));
 }
 
-void APlayerCharacter::UpdateStamina(float DeltaTime)
+void APlayerCharacter::UpdateFootsteps()
 {
-    if (bIsSprinting)
+    const FVector Location = GetActorLocation();
+    
+    if (SprintMovement->IsMovingOnGround())
     {
-        CurrentStamina -= StaminaConsumptionRate * DeltaTime;
-        if (CurrentStamina <= 0.0f)
+        DistanceSinceFootstep += FVector::Dist2D(Location, LastFootstepCheckLocation);
+        if (DistanceSinceFootstep >= FootstepStrideLength)
         {
-            CurrentStamina = 0.0f;
-            bIsSprinting = false;
-            GetCharacterMovement()->MaxWalkSpeed = NormalSpeed;
+            DistanceSinceFootstep = 0.0f;
+            
+            const float SpeedFraction = FMath::Clamp(GetVelocity().Size2D() / SprintMovement->MaxWalkSpeed, 0.0f, 1.0f);
+            EmitNoise(SprintMovement->IsSprinting() ? SprintFootstepLoudness : WalkFootstepLoudness * SpeedFraction);
         }
     }
-    else
+    
+    LastFootstepCheckLocation = Location;
+}
+
+void APlayerCharacter::EmitNoise(float Loudness)
+{
+    if (UNoiseSubsystem* NoiseSubsystem = GetWorld()->GetSubsystem<UNoiseSubsystem>())
     {
-        if (StaminaRegenTimer < StaminaRegenDelay && CurrentStamina / MaxStamina < StaminaRecoveryBuffer)
-        {
-            StaminaRegenTimer += DeltaTime;
-        }
-        else
-        {
-            CurrentStamina += StaminaRecoveryRate * DeltaTime;
-            if (CurrentStamina > MaxStamina)
-            {
-                CurrentStamina = MaxStamina;
-            }
-        }
+        NoiseSubsystem->ReportNoise(this, GetActorLocation(), Loudness);
     }
 }
 
-void APlayerCharacter::ToggleFlashlight(const FInputActionValue& Value)
+void APlayerCharacter::StartSprinting(const FInputActionValue& Value)
+{
+    // The movement component starts sprinting on the next move if there is enough stamina
+    SprintMovement->SetWantsToSprint(true);
+}
+
+void APlayerCharacter::StopSprinting(const FInputActionValue& Value)
 {
-    // If we have enough battery, toggle the flashlight
-    if (CurrentFlashlightMode == EFlashlightMode::Off && CurrentBatteryLife > 0.0f)
+    SprintMovement->SetWantsToSprint(false);
+}
+
+void APlayerCharacter::HandleStaminaChanged(float Value, float MaxValue)
+{
+    if (HUDViewModel)
     {
-        // Turn on the flashlight to the last used mode or Medium mode if it's the first time
-        // We need to store the last mode when turning off
-        if (LastUsedFlashlightMode == EFlashlightMode::Off)
-        {
-            SetFlashlightMode(EFlashlightMode::Medium);
-        }
-        else
-        {
-            SetFlashlightMode(LastUsedFlashlightMode);
-        }
-        bIsHoldingFlashlight = true;
+        HUDViewModel->SetStaminaFraction(Value / MaxValue);
     }
-    else
+}
+
+void APlayerCharacter::HandleBatteryChanged(float Value, float MaxValue)
+{
+    if (HUDViewModel)
     {
-        // Remember the current mode before turning off
-        LastUsedFlashlightMode = CurrentFlashlightMode;
-        
-        // Turn off the flashlight
-        SetFlashlightMode(EFlashlightMode::Off);
-        bIsHoldingFlashlight = false;
+        HUDViewModel->SetBatteryFraction(Value / MaxValue);
     }
+}
+
+void APlayerCharacter::ToggleFlashlight(const FInputActionValue& Value)
+{
+    // Turn on to the last used mode, or off if already on or out of battery
+    Flashlight->Toggle();
+    EmitNoise(FlashlightClickLoudness);
     
     // Play toggle sound
-    if (FlashlightToggleSound)
+    if (USoundBase* ToggleSound = FlashlightToggleSound.Get())
     {
-        UGameplayStatics::PlaySoundAtLocation(this, FlashlightToggleSound, GetActorLocation());
+        UGameplayStatics::PlaySoundAtLocation(this, ToggleSound, GetActorLocation());
     }
 }
 
 void APlayerCharacter::CycleFlashlightMode(const FInputActionValue& Value)
 {
     // Only cycle if the flashlight is on and has battery
-    if (bIsHoldingFlashlight && CurrentBatteryLife > 0.0f)
+    if (Flashlight->CycleMode())
     {
-        // Cycle through modes
-        switch (CurrentFlashlightMode)
-        {
-            case EFlashlightMode::Low:
-                SetFlashlightMode(EFlashlightMode::Medium);
-                break;
-            case EFlashlightMode::Medium:
-                SetFlashlightMode(EFlashlightMode::High);
-                break;
-            case EFlashlightMode::High:
-                SetFlashlightMode(EFlashlightMode::Strobe);
-                break;
-            case EFlashlightMode::Strobe:
-                SetFlashlightMode(EFlashlightMode::Low);
-                break;
-            default:
-                SetFlashlightMode(EFlashlightMode::Medium);
-                break;
-        }
+        EmitNoise(FlashlightClickLoudness);
         
         // Play toggle sound at a lower volume for mode changes
-        if (FlashlightToggleSound)
-        {
-            UGameplayStatics::PlaySoundAtLocation(this, FlashlightToggleSound, GetActorLocation(), 0.5f);
-        }
-    }
-}
-
-void APlayerCharacter::UpdateFlashlight(float DeltaTime)
-{
-    // Only update if flashlight is on
-    if (CurrentFlashlightMode != EFlashlightMode::Off)
-    {
-        // Calculate battery drain based on current mode
-        float DrainMultiplier = 0.0f;
-        switch (CurrentFlashlightMode)
-        {
-            case EFlashlightMode::Low:
-                DrainMultiplier = BatteryDrainMultiplierLow;
-                break;
-            case EFlashlightMode::Medium:
-                DrainMultiplier = BatteryDrainMultiplierMedium;
-                break;
-            case EFlashlightMode::High:
-                DrainMultiplier = BatteryDrainMultiplierHigh;
-                break;
-            case EFlashlightMode::Strobe:
-                DrainMultiplier = BatteryDrainMultiplierStrobe;
-                break;
-            default:
-                DrainMultiplier = 0.0f;
-                break;
-        }
-          // Drain battery
-        CurrentBatteryLife -= BatteryDrainRate * DrainMultiplier * DeltaTime;
-        
-        // Handle low battery effects - continue flickering until completely depleted
-        if (CurrentBatteryLife <= LowBatteryThreshold)
-        {
-            // Update low battery flicker - intensity increases as battery depletes
-            LowBatteryFlickerTimer += DeltaTime;
-            if (LowBatteryFlickerTimer >= 1.0f / LowBatteryFlickerFrequency)
-            {
-                LowBatteryFlickerTimer = 0.0f;
-                  // Random chance to flicker based on battery percentage
-                // Higher chance to flicker as battery depletes
-                float FlickerChance = 1.0f - (CurrentBatteryLife / LowBatteryThreshold);
-                
-                // Ensure flickering still occurs at 0% battery
-                if (CurrentBatteryLife <= 5.0f) // Very low battery threshold
-                {
-                    FlickerChance = 0.9f; // Very high chance to flicker, but not constant
-                }
-                
-                if (FMath::FRand() < FlickerChance)
-                {
-                    // More dramatic flickering for very low battery
-                    float FlickerIntensity = 0.5f;                    if (CurrentBatteryLife < 5.0f)
-                    {
-                        // More severe flickering (dimmer) when almost depleted
-                        FlickerIntensity = 0.2f;
-                    }
-                    
-                    // Temporarily dim the lights
-                    InnerFlashlight->SetIntensity(InnerFlashlight->Intensity * FlickerIntensity);
-                    OuterFlashlight->SetIntensity(OuterFlashlight->Intensity * FlickerIntensity);
-                    
-                    // Set the flickering flag
-                    bIsFlickering = true;
-                    
-                    // Schedule restoration to normal brightness
-                    FTimerHandle FlickerRestoreTimerHandle;
-                    GetWorldTimerManager().SetTimer(
-                        FlickerRestoreTimerHandle,
-                        [this]()
-                        {
-                            // Reset flickering flag
-                            bIsFlickering = false;
-                            
-                            // Restore original intensity based on current mode
-                            float TargetIntensity = 0.0f;
-                            switch (CurrentFlashlightMode)
-                            {
-                                case EFlashlightMode::Low:
-                                    TargetIntensity = FlashlightIntensityLow;
-                                    break;
-                                case EFlashlightMode::Medium:
-                                    TargetIntensity = FlashlightIntensityMedium;
-                                    break;
-                                case EFlashlightMode::High:
-                                    TargetIntensity = FlashlightIntensityHigh;
-                                    break;
-                                default:
-                                    break;
-                            }
-                              if (CurrentFlashlightMode != EFlashlightMode::Off && CurrentFlashlightMode != EFlashlightMode::Strobe)
-                            {
-                                // Apply gradual dimming based on battery percentage
-                                if (CurrentBatteryLife < DimmingStartThreshold)
-                                {
-                                    // Calculate dimming factor (from 0.1 at 0% to 1.0 at DimmingStartThreshold%)
-                                    float DimFactor = FMath::Max(0.1f, CurrentBatteryLife / DimmingStartThreshold);
-                                    TargetIntensity *= DimFactor;
-                                }
-                                
-                                InnerFlashlight->SetIntensity(TargetIntensity);
-                                OuterFlashlight->SetIntensity(TargetIntensity * 0.5f);
-                            }                },
-                        // Longer flicker duration for nearly depleted battery
-                        (CurrentBatteryLife < 5.0f) ? 0.2f : 0.1f,
-                        false
-                    );
-                }
-            }
-        }
-        
-        // Apply gradual dimming effect based on battery level
-        if (CurrentFlashlightMode != EFlashlightMode::Off && CurrentFlashlightMode != EFlashlightMode::Strobe && !bIsFlickering)
-        {
-            float CurrentIntensity = 0.0f;
-            switch (CurrentFlashlightMode)
-            {
-                case EFlashlightMode::Low:
-                    CurrentIntensity = FlashlightIntensityLow;
-                    break;
-                case EFlashlightMode::Medium:
-                    CurrentIntensity = FlashlightIntensityMedium;
-                    break;
-                case EFlashlightMode::High:
-                    CurrentIntensity = FlashlightIntensityHigh;
-                    break;
-                default:
-                    break;
-            }
-            
-            // Start dimming gradually based on DimmingStartThreshold
-            if (CurrentBatteryLife < DimmingStartThreshold)
-            {
-                // Calculate dimming factor (from 0.1 at 0% to 1.0 at DimmingStartThreshold%)
-                float DimFactor = FMath::Max(0.1f, CurrentBatteryLife / DimmingStartThreshold);
-                
-                // Apply dimming                InnerFlashlight->SetIntensity(CurrentIntensity * DimFactor);
-                OuterFlashlight->SetIntensity(CurrentIntensity * 0.5f * DimFactor);
-            }
-        }
-        
-        // Handle strobe effect
-        if (CurrentFlashlightMode == EFlashlightMode::Strobe)
-        {
-            StrobeTimer += DeltaTime;
-            if (StrobeTimer >= StrobeInterval)
-            {
-                StrobeTimer = 0.0f;
-                bStrobeState = !bStrobeState;
-                
-                InnerFlashlight->SetVisibility(bStrobeState);
-                OuterFlashlight->SetVisibility(bStrobeState);
-            }
-        }
-        
-        // If battery is depleted, turn off the flashlight
-        if (CurrentBatteryLife <= 0.0f)
+        if (USoundBase* ToggleSound = FlashlightToggleSound.Get())
         {
-            CurrentBatteryLife = 0.0f;
-            SetFlashlightMode(EFlashlightMode::Off);
-            bIsHoldingFlashlight = false;
-        }
-    }
-    else
-    {
-        // Recharge battery when flashlight is off
-        if (CurrentBatteryLife < MaxBatteryLife)
-        {
-            CurrentBatteryLife += BatteryRechargeRate * DeltaTime;
-            if (CurrentBatteryLife > MaxBatteryLife)
-            {
-                CurrentBatteryLife = MaxBatteryLife;
-            }
+            UGameplayStatics::PlaySoundAtLocation(this, ToggleSound, GetActorLocation(), 0.5f);
         }
     }
 }
 
-void APlayerCharacter::SetFlashlightMode(EFlashlightMode NewMode)
+void APlayerCharacter::HandleFlashlightModeChanged(EFlashlightMode NewMode)
 {
-    CurrentFlashlightMode = NewMode;
-      // Reset strobe variables if changing modes
-    StrobeTimer = 0.0f;
-    bStrobeState = true;
+    bIsHoldingFlashlight = NewMode != EFlashlightMode::Off;
     
-    // Update flashlight settings based on mode    
-    switch (NewMode)
+    if (HUDViewModel)
     {
-        case EFlashlightMode::Off:
-            InnerFlashlight->SetVisibility(false);
-            OuterFlashlight->SetVisibility(false);
-            bIsFlickering = false; // Reset flickering flag when turning off
-            break;
-            
-        case EFlashlightMode::Low:
-        {            InnerFlashlight->SetVisibility(true);
-            OuterFlashlight->SetVisibility(true);
-              
-            float TargetIntensity = FlashlightIntensityLow;
-            // Apply gradual dimming effect based on battery level
-            if (CurrentBatteryLife < DimmingStartThreshold)
-            {
-                // Calculate dimming factor (from 0.1 at 0% to 1.0 at DimmingStartThreshold%)
-                float DimFactor = FMath::Max(0.1f, CurrentBatteryLife / DimmingStartThreshold);
-                TargetIntensity *= DimFactor;
-            }
-            
-            InnerFlashlight->SetIntensity(TargetIntensity);
-            OuterFlashlight->SetIntensity(TargetIntensity * 0.5f);
-            OuterFlashlight->OuterConeAngle = 40.0f;
-            InnerFlashlight->OuterConeAngle = 25.0f;
-            break;        }
-            
-        case EFlashlightMode::Medium:
-        {
-            InnerFlashlight->SetVisibility(true);
-            OuterFlashlight->SetVisibility(true);
-              
-            float TargetIntensity = FlashlightIntensityMedium;
-            // Apply gradual dimming effect based on battery level
-            if (CurrentBatteryLife < DimmingStartThreshold)
-            {
-                // Calculate dimming factor (from 0.1 at 0% to 1.0 at DimmingStartThreshold%)
-                float DimFactor = FMath::Max(0.1f, CurrentBatteryLife / DimmingStartThreshold);
-                TargetIntensity *= DimFactor;
-            }
-            
-            InnerFlashlight->SetIntensity(TargetIntensity);
-            OuterFlashlight->SetIntensity(TargetIntensity * 0.5f);
-            OuterFlashlight->OuterConeAngle = 45.0f;
-            InnerFlashlight->OuterConeAngle = 45.0f/2.0f;
-            break;        }
-            
-        case EFlashlightMode::High:
-        {
-            InnerFlashlight->SetVisibility(true);
-            OuterFlashlight->SetVisibility(true);
-              
-            float TargetIntensity = FlashlightIntensityHigh;
-            // Apply gradual dimming effect based on battery level
-            if (CurrentBatteryLife < DimmingStartThreshold)
-            {
-                // Calculate dimming factor (from 0.1 at 0% to 1.0 at DimmingStartThreshold%)
-                float DimFactor = FMath::Max(0.1f, CurrentBatteryLife / DimmingStartThreshold);
-                TargetIntensity *= DimFactor;
-            }
-            
-            InnerFlashlight->SetIntensity(TargetIntensity);
-            OuterFlashlight->SetIntensity(TargetIntensity * 0.5f);
-            OuterFlashlight->OuterConeAngle = 50.0f;
-            InnerFlashlight->OuterConeAngle = 30.0f;
-            break;
-        }
-            
-        case EFlashlightMode::Strobe:
-            InnerFlashlight->SetVisibility(true);
-            OuterFlashlight->SetVisibility(true);
-            InnerFlashlight->SetIntensity(FlashlightIntensityHigh * 1.2f); // Extra bright for strobe
-            OuterFlashlight->SetIntensity(FlashlightIntensityHigh * 0.6f);
-            OuterFlashlight->OuterConeAngle = 45.0f;
-            InnerFlashlight->OuterConeAngle = 30.0f;
-            break;
+        HUDViewModel->SetFlashlightMode(NewMode);
     }
 }
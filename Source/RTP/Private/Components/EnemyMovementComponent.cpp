@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/EnemyMovementComponent.h"
+#include "AI/CrowdAvoidanceSubsystem.h"
+#include "Engine/World.h"
+
+void UEnemyMovementComponent::BeginPlay()
+{
+    Super::BeginPlay();
+    
+    if (UCrowdAvoidanceSubsystem* CrowdSubsystem = GetWorld()->GetSubsystem<UCrowdAvoidanceSubsystem>())
+    {
+        CrowdSubsystem->RegisterAgent(this);
+    }
+}
+
+void UEnemyMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UCrowdAvoidanceSubsystem* CrowdSubsystem = GetWorld()->GetSubsystem<UCrowdAvoidanceSubsystem>())
+    {
+        CrowdSubsystem->UnregisterAgent(this);
+    }
+    
+    Super::EndPlay(EndPlayReason);
+}
+
+void UEnemyMovementComponent::RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed)
+{
+    Super::RequestDirectMove(MoveVelocity, bForceMaxSpeed);
+    
+    // Path following calls this every frame while moving, the crowd treats it as where the enemy wants to go
+    const float Speed = bForceMaxSpeed ? GetMaxSpeed() : FMath::Min(MoveVelocity.Size2D(), GetMaxSpeed());
+    PreferredVelocity = FVector2f(MoveVelocity.X, MoveVelocity.Y).GetSafeNormal() * Speed;
+    PreferredVelocityFrame = GFrameCounter;
+}
+
+bool UEnemyMovementComponent::HasPreferredVelocity() const
+{
+    return PreferredVelocityFrame != 0 && GFrameCounter - PreferredVelocityFrame <= 1;
+}
+
+void UEnemyMovementComponent::SetAvoidanceVelocity(const FVector2f& InAvoidanceVelocity)
+{
+    AvoidanceVelocity = InAvoidanceVelocity;
+    bHasAvoidanceVelocity = true;
+}
+
+void UEnemyMovementComponent::CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration)
+{
+    Super::CalcVelocity(DeltaTime, Friction, bFluid, BrakingDeceleration);
+    
+    if (!bHasAvoidanceVelocity || !IsMovingOnGround() || !HasPreferredVelocity())
+    {
+        return;
+    }
+    
+    // Turn towards the avoidance velocity no faster than the character could accelerate
+    const FVector2f CurrentVelocity(Velocity.X, Velocity.Y);
+    const FVector2f Delta = AvoidanceVelocity - CurrentVelocity;
+    const float MaxDelta = GetMaxAcceleration() * DeltaTime;
+    const FVector2f NewVelocity = CurrentVelocity + (Delta.SizeSquared() > FMath::Square(MaxDelta) ? Delta.GetSafeNormal() * MaxDelta : Delta);
+    
+    Velocity.X = NewVelocity.X;
+    Velocity.Y = NewVelocity.Y;
+}
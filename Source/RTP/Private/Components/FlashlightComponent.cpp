@@ -0,0 +1,271 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/FlashlightComponent.h"
+#include "Components/SpotLightComponent.h"
+#include "Components/ResourceComponent.h"
+#include "Telemetry/TelemetryRecorder.h"
+#include "FlashlightSim.h"
+
+UFlashlightComponent::UFlashlightComponent()
+{
+    // Ticking is switched on and off by UpdateTickEnabled
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UFlashlightComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    if (Battery)
+    {
+        Battery->OnDepleted.AddDynamic(this, &UFlashlightComponent::HandleBatteryDepleted);
+    }
+
+    BuildFlickerTimeline();
+    ApplyLightState(true);
+    UpdateTickEnabled();
+}
+
+void UFlashlightComponent::SetLights(USpotLightComponent* InInnerLight, USpotLightComponent* InOuterLight)
+{
+    InnerLight = InInnerLight;
+    OuterLight = InOuterLight;
+}
+
+void UFlashlightComponent::SetBattery(UResourceComponent* InBattery)
+{
+    Battery = InBattery;
+}
+
+float UFlashlightComponent::GetBatteryPercent() const
+{
+    return Battery ? Battery->GetFraction() : 0.0f;
+}
+
+float UFlashlightComponent::GetBatteryLife() const
+{
+    return Battery ? Battery->GetValue() : 0.0f;
+}
+
+void UFlashlightComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    // Only reached while the light is on, the battery drains analytically in the resource component
+    ModeTime += DeltaTime;
+    ApplyLightState();
+}
+
+float UFlashlightComponent::GetModeDrainRate() const
+{
+    // Calculate battery drain based on current mode
+    switch (CurrentMode)
+    {
+        case EFlashlightMode::Low:
+            return BatteryDrainRate * BatteryDrainMultiplierLow;
+        case EFlashlightMode::Medium:
+            return BatteryDrainRate * BatteryDrainMultiplierMedium;
+        case EFlashlightMode::High:
+            return BatteryDrainRate * BatteryDrainMultiplierHigh;
+        case EFlashlightMode::Strobe:
+            return BatteryDrainRate * BatteryDrainMultiplierStrobe;
+        default:
+            return 0.0f;
+    }
+}
+
+void UFlashlightComponent::HandleBatteryDepleted()
+{
+    // If battery is depleted, turn off the flashlight
+    if (IsOn())
+    {
+        SetMode(EFlashlightMode::Off);
+    }
+}
+
+void UFlashlightComponent::SetMode(EFlashlightMode NewMode)
+{
+    const EFlashlightMode PreviousMode = CurrentMode;
+    CurrentMode = NewMode;
+
+    // Restart strobe and flicker timing on every mode change
+    ModeTime = 0.0f;
+
+    // Cone angles only change with the mode, so they are set here rather than per frame
+    float InnerConeAngle = 45.0f / 2.0f;
+    float OuterConeAngle = 45.0f;
+    switch (NewMode)
+    {
+        case EFlashlightMode::Low:
+            InnerConeAngle = 25.0f;
+            OuterConeAngle = 40.0f;
+            break;
+        case EFlashlightMode::High:
+            InnerConeAngle = 30.0f;
+            OuterConeAngle = 50.0f;
+            break;
+        case EFlashlightMode::Strobe:
+            InnerConeAngle = 30.0f;
+            OuterConeAngle = 45.0f;
+            break;
+        default:
+            break;
+    }
+
+    if (NewMode != EFlashlightMode::Off && InnerLight && OuterLight)
+    {
+        InnerLight->SetOuterConeAngle(InnerConeAngle);
+        OuterLight->SetOuterConeAngle(OuterConeAngle);
+    }
+
+    if (Battery)
+    {
+        Battery->SetDrainRate(GetModeDrainRate());
+    }
+
+    ApplyLightState(true);
+    UpdateTickEnabled();
+
+    if (PreviousMode != NewMode)
+    {
+        RTP_TELEMETRY(FlashlightModeChanged, GetOwner(), GetOwner()->GetActorLocation(), static_cast<uint32>(NewMode));
+        OnModeChanged.Broadcast(NewMode);
+    }
+}
+
+bool UFlashlightComponent::Toggle()
+{
+    // If we have enough battery, turn on to the last used mode or Medium if it's the first time
+    if (CurrentMode == EFlashlightMode::Off && GetBatteryLife() > 0.0f)
+    {
+        SetMode(LastUsedMode == EFlashlightMode::Off ? EFlashlightMode::Medium : LastUsedMode);
+    }
+    else
+    {
+        // Remember the current mode before turning off
+        LastUsedMode = CurrentMode;
+        SetMode(EFlashlightMode::Off);
+    }
+
+    return IsOn();
+}
+
+bool UFlashlightComponent::CycleMode()
+{
+    // Only cycle if the flashlight is on and has battery
+    if (!IsOn() || GetBatteryLife() <= 0.0f)
+    {
+        return false;
+    }
+
+    switch (CurrentMode)
+    {
+        case EFlashlightMode::Low:
+            SetMode(EFlashlightMode::Medium);
+            break;
+        case EFlashlightMode::Medium:
+            SetMode(EFlashlightMode::High);
+            break;
+        case EFlashlightMode::High:
+            SetMode(EFlashlightMode::Strobe);
+            break;
+        case EFlashlightMode::Strobe:
+            SetMode(EFlashlightMode::Low);
+            break;
+        default:
+            SetMode(EFlashlightMode::Medium);
+            break;
+    }
+
+    return true;
+}
+
+void UFlashlightComponent::SetFlickerSeed(int32 NewSeed)
+{
+    FlickerSeed = NewSeed;
+    BuildFlickerTimeline();
+}
+
+float UFlashlightComponent::GetModeIntensity(EFlashlightMode Mode) const
+{
+    switch (Mode)
+    {
+        case EFlashlightMode::Low:
+            return FlashlightIntensityLow;
+        case EFlashlightMode::Medium:
+            return FlashlightIntensityMedium;
+        case EFlashlightMode::High:
+            return FlashlightIntensityHigh;
+        case EFlashlightMode::Strobe:
+            // Extra bright for strobe
+            return FlashlightIntensityHigh * 1.2f;
+        default:
+            return 0.0f;
+    }
+}
+
+void UFlashlightComponent::BuildFlickerTimeline()
+{
+    FFlashlightSim::BuildFlickerTimeline(FlickerSeed, FMath::Max(FlickerTimelineLength, 8), FlickerTimeline);
+}
+
+float UFlashlightComponent::EvaluateIntensityScale() const
+{
+    if (!IsOn())
+    {
+        return 0.0f;
+    }
+
+    // Strobe is unaffected by dimming
+    if (CurrentMode == EFlashlightMode::Strobe)
+    {
+        return FFlashlightSim::EvaluateStrobeScale(ModeTime, StrobeInterval);
+    }
+
+    FFlashlightBatteryParams Params;
+    Params.DimmingStartThreshold = DimmingStartThreshold;
+    Params.LowBatteryThreshold = LowBatteryThreshold;
+    Params.LowBatteryFlickerFrequency = LowBatteryFlickerFrequency;
+    return FFlashlightSim::EvaluateBatteryScale(Params, FlickerTimeline, GetBatteryLife(), ModeTime);
+}
+
+void UFlashlightComponent::ApplyLightState(bool bForce)
+{
+    if (!InnerLight || !OuterLight)
+    {
+        return;
+    }
+
+    const float InnerIntensity = GetModeIntensity(CurrentMode) * EvaluateIntensityScale();
+    const bool bVisible = InnerIntensity > 0.0f;
+
+    if (bForce || bVisible != bAppliedVisible)
+    {
+        InnerLight->SetVisibility(bVisible);
+        OuterLight->SetVisibility(bVisible);
+        bAppliedVisible = bVisible;
+    }
+
+    // Leave the render state alone while the light is hidden or the change is too small to see
+    if (!bVisible)
+    {
+        return;
+    }
+
+    const float Threshold = IntensityChangeThreshold * FMath::Max(AppliedInnerIntensity, 1.0f);
+    if (bForce || FMath::Abs(InnerIntensity - AppliedInnerIntensity) > Threshold)
+    {
+        InnerLight->SetIntensity(InnerIntensity);
+        OuterLight->SetIntensity(InnerIntensity * 0.5f);
+        AppliedInnerIntensity = InnerIntensity;
+    }
+}
+
+void UFlashlightComponent::UpdateTickEnabled()
+{
+    // Recharging happens in the battery resource, so there is nothing to tick while the light is off,
+    // nor ever without lights to animate, as on a dedicated server
+    SetComponentTickEnabled(IsOn() && InnerLight && OuterLight);
+}
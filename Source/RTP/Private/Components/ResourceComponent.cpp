@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/ResourceComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
+
+namespace
+{
+    // Wake up slightly after the computed crossing so the value read in HandleWakeup is past it
+    constexpr double WakeupSlack = 0.001;
+}
+
+UResourceComponent::UResourceComponent()
+{
+    // Values are computed on read, the component never ticks
+    PrimaryComponentTick.bCanEverTick = false;
+    SetIsReplicatedByDefault(true);
+
+    Segment.AnchorValue = MaxValue;
+}
+
+void UResourceComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+    DOREPLIFETIME(UResourceComponent, Segment);
+}
+
+void UResourceComponent::InitializeResource(float InMaxValue, float InRegenRate, float InRegenDelay, float InRegenDelayBelowFraction)
+{
+    MaxValue = InMaxValue;
+    RegenRate = InRegenRate;
+    RegenDelay = InRegenDelay;
+    RegenDelayBelowFraction = InRegenDelayBelowFraction;
+
+    Segment.AnchorValue = MaxValue;
+    Segment.AnchorTime = 0.0;
+    Segment.DrainRate = 0.0f;
+}
+
+void UResourceComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    Segment.AnchorTime = GetNow();
+    LastDispatchedValue = GetValue();
+    bRegenStartDispatched = false;
+
+    ScheduleNextWakeup();
+}
+
+void UResourceComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UWorld* World = GetWorld())
+    {
+        World->GetTimerManager().ClearTimer(WakeupTimerHandle);
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+double UResourceComponent::GetNow() const
+{
+    const UWorld* World = GetWorld();
+    if (!World)
+    {
+        return 0.0;
+    }
+
+    // Server time keeps replicated anchors meaningful on clients
+    if (const AGameStateBase* GameState = World->GetGameState())
+    {
+        return GameState->GetServerWorldTimeSeconds();
+    }
+
+    return World->GetTimeSeconds();
+}
+
+FResourceParams UResourceComponent::GetParams() const
+{
+    FResourceParams Params;
+    Params.MaxValue = MaxValue;
+    Params.RegenRate = RegenRate;
+    Params.RegenDelay = RegenDelay;
+    Params.RegenDelayBelowFraction = RegenDelayBelowFraction;
+    return Params;
+}
+
+FResourceLine UResourceComponent::GetLine() const
+{
+    FResourceLine Line;
+    Line.AnchorValue = Segment.AnchorValue;
+    Line.AnchorTime = Segment.AnchorTime;
+    Line.DrainRate = Segment.DrainRate;
+    return Line;
+}
+
+double UResourceComponent::GetMoveStartTime() const
+{
+    return FResourceSim::GetMoveStartTime(GetParams(), GetLine());
+}
+
+float UResourceComponent::GetSlope() const
+{
+    return FResourceSim::GetSlope(GetParams(), GetLine());
+}
+
+float UResourceComponent::GetValue() const
+{
+    return GetValueAtTime(GetNow());
+}
+
+float UResourceComponent::GetValueAtTime(double Time) const
+{
+    return FResourceSim::GetValueAtTime(GetParams(), GetLine(), Time);
+}
+
+void UResourceComponent::SetDrainRate(float NewDrainRate)
+{
+    NewDrainRate = FMath::Max(0.0f, NewDrainRate);
+    if (NewDrainRate != Segment.DrainRate)
+    {
+        Reanchor(GetValue(), NewDrainRate);
+    }
+}
+
+void UResourceComponent::Consume(float Amount)
+{
+    Reanchor(GetValue() - Amount, Segment.DrainRate);
+}
+
+void UResourceComponent::Restore(float Amount)
+{
+    Reanchor(GetValue() + Amount, Segment.DrainRate);
+}
+
+void UResourceComponent::SetValue(float NewValue)
+{
+    Reanchor(NewValue, Segment.DrainRate);
+}
+
+void UResourceComponent::AddThreshold(float Threshold)
+{
+    Thresholds.AddUnique(Threshold);
+
+    if (HasBegunPlay())
+    {
+        ScheduleNextWakeup();
+    }
+}
+
+void UResourceComponent::SetChangeNotifyStep(float Step)
+{
+    ChangeNotifyStep = FMath::Max(0.0f, Step);
+
+    if (HasBegunPlay())
+    {
+        ScheduleNextWakeup();
+    }
+}
+
+void UResourceComponent::Reanchor(float NewValue, float NewDrainRate)
+{
+    Segment.AnchorValue = FMath::Clamp(NewValue, 0.0f, MaxValue);
+    Segment.AnchorTime = GetNow();
+    Segment.DrainRate = NewDrainRate;
+    bRegenStartDispatched = false;
+
+    DispatchEvents(true);
+    ScheduleNextWakeup();
+}
+
+void UResourceComponent::OnRep_Segment()
+{
+    bRegenStartDispatched = false;
+
+    DispatchEvents(true);
+    ScheduleNextWakeup();
+}
+
+double UResourceComponent::ComputeNextEventTime(double Now) const
+{
+    return FResourceSim::ComputeNextEventTime(GetParams(), GetLine(), Now, Thresholds, ChangeNotifyStep, bRegenStartDispatched);
+}
+
+void UResourceComponent::ScheduleNextWakeup()
+{
+    UWorld* World = GetWorld();
+    if (!World)
+    {
+        return;
+    }
+
+    FTimerManager& TimerManager = World->GetTimerManager();
+
+    const double Now = GetNow();
+    const double NextTime = ComputeNextEventTime(Now);
+    if (NextTime == TNumericLimits<double>::Max())
+    {
+        TimerManager.ClearTimer(WakeupTimerHandle);
+        return;
+    }
+
+    const float Delay = static_cast<float>(FMath::Max(NextTime - Now, 0.0) + WakeupSlack);
+    TimerManager.SetTimer(WakeupTimerHandle, this, &UResourceComponent::HandleWakeup, Delay, false);
+}
+
+void UResourceComponent::HandleWakeup()
+{
+    DispatchEvents(false);
+    ScheduleNextWakeup();
+}
+
+void UResourceComponent::DispatchEvents(bool bExplicitChange)
+{
+    const float PreviousValue = LastDispatchedValue;
+    const float Value = GetValue();
+    LastDispatchedValue = Value;
+
+    if (!IsDraining() && !bRegenStartDispatched && RegenRate > 0.0f && Segment.AnchorValue < MaxValue && GetNow() >= GetMoveStartTime())
+    {
+        bRegenStartDispatched = true;
+        OnRegenStarted.Broadcast();
+    }
+
+    if (bExplicitChange || Value != PreviousValue)
+    {
+        OnValueChanged.Broadcast(Value, MaxValue);
+    }
+
+    for (const float Threshold : Thresholds)
+    {
+        if (PreviousValue < Threshold && Value >= Threshold)
+        {
+            OnThresholdCrossed.Broadcast(Threshold, true);
+        }
+        else if (PreviousValue >= Threshold && Value < Threshold)
+        {
+            OnThresholdCrossed.Broadcast(Threshold, false);
+        }
+    }
+
+    if (PreviousValue > 0.0f && Value <= 0.0f)
+    {
+        OnDepleted.Broadcast();
+    }
+    else if (PreviousValue < MaxValue && Value >= MaxValue)
+    {
+        OnFull.Broadcast();
+    }
+}
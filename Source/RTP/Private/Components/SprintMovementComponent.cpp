@@ -0,0 +1,239 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Components/SprintMovementComponent.h"
+#include "GameFramework/Character.h"
+#include "StaminaSim.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Sprint Client Corrections"), STAT_SprintClientCorrections, STATGROUP_RTPMovement);
+
+/**
+ * Saved move that records the sprint request as input and the stamina state at the start of the move.
+ */
+class FSavedMove_Sprint : public FSavedMove_Character
+{
+public:
+    typedef FSavedMove_Character Super;
+
+    virtual void Clear() override
+    {
+        Super::Clear();
+
+        bSavedWantsToSprint = false;
+        bStartIsSprinting = false;
+        StartStamina = 0.0f;
+        StartStaminaRegenDelayRemaining = 0.0f;
+    }
+
+    virtual uint8 GetCompressedFlags() const override
+    {
+        uint8 Result = Super::GetCompressedFlags();
+        if (bSavedWantsToSprint)
+        {
+            Result |= FLAG_Custom_0;
+        }
+        return Result;
+    }
+
+    virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override
+    {
+        const FSavedMove_Sprint* NewSprintMove = static_cast<const FSavedMove_Sprint*>(NewMove.Get());
+        if (bSavedWantsToSprint != NewSprintMove->bSavedWantsToSprint || bStartIsSprinting != NewSprintMove->bStartIsSprinting)
+        {
+            return false;
+        }
+
+        return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+    }
+
+    virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override
+    {
+        Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+        if (const USprintMovementComponent* Movement = Cast<USprintMovementComponent>(C->GetCharacterMovement()))
+        {
+            bSavedWantsToSprint = Movement->bWantsToSprint;
+            bStartIsSprinting = Movement->bIsSprinting;
+            StartStamina = Movement->Stamina;
+            StartStaminaRegenDelayRemaining = Movement->StaminaRegenDelayRemaining;
+        }
+    }
+
+    virtual void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation) override
+    {
+        Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
+
+        // The combined move is re-simulated from the old move's start, so rewind stamina with it
+        const FSavedMove_Sprint* OldSprintMove = static_cast<const FSavedMove_Sprint*>(OldMove);
+        if (USprintMovementComponent* Movement = Cast<USprintMovementComponent>(InCharacter->GetCharacterMovement()))
+        {
+            Movement->bIsSprinting = OldSprintMove->bStartIsSprinting;
+            Movement->Stamina = OldSprintMove->StartStamina;
+            Movement->StaminaRegenDelayRemaining = OldSprintMove->StartStaminaRegenDelayRemaining;
+        }
+    }
+
+    virtual void PrepMoveFor(ACharacter* C) override
+    {
+        Super::PrepMoveFor(C);
+
+        // Only the input is restored for replays, stamina carries forward from the corrected state
+        if (USprintMovementComponent* Movement = Cast<USprintMovementComponent>(C->GetCharacterMovement()))
+        {
+            Movement->bWantsToSprint = bSavedWantsToSprint;
+        }
+    }
+
+    bool bSavedWantsToSprint = false;
+    bool bStartIsSprinting = false;
+    float StartStamina = 0.0f;
+    float StartStaminaRegenDelayRemaining = 0.0f;
+};
+
+class FNetworkPredictionData_Client_Sprint : public FNetworkPredictionData_Client_Character
+{
+public:
+    typedef FNetworkPredictionData_Client_Character Super;
+
+    FNetworkPredictionData_Client_Sprint(const UCharacterMovementComponent& ClientMovement)
+        : Super(ClientMovement)
+    {
+    }
+
+    virtual FSavedMovePtr AllocateNewMove() override
+    {
+        return FSavedMovePtr(new FSavedMove_Sprint());
+    }
+};
+
+void FSprintMoveResponseDataContainer::ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment)
+{
+    FCharacterMoveResponseDataContainer::ServerFillResponseData(CharacterMovement, PendingAdjustment);
+
+    const USprintMovementComponent& SprintMovement = static_cast<const USprintMovementComponent&>(CharacterMovement);
+    bIsSprinting = SprintMovement.bIsSprinting;
+    Stamina = SprintMovement.Stamina;
+    StaminaRegenDelayRemaining = SprintMovement.StaminaRegenDelayRemaining;
+}
+
+bool FSprintMoveResponseDataContainer::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap)
+{
+    if (!FCharacterMoveResponseDataContainer::Serialize(CharacterMovement, Ar, PackageMap))
+    {
+        return false;
+    }
+
+    // Good moves are acknowledged without a payload, only corrections carry the sprint state
+    if (IsCorrection())
+    {
+        Ar.SerializeBits(&bIsSprinting, 1);
+        Ar << Stamina;
+        Ar << StaminaRegenDelayRemaining;
+    }
+
+    return !Ar.IsError();
+}
+
+USprintMovementComponent::USprintMovementComponent()
+{
+    MaxWalkSpeed = 450.0f;
+
+    SetMoveResponseDataContainer(SprintMoveResponseData);
+}
+
+float USprintMovementComponent::GetMaxSpeed() const
+{
+    if (bIsSprinting && IsMovingOnGround())
+    {
+        return SprintSpeed;
+    }
+
+    return Super::GetMaxSpeed();
+}
+
+void USprintMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+    Super::UpdateFromCompressedFlags(Flags);
+
+    bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+}
+
+FNetworkPredictionData_Client* USprintMovementComponent::GetPredictionData_Client() const
+{
+    if (!ClientPredictionData)
+    {
+        USprintMovementComponent* MutableThis = const_cast<USprintMovementComponent*>(this);
+        MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Sprint(*this);
+    }
+
+    return ClientPredictionData;
+}
+
+void USprintMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+    Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+    // Runs once per move on the owning client, the server and during replays
+    SimulateStamina(DeltaSeconds);
+}
+
+void USprintMovementComponent::SimulateStamina(float DeltaSeconds)
+{
+    FStaminaParams Params;
+    Params.MaxStamina = MaxStamina;
+    Params.ConsumptionRate = StaminaConsumptionRate;
+    Params.RecoveryRate = StaminaRecoveryRate;
+    Params.RegenDelay = StaminaRegenDelay;
+    Params.RecoveryBuffer = StaminaRecoveryBuffer;
+    Params.ConsumptionBuffer = StaminaConsumptionBuffer;
+    
+    FStaminaState State;
+    State.bIsSprinting = bIsSprinting;
+    State.Stamina = Stamina;
+    State.RegenDelayRemaining = StaminaRegenDelayRemaining;
+    
+    FStaminaSim::Step(State, Params, bWantsToSprint, DeltaSeconds);
+    
+    bIsSprinting = State.bIsSprinting;
+    Stamina = State.Stamina;
+    StaminaRegenDelayRemaining = State.RegenDelayRemaining;
+    
+    NotifyStaminaChanged();
+}
+
+void USprintMovementComponent::SetStamina(float NewStamina)
+{
+    Stamina = FMath::Clamp(NewStamina, 0.0f, MaxStamina);
+    bIsSprinting = false;
+    StaminaRegenDelayRemaining = 0.0f;
+
+    NotifyStaminaChanged(true);
+}
+
+void USprintMovementComponent::NotifyStaminaChanged(bool bForce)
+{
+    const int32 StaminaStep = StaminaNotifyStep > 0.0f ? FMath::FloorToInt32(Stamina / StaminaNotifyStep) : 0;
+    if (bForce || StaminaStep != LastNotifiedStaminaStep)
+    {
+        LastNotifiedStaminaStep = StaminaStep;
+        OnStaminaChanged.Broadcast(Stamina, MaxStamina);
+    }
+}
+
+void USprintMovementComponent::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp,
+    FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName,
+    bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode, FVector ServerGravityDirection)
+{
+    Super::OnClientCorrectionReceived(ClientData, TimeStamp, NewLocation, NewVelocity, NewBase, NewBaseBoneName,
+        bHasBase, bBaseRelativePosition, ServerMovementMode, ServerGravityDirection);
+
+    INC_DWORD_STAT(STAT_SprintClientCorrections);
+
+    // Take the server's sprint state, pending moves are then replayed on top of it
+    const FSprintMoveResponseDataContainer& Response = static_cast<const FSprintMoveResponseDataContainer&>(GetMoveResponseDataContainer());
+    bIsSprinting = Response.bIsSprinting;
+    Stamina = Response.Stamina;
+    StaminaRegenDelayRemaining = Response.StaminaRegenDelayRemaining;
+
+    NotifyStaminaChanged(true);
+}
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemies/AnimInstance/EnemyAnimationInstance.h"
+
+void FEnemyAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	Super::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Game thread: gather everything the worker-thread update needs
+	const UEnemyAnimationInstance* AnimInstance = CastChecked<UEnemyAnimationInstance>(InAnimInstance);
+	if (const ABaseEnemy* Enemy = AnimInstance->Enemy)
+	{
+		EnemyState = Enemy->GetEnemyState();
+		Speed = Enemy->GetVelocity().Size2D();
+		AIStepAlpha = Enemy->GetAIStepAlpha();
+	}
+}
+
+UEnemyAnimationInstance::UEnemyAnimationInstance()
+{
+	// Allow the update to leave the game thread, the graph only reads proxy-copied values
+	bUseMultiThreadedAnimationUpdate = true;
+}
+
+void UEnemyAnimationInstance::NativeInitializeAnimation()
+{
+	Super::NativeInitializeAnimation();
+
+	Enemy = Cast<ABaseEnemy>(TryGetPawnOwner());
+}
+
+void UEnemyAnimationInstance::NativeThreadSafeUpdateAnimation(float DeltaTime)
+{
+	Super::NativeThreadSafeUpdateAnimation(DeltaTime);
+
+	const FEnemyAnimInstanceProxy& AnimProxy = GetProxyOnAnyThread<FEnemyAnimInstanceProxy>();
+	EnemyState = AnimProxy.EnemyState;
+	bIsStunned = AnimProxy.EnemyState == EEnemyState::Stunned;
+	bIsDead = AnimProxy.EnemyState == EEnemyState::Dead;
+	Speed = AnimProxy.Speed;
+	AIStepAlpha = AnimProxy.AIStepAlpha;
+}
@@ -2,18 +2,46 @@
 
 
 #include "Enemies/BaseEnemy.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "AI/EnemyBrainComponent.h"
+#include "AI/AISightSubsystem.h"
+#include "AI/EnemySquadSubsystem.h"
+#include "AI/InfluenceMapSubsystem.h"
+#include "AI/NoiseSubsystem.h"
+#include "Enemies/CorpseSubsystem.h"
+#include "Enemies/EnemyAssetPreloader.h"
+#include "Enemies/ImpostorSubsystem.h"
+#include "Enemies/MovementLODSubsystem.h"
+#include "Components/EnemyMovementComponent.h"
+#include "Save/CheckpointTypes.h"
+#include "Telemetry/TelemetryRecorder.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimMontage.h"
 #include "Perception/PawnSensingComponent.h"
 #include "NavigationSystem.h"
 #include "AIController.h"
 #include "BehaviorTree/BlackboardComponent.h"
+#include "Navigation/PathFollowingComponent.h"
 #include "Components/AudioComponent.h"
 #include "Sound/SoundBase.h"
+#include "FixedStepClock.h"
+#include "RTP.h"
+
+// The decide rules in RTPSim see the state through their own mirror of EEnemyState
+static_assert(static_cast<uint8>(EEnemyState::Idle) == static_cast<uint8>(EEnemySimState::Idle)
+    && static_cast<uint8>(EEnemyState::Investigating) == static_cast<uint8>(EEnemySimState::Investigating)
+    && static_cast<uint8>(EEnemyState::Chasing) == static_cast<uint8>(EEnemySimState::Chasing)
+    && static_cast<uint8>(EEnemyState::Attacking) == static_cast<uint8>(EEnemySimState::Attacking)
+    && static_cast<uint8>(EEnemyState::Stunned) == static_cast<uint8>(EEnemySimState::Stunned)
+    && static_cast<uint8>(EEnemyState::Dead) == static_cast<uint8>(EEnemySimState::Dead),
+    "EEnemySimState must mirror EEnemyState");
 
 // Sets default values
-ABaseEnemy::ABaseEnemy()
+ABaseEnemy::ABaseEnemy(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer.SetDefaultSubobjectClass<UEnemyMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
@@ -29,10 +57,29 @@ ABaseEnemy::ABaseEnemy()
     PawnSensingComponent->LOSHearingThreshold = HearingRange * 0.75f;
     PawnSensingComponent->bOnlySensePlayers = true;
     
+    // Noises are pushed by UNoiseSubsystem instead of every sensor polling for them
+    PawnSensingComponent->bHearNoises = false;
+    
+    // Distant enemies NavWalk under UMovementLODSubsystem: snap to the real floor at the projection
+    // interval rather than sweeping the capsule every tick
+    GetCharacterMovement()->bProjectNavMeshWalking = true;
+    GetCharacterMovement()->bSweepWhileNavWalking = false;
+    
+    // Enemies are told apart from other pawns so crowd avoidance can let their capsules overlap, the profile
+    // gives the capsule the Pawn responses on its own object type
+    GetCapsuleComponent()->SetCollisionProfileName(RTP_ENEMY_COLLISION_PROFILE);
+    
     // Set up audio component
+#if !UE_SERVER
     AudioComponent = CreateDefaultSubobject<UAudioComponent>(TEXT("AudioComponent"));
     AudioComponent->SetupAttachment(RootComponent);
     AudioComponent->bAutoActivate = false;
+#else
+    // Nothing on a dedicated server looks at the pose, so animation is only evaluated if the mesh is ever rendered
+    GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+#endif
+    
+    BrainComponent = CreateDefaultSubobject<UEnemyBrainComponent>(TEXT("BrainComponent"));
 }
 
 // Called when the game starts or when spawned
@@ -40,6 +87,9 @@ void ABaseEnemy::BeginPlay()
 {
 	Super::BeginPlay();
 	
+    // Seed the per-enemy random stream so decisions do not depend on update order or threading
+    RandomStream.Initialize(RandomSeed != 0 ? RandomSeed : static_cast<int32>(GetTypeHash(GetFName())));
+    
     // Set health to max at the beginning of the game
     CurrentHealth = MaxHealth;
     
@@ -55,6 +105,200 @@ void ABaseEnemy::BeginPlay()
     
     // Initialize with idle state
     SetEnemyState(EEnemyState::Idle);
+    
+    if (UNoiseSubsystem* NoiseSubsystem = GetWorld()->GetSubsystem<UNoiseSubsystem>())
+    {
+        NoiseSubsystem->RegisterListener(this);
+    }
+    
+    SquadSubsystem = GetWorld()->GetSubsystem<UEnemySquadSubsystem>();
+    if (SquadSubsystem)
+    {
+        SquadIndex = SquadSubsystem->JoinSquad(this);
+    }
+    
+    InfluenceMap = GetWorld()->GetSubsystem<UInfluenceMapSubsystem>();
+    if (InfluenceMap)
+    {
+        InfluenceMap->RegisterEnemy(this);
+    }
+    
+    // Hold this type's montages and sounds, streaming them in if nothing requested them yet
+    if (UEnemyAssetPreloader* Preloader = GetWorld()->GetSubsystem<UEnemyAssetPreloader>())
+    {
+        Preloader->AddUser(GetClass());
+    }
+    
+    if (ImpostorSet)
+    {
+        if (UImpostorSubsystem* ImpostorSubsystem = GetWorld()->GetSubsystem<UImpostorSubsystem>())
+        {
+            ImpostorSubsystem->RegisterEnemy(this, ImpostorSet);
+        }
+    }
+    
+    if (UMovementLODSubsystem* MovementLODSubsystem = GetWorld()->GetSubsystem<UMovementLODSubsystem>())
+    {
+        MovementLODSubsystem->RegisterEnemy(this);
+    }
+    
+    // Hand decision updates over to the time-sliced scheduler when one is available
+    if (bUseUpdateScheduler)
+    {
+        if (UEnemyUpdateSubsystem* UpdateSubsystem = GetWorld()->GetSubsystem<UEnemyUpdateSubsystem>())
+        {
+            UpdateSubsystem->RegisterEnemy(this);
+            SetActorTickEnabled(false);
+        }
+    }
+}
+
+// Called when the enemy is removed from the world
+void ABaseEnemy::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // Cancel while the world's timeout queue is still around
+    StopBehavior();
+    
+    if (UEnemyUpdateSubsystem* UpdateSubsystem = GetWorld()->GetSubsystem<UEnemyUpdateSubsystem>())
+    {
+        UpdateSubsystem->UnregisterEnemy(this);
+    }
+    
+    if (UNoiseSubsystem* NoiseSubsystem = GetWorld()->GetSubsystem<UNoiseSubsystem>())
+    {
+        NoiseSubsystem->UnregisterListener(this);
+    }
+    
+    if (InfluenceMap)
+    {
+        InfluenceMap->UnregisterEnemy(this);
+    }
+    
+    if (UImpostorSubsystem* ImpostorSubsystem = GetWorld()->GetSubsystem<UImpostorSubsystem>())
+    {
+        ImpostorSubsystem->UnregisterEnemy(this);
+    }
+    
+    if (UMovementLODSubsystem* MovementLODSubsystem = GetWorld()->GetSubsystem<UMovementLODSubsystem>())
+    {
+        MovementLODSubsystem->UnregisterEnemy(this);
+    }
+    
+    if (UEnemyAssetPreloader* Preloader = GetWorld()->GetSubsystem<UEnemyAssetPreloader>())
+    {
+        Preloader->RemoveUser(GetClass());
+    }
+    
+    Super::EndPlay(EndPlayReason);
+}
+
+void ABaseEnemy::PossessedBy(AController* NewController)
+{
+    Super::PossessedBy(NewController);
+    
+    if (AAIController* AIController = Cast<AAIController>(NewController))
+    {
+        if (UPathFollowingComponent* PathFollowing = AIController->GetPathFollowingComponent())
+        {
+            PathFollowing->OnRequestFinished.AddUObject(this, &ABaseEnemy::OnMoveRequestFinished);
+        }
+    }
+}
+
+void ABaseEnemy::UnPossessed()
+{
+    if (AAIController* AIController = Cast<AAIController>(GetController()))
+    {
+        if (UPathFollowingComponent* PathFollowing = AIController->GetPathFollowingComponent())
+        {
+            PathFollowing->OnRequestFinished.RemoveAll(this);
+        }
+    }
+    
+    Super::UnPossessed();
+}
+
+void ABaseEnemy::PostActorCreated()
+{
+    Super::PostActorCreated();
+    
+    // Placed in the editor or spawned at runtime, a respawn from a checkpoint overwrites it before finishing
+    EnemyId = FGuid::NewGuid();
+}
+
+void ABaseEnemy::PostLoad()
+{
+    Super::PostLoad();
+    
+    // Enemies placed before they had an ID get one that stays the same every time the level loads
+    if (!EnemyId.IsValid())
+    {
+        EnemyId = FGuid::NewDeterministicGuid(GetPathName());
+    }
+}
+
+void ABaseEnemy::PostDuplicate(bool bDuplicateForPIE)
+{
+    Super::PostDuplicate(bDuplicateForPIE);
+    
+    // PIE keeps the editor's ID so checkpoints line up with the placed enemies, an editor duplicate is a new enemy
+    if (!bDuplicateForPIE)
+    {
+        EnemyId = FGuid::NewGuid();
+    }
+}
+
+#if WITH_EDITOR
+void ABaseEnemy::PostEditImport()
+{
+    Super::PostEditImport();
+    
+    // Pasted enemies, the ID is not part of the copied text
+    if (!EnemyId.IsValid())
+    {
+        EnemyId = FGuid::NewGuid();
+    }
+}
+#endif
+
+void ABaseEnemy::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+    // Montages and sounds are only played on machines that render and hear them
+#if !UE_SERVER
+    OutAssets.Add(DeathMontage.ToSoftObjectPath());
+    OutAssets.Add(AttackMontage.ToSoftObjectPath());
+    OutAssets.Add(StunMontage.ToSoftObjectPath());
+    OutAssets.Add(AttackSound.ToSoftObjectPath());
+    OutAssets.Add(DeathSound.ToSoftObjectPath());
+    OutAssets.Add(SpotPlayerSound.ToSoftObjectPath());
+    OutAssets.Add(StunnedSound.ToSoftObjectPath());
+    OutAssets.Add(IdleSound.ToSoftObjectPath());
+#endif
+}
+
+// Play one of the enemy's sounds, compiled out of dedicated servers
+void ABaseEnemy::PlayEnemySound(const TSoftObjectPtr<USoundBase>& Sound)
+{
+#if !UE_SERVER
+    if (Sound.Get() && AudioComponent)
+    {
+        AudioComponent->SetSound(Sound.Get());
+        AudioComponent->Play();
+    }
+#endif
+}
+
+// Play a montage that only matters visually, compiled out of dedicated servers
+float ABaseEnemy::PlayCosmeticMontage(const TSoftObjectPtr<UAnimMontage>& Montage)
+{
+#if !UE_SERVER
+    if (UAnimMontage* LoadedMontage = Montage.Get())
+    {
+        // The final pose is reached when the montage starts blending out
+        return PlayAnimMontage(LoadedMontage) - LoadedMontage->BlendOut.GetBlendTime();
+    }
+#endif
+    return 0.0f;
 }
 
 // Called every frame
@@ -62,73 +306,395 @@ void ABaseEnemy::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
     
-    // Handle state-specific behaviors
-    if (!bIsDead)
+    // Only reached when the enemy is not driven by the update scheduler
+    UpdateDecision(DeltaTime);
+}
+
+// Run the state-specific decision logic
+void ABaseEnemy::UpdateDecision(float DeltaTime)
+{
+    if (IsBrainDriven())
     {
-        AAIController* AIController = Cast<AAIController>(GetController());
-        
-        switch (CurrentState)
+        BrainComponent->UpdateBrain(DeltaTime);
+    }
+    else
+    {
+        RunDecisionRules(DeltaTime);
+    }
+}
+
+// Hand-written decide and apply for one update
+void ABaseEnemy::RunDecisionRules(float DeltaTime)
+{
+    FEnemyDecision Decision;
+    DecideUpdate(CaptureWorldSnapshot(this), DeltaTime, Decision);
+    ApplyDecision(Decision);
+}
+
+// Whether a running StateTree brain makes this enemy's decisions
+bool ABaseEnemy::IsBrainDriven() const
+{
+    return BrainComponent && BrainComponent->IsRunning() && UEnemyBrainComponent::IsEnabled();
+}
+
+// Whether the target is in attack range and the attack is off cooldown
+bool ABaseEnemy::CanAttack(const AActor* Target) const
+{
+    return Target && !bIsAttackOnCooldown && FVector::Dist(GetActorLocation(), Target->GetActorLocation()) <= AttackRange;
+}
+
+// Whether a squad mate saw the player recently enough to count as this enemy seeing them
+bool ABaseEnemy::DoesSquadSeePlayer() const
+{
+    return SquadSubsystem && SquadSubsystem->HasFreshSighting(SquadIndex, GetWorld()->GetTimeSeconds());
+}
+
+// Chase the player in sight, the brain's counterpart of a bMoveToPlayer decision
+void ABaseEnemy::PursuePlayer(APawn* Player, bool bReportSighting)
+{
+    LastKnownPlayerLocation = Player->GetActorLocation();
+    if (bReportSighting)
+    {
+        ReportPlayerToSquad(Player, LastKnownPlayerLocation, true);
+    }
+    
+    if (AAIController* AIController = Cast<AAIController>(GetController()))
+    {
+        AIController->MoveToActor(Player);
+    }
+    PlayerSeenSignal.Trigger();
+}
+
+// Head for where the player was last seen, the brain's counterpart of a bMoveToLastKnownLocation decision
+void ABaseEnemy::PursueLastKnownLocation()
+{
+    MoveToLocation(LastKnownPlayerLocation);
+    
+    // Switch to investigating if we've lost sight, unless already counting down
+    if (!ActiveBehavior.IsRunning())
+    {
+        StartMemoryTimer(MemoryDuration);
+    }
+}
+
+// Go back to chasing a player seen again while investigating, the brain's counterpart of a bResumeChase decision
+void ABaseEnemy::ResumeChase(APawn* Player)
+{
+    ReportPlayerToSquad(Player, Player->GetActorLocation(), true);
+    SetEnemyState(EEnemyState::Chasing);
+    PlayerSeenSignal.Trigger();
+}
+
+// Capture the world inputs shared by every enemy's decide phase
+FEnemyWorldSnapshot ABaseEnemy::CaptureWorldSnapshot(const UObject* WorldContextObject)
+{
+    FEnemyWorldSnapshot Snapshot;
+    if (APawn* Player = UGameplayStatics::GetPlayerPawn(WorldContextObject, 0))
+    {
+        Snapshot.Player = Player;
+        Snapshot.PlayerLocation = Player->GetActorLocation();
+    }
+    Snapshot.WorldTime = WorldContextObject->GetWorld()->GetTimeSeconds();
+    return Snapshot;
+}
+
+// Read-only decide phase, safe to run on worker threads
+void ABaseEnemy::DecideUpdate(const FEnemyWorldSnapshot& Snapshot, float DeltaTime, FEnemyDecision& OutDecision, EAISightGridResult GridSight) const
+{
+    FEnemySimInput Input;
+    Input.State = static_cast<EEnemySimState>(CurrentState);
+    Input.bIsDead = bIsDead;
+    Input.bHasPlayer = Snapshot.Player != nullptr;
+    Input.bAttackOnCooldown = bIsAttackOnCooldown;
+    Input.bSquadSeesPlayer = SquadSubsystem && SquadSubsystem->HasFreshSighting(SquadIndex, Snapshot.WorldTime);
+    Input.AttackRange = AttackRange;
+    Input.Location = GetActorLocation();
+    Input.PlayerLocation = Snapshot.PlayerLocation;
+    Input.LastKnownPlayerLocation = LastKnownPlayerLocation;
+    
+    // Random rolls come from a copy of this enemy's stream, the advanced seed is committed in ApplyDecision if it rolled
+    FRandomStream DecisionStream = RandomStream;
+    FEnemySim::Decide(Input, [this, &Snapshot, GridSight]() { return HasLineOfSightTo(Snapshot.Player, GridSight); }, DecisionStream, OutDecision);
+}
+
+// The eye to player segment the decide phase may trace
+bool ABaseEnemy::GetSightSegment(const FEnemyWorldSnapshot& Snapshot, FVector& OutStart, FVector& OutEnd) const
+{
+    // Only chasing and investigating enemies look for the player, see FEnemySim::Decide
+    if (bIsDead || !Snapshot.Player || (CurrentState != EEnemyState::Chasing && CurrentState != EEnemyState::Investigating))
+    {
+        return false;
+    }
+    
+    // TraceSight ends on the target's location, which the snapshot took this frame
+    OutStart = GetEyeLocation();
+    OutEnd = Snapshot.PlayerLocation;
+    return true;
+}
+
+// Serial apply phase, runs on the game thread
+void ABaseEnemy::ApplyDecision(const FEnemyDecision& Decision)
+{
+    if (bIsDead)
+    {
+        return;
+    }
+    
+    // Commit the decide phase's rolls only if it made any, re-seeding otherwise would rewind the stream
+    // over draws made since the decide phase, e.g. by an earlier apply in the same round
+    if (Decision.bAdvancedRandomStream)
+    {
+        RandomStream.Initialize(Decision.RandomSeed);
+    }
+    
+    if (Decision.bAttack)
+    {
+        PerformAttack();
+    }
+    
+    if (Decision.bUpdateLastKnownLocation)
+    {
+        LastKnownPlayerLocation = Decision.LastKnownPlayerLocation;
+    }
+    
+    if (Decision.bReportSighting)
+    {
+        ReportPlayerToSquad(UGameplayStatics::GetPlayerPawn(this, 0), Decision.LastKnownPlayerLocation, true);
+    }
+    
+    if (Decision.bMoveToPlayer)
+    {
+        if (AAIController* AIController = Cast<AAIController>(GetController()))
         {
-            case EEnemyState::Chasing:
-                // Check if we're in attack range of the player
-                if (AActor* Player = UGameplayStatics::GetPlayerPawn(this, 0))
-                {
-                    if (IsInAttackRange(Player) && !bIsAttackOnCooldown)
-                    {
-                        PerformAttack();
-                    }
-                    else if (HasLineOfSightTo(Player))
-                    {
-                        // Update last known location if we can see the player
-                        LastKnownPlayerLocation = Player->GetActorLocation();
-                        
-                        // Move to the player
-                        if (AIController)
-                        {
-                            AIController->MoveToActor(Player);
-                        }
-                    }
-                    else
-                    {
-                        // Move to last known location if we can't see the player
-                        MoveToLocation(LastKnownPlayerLocation);
-                        
-                        // Switch to investigating if we've lost sight
-                        GetWorldTimerManager().SetTimer(
-                            StunTimerHandle, // Reuse stun timer for this
-                            [this]()
-                            {
-                                SetEnemyState(EEnemyState::Investigating);
-                            },
-                            MemoryDuration,
-                            false
-                        );
-                    }
-                }
-                break;
-                
-            case EEnemyState::Investigating:
-                // Check if player is nearby during investigation
-                if (AActor* Player = UGameplayStatics::GetPlayerPawn(this, 0))
+            if (APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0))
+            {
+                AIController->MoveToActor(Player);
+            }
+        }
+        PlayerSeenSignal.Trigger();
+    }
+    
+    if (Decision.bMoveToLastKnownLocation)
+    {
+        MoveToLocation(LastKnownPlayerLocation);
+    }
+    
+    if (Decision.bStartMemoryTimer && !ActiveBehavior.IsRunning())
+    {
+        // Switch to investigating if we've lost sight, unless already counting down
+        StartMemoryTimer(MemoryDuration);
+    }
+    
+    if (Decision.bResumeChase)
+    {
+        SetEnemyState(EEnemyState::Chasing);
+        PlayerSeenSignal.Trigger();
+    }
+}
+
+// Switch to investigating once the player has been out of sight for Duration seconds
+void ABaseEnemy::StartMemoryTimer(float Duration)
+{
+    StartBehavior(LoseSightBehavior(Duration));
+}
+
+// Investigate Location, returning to the default behavior once there
+void ABaseEnemy::StartInvestigating(const FVector& Location)
+{
+    StopBehavior();
+    
+    LastKnownPlayerLocation = Location;
+    SetEnemyState(EEnemyState::Investigating);
+    MoveToLocation(Location);
+    
+    StartBehavior(InvestigateBehavior());
+}
+
+void ABaseEnemy::StartBehavior(FLatentBehavior&& Behavior)
+{
+    ActiveBehavior = MoveTemp(Behavior);
+    ActiveBehavior.Start();
+}
+
+// Stay stunned for Duration, then go back to the default behavior
+FLatentBehavior ABaseEnemy::StunBehavior(float Duration)
+{
+    co_await FLatentDelay(this, Duration);
+    
+    if (CurrentState == EEnemyState::Stunned)
+    {
+        ReturnToDefaultBehavior();
+    }
+}
+
+// Hold the attacking state while the swing plays out, then resume the chase
+FLatentBehavior ABaseEnemy::AttackRecoveryBehavior()
+{
+    co_await FLatentDelay(this, 0.5f); // Short delay after attack animation
+    
+    if (CurrentState == EEnemyState::Attacking)
+    {
+        SetEnemyState(EEnemyState::Chasing);
+    }
+}
+
+// Keep chasing towards the last known location for MemoryTime, then investigate it
+FLatentBehavior ABaseEnemy::LoseSightBehavior(float MemoryTime)
+{
+    // Seeing the player again before the memory runs out ends this, the chase simply goes on
+    const TOptional<int32> Seen = co_await PlayerSeenSignal.Wait(this, MemoryTime);
+    if (Seen.IsSet() || CurrentState != EEnemyState::Chasing)
+    {
+        co_return;
+    }
+    
+    SetEnemyState(EEnemyState::Investigating);
+    MoveToLocation(LastKnownPlayerLocation);
+    co_await InvestigateBehavior();
+}
+
+// Wait for the investigation move to end, search on where the player likely went, then return to the default behavior
+FLatentBehavior ABaseEnemy::InvestigateBehavior()
+{
+    for (int32 Leg = 0; ; ++Leg)
+    {
+        // A move that finished or failed as it was requested has nothing to wait for
+        if (IsFollowingPath())
+        {
+            while (true)
+            {
+                const TOptional<int32> Flags = co_await MoveFinishedSignal.Wait(this);
+                if (CurrentState != EEnemyState::Investigating)
                 {
-                    if (HasLineOfSightTo(Player))
-                    {
-                        // If we can see the player again, go back to chasing
-                        SetEnemyState(EEnemyState::Chasing);
-                    }
+                    co_return;
                 }
                 
-                // Check if we've reached the investigation point
-                if (AIController && GetActorLocation().Equals(LastKnownPlayerLocation, 100.0f))
+                // Aborted by a newer request, e.g. towards a louder noise, whose end is waited for instead
+                if (!Flags.IsSet() || (Flags.GetValue() & FPathFollowingResultFlags::NewRequest) == 0)
                 {
-                    // Return to default behavior after investigating
-                    ReturnToDefaultBehavior();
+                    break;
                 }
-                break;
-                
-            default:
-                break;
+            }
+        }
+        
+        if (CurrentState != EEnemyState::Investigating)
+        {
+            co_return;
         }
+        
+        // The cells searched so far pick up this enemy's coverage, so each leg leads somewhere new
+        FVector SearchTarget;
+        if (Leg >= MaxSearchLegs || !FindSearchTarget(SearchTarget))
+        {
+            break;
+        }
+        
+        LastKnownPlayerLocation = SearchTarget;
+        MoveToLocation(SearchTarget);
+    }
+    
+    ApplyDefaultBehavior(RandomStream.FRand() < 0.5f);
+}
+
+bool ABaseEnemy::IsFollowingPath() const
+{
+    const AAIController* AIController = Cast<AAIController>(GetController());
+    return AIController && AIController->GetMoveStatus() == EPathFollowingStatus::Moving;
+}
+
+void ABaseEnemy::OnMoveRequestFinished(FAIRequestID RequestID, const FPathFollowingResult& Result)
+{
+    MoveFinishedSignal.Trigger(Result.Flags);
+}
+
+// Copy the state saved in checkpoints
+void ABaseEnemy::WriteCheckpoint(FEnemyCheckpoint& OutCheckpoint) const
+{
+    const FTimerManager& TimerManager = GetWorldTimerManager();
+    
+    OutCheckpoint.EnemyId = EnemyId;
+    OutCheckpoint.EnemyClass = GetClass()->GetPathName();
+    OutCheckpoint.Location = GetActorLocation();
+    OutCheckpoint.Rotation = GetActorRotation();
+    OutCheckpoint.LastKnownPlayerLocation = LastKnownPlayerLocation;
+    OutCheckpoint.Health = CurrentHealth;
+    OutCheckpoint.State = static_cast<uint8>(CurrentState);
+    OutCheckpoint.StateTimerRemaining = ActiveBehavior.GetWaitRemaining(GetWorld()->GetTimeSeconds());
+    OutCheckpoint.AttackCooldownRemaining = bIsAttackOnCooldown ? FMath::Max(0.0f, TimerManager.GetTimerRemaining(AttackCooldownTimerHandle)) : 0.0f;
+    OutCheckpoint.RandomSeed = RandomStream.GetCurrentSeed();
+}
+
+bool ABaseEnemy::IsCheckpointAlive(const FEnemyCheckpoint& Checkpoint)
+{
+    return Checkpoint.State != static_cast<uint8>(EEnemyState::Dead) && Checkpoint.Health > 0.0f;
+}
+
+// Restore state from a checkpoint
+void ABaseEnemy::ReadCheckpoint(const FEnemyCheckpoint& Checkpoint)
+{
+    const EEnemyState State = Checkpoint.State <= static_cast<uint8>(EEnemyState::Dead) ? static_cast<EEnemyState>(Checkpoint.State) : EEnemyState::Idle;
+    
+    // A corpse cannot be brought back in place, UCheckpointSubsystem spawns a fresh enemy for one saved alive
+    ensureMsgf(!bIsDead || !IsCheckpointAlive(Checkpoint), TEXT("%s is dead but its checkpoint is alive"), *GetName());
+    
+    SetActorLocationAndRotation(Checkpoint.Location, Checkpoint.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+    LastKnownPlayerLocation = Checkpoint.LastKnownPlayerLocation;
+    RandomStream.Initialize(Checkpoint.RandomSeed);
+    
+    CurrentHealth = FMath::Clamp(Checkpoint.Health, 0.0f, MaxHealth);
+    OnHealthChanged.Broadcast(CurrentHealth, MaxHealth);
+    
+    StopBehavior();
+    GetWorldTimerManager().ClearTimer(AttackCooldownTimerHandle);
+    if (AAIController* AIController = Cast<AAIController>(GetController()))
+    {
+        AIController->StopMovement();
+    }
+    
+    if (State == EEnemyState::Dead || CurrentHealth <= 0.0f)
+    {
+        Die();
+        return;
+    }
+    
+    bIsAttackOnCooldown = Checkpoint.AttackCooldownRemaining > 0.0f;
+    if (bIsAttackOnCooldown)
+    {
+        GetWorldTimerManager().SetTimer(
+            AttackCooldownTimerHandle,
+            [this]()
+            {
+                bIsAttackOnCooldown = false;
+            },
+            Checkpoint.AttackCooldownRemaining,
+            false
+        );
+    }
+    
+    switch (State)
+    {
+        case EEnemyState::Stunned:
+            Stun(Checkpoint.StateTimerRemaining > 0.0f ? Checkpoint.StateTimerRemaining : StunDuration);
+            break;
+            
+        case EEnemyState::Chasing:
+        case EEnemyState::Attacking:
+            // An attack in progress resumes as a chase, the next decision update attacks again if in range
+            SetEnemyState(EEnemyState::Chasing);
+            if (State == EEnemyState::Chasing && Checkpoint.StateTimerRemaining > 0.0f)
+            {
+                MoveToLocation(LastKnownPlayerLocation);
+                StartMemoryTimer(Checkpoint.StateTimerRemaining);
+            }
+            break;
+            
+        case EEnemyState::Investigating:
+            StartInvestigating(LastKnownPlayerLocation);
+            break;
+            
+        default:
+            SetEnemyState(EEnemyState::Idle);
+            break;
     }
 }
 
@@ -195,6 +761,7 @@ void ABaseEnemy::Die()
     
     // Set dead flag
     bIsDead = true;
+    RTP_TELEMETRY(EnemyDied, this, GetActorLocation());
     
     // Broadcast death event
     OnEnemyDeath.Broadcast();
@@ -205,8 +772,8 @@ void ABaseEnemy::Die()
     // Disable movement
     GetCharacterMovement()->DisableMovement();
     
-    // Clear any active timers
-    GetWorldTimerManager().ClearTimer(StunTimerHandle);
+    // Clear any active timers and behavior
+    StopBehavior();
     GetWorldTimerManager().ClearTimer(AttackCooldownTimerHandle);
     GetWorldTimerManager().ClearTimer(DeathTimerHandle);
     
@@ -214,16 +781,40 @@ void ABaseEnemy::Die()
     SetEnemyState(EEnemyState::Dead);
     
     // Play death sound
-    if (DeathSound && AudioComponent)
+    PlayEnemySound(DeathSound);
+    
+#if !UE_SERVER
+    // An enemy that dies before its type's bundle is resident waits for the stream instead of blocking on a load
+    UEnemyAssetPreloader* Preloader = GetWorld()->GetSubsystem<UEnemyAssetPreloader>();
+    if (Preloader && !DeathMontage.IsNull() && !DeathMontage.Get())
     {
-        AudioComponent->SetSound(DeathSound);
-        AudioComponent->Play();
+        Preloader->Preload(GetClass(), FStreamableDelegate::CreateUObject(this, &ABaseEnemy::PlayDeathPresentation));
+        return;
     }
+#endif
     
+    PlayDeathPresentation();
+}
+
+void ABaseEnemy::PlayDeathPresentation()
+{
     // Play death animation if available
-    if (DeathMontage)
+    const float FinalPoseDelay = PlayCosmeticMontage(DeathMontage);
+    
+    // Hand the body over to the corpse subsystem once it has settled
+    UCorpseSubsystem* CorpseSubsystem = GetWorld()->GetSubsystem<UCorpseSubsystem>();
+    if (CorpseSubsystem && UCorpseSubsystem::IsEnabled())
     {
-        PlayAnimMontage(DeathMontage);
+        GetWorldTimerManager().SetTimer(
+            DeathTimerHandle,
+            [this, CorpseSubsystem]()
+            {
+                CorpseSubsystem->AddCorpse(this);
+            },
+            FMath::Max(FinalPoseDelay, KINDA_SMALL_NUMBER),
+            false
+        );
+        return;
     }
     
     // Set up cleanup timer
@@ -239,6 +830,50 @@ void ABaseEnemy::Die()
     );
 }
 
+void ABaseEnemy::FreezeAsCorpse()
+{
+    // Leave every per-frame system: scheduler, hearing and AI control
+    if (UEnemyUpdateSubsystem* UpdateSubsystem = GetWorld()->GetSubsystem<UEnemyUpdateSubsystem>())
+    {
+        UpdateSubsystem->UnregisterEnemy(this);
+    }
+    
+    if (UNoiseSubsystem* NoiseSubsystem = GetWorld()->GetSubsystem<UNoiseSubsystem>())
+    {
+        NoiseSubsystem->UnregisterListener(this);
+    }
+    
+    if (InfluenceMap)
+    {
+        InfluenceMap->UnregisterEnemy(this);
+    }
+    
+    if (UImpostorSubsystem* ImpostorSubsystem = GetWorld()->GetSubsystem<UImpostorSubsystem>())
+    {
+        ImpostorSubsystem->UnregisterEnemy(this);
+    }
+    
+    if (UMovementLODSubsystem* MovementLODSubsystem = GetWorld()->GetSubsystem<UMovementLODSubsystem>())
+    {
+        MovementLODSubsystem->UnregisterEnemy(this);
+    }
+    
+    DetachFromControllerPendingDestroy();
+    
+    SetActorTickEnabled(false);
+    SetActorEnableCollision(false);
+    ForEachComponent(false, [](UActorComponent* Component)
+    {
+        Component->SetComponentTickEnabled(false);
+    });
+    
+    // Keep rendering the last evaluated pose without updating the skeleton again
+    USkeletalMeshComponent* MeshComponent = GetMesh();
+    MeshComponent->bPauseAnims = true;
+    MeshComponent->bNoSkeletonUpdate = true;
+    MeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+}
+
 // Set the enemy state
 void ABaseEnemy::SetEnemyState(EEnemyState NewState)
 {
@@ -246,28 +881,43 @@ void ABaseEnemy::SetEnemyState(EEnemyState NewState)
     {
         EEnemyState PreviousState = CurrentState;
         CurrentState = NewState;
+        RTP_TELEMETRY(EnemyStateChanged, this, GetActorLocation(), static_cast<uint32>(PreviousState) << 8 | static_cast<uint32>(NewState));
+        
+        if (BrainComponent)
+        {
+            BrainComponent->NotifyStateChanged();
+        }
+        
+        // Some states need the skeletal mesh and full movement right away, without waiting for the next time-sliced LOD pass
+        if (ImpostorSet)
+        {
+            if (UImpostorSubsystem* ImpostorSubsystem = GetWorld()->GetSubsystem<UImpostorSubsystem>())
+            {
+                ImpostorSubsystem->EvaluateNow(this);
+            }
+        }
+        
+        if (UMovementLODSubsystem* MovementLODSubsystem = GetWorld()->GetSubsystem<UMovementLODSubsystem>())
+        {
+            MovementLODSubsystem->EvaluateNow(this);
+        }
         
         // Handle state-specific setup
         switch (NewState)
         {
             case EEnemyState::Idle:
                 GetCharacterMovement()->MaxWalkSpeed = DefaultSpeed;
-                // Play idle sound occasionally
-                if (FMath::RandBool() && IdleSound && AudioComponent)
+                // Play idle sound occasionally, rolled on servers too so every build draws the same random sequence
+                if (RandomStream.FRand() < 0.5f)
                 {
-                    AudioComponent->SetSound(IdleSound);
-                    AudioComponent->Play();
+                    PlayEnemySound(IdleSound);
                 }
                 break;
                 
             case EEnemyState::Investigating:
                 GetCharacterMovement()->MaxWalkSpeed = InvestigateSpeed;
                 // Play investigation sound if available
-                if (SpotPlayerSound && AudioComponent)
-                {
-                    AudioComponent->SetSound(SpotPlayerSound);
-                    AudioComponent->Play();
-                }
+                PlayEnemySound(SpotPlayerSound);
                 break;
                 
             case EEnemyState::Chasing:
@@ -275,11 +925,7 @@ void ABaseEnemy::SetEnemyState(EEnemyState NewState)
                 // Play spot player sound if coming from a non-chase state
                 if (PreviousState != EEnemyState::Chasing && PreviousState != EEnemyState::Attacking)
                 {
-                    if (SpotPlayerSound && AudioComponent)
-                    {
-                        AudioComponent->SetSound(SpotPlayerSound);
-                        AudioComponent->Play();
-                    }
+                    PlayEnemySound(SpotPlayerSound);
                 }
                 break;
                 
@@ -287,11 +933,7 @@ void ABaseEnemy::SetEnemyState(EEnemyState NewState)
                 // Stop all movement when stunned
                 GetCharacterMovement()->StopMovementImmediately();
                 // Play stunned sound
-                if (StunnedSound && AudioComponent)
-                {
-                    AudioComponent->SetSound(StunnedSound);
-                    AudioComponent->Play();
-                }
+                PlayEnemySound(StunnedSound);
                 break;
                 
             case EEnemyState::Attacking:
@@ -319,24 +961,13 @@ void ABaseEnemy::Stun(float Duration)
     
     // Set stunned state
     SetEnemyState(EEnemyState::Stunned);
+    RTP_TELEMETRY(EnemyStunned, this, GetActorLocation(), static_cast<uint32>(Duration * 1000.0f));
     
     // Play stun animation if available
-    if (StunMontage)
-    {
-        PlayAnimMontage(StunMontage);
-    }
-    
-    // Clear any existing stun timer
-    GetWorldTimerManager().ClearTimer(StunTimerHandle);
+    PlayCosmeticMontage(StunMontage);
     
-    // Set timer to end stun after duration
-    GetWorldTimerManager().SetTimer(
-        StunTimerHandle,
-        this,
-        &ABaseEnemy::EndStun,
-        Duration,
-        false
-    );
+    // Replaces any running behavior, including an earlier stun
+    StartBehavior(StunBehavior(Duration));
 }
 
 // End stun state
@@ -345,6 +976,7 @@ void ABaseEnemy::EndStun()
     // Return to default behavior if still stunned
     if (CurrentState == EEnemyState::Stunned)
     {
+        StopBehavior();
         ReturnToDefaultBehavior();
     }
 }
@@ -356,19 +988,13 @@ void ABaseEnemy::PerformAttack()
     if (!bIsAttackOnCooldown && CurrentState != EEnemyState::Stunned && CurrentState != EEnemyState::Dead)
     {
         SetEnemyState(EEnemyState::Attacking);
+        RTP_TELEMETRY(EnemyAttack, this, GetActorLocation());
         
         // Play attack animation if available
-        if (AttackMontage)
-        {
-            PlayAnimMontage(AttackMontage);
-        }
+        PlayCosmeticMontage(AttackMontage);
         
         // Play attack sound
-        if (AttackSound && AudioComponent)
-        {
-            AudioComponent->SetSound(AttackSound);
-            AudioComponent->Play();
-        }
+        PlayEnemySound(AttackSound);
         
         // Try to damage the player
         if (AActor* Player = UGameplayStatics::GetPlayerPawn(this, 0))
@@ -389,18 +1015,7 @@ void ABaseEnemy::PerformAttack()
         StartAttackCooldown();
         
         // Return to chasing after attack
-        GetWorldTimerManager().SetTimer(
-            AttackCooldownTimerHandle,
-            [this]()
-            {
-                if (CurrentState == EEnemyState::Attacking)
-                {
-                    SetEnemyState(EEnemyState::Chasing);
-                }
-            },
-            0.5f, // Short delay after attack animation
-            false
-        );
+        StartBehavior(AttackRecoveryBehavior());
     }
 }
 
@@ -421,6 +1036,13 @@ void ABaseEnemy::StartAttackCooldown()
     );
 }
 
+float ABaseEnemy::GetAIStepAlpha() const
+{
+    FFixedStepClock Clock;
+    Clock.StepTime = AIStepTime;
+    return Clock.GetAlpha(GetWorld()->GetTimeSeconds(), AIStepInterval);
+}
+
 // Check if in attack range of target
 bool ABaseEnemy::IsInAttackRange(AActor* Target) const
 {
@@ -450,12 +1072,8 @@ void ABaseEnemy::ReactToSound(AActor* SoundSource, const FVector& SoundLocation)
         CurrentState != EEnemyState::Dead && 
         CurrentState != EEnemyState::Stunned)
     {
-        // Save the location
-        LastKnownPlayerLocation = SoundLocation;
-        
-        // Move to investigate
-        SetEnemyState(EEnemyState::Investigating);
-        MoveToLocation(SoundLocation);
+        // Move to investigate the location
+        StartInvestigating(SoundLocation);
     }
 }
 
@@ -472,6 +1090,7 @@ void ABaseEnemy::ReactToSeeingPlayer(APawn* PlayerPawn)
     if (PlayerPawn)
     {
         LastKnownPlayerLocation = PlayerPawn->GetActorLocation();
+        RTP_TELEMETRY(PlayerSighted, this, LastKnownPlayerLocation);
         
         // Start chasing
         SetEnemyState(EEnemyState::Chasing);
@@ -484,29 +1103,63 @@ void ABaseEnemy::ReactToSeeingPlayer(APawn* PlayerPawn)
         {
             AIController->MoveToActor(PlayerPawn);
         }
+        
+        PlayerSeenSignal.Trigger();
+    }
+}
+
+// React to a nearby squad mate seeing or hearing the player
+void ABaseEnemy::ReceiveSquadAlert(APawn* PlayerPawn, const FVector& Location, bool bSeen)
+{
+    // Enemies already fighting have their own knowledge of the player
+    if (CurrentState == EEnemyState::Chasing || CurrentState == EEnemyState::Attacking)
+    {
+        return;
+    }
+    
+    if (bSeen)
+    {
+        ReactToSeeingPlayer(PlayerPawn);
+    }
+    else
+    {
+        ReactToSound(PlayerPawn, Location);
     }
 }
 
 // Check line of sight to target
 bool ABaseEnemy::HasLineOfSightTo(AActor* Target) const
+{
+    return HasLineOfSightTo(Target, EAISightGridResult::Untested);
+}
+
+// Line of sight with the segment's visibility grid result when it was tested in a batch
+bool ABaseEnemy::HasLineOfSightTo(AActor* Target, EAISightGridResult GridSight) const
 {
     if (!Target)
     {
         return false;
     }
     
+    FVector EyeLocation = GetEyeLocation();
+    
+    // Trace the dedicated sight channel, which small foliage does not block
+    if (const UAISightSubsystem* SightSubsystem = GetWorld()->GetSubsystem<UAISightSubsystem>())
+    {
+        const FAISightResult Sight = SightSubsystem->TraceSight(EyeLocation, Target, this, GridSight);
+        return !Sight.bBlocked && Sight.Concealment < SightConcealmentThreshold;
+    }
+    
     FHitResult HitResult;
-    FVector EyeLocation = GetActorLocation() + FVector(0, 0, BaseEyeHeight);
     FVector TargetLocation = Target->GetActorLocation();
     
-    FCollisionQueryParams QueryParams;
-    QueryParams.AddIgnoredActor(this);
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(AISight), false, this);
     
     bool bHit = GetWorld()->LineTraceSingleByChannel(
         HitResult,
         EyeLocation,
         TargetLocation,
-        ECC_Visibility,
+        ECC_AISight,
         QueryParams
     );
     
@@ -516,10 +1169,24 @@ bool ABaseEnemy::HasLineOfSightTo(AActor* Target) const
 // Reset to default behavior
 void ABaseEnemy::ReturnToDefaultBehavior()
 {
-    SetEnemyState(EEnemyState::Idle);
+    ApplyDefaultBehavior(RandomStream.FRand() < 0.5f);
+}
+
+// Go idle and optionally wander to a random nearby point
+void ABaseEnemy::ApplyDefaultBehavior(bool bWander)
+{
+    // The wander move is requested before going idle: the state change re-evaluates the movement LOD on the spot,
+    // and an idle enemy that is not following a path yet would be put to sleep in the dormant tier
+    bool bMoving = false;
     
-    // Optionally wander around if idle
-    if (FMath::RandBool())
+    // Optionally wander around if idle, drawn towards lingering player heat before picking a random point
+    FVector SearchTarget;
+    if (bWander && FindSearchTarget(SearchTarget))
+    {
+        MoveToLocation(SearchTarget);
+        bMoving = true;
+    }
+    else if (bWander)
     {
         UNavigationSystemV1* NavSystem = UNavigationSystemV1::GetCurrent(GetWorld());
         if (NavSystem)
@@ -528,39 +1195,55 @@ void ABaseEnemy::ReturnToDefaultBehavior()
             if (NavSystem->GetRandomPointInNavigableRadius(GetActorLocation(), 500.0f, RandomLocation))
             {
                 MoveToLocation(RandomLocation.Location);
+                bMoving = true;
             }
         }
     }
+    
+    const bool bWasIdle = CurrentState == EEnemyState::Idle;
+    SetEnemyState(EEnemyState::Idle);
+    
+    // Already idle, so there was no state change to re-evaluate on, and a dormant enemy has to wake up for its move
+    if (bWasIdle && bMoving)
+    {
+        if (UMovementLODSubsystem* MovementLODSubsystem = GetWorld()->GetSubsystem<UMovementLODSubsystem>())
+        {
+            MovementLODSubsystem->EvaluateNow(this);
+        }
+    }
+}
+
+bool ABaseEnemy::FindSearchTarget(FVector& OutLocation) const
+{
+    return InfluenceMap && InfluenceMap->FindSearchTarget(GetActorLocation(), SearchRadius, OutLocation);
 }
 
 // Handle being hit by flashlight
 void ABaseEnemy::ReactToFlashlight(float Intensity)
 {
     // Only react if this enemy type is affected by flashlight
-    if (bAffectedByFlashlight)
+    if (!bAffectedByFlashlight)
     {
-        // Calculate stun chance based on intensity and sensitivity
-        float StunChance = FMath::Clamp(Intensity * FlashlightSensitivity / 8000.0f, 0.0f, 0.75f);
-        
-        // Chance to stun the enemy
-        if (FMath::FRand() < StunChance)
-        {
-            // Stun duration scales with intensity
-            float StunTime = FMath::Clamp(StunDuration * (Intensity / 8000.0f), 1.0f, StunDuration);
-            Stun(StunTime);
-        }
-        else if (CurrentState == EEnemyState::Idle)
+        return;
+    }
+    
+    // Being lit gives away where the player stands, whether or not this enemy reacts to it
+    AActor* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+    if (InfluenceMap && Player)
+    {
+        InfluenceMap->AddPlayerEvidence(Player->GetActorLocation(), Intensity / 8000.0f);
+    }
+    
+    const FFlashlightReaction Reaction = FEnemySim::ReactToFlashlight(Intensity, FlashlightSensitivity, StunDuration, CurrentState == EEnemyState::Idle, RandomStream);
+    if (Reaction.bStun)
+    {
+        Stun(Reaction.StunTime);
+    }
+    else if (Reaction.bInvestigate)
+    {
+        if (Player)
         {
-            // Even if not stunned, high intensity light might make the enemy investigate
-            if (Intensity > 4000.0f && FMath::FRand() < 0.5f)
-            {
-                if (AActor* Player = UGameplayStatics::GetPlayerPawn(this, 0))
-                {
-                    LastKnownPlayerLocation = GetActorLocation() + (Player->GetActorLocation() - GetActorLocation()).GetSafeNormal() * 300.0f;
-                    SetEnemyState(EEnemyState::Investigating);
-                    MoveToLocation(LastKnownPlayerLocation);
-                }
-            }
+            StartInvestigating(GetActorLocation() + (Player->GetActorLocation() - GetActorLocation()).GetSafeNormal() * 300.0f);
         }
     }
 }
@@ -571,16 +1254,42 @@ void ABaseEnemy::OnPlayerSeen(APawn* Pawn)
     if (Pawn && Pawn->IsPlayerControlled())
     {
         ReactToSeeingPlayer(Pawn);
+        ReportPlayerToSquad(Pawn, Pawn->GetActorLocation(), true);
+        
+        if (InfluenceMap)
+        {
+            InfluenceMap->AddPlayerEvidence(Pawn->GetActorLocation(), 1.0f);
+        }
     }
 }
 
 // Called when a sound is heard
 void ABaseEnemy::OnNoiseHeard(APawn* NoiseInstigator, const FVector& Location, float Volume)
 {
+    // Even sounds too quiet to react to hint at where the player is
+    if (InfluenceMap && NoiseInstigator && NoiseInstigator->IsPlayerControlled())
+    {
+        InfluenceMap->AddPlayerEvidence(Location, Volume);
+    }
+    
     // React more strongly to louder sounds
     if (Volume > 0.5f)
     {
         ReactToSound(NoiseInstigator, Location);
+        
+        if (NoiseInstigator && NoiseInstigator->IsPlayerControlled())
+        {
+            ReportPlayerToSquad(NoiseInstigator, Location, false);
+        }
+    }
+}
+
+// Share a sighting or sound of the player with this enemy's squad
+void ABaseEnemy::ReportPlayerToSquad(APawn* PlayerPawn, const FVector& Location, bool bSeen)
+{
+    if (SquadSubsystem && PlayerPawn && CurrentState != EEnemyState::Dead && CurrentState != EEnemyState::Stunned)
+    {
+        SquadSubsystem->ReportPlayer(this, PlayerPawn, Location, bSeen);
     }
 }
 
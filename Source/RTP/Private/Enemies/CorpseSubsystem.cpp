@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemies/CorpseSubsystem.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Corpses"), STAT_Corpses, STATGROUP_RTPAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Corpse Mesh Batches"), STAT_CorpseBatches, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<int32> CVarMaxCorpses(
+    TEXT("rtp.Corpses.MaxCount"),
+    128,
+    TEXT("Maximum number of enemy corpses kept in the world, the oldest is recycled first. 0 destroys enemies after their cleanup time instead."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdClearCorpses(
+    TEXT("rtp.Corpses.Clear"),
+    TEXT("Remove every enemy corpse from the world."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (UCorpseSubsystem* CorpseSubsystem = World ? World->GetSubsystem<UCorpseSubsystem>() : nullptr)
+        {
+            CorpseSubsystem->ClearCorpses();
+        }
+    }));
+
+bool UCorpseSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    // Corpses are instanced meshes left for show, a dedicated server destroys dead enemies after their cleanup time
+    return !IsRunningDedicatedServer() && (WorldType == EWorldType::Game || WorldType == EWorldType::PIE);
+}
+
+void UCorpseSubsystem::Deinitialize()
+{
+    DEC_DWORD_STAT_BY(STAT_Corpses, Corpses.Num());
+    DEC_DWORD_STAT_BY(STAT_CorpseBatches, Batches.Num());
+    
+    Corpses.Reset();
+    Batches.Reset();
+    BatchComponents.Reset();
+    CorpseActor = nullptr;
+    
+    Super::Deinitialize();
+}
+
+bool UCorpseSubsystem::IsEnabled()
+{
+    return CVarMaxCorpses.GetValueOnGameThread() > 0;
+}
+
+UCorpseSubsystem::FCorpseBatch& UCorpseSubsystem::FindOrAddBatch(UStaticMesh* Mesh)
+{
+    if (FCorpseBatch* Batch = Batches.Find(Mesh))
+    {
+        return *Batch;
+    }
+    
+    if (!CorpseActor)
+    {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.Name = TEXT("CorpseInstances");
+        SpawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+        CorpseActor = GetWorld()->SpawnActor<AActor>(SpawnParams);
+        CorpseActor->SetRootComponent(NewObject<USceneComponent>(CorpseActor, TEXT("Root")));
+        CorpseActor->GetRootComponent()->RegisterComponent();
+    }
+    
+    // Corpses are pure scenery: no collision, navigation, overlaps or tick
+    UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent>(CorpseActor);
+    Instances->SetStaticMesh(Mesh);
+    Instances->SetMobility(EComponentMobility::Movable);
+    Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Instances->SetGenerateOverlapEvents(false);
+    Instances->SetCanEverAffectNavigation(false);
+    Instances->PrimaryComponentTick.bCanEverTick = false;
+    Instances->SetupAttachment(CorpseActor->GetRootComponent());
+    Instances->RegisterComponent();
+    BatchComponents.Add(Instances);
+    
+    INC_DWORD_STAT(STAT_CorpseBatches);
+    
+    FCorpseBatch& Batch = Batches.Add(Mesh);
+    Batch.Instances = Instances;
+    return Batch;
+}
+
+void UCorpseSubsystem::AddCorpse(ABaseEnemy* Enemy)
+{
+    if (!Enemy)
+    {
+        return;
+    }
+    
+    const int32 MaxCorpses = FMath::Max(CVarMaxCorpses.GetValueOnGameThread(), 1);
+    while (Corpses.Num() >= MaxCorpses)
+    {
+        RecycleOldest();
+    }
+    
+    FCorpseRecord& Record = Corpses.AddDefaulted_GetRef();
+    INC_DWORD_STAT(STAT_Corpses);
+    
+    if (UStaticMesh* CorpseMesh = Enemy->GetCorpseMesh())
+    {
+        // The authored mesh is in the death pose, placed where the skeletal mesh was
+        const FTransform CorpseTransform = Enemy->GetMesh()->GetComponentTransform();
+        
+        FCorpseBatch& Batch = FindOrAddBatch(CorpseMesh);
+        if (Batch.FreeSlots.Num() > 0)
+        {
+            Record.InstanceIndex = Batch.FreeSlots.Pop(EAllowShrinking::No);
+            Batch.Instances->UpdateInstanceTransform(Record.InstanceIndex, CorpseTransform, true, true);
+        }
+        else
+        {
+            Record.InstanceIndex = Batch.Instances->AddInstance(CorpseTransform, true);
+        }
+        Record.Instances = Batch.Instances;
+        
+        Enemy->Destroy();
+    }
+    else
+    {
+        Enemy->FreezeAsCorpse();
+        Record.FrozenEnemy = Enemy;
+    }
+}
+
+void UCorpseSubsystem::RecycleOldest()
+{
+    if (Corpses.Num() == 0)
+    {
+        return;
+    }
+    
+    const FCorpseRecord Oldest = Corpses[0];
+    Corpses.RemoveAt(0, 1, EAllowShrinking::No);
+    DEC_DWORD_STAT(STAT_Corpses);
+    
+    if (UInstancedStaticMeshComponent* Instances = Oldest.Instances.Get())
+    {
+        // Hide the instance rather than removing it, removal would shift the indices of newer corpses
+        Instances->UpdateInstanceTransform(Oldest.InstanceIndex, FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector), true, true);
+        Batches.FindChecked(Instances->GetStaticMesh()).FreeSlots.Add(Oldest.InstanceIndex);
+    }
+    else if (ABaseEnemy* FrozenEnemy = Oldest.FrozenEnemy.Get())
+    {
+        FrozenEnemy->Destroy();
+    }
+}
+
+void UCorpseSubsystem::ClearCorpses()
+{
+    for (const FCorpseRecord& Record : Corpses)
+    {
+        if (ABaseEnemy* FrozenEnemy = Record.FrozenEnemy.Get())
+        {
+            FrozenEnemy->Destroy();
+        }
+    }
+    
+    for (TPair<UStaticMesh*, FCorpseBatch>& Pair : Batches)
+    {
+        Pair.Value.Instances->ClearInstances();
+        Pair.Value.FreeSlots.Reset();
+    }
+    
+    DEC_DWORD_STAT_BY(STAT_Corpses, Corpses.Num());
+    Corpses.Reset();
+}
@@ -0,0 +1,246 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemies/EnemyAssetPreloader.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+#include "RTP.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resident Enemy Asset Bundles"), STAT_ResidentEnemyBundles, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<float> CVarEnemyBundleReleaseDelay(
+    TEXT("rtp.Enemy.BundleReleaseDelay"),
+    30.0f,
+    TEXT("Seconds an enemy type's asset bundle stays resident after its last enemy is gone."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorld ListEnemyAssetBundlesCommand(
+    TEXT("rtp.Enemy.ListAssetBundles"),
+    TEXT("Log every enemy asset bundle with its users, load time and resident size."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (const UEnemyAssetPreloader* Preloader = World ? World->GetSubsystem<UEnemyAssetPreloader>() : nullptr)
+        {
+            Preloader->LogBundles();
+        }
+    }));
+
+bool UEnemyAssetPreloader::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEnemyAssetPreloader::Deinitialize()
+{
+    for (TPair<TObjectKey<UClass>, FEnemyBundle>& Pair : Bundles)
+    {
+        if (Pair.Value.Handle.IsValid())
+        {
+            Pair.Value.Handle->ReleaseHandle();
+        }
+        if (Pair.Value.bLoaded)
+        {
+            DEC_DWORD_STAT(STAT_ResidentEnemyBundles);
+        }
+    }
+    Bundles.Reset();
+    
+    Super::Deinitialize();
+}
+
+UEnemyAssetPreloader::FEnemyBundle& UEnemyAssetPreloader::FindOrRequestBundle(UClass* EnemyClass)
+{
+    const TObjectKey<UClass> Key(EnemyClass);
+    if (FEnemyBundle* Bundle = Bundles.Find(Key))
+    {
+        return *Bundle;
+    }
+    
+    FEnemyBundle& Bundle = Bundles.Add(Key);
+    Bundle.RequestTime = FPlatformTime::Seconds();
+    
+    TArray<FSoftObjectPath> Assets;
+    EnemyClass->GetDefaultObject<ABaseEnemy>()->GetPreloadAssets(Assets);
+    Assets.RemoveAll([](const FSoftObjectPath& Path) { return Path.IsNull(); });
+    
+    if (Assets.Num() > 0)
+    {
+        Bundle.Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+            Assets,
+            FStreamableDelegate::CreateUObject(this, &UEnemyAssetPreloader::HandleBundleLoaded, Key),
+            FStreamableManager::AsyncLoadHighPriority);
+    }
+    
+    // Nothing to stream, or everything was already resident and the handle completed synchronously
+    if (!Bundle.bLoaded && (!Bundle.Handle.IsValid() || Bundle.Handle->HasLoadCompleted()))
+    {
+        Bundle.bLoaded = true;
+        INC_DWORD_STAT(STAT_ResidentEnemyBundles);
+    }
+    
+    return Bundle;
+}
+
+void UEnemyAssetPreloader::Preload(TSubclassOf<ABaseEnemy> EnemyClass, FStreamableDelegate OnLoaded)
+{
+    if (!EnemyClass)
+    {
+        OnLoaded.ExecuteIfBound();
+        return;
+    }
+    
+    FEnemyBundle& Bundle = FindOrRequestBundle(EnemyClass);
+    
+    // A bundle preloaded ahead of its first enemy is released like one whose enemies are gone
+    if (Bundle.NumUsers == 0)
+    {
+        MarkUnused(Bundle);
+    }
+    
+    if (Bundle.bLoaded)
+    {
+        OnLoaded.ExecuteIfBound();
+    }
+    else if (OnLoaded.IsBound())
+    {
+        Bundle.PendingCallbacks.Add(MoveTemp(OnLoaded));
+    }
+}
+
+bool UEnemyAssetPreloader::IsLoaded(TSubclassOf<ABaseEnemy> EnemyClass) const
+{
+    const FEnemyBundle* Bundle = Bundles.Find(TObjectKey<UClass>(EnemyClass));
+    return Bundle && Bundle->bLoaded;
+}
+
+void UEnemyAssetPreloader::HandleBundleLoaded(TObjectKey<UClass> EnemyClass)
+{
+    FEnemyBundle* Bundle = Bundles.Find(EnemyClass);
+    if (!Bundle || Bundle->bLoaded)
+    {
+        return;
+    }
+    
+    Bundle->bLoaded = true;
+    Bundle->LoadSeconds = FPlatformTime::Seconds() - Bundle->RequestTime;
+    INC_DWORD_STAT(STAT_ResidentEnemyBundles);
+    
+    UE_LOG(LogRTP, Verbose, TEXT("Loaded asset bundle of %s in %.1f ms"), *GetNameSafe(EnemyClass.ResolveObjectPtr()), Bundle->LoadSeconds * 1000.0);
+    
+    // The release delay runs from the load, not the request, if nobody picked the bundle up in the meantime
+    if (Bundle->NumUsers == 0)
+    {
+        MarkUnused(*Bundle);
+    }
+    
+    // Callbacks may request more bundles, which can reallocate the map
+    TArray<FStreamableDelegate> Callbacks = MoveTemp(Bundle->PendingCallbacks);
+    for (FStreamableDelegate& Callback : Callbacks)
+    {
+        Callback.ExecuteIfBound();
+    }
+}
+
+void UEnemyAssetPreloader::AddUser(TSubclassOf<ABaseEnemy> EnemyClass)
+{
+    if (EnemyClass)
+    {
+        ++FindOrRequestBundle(EnemyClass).NumUsers;
+    }
+}
+
+void UEnemyAssetPreloader::RemoveUser(TSubclassOf<ABaseEnemy> EnemyClass)
+{
+    FEnemyBundle* Bundle = Bundles.Find(TObjectKey<UClass>(EnemyClass));
+    if (!Bundle || Bundle->NumUsers == 0)
+    {
+        return;
+    }
+    
+    if (--Bundle->NumUsers == 0)
+    {
+        // Keep the bundle around for a while in case the next wave uses the same type
+        MarkUnused(*Bundle);
+    }
+}
+
+void UEnemyAssetPreloader::MarkUnused(FEnemyBundle& Bundle)
+{
+    const float ReleaseDelay = CVarEnemyBundleReleaseDelay.GetValueOnGameThread();
+    Bundle.UnusedSince = GetWorld()->GetTimeSeconds();
+    if (!GetWorld()->GetTimerManager().IsTimerActive(ReleaseTimerHandle))
+    {
+        GetWorld()->GetTimerManager().SetTimer(ReleaseTimerHandle, this, &UEnemyAssetPreloader::ReleaseUnusedBundles, FMath::Max(ReleaseDelay, 0.1f), false);
+    }
+}
+
+void UEnemyAssetPreloader::ReleaseUnusedBundles()
+{
+    const float ReleaseDelay = CVarEnemyBundleReleaseDelay.GetValueOnGameThread();
+    const double Now = GetWorld()->GetTimeSeconds();
+    double NextRelease = TNumericLimits<double>::Max();
+    
+    for (auto It = Bundles.CreateIterator(); It; ++It)
+    {
+        FEnemyBundle& Bundle = It.Value();
+        if (Bundle.NumUsers > 0 || Bundle.PendingCallbacks.Num() > 0)
+        {
+            continue;
+        }
+        
+        const double ReleaseTime = Bundle.UnusedSince + ReleaseDelay;
+        if (ReleaseTime > Now)
+        {
+            NextRelease = FMath::Min(NextRelease, ReleaseTime);
+            continue;
+        }
+        
+        // Released assets are unloaded by the next garbage collection unless something else holds them
+        if (Bundle.Handle.IsValid())
+        {
+            Bundle.Handle->ReleaseHandle();
+        }
+        if (Bundle.bLoaded)
+        {
+            DEC_DWORD_STAT(STAT_ResidentEnemyBundles);
+        }
+        It.RemoveCurrent();
+    }
+    
+    if (NextRelease != TNumericLimits<double>::Max())
+    {
+        GetWorld()->GetTimerManager().SetTimer(ReleaseTimerHandle, this, &UEnemyAssetPreloader::ReleaseUnusedBundles, FMath::Max(NextRelease - Now, 0.1), false);
+    }
+}
+
+void UEnemyAssetPreloader::LogBundles() const
+{
+    int64 TotalBytes = 0;
+    for (const TPair<TObjectKey<UClass>, FEnemyBundle>& Pair : Bundles)
+    {
+        const FEnemyBundle& Bundle = Pair.Value;
+        
+        TArray<UObject*> Assets;
+        if (Bundle.Handle.IsValid())
+        {
+            Bundle.Handle->GetLoadedAssets(Assets);
+        }
+        
+        int64 Bytes = 0;
+        for (const UObject* Asset : Assets)
+        {
+            Bytes += Asset ? Asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal) : 0;
+        }
+        TotalBytes += Bytes;
+        
+        UE_LOG(LogRTP, Display, TEXT("%s: %s, %d users, %d assets, %.1f ms to load, %lld KB"),
+            *GetNameSafe(Pair.Key.ResolveObjectPtr()), Bundle.bLoaded ? TEXT("resident") : TEXT("loading"),
+            Bundle.NumUsers, Assets.Num(), Bundle.LoadSeconds * 1000.0, Bytes / 1024);
+    }
+    
+    UE_LOG(LogRTP, Display, TEXT("%d enemy asset bundles, %lld KB resident"), Bundles.Num(), TotalBytes / 1024);
+}
@@ -0,0 +1,244 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemies/EnemySpawnSubsystem.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "Enemies/EnemyAssetPreloader.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "RTP.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Spawn Queue"), STAT_EnemySpawnQueue, STATGROUP_RTPAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pending Enemy Spawns"), STAT_PendingEnemySpawns, STATGROUP_RTPAI);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Worst Spawn Frame (ms)"), STAT_WorstSpawnFrameMs, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<float> CVarEnemySpawnBudgetMs(
+    TEXT("rtp.Enemy.SpawnBudgetMs"),
+    2.0f,
+    TEXT("Milliseconds per frame the spawn queue may spend constructing and finishing enemies. At least one step runs every frame."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs SpawnWaveCommand(
+    TEXT("rtp.Enemy.SpawnWave"),
+    TEXT("Spawn a wave of enemies in a ring around the player, through the spawn queue or all in one frame. Usage: rtp.Enemy.SpawnWave <ClassPath> [Count=50] [Immediate=0]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        UEnemySpawnSubsystem* SpawnSubsystem = World ? World->GetSubsystem<UEnemySpawnSubsystem>() : nullptr;
+        const APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0);
+        UClass* EnemyClass = Args.Num() > 0 ? LoadClass<ABaseEnemy>(nullptr, *Args[0]) : nullptr;
+        if (!SpawnSubsystem || !Player || !EnemyClass)
+        {
+            UE_LOG(LogRTP, Warning, TEXT("rtp.Enemy.SpawnWave needs a player and a valid ABaseEnemy class path"));
+            return;
+        }
+        
+        const int32 Count = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 50;
+        const bool bImmediate = Args.Num() > 2 && FCString::Atoi(*Args[2]) != 0;
+        
+        TArray<FTransform> Transforms;
+        for (int32 Index = 0; Index < Count; ++Index)
+        {
+            const float Angle = 2.0f * PI * Index / Count;
+            const FVector Offset(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f);
+            Transforms.Add(FTransform(FRotator(0.0f, Angle * 180.0f / PI + 180.0f, 0.0f), Player->GetActorLocation() + Offset * 1500.0f));
+        }
+        
+        if (!bImmediate)
+        {
+            for (const FTransform& Transform : Transforms)
+            {
+                SpawnSubsystem->RequestSpawn(EnemyClass, Transform);
+            }
+            return;
+        }
+        
+        // Baseline for comparison: every spawn in this frame, the way a wave used to be spawned
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+        const double StartTime = FPlatformTime::Seconds();
+        for (const FTransform& Transform : Transforms)
+        {
+            World->SpawnActor<ABaseEnemy>(EnemyClass, Transform, SpawnParams);
+        }
+        UE_LOG(LogRTP, Display, TEXT("Spawned %d enemies in one frame: %.2f ms"), Count, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+    }));
+
+static FAutoConsoleCommandWithWorld MeasureEnemyFootprintCommand(
+    TEXT("rtp.Enemy.MeasureFootprint"),
+    TEXT("Log the average object memory, components, enabled tick functions and animated meshes per living enemy, to compare dedicated and listen servers."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (!World)
+        {
+            return;
+        }
+        
+        int32 NumEnemies = 0;
+        int32 NumComponents = 0;
+        int32 NumTickFunctions = 0;
+        int32 NumAnimatedMeshes = 0;
+        SIZE_T Bytes = 0;
+        for (TActorIterator<ABaseEnemy> It(World); It; ++It)
+        {
+            ++NumEnemies;
+            Bytes += FArchiveCountMem(*It).GetMax();
+            NumTickFunctions += It->IsActorTickEnabled();
+            
+            TInlineComponentArray<UActorComponent*> Components(*It);
+            for (UActorComponent* Component : Components)
+            {
+                ++NumComponents;
+                Bytes += FArchiveCountMem(Component).GetMax();
+                NumTickFunctions += Component->IsComponentTickEnabled();
+                
+                if (const USkeletalMeshComponent* Mesh = Cast<USkeletalMeshComponent>(Component))
+                {
+                    NumAnimatedMeshes += Mesh->ShouldTickPose();
+                }
+            }
+        }
+        
+        if (NumEnemies == 0)
+        {
+            UE_LOG(LogRTP, Display, TEXT("No living enemies to measure"));
+            return;
+        }
+        
+        const ENetMode NetMode = World->GetNetMode();
+        const TCHAR* NetModeName = NetMode == NM_DedicatedServer ? TEXT("dedicated server") : NetMode == NM_ListenServer ? TEXT("listen server") : NetMode == NM_Client ? TEXT("client") : TEXT("standalone");
+        UE_LOG(LogRTP, Display, TEXT("%d enemies on %s: %.1f KB, %.1f components, %.1f enabled tick functions per enemy, %d of them with a ticking pose"),
+            NumEnemies, NetModeName, Bytes / 1024.0 / NumEnemies, static_cast<float>(NumComponents) / NumEnemies,
+            static_cast<float>(NumTickFunctions) / NumEnemies, NumAnimatedMeshes);
+    }));
+
+bool UEnemySpawnSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEnemySpawnSubsystem::Deinitialize()
+{
+    DEC_DWORD_STAT_BY(STAT_PendingEnemySpawns, GetNumPending());
+    
+    Requests.Reset();
+    Deferred.Reset();
+    
+    Super::Deinitialize();
+}
+
+TStatId UEnemySpawnSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemySpawnSubsystem, STATGROUP_Tickables);
+}
+
+void UEnemySpawnSubsystem::RequestSpawn(TSubclassOf<ABaseEnemy> EnemyClass, const FTransform& Transform, FOnEnemySpawned OnSpawned)
+{
+    if (!EnemyClass)
+    {
+        return;
+    }
+    
+    // The request holds the type's bundle until its enemy exists and holds it instead
+    if (UEnemyAssetPreloader* Preloader = GetWorld()->GetSubsystem<UEnemyAssetPreloader>())
+    {
+        Preloader->AddUser(EnemyClass);
+    }
+    
+    Requests.Add({ EnemyClass, Transform, MoveTemp(OnSpawned) });
+    INC_DWORD_STAT(STAT_PendingEnemySpawns);
+}
+
+void UEnemySpawnSubsystem::Tick(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_EnemySpawnQueue);
+    
+    Super::Tick(DeltaTime);
+    
+    if (Requests.Num() == 0 && Deferred.Num() == 0)
+    {
+        return;
+    }
+    
+    const double StartTime = FPlatformTime::Seconds();
+    const double Budget = CVarEnemySpawnBudgetMs.GetValueOnGameThread() / 1000.0;
+    bool bDidWork = false;
+    
+    auto HasBudget = [&]()
+    {
+        // Always make progress, even when a single step exceeds the budget
+        return !bDidWork || FPlatformTime::Seconds() - StartTime < Budget;
+    };
+    
+    UEnemyAssetPreloader* Preloader = GetWorld()->GetSubsystem<UEnemyAssetPreloader>();
+    
+    // Finish last frame's constructions first so enemies appear in request order
+    int32 NumFinished = 0;
+    while (NumFinished < Deferred.Num() && HasBudget())
+    {
+        FDeferredSpawn& Spawn = Deferred[NumFinished++];
+        if (ABaseEnemy* Enemy = Spawn.Enemy.Get())
+        {
+            Enemy->FinishSpawning(Spawn.Transform);
+            Spawn.OnSpawned.ExecuteIfBound(Enemy);
+            ++WaveSpawns;
+        }
+        
+        if (Preloader)
+        {
+            Preloader->RemoveUser(Spawn.EnemyClass);
+        }
+        bDidWork = true;
+    }
+    Deferred.RemoveAt(0, NumFinished, EAllowShrinking::No);
+    DEC_DWORD_STAT_BY(STAT_PendingEnemySpawns, NumFinished);
+    
+    // Construct new enemies whose assets are resident, later requests may overtake ones still loading
+    for (int32 Index = 0; Index < Requests.Num() && HasBudget(); )
+    {
+        FSpawnRequest& Request = Requests[Index];
+        if (Preloader && !Preloader->IsLoaded(Request.EnemyClass))
+        {
+            ++Index;
+            continue;
+        }
+        
+        ABaseEnemy* Enemy = GetWorld()->SpawnActorDeferred<ABaseEnemy>(Request.EnemyClass, Request.Transform, nullptr, nullptr,
+            ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+        if (Enemy)
+        {
+            Deferred.Add({ Request.EnemyClass, Enemy, Request.Transform, MoveTemp(Request.OnSpawned) });
+        }
+        else
+        {
+            DEC_DWORD_STAT(STAT_PendingEnemySpawns);
+            if (Preloader)
+            {
+                Preloader->RemoveUser(Request.EnemyClass);
+            }
+        }
+        
+        Requests.RemoveAt(Index, 1, EAllowShrinking::No);
+        bDidWork = true;
+    }
+    
+    if (bDidWork)
+    {
+        const double FrameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+        WorstFrameMs = FMath::Max(WorstFrameMs, FrameMs);
+        ++WaveFrames;
+        SET_FLOAT_STAT(STAT_WorstSpawnFrameMs, WorstFrameMs);
+    }
+    
+    if (Requests.Num() == 0 && Deferred.Num() == 0)
+    {
+        UE_LOG(LogRTP, Display, TEXT("Spawn queue drained: %d enemies over %d frames, worst frame %.2f ms"), WaveSpawns, WaveFrames, WorstFrameMs);
+        WorstFrameMs = 0.0;
+        WaveSpawns = 0;
+        WaveFrames = 0;
+    }
+}
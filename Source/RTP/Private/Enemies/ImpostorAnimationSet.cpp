@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemies/ImpostorAnimationSet.h"
+
+const FName UImpostorAnimationSet::PositionTextureParameter(TEXT("VAT_PositionTexture"));
+const FName UImpostorAnimationSet::NormalTextureParameter(TEXT("VAT_NormalTexture"));
+const FName UImpostorAnimationSet::RowsPerFrameParameter(TEXT("VAT_RowsPerFrame"));
+const FName UImpostorAnimationSet::TextureHeightParameter(TEXT("VAT_TextureHeight"));
+const FName UImpostorAnimationSet::SampleRateParameter(TEXT("VAT_SampleRate"));
+
+UImpostorAnimationSet::UImpostorAnimationSet()
+{
+    Clips.SetNum(static_cast<int32>(EImpostorClip::Num));
+}
@@ -0,0 +1,401 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemies/ImpostorSubsystem.h"
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "Enemies/ImpostorAnimationSet.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+DECLARE_CYCLE_STAT(TEXT("Impostor Update"), STAT_ImpostorUpdate, STATGROUP_RTPAI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Impostors"), STAT_Impostors, STATGROUP_RTPAI);
+
+static TAutoConsoleVariable<bool> CVarImpostorEnable(
+    TEXT("rtp.Impostor.Enable"),
+    true,
+    TEXT("Render distant enemies that have an impostor animation set as vertex-animated instances."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarImpostorEnterDistance(
+    TEXT("rtp.Impostor.EnterDistance"),
+    4000.0f,
+    TEXT("Distance from the camera beyond which enemies switch to their impostor."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarImpostorExitDistance(
+    TEXT("rtp.Impostor.ExitDistance"),
+    3500.0f,
+    TEXT("Distance from the camera within which impostors switch back to the skeletal mesh."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarImpostorEvaluationsPerFrame(
+    TEXT("rtp.Impostor.EvaluationsPerFrame"),
+    32,
+    TEXT("Number of enemies whose impostor LOD and playback are re-evaluated each frame."),
+    ECVF_Default);
+
+bool UImpostorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    // Impostors only change what is drawn
+    return !IsRunningDedicatedServer() && (WorldType == EWorldType::Game || WorldType == EWorldType::PIE);
+}
+
+void UImpostorSubsystem::Deinitialize()
+{
+    DEC_DWORD_STAT_BY(STAT_Impostors, GetNumImpostors());
+    
+    Agents.Empty();
+    AgentIds.Reset();
+    Batches.Reset();
+    BatchComponents.Reset();
+    BatchAnimationSets.Reset();
+    ImpostorActor = nullptr;
+    
+    Super::Deinitialize();
+}
+
+TStatId UImpostorSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UImpostorSubsystem, STATGROUP_Tickables);
+}
+
+FImpostorLODSettings UImpostorSubsystem::GetSettings()
+{
+    FImpostorLODSettings Settings;
+    Settings.EnterDistance = CVarImpostorEnterDistance.GetValueOnGameThread();
+    Settings.ExitDistance = FMath::Min(CVarImpostorExitDistance.GetValueOnGameThread(), Settings.EnterDistance);
+    return Settings;
+}
+
+bool UImpostorSubsystem::GetViewLocation(FVector& OutLocation) const
+{
+    const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+    if (!PlayerController || !PlayerController->PlayerCameraManager)
+    {
+        return false;
+    }
+    
+    OutLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+    return true;
+}
+
+int32 UImpostorSubsystem::GetNumImpostors() const
+{
+    int32 NumImpostors = 0;
+    for (const TPair<UImpostorAnimationSet*, FImpostorBatch>& Pair : Batches)
+    {
+        NumImpostors += Pair.Value.Table.Num();
+    }
+    return NumImpostors;
+}
+
+bool UImpostorSubsystem::IsImpostor(const ABaseEnemy* Enemy) const
+{
+    const int32* AgentId = AgentIds.Find(Enemy);
+    return AgentId && Agents[*AgentId].InstanceIndex != INDEX_NONE;
+}
+
+void UImpostorSubsystem::RegisterEnemy(ABaseEnemy* Enemy, UImpostorAnimationSet* AnimationSet)
+{
+    if (!Enemy || !AnimationSet || !AnimationSet->Mesh || AgentIds.Contains(Enemy))
+    {
+        return;
+    }
+    
+    FImpostorAgent Agent;
+    Agent.Enemy = Enemy;
+    Agent.AnimationSet = AnimationSet;
+    AgentIds.Add(Enemy, Agents.Add(MoveTemp(Agent)));
+}
+
+void UImpostorSubsystem::UnregisterEnemy(ABaseEnemy* Enemy)
+{
+    int32 AgentId = INDEX_NONE;
+    if (!AgentIds.RemoveAndCopyValue(Enemy, AgentId))
+    {
+        return;
+    }
+    
+    SwitchToSkeletal(AgentId);
+    Agents.RemoveAt(AgentId);
+}
+
+void UImpostorSubsystem::EvaluateNow(ABaseEnemy* Enemy)
+{
+    const int32* AgentId = AgentIds.Find(Enemy);
+    FVector ViewLocation;
+    if (AgentId && GetViewLocation(ViewLocation))
+    {
+        EvaluateAgent(*AgentId, ViewLocation, GetSettings(), GetWorld()->GetTimeSeconds());
+    }
+}
+
+UImpostorSubsystem::FImpostorBatch& UImpostorSubsystem::FindOrAddBatch(UImpostorAnimationSet* AnimationSet)
+{
+    if (FImpostorBatch* Batch = Batches.Find(AnimationSet))
+    {
+        return *Batch;
+    }
+    
+    if (!ImpostorActor)
+    {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.Name = TEXT("EnemyImpostors");
+        SpawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+        ImpostorActor = GetWorld()->SpawnActor<AActor>(SpawnParams);
+        ImpostorActor->SetRootComponent(NewObject<USceneComponent>(ImpostorActor, TEXT("Root")));
+        ImpostorActor->GetRootComponent()->RegisterComponent();
+    }
+    
+    UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent>(ImpostorActor);
+    Instances->SetStaticMesh(AnimationSet->Mesh);
+    Instances->SetMobility(EComponentMobility::Movable);
+    Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Instances->SetGenerateOverlapEvents(false);
+    Instances->SetCanEverAffectNavigation(false);
+    Instances->PrimaryComponentTick.bCanEverTick = false;
+    Instances->NumCustomDataFloats = UImpostorAnimationSet::NumCustomDataFloats;
+    
+    // The vertex animation textures and their layout are shared by every instance of the set
+    if (AnimationSet->Material)
+    {
+        UMaterialInstanceDynamic* Material = UMaterialInstanceDynamic::Create(AnimationSet->Material, Instances);
+        Material->SetTextureParameterValue(UImpostorAnimationSet::PositionTextureParameter, AnimationSet->PositionTexture);
+        Material->SetTextureParameterValue(UImpostorAnimationSet::NormalTextureParameter, AnimationSet->NormalTexture);
+        Material->SetScalarParameterValue(UImpostorAnimationSet::RowsPerFrameParameter, AnimationSet->RowsPerFrame);
+        Material->SetScalarParameterValue(UImpostorAnimationSet::TextureHeightParameter, AnimationSet->TextureHeight);
+        Material->SetScalarParameterValue(UImpostorAnimationSet::SampleRateParameter, AnimationSet->SampleRate);
+        for (int32 MaterialIndex = 0; MaterialIndex < Instances->GetNumMaterials(); ++MaterialIndex)
+        {
+            Instances->SetMaterial(MaterialIndex, Material);
+        }
+    }
+    
+    Instances->SetupAttachment(ImpostorActor->GetRootComponent());
+    Instances->RegisterComponent();
+    BatchComponents.Add(Instances);
+    BatchAnimationSets.Add(AnimationSet);
+    
+    FImpostorBatch& Batch = Batches.Add(AnimationSet);
+    Batch.Instances = Instances;
+    return Batch;
+}
+
+void UImpostorSubsystem::Tick(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_ImpostorUpdate);
+    
+    Super::Tick(DeltaTime);
+    
+    if (!CVarImpostorEnable.GetValueOnGameThread())
+    {
+        if (GetNumImpostors() > 0)
+        {
+            for (TSparseArray<FImpostorAgent>::TIterator It(Agents); It; ++It)
+            {
+                SwitchToSkeletal(It.GetIndex());
+            }
+        }
+        return;
+    }
+    
+    FVector ViewLocation;
+    if (!GetViewLocation(ViewLocation))
+    {
+        return;
+    }
+    
+    const FImpostorLODSettings Settings = GetSettings();
+    const float Time = GetWorld()->GetTimeSeconds();
+    
+    // Time-sliced: impostors are far away, a few frames of latency is not visible
+    const int32 MaxIndex = Agents.GetMaxIndex();
+    const int32 Budget = FMath::Min(CVarImpostorEvaluationsPerFrame.GetValueOnGameThread(), MaxIndex);
+    for (int32 Step = 0; Step < Budget; ++Step)
+    {
+        if (EvaluationCursor >= MaxIndex)
+        {
+            EvaluationCursor = 0;
+        }
+        
+        const int32 AgentId = EvaluationCursor++;
+        if (Agents.IsAllocated(AgentId))
+        {
+            EvaluateAgent(AgentId, ViewLocation, Settings, Time);
+        }
+    }
+    
+    SyncTransforms();
+    
+    SET_DWORD_STAT(STAT_Impostors, GetNumImpostors());
+}
+
+void UImpostorSubsystem::EvaluateAgent(int32 AgentId, const FVector& ViewLocation, const FImpostorLODSettings& Settings, float Time)
+{
+    FImpostorAgent& Agent = Agents[AgentId];
+    const ABaseEnemy* Enemy = Agent.Enemy.Get();
+    if (!Enemy)
+    {
+        return;
+    }
+    
+    // Attacks, stuns and deaths are montages the impostor cannot play
+    const EEnemyState State = Enemy->GetEnemyState();
+    const bool bForceSkeletal = State == EEnemyState::Attacking || State == EEnemyState::Stunned || State == EEnemyState::Dead;
+    
+    const bool bIsImpostor = Agent.InstanceIndex != INDEX_NONE;
+    const float DistanceSquared = FVector::DistSquared(ViewLocation, Enemy->GetActorLocation());
+    const bool bUseImpostor = FImpostorLODPolicy::ShouldUseImpostor(Settings, DistanceSquared, bForceSkeletal, bIsImpostor);
+    
+    if (bUseImpostor && !bIsImpostor)
+    {
+        SwitchToImpostor(AgentId, Settings, Time);
+    }
+    else if (!bUseImpostor && bIsImpostor)
+    {
+        SwitchToSkeletal(AgentId);
+    }
+    else if (bIsImpostor)
+    {
+        UpdateAnimation(Agent, Settings, Time);
+    }
+}
+
+void UImpostorSubsystem::SwitchToImpostor(int32 AgentId, const FImpostorLODSettings& Settings, float Time)
+{
+    FImpostorAgent& Agent = Agents[AgentId];
+    ABaseEnemy* Enemy = Agent.Enemy.Get();
+    USkeletalMeshComponent* MeshComponent = Enemy->GetMesh();
+    
+    FImpostorBatch& Batch = FindOrAddBatch(Agent.AnimationSet);
+    Agent.InstanceIndex = Batch.Table.Add(AgentId);
+    Agent.LastTransform = MeshComponent->GetComponentTransform();
+    verify(Batch.Instances->AddInstance(Agent.LastTransform, true) == Agent.InstanceIndex);
+    
+    // Offset each enemy's cycle so a distant crowd does not walk in lockstep
+    const UImpostorAnimationSet* AnimationSet = Agent.AnimationSet;
+    const EImpostorClip Clip = FImpostorLODPolicy::SelectClip(Settings, Enemy->GetVelocity().Size2D());
+    Agent.Anim.Clip = Clip;
+    Agent.Anim.PlayRate = 1.0f;
+    Agent.Anim.Phase = (GetTypeHash(Enemy->GetFName()) & 0xffff) / 65536.0f * AnimationSet->GetCycleLength(Clip);
+    UpdateAnimation(Agent, Settings, Time);
+    WriteCustomData(Agent);
+    
+    // Hidden skeletal meshes still tick their pose by default, stop it entirely
+    MeshComponent->SetVisibility(false);
+    MeshComponent->SetComponentTickEnabled(false);
+}
+
+void UImpostorSubsystem::SwitchToSkeletal(int32 AgentId)
+{
+    FImpostorAgent& Agent = Agents[AgentId];
+    if (Agent.InstanceIndex == INDEX_NONE)
+    {
+        return;
+    }
+    
+    RemoveInstance(Agent);
+    
+    if (ABaseEnemy* Enemy = Agent.Enemy.Get())
+    {
+        // Evaluate a fresh pose before showing the mesh, otherwise it appears for a frame in its stale pose
+        USkeletalMeshComponent* MeshComponent = Enemy->GetMesh();
+        MeshComponent->SetComponentTickEnabled(true);
+        MeshComponent->TickAnimation(0.0f, false);
+        MeshComponent->RefreshBoneTransforms();
+        MeshComponent->SetVisibility(true);
+    }
+}
+
+void UImpostorSubsystem::RemoveInstance(FImpostorAgent& Agent)
+{
+    FImpostorBatch& Batch = Batches.FindChecked(Agent.AnimationSet);
+    const int32 InstanceIndex = Agent.InstanceIndex;
+    const int32 LastIndex = Batch.Table.Num() - 1;
+    Agent.InstanceIndex = INDEX_NONE;
+    
+    const int32 MovedAgentId = Batch.Table.RemoveAtSwap(InstanceIndex);
+    if (MovedAgentId != INDEX_NONE)
+    {
+        FImpostorAgent& MovedAgent = Agents[MovedAgentId];
+        MovedAgent.InstanceIndex = InstanceIndex;
+        Batch.Instances->UpdateInstanceTransform(InstanceIndex, MovedAgent.LastTransform, true, true);
+        WriteCustomData(MovedAgent);
+    }
+    
+    // Removing the last instance never shifts the others
+    Batch.Instances->RemoveInstance(LastIndex);
+}
+
+void UImpostorSubsystem::UpdateAnimation(FImpostorAgent& Agent, const FImpostorLODSettings& Settings, float Time)
+{
+    const UImpostorAnimationSet* AnimationSet = Agent.AnimationSet;
+    const float Speed = Agent.Enemy->GetVelocity().Size2D();
+    const EImpostorClip Clip = FImpostorLODPolicy::SelectClip(Settings, Speed);
+    
+    const float ReferenceSpeed = AnimationSet->GetClip(Clip).ReferenceSpeed;
+    const float PlayRate = Clip != EImpostorClip::Idle && ReferenceSpeed > 0.0f ? FMath::Clamp(Speed / ReferenceSpeed, 0.5f, 2.0f) : 1.0f;
+    
+    if (Clip == Agent.Anim.Clip && FMath::IsNearlyEqual(PlayRate, Agent.Anim.PlayRate, Agent.Anim.PlayRate * 0.1f))
+    {
+        return;
+    }
+    
+    Agent.Anim = FImpostorLODPolicy::Continue(Agent.Anim, AnimationSet->GetCycleLength(Agent.Anim.Clip),
+        Clip, PlayRate, AnimationSet->GetCycleLength(Clip), Time);
+    
+    if (Agent.InstanceIndex != INDEX_NONE)
+    {
+        WriteCustomData(Agent);
+    }
+}
+
+void UImpostorSubsystem::WriteCustomData(const FImpostorAgent& Agent)
+{
+    const FImpostorClipInfo& Clip = Agent.AnimationSet->GetClip(Agent.Anim.Clip);
+    const float CustomData[UImpostorAnimationSet::NumCustomDataFloats] =
+    {
+        static_cast<float>(Clip.StartFrame),
+        static_cast<float>(Clip.NumFrames),
+        Agent.Anim.PlayRate,
+        Agent.Anim.Phase
+    };
+    
+    Batches.FindChecked(Agent.AnimationSet).Instances->SetCustomData(Agent.InstanceIndex, CustomData, true);
+}
+
+void UImpostorSubsystem::SyncTransforms()
+{
+    for (TPair<UImpostorAnimationSet*, FImpostorBatch>& Pair : Batches)
+    {
+        FImpostorBatch& Batch = Pair.Value;
+        const TArray<int32>& Owners = Batch.Table.GetOwners();
+        for (int32 InstanceIndex = 0; InstanceIndex < Owners.Num(); ++InstanceIndex)
+        {
+            FImpostorAgent& Agent = Agents[Owners[InstanceIndex]];
+            const ABaseEnemy* Enemy = Agent.Enemy.Get();
+            if (!Enemy)
+            {
+                continue;
+            }
+            
+            // Only moved enemies cost anything, standing ones are skipped
+            const FTransform& Transform = Enemy->GetMesh()->GetComponentTransform();
+            if (Transform.GetLocation().Equals(Agent.LastTransform.GetLocation(), 1.0)
+                && Transform.GetRotation().Equals(Agent.LastTransform.GetRotation(), 1.e-3))
+            {
+                continue;
+            }
+            
+            Agent.LastTransform = Transform;
+            Batch.Instances->UpdateInstanceTransform(InstanceIndex, Transform, true, true);
+        }
+    }
+}
@@ -0,0 +1,352 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemies/MovementLODSubsystem.h"
+#include "Components/SprintMovementComponent.h"
+#include "Enemies/BaseEnemy.h"
+#include "AIController.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "RTP.h"
+
+DECLARE_CYCLE_STAT(TEXT("Movement LOD Update"), STAT_MovementLODUpdate, STATGROUP_RTPMovement);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Movement LOD Full"), STAT_MovementLODFull, STATGROUP_RTPMovement);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Movement LOD Reduced"), STAT_MovementLODReduced, STATGROUP_RTPMovement);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Movement LOD Dormant"), STAT_MovementLODDormant, STATGROUP_RTPMovement);
+
+static TAutoConsoleVariable<bool> CVarMovementLODEnable(
+    TEXT("rtp.Movement.LOD.Enable"),
+    true,
+    TEXT("Reduce character movement simulation for enemies far from every player."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarMovementLODReducedDistance(
+    TEXT("rtp.Movement.LOD.ReducedDistance"),
+    2500.0f,
+    TEXT("Distance from the nearest player beyond which enemies NavWalk at a reduced tick rate."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarMovementLODDormantDistance(
+    TEXT("rtp.Movement.LOD.DormantDistance"),
+    5000.0f,
+    TEXT("Distance from the nearest player beyond which idle enemies stop simulating movement."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarMovementLODHysteresis(
+    TEXT("rtp.Movement.LOD.Hysteresis"),
+    300.0f,
+    TEXT("Distance an enemy must come back inside a tier's threshold before returning to the closer tier."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarMovementLODReducedTickInterval(
+    TEXT("rtp.Movement.LOD.ReducedTickInterval"),
+    0.05f,
+    TEXT("Seconds between character movement ticks for enemies in the reduced tier."),
+    ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarMovementLODEvaluationsPerFrame(
+    TEXT("rtp.Movement.LOD.EvaluationsPerFrame"),
+    32,
+    TEXT("Number of enemies whose movement tier is re-evaluated each frame."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs MeasureMovementLODCommand(
+    TEXT("rtp.Movement.LOD.Measure"),
+    TEXT("Average the frame time over N frames with the movement LOD disabled, then N frames with it enabled. Usage: rtp.Movement.LOD.Measure [Frames]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        if (UMovementLODSubsystem* Subsystem = World ? World->GetSubsystem<UMovementLODSubsystem>() : nullptr)
+        {
+            Subsystem->StartMeasurement(Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 300);
+        }
+    }));
+
+static FAutoConsoleCommandWithWorld ListMovementLODCommand(
+    TEXT("rtp.Movement.LOD.List"),
+    TEXT("Log how many enemies are in each movement LOD tier."),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+    {
+        if (const UMovementLODSubsystem* Subsystem = World ? World->GetSubsystem<UMovementLODSubsystem>() : nullptr)
+        {
+            Subsystem->LogTiers();
+        }
+    }));
+
+bool UMovementLODSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UMovementLODSubsystem::Deinitialize()
+{
+    DEC_DWORD_STAT_BY(STAT_MovementLODFull, NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Full)]);
+    DEC_DWORD_STAT_BY(STAT_MovementLODReduced, NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Reduced)]);
+    DEC_DWORD_STAT_BY(STAT_MovementLODDormant, NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Dormant)]);
+    
+    Agents.Empty();
+    AgentIds.Reset();
+    FMemory::Memzero(NumPerLOD);
+    
+    Super::Deinitialize();
+}
+
+TStatId UMovementLODSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UMovementLODSubsystem, STATGROUP_Tickables);
+}
+
+FMovementLODSettings UMovementLODSubsystem::GetSettings()
+{
+    FMovementLODSettings Settings;
+    Settings.ReducedDistance = CVarMovementLODReducedDistance.GetValueOnGameThread();
+    Settings.DormantDistance = FMath::Max(CVarMovementLODDormantDistance.GetValueOnGameThread(), Settings.ReducedDistance);
+    Settings.Hysteresis = FMath::Max(CVarMovementLODHysteresis.GetValueOnGameThread(), 0.0f);
+    return Settings;
+}
+
+bool UMovementLODSubsystem::IsLODEnabled() const
+{
+    // The first half of a measurement runs everything at full movement
+    const bool bMeasuringWithoutLOD = Measurement.FramesRemaining > 0 && !Measurement.bLODPhase;
+    return CVarMovementLODEnable.GetValueOnGameThread() && !bMeasuringWithoutLOD;
+}
+
+bool UMovementLODSubsystem::GetPlayerLocations(TArray<FVector, TInlineAllocator<4>>& OutLocations) const
+{
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        if (const APawn* Pawn = It->Get() ? It->Get()->GetPawn() : nullptr)
+        {
+            OutLocations.Add(Pawn->GetActorLocation());
+        }
+    }
+    return OutLocations.Num() > 0;
+}
+
+EEnemyMovementLOD UMovementLODSubsystem::GetMovementLOD(const ABaseEnemy* Enemy) const
+{
+    const int32* AgentId = AgentIds.Find(Enemy);
+    return AgentId ? Agents[*AgentId].LOD : EEnemyMovementLOD::Full;
+}
+
+void UMovementLODSubsystem::RegisterEnemy(ABaseEnemy* Enemy)
+{
+    if (!Enemy || AgentIds.Contains(Enemy))
+    {
+        return;
+    }
+    
+    FMovementAgent Agent;
+    Agent.Enemy = Enemy;
+    AgentIds.Add(Enemy, Agents.Add(MoveTemp(Agent)));
+    ++NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Full)];
+}
+
+void UMovementLODSubsystem::UnregisterEnemy(ABaseEnemy* Enemy)
+{
+    int32 AgentId = INDEX_NONE;
+    if (!AgentIds.RemoveAndCopyValue(Enemy, AgentId))
+    {
+        return;
+    }
+    
+    ApplyLOD(Agents[AgentId], EEnemyMovementLOD::Full);
+    --NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Full)];
+    Agents.RemoveAt(AgentId);
+}
+
+void UMovementLODSubsystem::EvaluateNow(ABaseEnemy* Enemy)
+{
+    const int32* AgentId = AgentIds.Find(Enemy);
+    if (!AgentId)
+    {
+        return;
+    }
+    
+    TArray<FVector, TInlineAllocator<4>> PlayerLocations;
+    if (IsLODEnabled() && GetPlayerLocations(PlayerLocations))
+    {
+        EvaluateAgent(Agents[*AgentId], PlayerLocations, GetSettings());
+    }
+}
+
+void UMovementLODSubsystem::Tick(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_MovementLODUpdate);
+    
+    Super::Tick(DeltaTime);
+    
+    UpdateMeasurement();
+    
+    TArray<FVector, TInlineAllocator<4>> PlayerLocations;
+    if (!IsLODEnabled() || !GetPlayerLocations(PlayerLocations))
+    {
+        if (NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Full)] != Agents.Num())
+        {
+            for (FMovementAgent& Agent : Agents)
+            {
+                ApplyLOD(Agent, EEnemyMovementLOD::Full);
+            }
+        }
+    }
+    else
+    {
+        const FMovementLODSettings Settings = GetSettings();
+        
+        // Time-sliced: a distant enemy reaching the full tier a few frames late is not visible,
+        // and anything that needs it right away goes through EvaluateNow
+        const int32 MaxIndex = Agents.GetMaxIndex();
+        const int32 Budget = FMath::Min(CVarMovementLODEvaluationsPerFrame.GetValueOnGameThread(), MaxIndex);
+        for (int32 Step = 0; Step < Budget; ++Step)
+        {
+            if (EvaluationCursor >= MaxIndex)
+            {
+                EvaluationCursor = 0;
+            }
+            
+            const int32 AgentId = EvaluationCursor++;
+            if (Agents.IsAllocated(AgentId))
+            {
+                EvaluateAgent(Agents[AgentId], PlayerLocations, Settings);
+            }
+        }
+    }
+    
+    SET_DWORD_STAT(STAT_MovementLODFull, NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Full)]);
+    SET_DWORD_STAT(STAT_MovementLODReduced, NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Reduced)]);
+    SET_DWORD_STAT(STAT_MovementLODDormant, NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Dormant)]);
+}
+
+void UMovementLODSubsystem::EvaluateAgent(FMovementAgent& Agent, TConstArrayView<FVector> PlayerLocations, const FMovementLODSettings& Settings)
+{
+    const ABaseEnemy* Enemy = Agent.Enemy.Get();
+    if (!Enemy)
+    {
+        return;
+    }
+    
+    // Stunned and dying enemies play montages, keep them on the full simulation with the fighting ones
+    const EEnemyState State = Enemy->GetEnemyState();
+    const bool bInCombat = State != EEnemyState::Idle && State != EEnemyState::Investigating;
+    
+    // A wandering enemy is still moving along a path and must not freeze mid-route
+    const AAIController* Controller = Cast<AAIController>(Enemy->GetController());
+    const bool bIsIdle = State == EEnemyState::Idle && (!Controller || Controller->GetMoveStatus() == EPathFollowingStatus::Idle);
+    
+    float DistanceSquared = TNumericLimits<float>::Max();
+    const FVector EnemyLocation = Enemy->GetActorLocation();
+    for (const FVector& PlayerLocation : PlayerLocations)
+    {
+        DistanceSquared = FMath::Min(DistanceSquared, static_cast<float>(FVector::DistSquared(PlayerLocation, EnemyLocation)));
+    }
+    
+    ApplyLOD(Agent, FMovementLODPolicy::Select(Settings, DistanceSquared, bInCombat, bIsIdle, Agent.LOD));
+}
+
+void UMovementLODSubsystem::ApplyLOD(FMovementAgent& Agent, EEnemyMovementLOD NewLOD)
+{
+    if (Agent.LOD == NewLOD)
+    {
+        return;
+    }
+    
+    --NumPerLOD[static_cast<int32>(Agent.LOD)];
+    ++NumPerLOD[static_cast<int32>(NewLOD)];
+    Agent.LOD = NewLOD;
+    
+    ABaseEnemy* Enemy = Agent.Enemy.Get();
+    if (!Enemy)
+    {
+        return;
+    }
+    
+    // Only swap between the two ground modes, falling and disabled movement are left alone
+    UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement();
+    switch (NewLOD)
+    {
+        case EEnemyMovementLOD::Full:
+            if (Movement->MovementMode == MOVE_NavWalking)
+            {
+                Movement->SetMovementMode(MOVE_Walking);
+            }
+            Movement->SetComponentTickInterval(0.0f);
+            Movement->SetComponentTickEnabled(true);
+            break;
+            
+        case EEnemyMovementLOD::Reduced:
+            // NavWalking follows the navmesh instead of sweeping the capsule along the floor
+            if (Movement->MovementMode == MOVE_Walking)
+            {
+                Movement->SetMovementMode(MOVE_NavWalking);
+            }
+            Movement->SetComponentTickInterval(CVarMovementLODReducedTickInterval.GetValueOnGameThread());
+            Movement->SetComponentTickEnabled(true);
+            break;
+            
+        case EEnemyMovementLOD::Dormant:
+            Movement->StopMovementImmediately();
+            Movement->SetComponentTickEnabled(false);
+            break;
+    }
+}
+
+void UMovementLODSubsystem::StartMeasurement(int32 FramesPerPhase)
+{
+    Measurement = FMeasurement();
+    Measurement.FramesPerPhase = FramesPerPhase;
+    Measurement.FramesRemaining = FramesPerPhase;
+    
+    UE_LOG(LogRTP, Log, TEXT("Measuring movement LOD with %d enemies over 2x%d frames, run 'stat Character' alongside for the CharacterMovement breakdown"),
+        Agents.Num(), FramesPerPhase);
+}
+
+void UMovementLODSubsystem::UpdateMeasurement()
+{
+    if (Measurement.FramesRemaining <= 0)
+    {
+        return;
+    }
+    
+    // Real frame time, unaffected by time dilation
+    Measurement.Seconds[Measurement.bLODPhase ? 1 : 0] += FApp::GetDeltaTime();
+    if (--Measurement.FramesRemaining > 0)
+    {
+        return;
+    }
+    
+    if (!Measurement.bLODPhase)
+    {
+        // Put every enemy in its tier at once so the second phase does not include the transition
+        Measurement.bLODPhase = true;
+        Measurement.FramesRemaining = Measurement.FramesPerPhase;
+        
+        TArray<FVector, TInlineAllocator<4>> PlayerLocations;
+        if (IsLODEnabled() && GetPlayerLocations(PlayerLocations))
+        {
+            const FMovementLODSettings Settings = GetSettings();
+            for (FMovementAgent& Agent : Agents)
+            {
+                EvaluateAgent(Agent, PlayerLocations, Settings);
+            }
+        }
+        return;
+    }
+    
+    const double FullMs = Measurement.Seconds[0] * 1000.0 / Measurement.FramesPerPhase;
+    const double LODMs = Measurement.Seconds[1] * 1000.0 / Measurement.FramesPerPhase;
+    UE_LOG(LogRTP, Log, TEXT("Movement LOD with %d enemies: %.2f ms/frame at full movement, %.2f ms/frame with LOD (%.2f ms saved)"),
+        Agents.Num(), FullMs, LODMs, FullMs - LODMs);
+    LogTiers();
+}
+
+void UMovementLODSubsystem::LogTiers() const
+{
+    UE_LOG(LogRTP, Log, TEXT("Movement LOD tiers: %d full, %d reduced, %d dormant"),
+        NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Full)],
+        NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Reduced)],
+        NumPerLOD[static_cast<int32>(EEnemyMovementLOD::Dormant)]);
+}
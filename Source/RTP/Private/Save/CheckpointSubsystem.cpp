@@ -0,0 +1,378 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Save/CheckpointSubsystem.h"
+#include "Characters/PlayerCharacter.h"
+#include "Enemies/BaseEnemy.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/SoftObjectPath.h"
+#include "RTP.h"
+
+DECLARE_CYCLE_STAT(TEXT("Checkpoint Capture"), STAT_CheckpointCapture, STATGROUP_RTPSave);
+DECLARE_CYCLE_STAT(TEXT("Checkpoint Apply"), STAT_CheckpointApply, STATGROUP_RTPSave);
+
+static TAutoConsoleVariable<int32> CVarCheckpointEnemiesPerFrame(
+    TEXT("rtp.Checkpoint.EnemiesPerFrame"),
+    16,
+    TEXT("Enemies restored per frame while applying a loaded checkpoint."),
+    ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs SaveCheckpointCommand(
+    TEXT("rtp.Checkpoint.Save"),
+    TEXT("Save a checkpoint in the background. Usage: rtp.Checkpoint.Save [SlotName]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        if (UCheckpointSubsystem* Subsystem = World ? World->GetSubsystem<UCheckpointSubsystem>() : nullptr)
+        {
+            Subsystem->SaveCheckpoint(Args.Num() > 0 ? Args[0] : TEXT("Quick"));
+        }
+    }));
+
+static FAutoConsoleCommandWithWorldAndArgs LoadCheckpointCommand(
+    TEXT("rtp.Checkpoint.Load"),
+    TEXT("Load a checkpoint and apply it over several frames. Usage: rtp.Checkpoint.Load [SlotName]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+    {
+        if (UCheckpointSubsystem* Subsystem = World ? World->GetSubsystem<UCheckpointSubsystem>() : nullptr)
+        {
+            Subsystem->LoadCheckpoint(Args.Num() > 0 ? Args[0] : TEXT("Quick"));
+        }
+    }));
+
+namespace
+{
+    // File layout: magic, uncompressed size, then the compressed snapshot
+    constexpr uint32 CheckpointMagic = 0x50435452; // "RTCP"
+    constexpr int32 CheckpointHeaderSize = 2 * sizeof(uint32);
+    
+    // Limits on the uncompressed size read from the header, a corrupt or hostile file must not drive a huge allocation
+    constexpr uint32 MaxCheckpointRawSize = 64 * 1024 * 1024;
+    constexpr uint32 MaxCheckpointCompressionRatio = 64;
+}
+
+bool UCheckpointSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCheckpointSubsystem::Deinitialize()
+{
+    // Let an in-flight write reach the disk, a pending load is simply dropped
+    if (SaveTask.IsValid())
+    {
+        SaveTask.Wait();
+    }
+    if (LoadTask.IsValid())
+    {
+        LoadTask.Wait();
+    }
+    
+    SaveTask = {};
+    LoadTask = {};
+    PendingEnemies.Reset();
+    bApplying = false;
+    
+    Super::Deinitialize();
+}
+
+TStatId UCheckpointSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UCheckpointSubsystem, STATGROUP_Tickables);
+}
+
+FString UCheckpointSubsystem::GetSlotPath(const FString& SlotName)
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Checkpoints"), SlotName + TEXT(".rtpcp"));
+}
+
+bool UCheckpointSubsystem::SaveCheckpoint(const FString& SlotName)
+{
+    if (IsBusy())
+    {
+        UE_LOG(LogRTP, Warning, TEXT("Checkpoint save to '%s' ignored, another save or load is in progress"), *SlotName);
+        return false;
+    }
+    
+    const double CaptureStart = FPlatformTime::Seconds();
+    
+    FCheckpointSnapshot Snapshot;
+    CaptureSnapshot(Snapshot);
+    
+    Stats.CaptureMs = static_cast<float>((FPlatformTime::Seconds() - CaptureStart) * 1000.0);
+    
+    // The snapshot is owned by the task from here on, the game thread never waits for it
+    SaveTask = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+        [Snapshot = MoveTemp(Snapshot), Path = GetSlotPath(SlotName)]() mutable
+        {
+            return WriteSnapshot(Snapshot, Path);
+        });
+    
+    return true;
+}
+
+bool UCheckpointSubsystem::LoadCheckpoint(const FString& SlotName)
+{
+    if (IsBusy())
+    {
+        UE_LOG(LogRTP, Warning, TEXT("Checkpoint load from '%s' ignored, another save or load is in progress"), *SlotName);
+        return false;
+    }
+    
+    LoadTask = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+        [Path = GetSlotPath(SlotName)]()
+        {
+            return ReadSnapshot(Path);
+        });
+    
+    return true;
+}
+
+void UCheckpointSubsystem::CaptureSnapshot(FCheckpointSnapshot& OutSnapshot) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_CheckpointCapture);
+    
+    UWorld* World = GetWorld();
+    
+    if (const APlayerCharacter* Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerPawn(World, 0)))
+    {
+        Player->WriteCheckpoint(OutSnapshot.Player);
+        OutSnapshot.bHasPlayer = true;
+    }
+    
+    for (TActorIterator<ABaseEnemy> It(World); It; ++It)
+    {
+        It->WriteCheckpoint(OutSnapshot.Enemies.AddDefaulted_GetRef());
+    }
+}
+
+UCheckpointSubsystem::FWriteResult UCheckpointSubsystem::WriteSnapshot(FCheckpointSnapshot& Snapshot, const FString& Path)
+{
+    FWriteResult Result;
+    const double StartTime = FPlatformTime::Seconds();
+    
+    TArray<uint8> RawData;
+    FMemoryWriter Writer(RawData);
+    Writer << Snapshot;
+    
+    int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Oodle, RawData.Num());
+    TArray<uint8> FileData;
+    FileData.SetNumUninitialized(CheckpointHeaderSize + CompressedSize);
+    
+    if (FCompression::CompressMemory(NAME_Oodle, FileData.GetData() + CheckpointHeaderSize, CompressedSize, RawData.GetData(), RawData.Num()))
+    {
+        FileData.SetNum(CheckpointHeaderSize + CompressedSize);
+        
+        FMemoryWriter HeaderWriter(FileData);
+        uint32 Magic = CheckpointMagic;
+        uint32 RawSize = RawData.Num();
+        HeaderWriter << Magic;
+        HeaderWriter << RawSize;
+        
+        Result.bSuccess = FFileHelper::SaveArrayToFile(FileData, *Path);
+        Result.RawBytes = RawData.Num();
+        Result.CompressedBytes = CompressedSize;
+    }
+    
+    Result.Seconds = FPlatformTime::Seconds() - StartTime;
+    return Result;
+}
+
+UCheckpointSubsystem::FReadResult UCheckpointSubsystem::ReadSnapshot(const FString& Path)
+{
+    FReadResult Result;
+    const double StartTime = FPlatformTime::Seconds();
+    
+    TArray<uint8> FileData;
+    if (FFileHelper::LoadFileToArray(FileData, *Path, FILEREAD_Silent) && FileData.Num() > CheckpointHeaderSize)
+    {
+        FMemoryReader HeaderReader(FileData);
+        uint32 Magic = 0;
+        uint32 RawSize = 0;
+        HeaderReader << Magic;
+        HeaderReader << RawSize;
+        
+        // Check the claimed size before allocating for it, real snapshots compress well below the ratio
+        const uint64 CompressedSize = FileData.Num() - CheckpointHeaderSize;
+        if (Magic != CheckpointMagic || RawSize > MaxCheckpointRawSize || RawSize > CompressedSize * MaxCheckpointCompressionRatio)
+        {
+            UE_LOG(LogRTP, Warning, TEXT("Checkpoint '%s' rejected, bad header claiming %u bytes from %llu compressed"), *Path, RawSize, CompressedSize);
+        }
+        else
+        {
+            TArray<uint8> RawData;
+            RawData.SetNumUninitialized(RawSize);
+            
+            if (FCompression::UncompressMemory(NAME_Oodle, RawData.GetData(), RawData.Num(),
+                    FileData.GetData() + CheckpointHeaderSize, FileData.Num() - CheckpointHeaderSize))
+            {
+                // No string or array in the snapshot can be longer than the data holding it
+                FMemoryReader Reader(RawData);
+                Reader.ArMaxSerializeSize = RawData.Num();
+                Reader << Result.Snapshot;
+                Result.bSuccess = !Reader.IsError();
+            }
+        }
+    }
+    
+    Result.Seconds = FPlatformTime::Seconds() - StartTime;
+    return Result;
+}
+
+void UCheckpointSubsystem::Tick(float DeltaTime)
+{
+    if (SaveTask.IsValid() && SaveTask.IsCompleted())
+    {
+        FinishSave();
+    }
+    
+    if (LoadTask.IsValid() && LoadTask.IsCompleted())
+    {
+        FReadResult& Result = LoadTask.GetResult();
+        Stats.ReadMs = static_cast<float>(Result.Seconds * 1000.0);
+        
+        if (Result.bSuccess)
+        {
+            BeginApply(MoveTemp(Result.Snapshot));
+        }
+        else
+        {
+            UE_LOG(LogRTP, Warning, TEXT("Checkpoint load failed after %.2f ms"), Stats.ReadMs);
+            OnLoadCompleted.Broadcast(false);
+        }
+        
+        LoadTask = {};
+    }
+    
+    if (bApplying && ApplyNextBatch())
+    {
+        FinishApply(true);
+    }
+}
+
+void UCheckpointSubsystem::FinishSave()
+{
+    const FWriteResult& Result = SaveTask.GetResult();
+    Stats.WriteMs = static_cast<float>(Result.Seconds * 1000.0);
+    Stats.RawBytes = Result.RawBytes;
+    Stats.CompressedBytes = Result.CompressedBytes;
+    const bool bSuccess = Result.bSuccess;
+    
+    SaveTask = {};
+    
+    UE_LOG(LogRTP, Log, TEXT("Checkpoint %s: capture %.3f ms on the game thread, write %.2f ms in the background, %d bytes compressed to %d"),
+        bSuccess ? TEXT("saved") : TEXT("save failed"), Stats.CaptureMs, Stats.WriteMs, Stats.RawBytes, Stats.CompressedBytes);
+    
+    OnSaveCompleted.Broadcast(bSuccess);
+}
+
+void UCheckpointSubsystem::BeginApply(FCheckpointSnapshot&& Snapshot)
+{
+    PendingSnapshot = MoveTemp(Snapshot);
+    NextEnemyIndex = 0;
+    bApplying = true;
+    Stats.ApplyMs = 0.0f;
+    Stats.ApplyFrames = 0;
+    
+    // Every live enemy, entries left over after applying were not part of the checkpoint
+    PendingEnemies.Reset();
+    for (TActorIterator<ABaseEnemy> It(GetWorld()); It; ++It)
+    {
+        PendingEnemies.Add(It->GetEnemyId(), *It);
+    }
+}
+
+ABaseEnemy* UCheckpointSubsystem::RespawnEnemy(const FEnemyCheckpoint& Checkpoint)
+{
+    UClass* EnemyClass = FSoftClassPath(Checkpoint.EnemyClass).TryLoadClass<ABaseEnemy>();
+    if (!EnemyClass)
+    {
+        UE_LOG(LogRTP, Warning, TEXT("Checkpoint enemy class '%s' not found, enemy %s skipped"), *Checkpoint.EnemyClass, *Checkpoint.EnemyId.ToString());
+        return nullptr;
+    }
+    
+    // Deferred so the saved ID is in place before BeginPlay
+    const FTransform Transform(Checkpoint.Rotation, Checkpoint.Location);
+    ABaseEnemy* Enemy = GetWorld()->SpawnActorDeferred<ABaseEnemy>(EnemyClass, Transform, nullptr, nullptr,
+        ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+    if (Enemy)
+    {
+        Enemy->SetEnemyId(Checkpoint.EnemyId);
+        Enemy->FinishSpawning(Transform);
+    }
+    return Enemy;
+}
+
+bool UCheckpointSubsystem::ApplyNextBatch()
+{
+    SCOPE_CYCLE_COUNTER(STAT_CheckpointApply);
+    const double StartTime = FPlatformTime::Seconds();
+    
+    // The player goes first so the camera settles before enemies start reacting
+    if (Stats.ApplyFrames == 0 && PendingSnapshot.bHasPlayer)
+    {
+        if (APlayerCharacter* Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerPawn(GetWorld(), 0)))
+        {
+            Player->ReadCheckpoint(PendingSnapshot.Player);
+        }
+    }
+    
+    const int32 EndIndex = FMath::Min(NextEnemyIndex + FMath::Max(1, CVarCheckpointEnemiesPerFrame.GetValueOnGameThread()), PendingSnapshot.Enemies.Num());
+    for (; NextEnemyIndex < EndIndex; ++NextEnemyIndex)
+    {
+        const FEnemyCheckpoint& Checkpoint = PendingSnapshot.Enemies[NextEnemyIndex];
+        
+        TWeakObjectPtr<ABaseEnemy> FoundEnemy;
+        PendingEnemies.RemoveAndCopyValue(Checkpoint.EnemyId, FoundEnemy);
+        ABaseEnemy* Enemy = FoundEnemy.Get();
+        
+        // Killed or removed since the save while it was alive then, a corpse cannot be revived in place
+        if (ABaseEnemy::IsCheckpointAlive(Checkpoint) && (!Enemy || Enemy->IsDead()))
+        {
+            if (Enemy)
+            {
+                Enemy->Destroy();
+            }
+            Enemy = RespawnEnemy(Checkpoint);
+        }
+        
+        // An enemy saved dead whose body is gone has nothing left to restore
+        if (Enemy)
+        {
+            Enemy->ReadCheckpoint(Checkpoint);
+        }
+    }
+    
+    Stats.ApplyMs += static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+    Stats.ApplyFrames++;
+    
+    return NextEnemyIndex >= PendingSnapshot.Enemies.Num();
+}
+
+void UCheckpointSubsystem::FinishApply(bool bSuccess)
+{
+    // Enemies spawned after the checkpoint was taken
+    for (const TPair<FGuid, TWeakObjectPtr<ABaseEnemy>>& Pair : PendingEnemies)
+    {
+        if (ABaseEnemy* Enemy = Pair.Value.Get())
+        {
+            Enemy->Destroy();
+        }
+    }
+    
+    PendingEnemies.Reset();
+    PendingSnapshot = FCheckpointSnapshot();
+    bApplying = false;
+    
+    UE_LOG(LogRTP, Log, TEXT("Checkpoint loaded: read %.2f ms in the background, applied in %.3f ms over %d frames"),
+        Stats.ReadMs, Stats.ApplyMs, Stats.ApplyFrames);
+    
+    OnLoadCompleted.Broadcast(bSuccess);
+}
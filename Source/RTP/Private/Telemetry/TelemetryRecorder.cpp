@@ -0,0 +1,261 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Telemetry/TelemetryRecorder.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "RTP.h"
+
+static TAutoConsoleVariable<int32> CVarTelemetryFlushIntervalMs(
+    TEXT("rtp.Telemetry.FlushIntervalMs"),
+    50,
+    TEXT("How often the telemetry thread drains the per-thread rings to disk, in milliseconds."),
+    ECVF_Default);
+
+static FAutoConsoleCommand StartTelemetryCommand(
+    TEXT("rtp.Telemetry.Start"),
+    TEXT("Start recording gameplay telemetry. Usage: rtp.Telemetry.Start [FilePath]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+    {
+        FTelemetryRecorder::Get().StartSession(Args.Num() > 0 ? Args[0] : FString());
+    }));
+
+static FAutoConsoleCommand StopTelemetryCommand(
+    TEXT("rtp.Telemetry.Stop"),
+    TEXT("Flush and close the current telemetry recording."),
+    FConsoleCommandDelegate::CreateLambda([]()
+    {
+        FTelemetryRecorder::Get().StopSession();
+    }));
+
+std::atomic<bool> FTelemetryRecorder::bRecording{false};
+
+// Single-producer ring owned by one thread, drained by the flush thread
+struct FTelemetryRecorder::FThreadBuffer
+{
+    static constexpr uint32 Capacity = 4096;
+    static constexpr uint32 Mask = Capacity - 1;
+    static_assert(FMath::IsPowerOfTwo(Capacity), "Ring indices wrap with a mask");
+
+    FTelemetryEvent Events[Capacity];
+
+    // Written by the producer only
+    alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> Head{0};
+    std::atomic<uint64> Dropped{0};
+
+    // Set while the producer is between checking the session and publishing its record
+    std::atomic<bool> bWriting{false};
+
+    // Written by the flush thread only
+    alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> Tail{0};
+};
+
+FTelemetryRecorder& FTelemetryRecorder::Get()
+{
+    static FTelemetryRecorder Instance;
+    return Instance;
+}
+
+FTelemetryRecorder::~FTelemetryRecorder()
+{
+    // Sessions are closed on pre-exit, by now the engine is gone
+    check(!FlushThread);
+}
+
+FTelemetryRecorder::FThreadBuffer& FTelemetryRecorder::GetThreadBuffer()
+{
+    static thread_local FThreadBuffer* ThreadBuffer = nullptr;
+    if (!ThreadBuffer)
+    {
+        // Once per thread, buffers are kept until exit so the flush thread never sees a dangling one
+        FScopeLock Lock(&BuffersLock);
+        ThreadBuffer = Buffers.Add_GetRef(MakeUnique<FThreadBuffer>()).Get();
+    }
+    return *ThreadBuffer;
+}
+
+void FTelemetryRecorder::RecordEvent(ETelemetryEventType Type, uint32 SubjectId, const FVector& Location, uint32 Payload)
+{
+    FThreadBuffer& Buffer = GetThreadBuffer();
+
+    // Announce the write before confirming the session is still open, StopSession() waits it out before the last drain.
+    // Both sides use sequentially consistent accesses so neither can miss the other
+    Buffer.bWriting.store(true);
+    if (!bRecording.load())
+    {
+        Buffer.bWriting.store(false, std::memory_order_release);
+        return;
+    }
+
+    const uint32 Head = Buffer.Head.load(std::memory_order_relaxed);
+    if (Head - Buffer.Tail.load(std::memory_order_acquire) >= FThreadBuffer::Capacity)
+    {
+        Buffer.Dropped.store(Buffer.Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        Buffer.bWriting.store(false, std::memory_order_release);
+        return;
+    }
+
+    FTelemetryEvent& Event = Buffer.Events[Head & FThreadBuffer::Mask];
+    Event.Cycles = FPlatformTime::Cycles64();
+    Event.SubjectId = SubjectId;
+    Event.Type = Type;
+    Event.Reserved = 0;
+    Event.Location = FVector3f(Location);
+    Event.Payload = Payload;
+
+    // Publish the record to the flush thread
+    Buffer.Head.store(Head + 1, std::memory_order_release);
+    Buffer.bWriting.store(false, std::memory_order_release);
+}
+
+uint64 FTelemetryRecorder::GetNumDropped() const
+{
+    FScopeLock Lock(&BuffersLock);
+
+    uint64 Dropped = 0;
+    for (const TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+    {
+        Dropped += Buffer->Dropped.load(std::memory_order_relaxed);
+    }
+    return Dropped;
+}
+
+bool FTelemetryRecorder::StartSession(const FString& FilePath)
+{
+    check(IsInGameThread());
+
+    if (FlushThread)
+    {
+        UE_LOG(LogRTP, Warning, TEXT("Telemetry is already recording"));
+        return false;
+    }
+
+    const FString Path = FilePath.IsEmpty()
+        ? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Telemetry"), FDateTime::Now().ToString() + TEXT(".rtptel"))
+        : FilePath;
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+    FileHandle.Reset(PlatformFile.OpenWrite(*Path));
+    if (!FileHandle)
+    {
+        UE_LOG(LogRTP, Warning, TEXT("Could not open telemetry file %s"), *Path);
+        return false;
+    }
+
+    FTelemetryFileHeader Header;
+    Header.Magic = TelemetryFileMagic;
+    Header.Version = TelemetryFileVersion;
+    Header.StartCycles = FPlatformTime::Cycles64();
+    Header.SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+    Header.StartUtcTicks = FDateTime::UtcNow().GetTicks();
+    FileHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+
+    // Make sure an open session is flushed when the game shuts down
+    static bool bRegisteredExitHandler = false;
+    if (!bRegisteredExitHandler)
+    {
+        bRegisteredExitHandler = true;
+        FCoreDelegates::OnPreExit.AddLambda([]()
+        {
+            FTelemetryRecorder::Get().StopSession();
+        });
+    }
+
+    NumWritten.store(0, std::memory_order_relaxed);
+    bStopRequested.store(false);
+    FlushEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    FlushThread = FRunnableThread::Create(this, TEXT("RTPTelemetryFlush"), 0, TPri_BelowNormal);
+
+    bRecording.store(true);
+
+    UE_LOG(LogRTP, Log, TEXT("Telemetry recording to %s"), *Path);
+    return true;
+}
+
+void FTelemetryRecorder::StopSession()
+{
+    if (!FlushThread)
+    {
+        return;
+    }
+
+    bRecording.store(false);
+
+    // Calls Stop() and waits for Run() to return
+    FlushThread->Kill(true);
+    delete FlushThread;
+    FlushThread = nullptr;
+
+    FPlatformProcess::ReturnSynchEventToPool(FlushEvent);
+    FlushEvent = nullptr;
+
+    // Threads that saw the session still open finish their record, later ones see it closed and skip it
+    WaitForWriters();
+    Drain();
+    FileHandle.Reset();
+
+    UE_LOG(LogRTP, Log, TEXT("Telemetry stopped: %llu events written, %llu dropped"), GetNumRecorded(), GetNumDropped());
+}
+
+void FTelemetryRecorder::WaitForWriters() const
+{
+    FScopeLock Lock(&BuffersLock);
+
+    for (const TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+    {
+        // A record is a few stores, the wait is over within a few spins unless the writer was preempted
+        while (Buffer->bWriting.load())
+        {
+            FPlatformProcess::Yield();
+        }
+    }
+}
+
+uint32 FTelemetryRecorder::Run()
+{
+    while (!bStopRequested.load())
+    {
+        FlushEvent->Wait(FMath::Max(1, CVarTelemetryFlushIntervalMs.GetValueOnAnyThread()));
+        Drain();
+    }
+    return 0;
+}
+
+void FTelemetryRecorder::Stop()
+{
+    bStopRequested.store(true);
+    if (FlushEvent)
+    {
+        FlushEvent->Trigger();
+    }
+}
+
+void FTelemetryRecorder::Drain()
+{
+    FScopeLock Lock(&BuffersLock);
+
+    DrainScratch.Reset();
+    for (const TUniquePtr<FThreadBuffer>& Buffer : Buffers)
+    {
+        const uint32 Tail = Buffer->Tail.load(std::memory_order_relaxed);
+        const uint32 Head = Buffer->Head.load(std::memory_order_acquire);
+        for (uint32 Index = Tail; Index != Head; ++Index)
+        {
+            DrainScratch.Add(Buffer->Events[Index & FThreadBuffer::Mask]);
+        }
+
+        // Hand the slots back to the producer
+        Buffer->Tail.store(Head, std::memory_order_release);
+    }
+
+    if (DrainScratch.Num() > 0 && FileHandle)
+    {
+        FileHandle->Write(reinterpret_cast<const uint8*>(DrainScratch.GetData()), DrainScratch.Num() * sizeof(FTelemetryEvent));
+        NumWritten.fetch_add(DrainScratch.Num(), std::memory_order_relaxed);
+    }
+}
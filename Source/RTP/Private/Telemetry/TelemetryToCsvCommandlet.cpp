@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Telemetry/TelemetryToCsvCommandlet.h"
+#include "Telemetry/TelemetryRecorder.h"
+#include "Components/FlashlightComponent.h"
+#include "Enemies/BaseEnemy.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "RTP.h"
+
+namespace
+{
+    const TCHAR* GetEventTypeName(ETelemetryEventType Type)
+    {
+        switch (Type)
+        {
+            case ETelemetryEventType::EnemyStateChanged: return TEXT("EnemyStateChanged");
+            case ETelemetryEventType::PlayerSighted: return TEXT("PlayerSighted");
+            case ETelemetryEventType::EnemyAttack: return TEXT("EnemyAttack");
+            case ETelemetryEventType::EnemyStunned: return TEXT("EnemyStunned");
+            case ETelemetryEventType::EnemyDied: return TEXT("EnemyDied");
+            case ETelemetryEventType::FlashlightModeChanged: return TEXT("FlashlightModeChanged");
+            default: return TEXT("Unknown");
+        }
+    }
+    
+    // Human readable form of the event payload
+    FString DescribePayload(const FTelemetryEvent& Event)
+    {
+        switch (Event.Type)
+        {
+            case ETelemetryEventType::EnemyStateChanged:
+                return FString::Printf(TEXT("%s->%s"),
+                    *StaticEnum<EEnemyState>()->GetNameStringByValue(Event.Payload >> 8),
+                    *StaticEnum<EEnemyState>()->GetNameStringByValue(Event.Payload & 0xFF));
+            case ETelemetryEventType::EnemyStunned:
+                return FString::Printf(TEXT("%.3fs"), Event.Payload / 1000.0f);
+            case ETelemetryEventType::FlashlightModeChanged:
+                return StaticEnum<EFlashlightMode>()->GetNameStringByValue(Event.Payload);
+            default:
+                return FString();
+        }
+    }
+}
+
+UTelemetryToCsvCommandlet::UTelemetryToCsvCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UTelemetryToCsvCommandlet::Main(const FString& Params)
+{
+    FString InPath;
+    if (!FParse::Value(*Params, TEXT("In="), InPath))
+    {
+        UE_LOG(LogRTP, Error, TEXT("Usage: -run=TelemetryToCsv -In=<file.rtptel> [-Out=<file.csv>]"));
+        return 1;
+    }
+    
+    FString OutPath;
+    if (!FParse::Value(*Params, TEXT("Out="), OutPath))
+    {
+        OutPath = FPaths::ChangeExtension(InPath, TEXT("csv"));
+    }
+    
+    TArray<uint8> Data;
+    if (!FFileHelper::LoadFileToArray(Data, *InPath) || Data.Num() < static_cast<int32>(sizeof(FTelemetryFileHeader)))
+    {
+        UE_LOG(LogRTP, Error, TEXT("Could not read telemetry file %s"), *InPath);
+        return 1;
+    }
+    
+    FTelemetryFileHeader Header;
+    FMemory::Memcpy(&Header, Data.GetData(), sizeof(Header));
+    if (Header.Magic != TelemetryFileMagic || Header.Version != TelemetryFileVersion)
+    {
+        UE_LOG(LogRTP, Error, TEXT("%s is not a version %u telemetry file"), *InPath, TelemetryFileVersion);
+        return 1;
+    }
+    
+    // A recording cut short may end in a partial record, which is ignored
+    const int32 NumEvents = (Data.Num() - sizeof(FTelemetryFileHeader)) / sizeof(FTelemetryEvent);
+    TArray<FTelemetryEvent> Events;
+    Events.SetNumUninitialized(NumEvents);
+    FMemory::Memcpy(Events.GetData(), Data.GetData() + sizeof(FTelemetryFileHeader), NumEvents * sizeof(FTelemetryEvent));
+    
+    // Rings are drained one thread at a time, so records are only ordered per thread in the file
+    Events.StableSort([](const FTelemetryEvent& A, const FTelemetryEvent& B)
+    {
+        return A.Cycles < B.Cycles;
+    });
+    
+    FString Csv = TEXT("TimeSeconds,Event,SubjectId,X,Y,Z,Payload,Detail\n");
+    Csv.Reserve(NumEvents * 80);
+    
+    for (const FTelemetryEvent& Event : Events)
+    {
+        const double Time = static_cast<double>(static_cast<int64>(Event.Cycles - Header.StartCycles)) * Header.SecondsPerCycle;
+        Csv += FString::Printf(TEXT("%.6f,%s,%u,%.1f,%.1f,%.1f,%u,%s\n"),
+            Time, GetEventTypeName(Event.Type), Event.SubjectId,
+            Event.Location.X, Event.Location.Y, Event.Location.Z,
+            Event.Payload, *DescribePayload(Event));
+    }
+    
+    if (!FFileHelper::SaveStringToFile(Csv, *OutPath))
+    {
+        UE_LOG(LogRTP, Error, TEXT("Could not write %s"), *OutPath);
+        return 1;
+    }
+    
+    UE_LOG(LogRTP, Display, TEXT("Wrote %d telemetry events to %s"), NumEvents, *OutPath);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/EnemyUpdateSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/DefaultPawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEnemyParallelDecideTest, "RTP.AI.ParallelDecideMatchesSerial",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FEnemyParallelDecideTest::RunTest(const FString& Parameters)
+{
+    // A bare game world, the enemies only need the player pawn and the world subsystems
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+
+    const FURL URL;
+    World->SetGameMode(URL);
+    World->InitializeActorsForPlay(URL);
+    World->BeginPlay();
+
+    // The snapshot finds the player through the first player controller
+    APlayerController* PlayerController = World->SpawnActor<APlayerController>();
+    APawn* Player = World->SpawnActor<ADefaultPawn>(FVector::ZeroVector, FRotator::ZeroRotator);
+    PlayerController->Possess(Player);
+
+    // Enemies around the player in every state the decide phase handles, some in attack range, some out of it
+    constexpr int32 NumEnemies = 64;
+    const EEnemyState States[] = { EEnemyState::Idle, EEnemyState::Investigating, EEnemyState::Chasing, EEnemyState::Chasing, EEnemyState::Stunned };
+    FRandomStream Stream(27);
+    for (int32 Index = 0; Index < NumEnemies; ++Index)
+    {
+        const float Distance = Index % 3 == 0 ? 100.0f : Stream.FRandRange(300.0f, 3000.0f);
+        const FVector Location = FRotator(0.0f, 360.0f * Index / NumEnemies, 0.0f).Vector() * Distance;
+        ABaseEnemy* Enemy = World->SpawnActor<ABaseEnemy>(Location, FRotator::ZeroRotator);
+        if (!TestNotNull(TEXT("Spawned enemy"), Enemy))
+        {
+            break;
+        }
+
+        if (Index % 11 == 0)
+        {
+            Enemy->Die();
+        }
+        else
+        {
+            Enemy->SetEnemyState(States[Index % UE_ARRAY_COUNT(States)]);
+        }
+    }
+
+    const UEnemyUpdateSubsystem* UpdateSubsystem = World->GetSubsystem<UEnemyUpdateSubsystem>();
+    if (TestNotNull(TEXT("Enemy update subsystem"), UpdateSubsystem))
+    {
+        TestEqual(TEXT("Registered enemies"), UpdateSubsystem->GetNumRegisteredEnemies(), NumEnemies);
+        TestTrue(TEXT("Parallel decide results match the serial ones"), UpdateSubsystem->VerifyParallelDeterminism(8));
+    }
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+    return true;
+}
+
+#endif
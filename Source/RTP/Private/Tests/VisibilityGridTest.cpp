@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AI/VisibilityGridAsset.h"
+#include "AI/VisibilityGridSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    // Mark one voxel occupied, storing its brick on first use the way the bake does
+    void OccupyVoxel(UVisibilityGridAsset& Grid, const FIntVector& Voxel)
+    {
+        constexpr int32 Shift = UVisibilityGridAsset::BrickShift;
+        constexpr int32 Mask = UVisibilityGridAsset::BrickMask;
+        int32& BrickIndex = Grid.BrickTable[(Voxel.X >> Shift) + Grid.BrickCounts.X * ((Voxel.Y >> Shift) + Grid.BrickCounts.Y * (Voxel.Z >> Shift))];
+        if (BrickIndex == INDEX_NONE)
+        {
+            BrickIndex = Grid.BrickBits.Num() / UVisibilityGridAsset::WordsPerBrick;
+            Grid.BrickBits.AddZeroed(UVisibilityGridAsset::WordsPerBrick);
+        }
+
+        const uint32 Bit = (Voxel.X & Mask) | (Voxel.Y & Mask) << Shift | (Voxel.Z & Mask) << (2 * Shift);
+        Grid.BrickBits[BrickIndex * UVisibilityGridAsset::WordsPerBrick + (Bit >> 6)] |= uint64(1) << (Bit & 63);
+    }
+
+    FVector VoxelCenter(const UVisibilityGridAsset& Grid, int32 X, int32 Y, int32 Z)
+    {
+        return Grid.Origin + (FVector(X, Y, Z) + 0.5) * Grid.VoxelSize;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVisibilityGridEndpointTest, "RTP.AI.VisibilityGridBlocksAtEndpoints",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FVisibilityGridEndpointTest::RunTest(const FString& Parameters)
+{
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+
+    UVisibilityGridSubsystem* Subsystem = World->GetSubsystem<UVisibilityGridSubsystem>();
+    if (TestNotNull(TEXT("Visibility grid subsystem"), Subsystem))
+    {
+        // A row of four bricks along X, sight runs from voxel 2 to voxel 29 on the row's center line
+        UVisibilityGridAsset* Grid = NewObject<UVisibilityGridAsset>();
+        Grid->BrickCounts = FIntVector(4, 1, 1);
+        Grid->Dimensions = Grid->BrickCounts * UVisibilityGridAsset::BrickSize;
+        Grid->BrickTable.Init(INDEX_NONE, Grid->BrickCounts.X * Grid->BrickCounts.Y * Grid->BrickCounts.Z);
+        Subsystem->SetGrid(Grid);
+
+        const FVector Eye = VoxelCenter(*Grid, 2, 4, 4) + FVector(10.0f, 0.0f, 0.0f);
+        const FVector Target = VoxelCenter(*Grid, 29, 4, 4) - FVector(10.0f, 0.0f, 0.0f);
+        TestTrue(TEXT("Clear without occluders"), Subsystem->IsSegmentClear(Eye, Target));
+
+        // Walls just behind the eye and just in front of the target, sharing their voxels
+        const int32 WallVoxels[] = { 2, 29, 15 };
+        const TCHAR* WallNames[] = { TEXT("Wall in the eye's voxel blocks"), TEXT("Wall in the target's voxel blocks"), TEXT("Wall between the voxels blocks") };
+        for (int32 Index = 0; Index < UE_ARRAY_COUNT(WallVoxels); ++Index)
+        {
+            Grid->BrickTable.Init(INDEX_NONE, Grid->BrickTable.Num());
+            Grid->BrickBits.Reset();
+            OccupyVoxel(*Grid, FIntVector(WallVoxels[Index], 4, 4));
+            TestFalse(WallNames[Index], Subsystem->IsSegmentClear(Eye, Target));
+            TestFalse(FString(WallNames[Index]) + TEXT(" in reverse"), Subsystem->IsSegmentClear(Target, Eye));
+        }
+
+        // A batch that does not fill the last group of lanes, only the segments ending in the wall's voxel are blocked
+        Grid->BrickTable.Init(INDEX_NONE, Grid->BrickTable.Num());
+        Grid->BrickBits.Reset();
+        OccupyVoxel(*Grid, FIntVector(20, 4, 4));
+
+        TArray<FVector> Starts;
+        TArray<FVector> Ends;
+        for (int32 EndVoxel = 16; EndVoxel < 23; ++EndVoxel)
+        {
+            Starts.Add(Eye);
+            Ends.Add(VoxelCenter(*Grid, EndVoxel, 4, 4));
+        }
+        TArray<bool> Clear;
+        Clear.SetNumUninitialized(Starts.Num());
+        Subsystem->TestSegments(Starts, Ends, Clear);
+        for (int32 Index = 0; Index < Starts.Num(); ++Index)
+        {
+            TestEqual(FString::Printf(TEXT("Segment ending in voxel %d"), 16 + Index), Clear[Index], 16 + Index < 20);
+        }
+    }
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+    return true;
+}
+
+#endif
@@ -2,11 +2,43 @@
 
 
 #include "Widgets/FlashlightWidget.h"
+#include "Widgets/PlayerHUDViewModel.h"
 #include "Components/ProgressBar.h"
 #include "Components/TextBlock.h"
 
 void UFlashlightWidget::UpdateBatteryPercentage(float BatteryPercent)
 {
+    HandleBatteryChanged(UPlayerHUDViewModel::QuantizePercent(BatteryPercent));
+}
+
+void UFlashlightWidget::UpdateFlashlightMode(EFlashlightMode CurrentMode)
+{
+    HandleFlashlightModeChanged(CurrentMode);
+}
+
+void UFlashlightWidget::SetViewModel(UPlayerHUDViewModel* InViewModel)
+{
+    if (ViewModel)
+    {
+        ViewModel->OnBatteryChanged.RemoveDynamic(this, &UFlashlightWidget::HandleBatteryChanged);
+        ViewModel->OnFlashlightModeChanged.RemoveDynamic(this, &UFlashlightWidget::HandleFlashlightModeChanged);
+    }
+    
+    ViewModel = InViewModel;
+    
+    if (ViewModel)
+    {
+        ViewModel->OnBatteryChanged.AddDynamic(this, &UFlashlightWidget::HandleBatteryChanged);
+        ViewModel->OnFlashlightModeChanged.AddDynamic(this, &UFlashlightWidget::HandleFlashlightModeChanged);
+        HandleBatteryChanged(ViewModel->GetBatteryPercent());
+        HandleFlashlightModeChanged(ViewModel->GetFlashlightMode());
+    }
+}
+
+void UFlashlightWidget::HandleBatteryChanged(int32 Percent)
+{
+    const float BatteryPercent = Percent / 100.0f;
+    
     // Update battery progress bar
     if (BatteryProgressBar)
     {
@@ -32,43 +64,17 @@ void UFlashlightWidget::UpdateBatteryPercentage(float BatteryPercent)
         BatteryProgressBar->SetFillColorAndOpacity(BarColor);
     }
     
-    // Update battery text
+    // Update battery text from the pre-built table
     if (BatteryText)
     {
-        FText BatteryTextValue = FText::FromString(FString::Printf(TEXT("Battery: %.0f%%"), BatteryPercent * 100));
-        BatteryText->SetText(BatteryTextValue);
+        BatteryText->SetText(UPlayerHUDViewModel::GetBatteryText(Percent));
     }
 }
 
-void UFlashlightWidget::UpdateFlashlightMode(EFlashlightMode CurrentMode)
+void UFlashlightWidget::HandleFlashlightModeChanged(EFlashlightMode NewMode)
 {
     if (FlashlightModeText)
     {
-        FString ModeText;
-        switch (CurrentMode)
-        {
-            case EFlashlightMode::Off:
-                ModeText = "OFF";
-                break;
-            case EFlashlightMode::Low:
-                ModeText = "LOW";
-                break;
-            case EFlashlightMode::Medium:
-                ModeText = "MED";
-                break;
-            case EFlashlightMode::High:
-                ModeText = "HIGH";
-                break;
-            case EFlashlightMode::Strobe:
-                ModeText = "STROBE";
-                break;
-            default:
-                ModeText = "UNK";
-                break;
-        }
-        
-        FText ModeTextValue = FText::FromString(FString::Printf(TEXT("Mode: %s"), *ModeText));
-        FlashlightModeText->SetText(ModeTextValue);
+        FlashlightModeText->SetText(UPlayerHUDViewModel::GetFlashlightModeText(NewMode));
     }
 }
-
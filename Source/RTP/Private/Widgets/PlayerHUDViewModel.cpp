@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Widgets/PlayerHUDViewModel.h"
+
+namespace
+{
+    // Build "<Label>: 0%" .. "<Label>: 100%" once so the HUD never formats text at runtime
+    TArray<FText> BuildPercentTexts(const TCHAR* Label)
+    {
+        TArray<FText> Texts;
+        Texts.Reserve(101);
+        for (int32 Percent = 0; Percent <= 100; ++Percent)
+        {
+            Texts.Add(FText::FromString(FString::Printf(TEXT("%s: %d%%"), Label, Percent)));
+        }
+        return Texts;
+    }
+}
+
+void UPlayerHUDViewModel::SetStaminaFraction(float Fraction)
+{
+    const int32 NewPercent = QuantizePercent(Fraction);
+    if (NewPercent != StaminaPercent)
+    {
+        StaminaPercent = NewPercent;
+        OnStaminaChanged.Broadcast(StaminaPercent);
+    }
+}
+
+void UPlayerHUDViewModel::SetBatteryFraction(float Fraction)
+{
+    const int32 NewPercent = QuantizePercent(Fraction);
+    if (NewPercent != BatteryPercent)
+    {
+        BatteryPercent = NewPercent;
+        OnBatteryChanged.Broadcast(BatteryPercent);
+    }
+}
+
+void UPlayerHUDViewModel::SetFlashlightMode(EFlashlightMode NewMode)
+{
+    if (NewMode != FlashlightMode)
+    {
+        FlashlightMode = NewMode;
+        OnFlashlightModeChanged.Broadcast(FlashlightMode);
+    }
+}
+
+const FText& UPlayerHUDViewModel::GetStaminaText(int32 Percent)
+{
+    static const TArray<FText> StaminaTexts = BuildPercentTexts(TEXT("Stamina"));
+    return StaminaTexts[FMath::Clamp(Percent, 0, 100)];
+}
+
+const FText& UPlayerHUDViewModel::GetBatteryText(int32 Percent)
+{
+    static const TArray<FText> BatteryTexts = BuildPercentTexts(TEXT("Battery"));
+    return BatteryTexts[FMath::Clamp(Percent, 0, 100)];
+}
+
+const FText& UPlayerHUDViewModel::GetFlashlightModeText(EFlashlightMode Mode)
+{
+    static const FText ModeTexts[] =
+    {
+        FText::FromString(TEXT("Mode: OFF")),
+        FText::FromString(TEXT("Mode: LOW")),
+        FText::FromString(TEXT("Mode: MED")),
+        FText::FromString(TEXT("Mode: HIGH")),
+        FText::FromString(TEXT("Mode: STROBE")),
+        FText::FromString(TEXT("Mode: UNK"))
+    };
+
+    const int32 UnknownIndex = UE_ARRAY_COUNT(ModeTexts) - 1;
+    return ModeTexts[FMath::Min(static_cast<int32>(Mode), UnknownIndex)];
+}
+
+int32 UPlayerHUDViewModel::QuantizePercent(float Fraction)
+{
+    return FMath::Clamp(FMath::RoundToInt32(Fraction * 100.0f), 0, 100);
+}
@@ -2,20 +2,41 @@
 
 
 #include "Widgets/StaminaWidget.h"
+#include "Widgets/PlayerHUDViewModel.h"
 #include "Components/ProgressBar.h"
 #include "Components/TextBlock.h"
 
 void UStaminaWidget::UpdateStaminaBar(float StaminaPercent)
+{
+	HandleStaminaChanged(UPlayerHUDViewModel::QuantizePercent(StaminaPercent));
+}
+
+void UStaminaWidget::SetViewModel(UPlayerHUDViewModel* InViewModel)
+{
+	if (ViewModel)
+	{
+		ViewModel->OnStaminaChanged.RemoveDynamic(this, &UStaminaWidget::HandleStaminaChanged);
+	}
+
+	ViewModel = InViewModel;
+
+	if (ViewModel)
+	{
+		ViewModel->OnStaminaChanged.AddDynamic(this, &UStaminaWidget::HandleStaminaChanged);
+		HandleStaminaChanged(ViewModel->GetStaminaPercent());
+	}
+}
+
+void UStaminaWidget::HandleStaminaChanged(int32 Percent)
 {
 	if (StaminaProgressBar)
 	{
-		StaminaProgressBar->SetPercent(StaminaPercent);
+		StaminaProgressBar->SetPercent(Percent / 100.0f);
 	}
 
 	if (StaminaText)
 	{
-		FText StaminaTextValue = FText::FromString(FString::Printf(TEXT("Stamina: %.0f%%"), StaminaPercent * 100));
-
-		StaminaText->SetText(StaminaTextValue);
+		// Pre-built text, so Slate only invalidates when the displayed percent actually changes
+		StaminaText->SetText(UPlayerHUDViewModel::GetStaminaText(Percent));
 	}
 }
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AISightSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+
+// How a mesh takes part in AI sight traces
+UENUM(BlueprintType)
+enum class EAISightOcclusion : uint8
+{
+    // Trunks, rocks and architecture, blocks with its simple collision
+    Blocker,
+    // Small vegetation, adds concealment when enabled, otherwise ignored by sight traces
+    Foliage
+};
+
+// Result of a single AI sight query
+struct FAISightResult
+{
+    bool bBlocked = false;
+    // Summed density of the foliage the ray passed through, 0 when concealment is disabled
+    float Concealment = 0.0f;
+};
+
+// What the baked visibility grid said about a sight segment, tested ahead of the trace in a batch
+enum class EAISightGridResult : uint8
+{
+    // Not tested yet, the trace asks the grid itself
+    Untested,
+    // No static occluder, only dynamic ones are traced
+    Clear,
+    // A voxel on the way is occupied, which only means a static occluder may be there
+    Blocked
+};
+
+/**
+ * Sets up AI sight collision for instanced meshes (PCG output and foliage) and answers sight queries.
+ * Only large meshes block ECC_AISight, through their simple collision. Small vegetation ignores the
+ * channel, or overlaps it when concealment is enabled, and keeps its collision on every other channel.
+ */
+UCLASS()
+class RTP_API UAISightSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// Classify the foliage and PCG instanced meshes in the world, call again after generating PCG content at runtime
+	UFUNCTION(BlueprintCallable, Category = "AI")
+	void ClassifyWorld();
+
+	// Whether an instanced mesh is painted foliage, PCG output or tagged for AI sight, the only ones classified
+	static bool IsScatteredComponent(const UInstancedStaticMeshComponent* Component);
+
+	// Classify one instanced mesh by its tags or bounds and set its sight collision accordingly
+	void ClassifyComponent(UInstancedStaticMeshComponent* Component);
+
+	// Whether an instanced mesh blocks sight or counts as foliage, shared with the visibility grid bake
+	static EAISightOcclusion Classify(const UInstancedStaticMeshComponent* Component);
+
+	// Trace from Start to the target, safe to call from worker threads. GridResult is the segment's result
+	// from TestGrid when it was tested in a batch beforehand
+	FAISightResult TraceSight(const FVector& Start, const AActor* Target, const AActor* IgnoredActor,
+		EAISightGridResult GridResult = EAISightGridResult::Untested) const;
+
+	// Test sight segments against the visibility grid in one batch, false and untouched results when the grid is not in use
+	bool TestGrid(TConstArrayView<FVector> Starts, TConstArrayView<FVector> Ends, TArrayView<EAISightGridResult> OutResults) const;
+
+	static bool IsConcealmentEnabled();
+
+	// Component tags that override the size-based classification
+	static const FName BlockerTag;
+	static const FName FoliageTag;
+	static const FName PCGGeneratedTag;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	int32 NumBlockers = 0;
+	int32 NumFoliage = 0;
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CrowdAvoidance.h"
+#include "CrowdAvoidanceSubsystem.generated.h"
+
+class UEnemyMovementComponent;
+
+/**
+ * Local avoidance for enemy crowds.
+ * Once per frame every registered enemy on the ground goes into one batched FCrowdAvoidance pass, and the
+ * resulting velocities steer the enemies' movement next frame. While enabled, enemy capsules ignore each
+ * other on ECC_Enemy, so converging enemies no longer shove one another through collision.
+ */
+UCLASS()
+class RTP_API UCrowdAvoidanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	void RegisterAgent(UEnemyMovementComponent* Movement);
+
+	void UnregisterAgent(UEnemyMovementComponent* Movement);
+
+	static bool IsEnabled();
+
+	static FCrowdAvoidanceSettings GetSettings();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Block or ignore other enemies' capsules
+	static void SetEnemyCollisionRelaxed(UEnemyMovementComponent* Movement, bool bRelaxed);
+
+	TArray<TWeakObjectPtr<UEnemyMovementComponent>> Members;
+
+	// Whether avoidance was enabled when the members' collision was last set up
+	bool bAppliedEnabled = false;
+
+	FCrowdAvoidance Solver;
+
+	// Scratch buffers reused across frames, parallel to each other
+	TArray<FCrowdAgent> Agents;
+	TArray<UEnemyMovementComponent*> AgentMovements;
+	TArray<FVector2f> Velocities;
+};
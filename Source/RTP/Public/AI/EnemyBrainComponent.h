@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "NativeGameplayTags.h"
+#include "StateTreeExecutionTypes.h"
+#include "StateTreeInstanceData.h"
+#include "EnemyBrainComponent.generated.h"
+
+class UStateTree;
+struct FStateTreeExecutionContext;
+
+// Sent to a brain whenever its enemy's EEnemyState changes, the tree re-selects its state from it
+RTP_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_AI_Enemy_StateChanged);
+
+/**
+ * Runs a shared enemy StateTree (see UEnemyStateTreeSchema) in place of the hand-written decision rules.
+ * The tree is not ticked by the component: the enemy's decision update, driven by UEnemyUpdateSubsystem,
+ * advances it, and only when a state change event is waiting or an active task needs to tick.
+ */
+UCLASS(ClassGroup = (AI), meta = (BlueprintSpawnableComponent))
+class RTP_API UEnemyBrainComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UEnemyBrainComponent();
+
+	// Whether brains drive their enemies, rtp.AI.StateTreeBrain
+	static bool IsEnabled();
+
+	// Switch rtp.AI.StateTreeBrain, keeping whatever priority it was last set with
+	static void SetEnabled(bool bEnabled);
+
+	bool IsRunning() const { return bRunning; }
+
+	// Advance the tree if there is anything for it to do, called from the enemy's decision update
+	void UpdateBrain(float DeltaTime);
+
+	// Queue a state change event, any number of changes before the next update collapse into one
+	void NotifyStateChanged();
+
+	// Set by the active tasks that need to run on every update
+	void SetNeedsTick(bool bInNeedsTick) { bNeedsTick = bInNeedsTick; }
+
+	// Shared tree asset, e.g. the one built by -run=BuildEnemyStateTree. None keeps the enemy on its hand-written rules
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	UStateTree* StateTree;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	bool SetContextRequirements(FStateTreeExecutionContext& Context);
+
+	bool CollectExternalData(const FStateTreeExecutionContext& Context, const UStateTree* Tree,
+		TArrayView<const FStateTreeExternalDataDesc> ExternalDataDescs, TArrayView<FStateTreeDataView> OutDataViews) const;
+
+	UPROPERTY(Transient)
+	FStateTreeInstanceData InstanceData;
+
+	bool bRunning = false;
+	bool bNeedsTick = false;
+	bool bStateChangePending = false;
+};
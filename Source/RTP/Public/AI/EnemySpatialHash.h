@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ABaseEnemy;
+
+/**
+ * Uniform 2D grid of enemy positions for radius queries.
+ * Rebuilt from scratch whenever positions are needed; cell arrays keep their memory between rebuilds.
+ */
+class RTP_API FEnemySpatialHash
+{
+public:
+    explicit FEnemySpatialHash(float InCellSize = 1000.0f);
+
+    // Change the cell size, dropping all cells
+    void SetCellSize(float InCellSize);
+
+    float GetCellSize() const { return CellSize; }
+
+    // Empty every cell, keeping allocations
+    void Reset();
+
+    void Add(ABaseEnemy* Enemy, const FVector& Location);
+
+    // Append every enemy within Radius of Location
+    void Gather(const FVector& Location, float Radius, TArray<ABaseEnemy*>& OutEnemies) const;
+
+    int32 Num() const { return NumEntries; }
+
+private:
+    struct FEntry
+    {
+        ABaseEnemy* Enemy;
+        FVector Location;
+    };
+
+    FIntPoint GetCell(const FVector& Location) const;
+
+    float CellSize;
+    float InvCellSize;
+    int32 NumEntries = 0;
+    TMap<FIntPoint, TArray<FEntry>> Cells;
+};
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemySquadSubsystem.generated.h"
+
+class ABaseEnemy;
+
+/**
+ * Shared perception memory for groups of enemies. Enemies with the same SquadName form a squad, the
+ * others are grouped by the region they spawned in. A member that sees or hears the player writes the
+ * sighting once and alerts the squad mates within rtp.AI.SquadAlertRadius. While a sighting is fresh,
+ * chasing members move on the shared knowledge instead of running sight traces of their own.
+ */
+UCLASS()
+class RTP_API UEnemySquadSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Squad an enemy belongs to, from its SquadName or its current region
+	int32 JoinSquad(const ABaseEnemy* Enemy);
+
+	// Record that Observer saw or heard the player at Location and alert nearby squad mates, game thread only
+	void ReportPlayer(ABaseEnemy* Observer, APawn* Player, const FVector& Location, bool bSeen);
+
+	// Whether a squad member saw the player recently enough for the others to skip their own trace, safe from worker threads
+	bool HasFreshSighting(int32 SquadIndex, double WorldTime) const;
+
+	// Write every squad and its shared memory to the log
+	void LogSquads() const;
+
+	static bool IsEnabled();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FSquadMemory
+	{
+		FName Name;
+		FVector LastKnownPlayerLocation = FVector::ZeroVector;
+
+		// World time the shared sighting stops standing in for the members' own traces
+		double SightingFreshUntil = -1.0;
+
+		// Alerts are throttled, perception keeps reporting a player that stays in view
+		double NextAlertTime = -1.0;
+	};
+
+	TArray<FSquadMemory> Squads;
+	TMap<FName, int32> SquadIndices;
+
+	// Scratch buffer reused across alerts
+	TArray<ABaseEnemy*> NearbyEnemies;
+};
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateTreeConditionBase.h"
+#include "StateTreeTaskBase.h"
+#include "Enemies/BaseEnemy.h"
+#include "EnemyStateTreeNodes.generated.h"
+
+class UEnemyBrainComponent;
+
+// Passes while the enemy is in the given EEnemyState
+USTRUCT(meta = (DisplayName = "Enemy State Is", Category = "Enemy"))
+struct RTP_API FEnemyStateCondition : public FStateTreeConditionCommonBase
+{
+	GENERATED_BODY()
+
+	virtual bool Link(FStateTreeLinker& Linker) override;
+
+	virtual bool TestCondition(FStateTreeExecutionContext& Context) const override;
+
+	UPROPERTY(EditAnywhere, Category = "Condition")
+	EEnemyState State = EEnemyState::Idle;
+
+	UPROPERTY(EditAnywhere, Category = "Condition")
+	bool bInvert = false;
+
+	TStateTreeExternalDataHandle<ABaseEnemy> EnemyHandle;
+};
+
+// Passes while the enemy has an unblocked line of sight to the player
+USTRUCT(meta = (DisplayName = "Enemy Sees Player", Category = "Enemy"))
+struct RTP_API FEnemySeesPlayerCondition : public FStateTreeConditionCommonBase
+{
+	GENERATED_BODY()
+
+	virtual bool Link(FStateTreeLinker& Linker) override;
+
+	virtual bool TestCondition(FStateTreeExecutionContext& Context) const override;
+
+	TStateTreeExternalDataHandle<ABaseEnemy> EnemyHandle;
+};
+
+// Passes while the player is in attack range and the enemy's attack is off cooldown
+USTRUCT(meta = (DisplayName = "Enemy Can Attack", Category = "Enemy"))
+struct RTP_API FEnemyCanAttackCondition : public FStateTreeConditionCommonBase
+{
+	GENERATED_BODY()
+
+	virtual bool Link(FStateTreeLinker& Linker) override;
+
+	virtual bool TestCondition(FStateTreeExecutionContext& Context) const override;
+
+	TStateTreeExternalDataHandle<ABaseEnemy> EnemyHandle;
+};
+
+/**
+ * Chases the player on every brain update: straight at them while they are in sight of the enemy or its squad,
+ * otherwise to where they were last seen. Entered from Investigating by the tree, it resumes the chase.
+ * Attacking is left to the state's transition.
+ */
+USTRUCT(meta = (DisplayName = "Enemy Chase", Category = "Enemy"))
+struct RTP_API FEnemyChaseTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	FEnemyChaseTask();
+
+	virtual bool Link(FStateTreeLinker& Linker) override;
+
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	virtual EStateTreeRunStatus Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const override;
+
+	TStateTreeExternalDataHandle<ABaseEnemy> EnemyHandle;
+	TStateTreeExternalDataHandle<UEnemyBrainComponent> BrainHandle;
+};
+
+// Performs the attack on entering the state. The enemy's attack recovery returns it to chasing; fails if the attack was refused
+USTRUCT(meta = (DisplayName = "Enemy Attack", Category = "Enemy"))
+struct RTP_API FEnemyAttackTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	FEnemyAttackTask();
+
+	virtual bool Link(FStateTreeLinker& Linker) override;
+
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	TStateTreeExternalDataHandle<ABaseEnemy> EnemyHandle;
+	TStateTreeExternalDataHandle<UEnemyBrainComponent> BrainHandle;
+};
+
+// Keeps the brain updating while the state's tick transitions look for the player, does no work itself
+USTRUCT(meta = (DisplayName = "Enemy Watch", Category = "Enemy"))
+struct RTP_API FEnemyWatchTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	FEnemyWatchTask();
+
+	virtual bool Link(FStateTreeLinker& Linker) override;
+
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	virtual void ExitState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+
+	TStateTreeExternalDataHandle<UEnemyBrainComponent> BrainHandle;
+};
+
+/**
+ * Holds a state that is advanced from outside the tree: perception, noise, damage and the enemy's
+ * latent behaviours change EEnemyState, and the resulting event re-selects the tree's state. Never ticks.
+ */
+USTRUCT(meta = (DisplayName = "Enemy Hold State", Category = "Enemy"))
+struct RTP_API FEnemyHoldStateTask : public FStateTreeTaskCommonBase
+{
+	GENERATED_BODY()
+
+	FEnemyHoldStateTask();
+
+	virtual EStateTreeRunStatus EnterState(FStateTreeExecutionContext& Context, const FStateTreeTransitionResult& Transition) const override;
+};
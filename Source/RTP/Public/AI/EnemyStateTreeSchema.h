@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateTreeSchema.h"
+#include "EnemyStateTreeSchema.generated.h"
+
+/**
+ * Schema for enemy brain StateTrees run by UEnemyBrainComponent.
+ * Nodes reach the enemy and its brain as external data, so they need no per-instance memory for them.
+ */
+UCLASS(BlueprintType, EditInlineNew, CollapseCategories, meta = (DisplayName = "Enemy Brain"))
+class RTP_API UEnemyStateTreeSchema : public UStateTreeSchema
+{
+	GENERATED_BODY()
+
+public:
+	UEnemyStateTreeSchema();
+
+	// Name of the ABaseEnemy context data
+	static const FName EnemyContextName;
+
+protected:
+	virtual bool IsStructAllowed(const UScriptStruct* InScriptStruct) const override;
+
+	virtual bool IsClassAllowed(const UClass* InClass) const override;
+
+	virtual bool IsExternalItemAllowed(const UStruct& InStruct) const override;
+
+	virtual TConstArrayView<FStateTreeExternalDataDesc> GetContextDataDescs() const override { return ContextDataDescs; }
+
+	UPROPERTY()
+	TArray<FStateTreeExternalDataDesc> ContextDataDescs;
+};
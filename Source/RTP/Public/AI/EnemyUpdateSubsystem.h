@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Enemies/BaseEnemy.h"
+#include "FixedStepClock.h"
+#include "EnemyUpdateSubsystem.generated.h"
+
+class UMovementLODSubsystem;
+
+DECLARE_STATS_GROUP(TEXT("RTP AI"), STATGROUP_RTPAI, STATCAT_Advanced);
+
+// Aggregate scheduler statistics, reset with ResetStats()
+USTRUCT(BlueprintType)
+struct RTP_API FEnemyUpdateStats
+{
+	GENERATED_BODY()
+
+	// Frames where the decision pass ran past its budget
+	UPROPERTY(BlueprintReadOnly, Category = "AI")
+	int32 BudgetOverruns = 0;
+
+	// Frames the scheduler has run
+	UPROPERTY(BlueprintReadOnly, Category = "AI")
+	int32 FramesScheduled = 0;
+
+	// Enemy decision steps run during the last frame
+	UPROPERTY(BlueprintReadOnly, Category = "AI")
+	int32 UpdatesLastFrame = 0;
+
+	// Time spent in the decision pass during the last frame
+	UPROPERTY(BlueprintReadOnly, Category = "AI")
+	float LastFrameMs = 0.0f;
+
+	// Longest decision pass seen so far
+	UPROPERTY(BlueprintReadOnly, Category = "AI")
+	float WorstFrameMs = 0.0f;
+
+	// Longest gap between two updates of the same enemy, in seconds
+	UPROPERTY(BlueprintReadOnly, Category = "AI")
+	float MaxUpdateLatency = 0.0f;
+};
+
+/**
+ * Runs ABaseEnemy decision updates in round-robin slices under a per-frame time budget.
+ * Enemies in combat (Chasing/Attacking) are served before everyone else. With rtp.AI.FixedStep each
+ * enemy steps on its own fixed-rate clock, faster in combat and slower in the distant movement LOD
+ * tiers, so AI cost and behaviour do not depend on the frame rate. Otherwise each enemy receives
+ * the real time elapsed since its own previous update.
+ */
+UCLASS()
+class RTP_API UEnemyUpdateSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	// Add an enemy to the update rotation
+	void RegisterEnemy(ABaseEnemy* Enemy);
+
+	// Remove an enemy from the update rotation
+	void UnregisterEnemy(ABaseEnemy* Enemy);
+
+	UFUNCTION(BlueprintPure, Category = "AI")
+	const FEnemyUpdateStats& GetStats() const { return Stats; }
+
+	UFUNCTION(BlueprintCallable, Category = "AI")
+	void ResetStats();
+
+	// Longest gap between two updates of the given enemy, in seconds
+	UFUNCTION(BlueprintPure, Category = "AI")
+	float GetMaxUpdateLatency(const ABaseEnemy* Enemy) const;
+
+	int32 GetNumRegisteredEnemies() const { return Entries.Num(); }
+
+	// Write the current stats and the worst per-enemy latencies to the log
+	void DumpStats() const;
+
+	// Run the decide phase for every registered enemy both in parallel and serially and compare the results
+	bool VerifyParallelDeterminism(int32 NumParallelRuns = 4) const;
+
+	// Average the decision pass over FramesPerPhase frames on the hand-written rules, then as many on the StateTree brains
+	void StartBrainMeasurement(int32 FramesPerPhase);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FScheduledEnemy
+	{
+		TWeakObjectPtr<ABaseEnemy> Enemy;
+		double LastUpdateTime = 0.0;
+		float MaxLatency = 0.0f;
+
+		// Fixed-rate decision clock and the interval of the enemy's current tier
+		FFixedStepClock Clock;
+		float StepInterval = 0.1f;
+	};
+
+	struct FBrainMeasurement
+	{
+		// Frames left in the current phase, the hand-written rules run first
+		int32 FramesRemaining = 0;
+		int32 FramesPerPhase = 0;
+		bool bBrainPhase = false;
+		bool bWasEnabled = true;
+		double Seconds[2] = { 0.0, 0.0 };
+		int32 Updates[2] = { 0, 0 };
+	};
+
+	struct FUpdateSlot
+	{
+		int32 EntryIndex;
+		bool bCombat;
+
+		// Decision steps to run this frame, more than one when catching up
+		int32 Steps;
+	};
+
+	// Fixed step interval for an enemy's combat state and movement LOD tier
+	static float GetStepInterval(const ABaseEnemy* Enemy, bool bCombat, const UMovementLODSubsystem* MovementLOD);
+
+	// Fill UpdateOrder with up to MaxUpdates due steps, combat enemies first, each group in round-robin order
+	void BuildUpdateOrder(double WorldTime, int32 MaxUpdates);
+
+	// Move the round-robin cursors past the first NumProcessed slots of UpdateOrder
+	void AdvanceCursors(int32 NumProcessed);
+
+	// Serial path: decide and apply one enemy at a time until the budget runs out
+	int32 RunSerialUpdates(double WorldTime, double StartTime, double BudgetSeconds, int32 MinUpdates);
+
+	// Parallel path: decide every selected enemy across worker threads, then apply on the game thread
+	int32 RunParallelUpdates(double WorldTime, double StartTime, double BudgetSeconds, int32 MinUpdates);
+
+	// Test the sight segments of the enemies about to decide against the visibility grid in one batch,
+	// brain-driven enemies and enemies that will not look for the player stay untested
+	void TestGridSight(const FEnemyWorldSnapshot& Snapshot, TConstArrayView<ABaseEnemy*> Enemies, TArray<EAISightGridResult>& OutGridSight) const;
+
+	// Bookkeeping for an entry about to take a step, returns the enemy's delta time
+	float BeginEntryUpdate(FScheduledEnemy& Entry, double WorldTime);
+
+	// Drop entries whose enemy has been destroyed
+	void CompactEntries();
+
+	void UpdateBrainMeasurement(double ElapsedSeconds, int32 NumUpdated);
+
+	TArray<FScheduledEnemy> Entries;
+
+	// Round-robin cursors for the combat and non-combat passes
+	int32 CombatCursor = 0;
+	int32 DefaultCursor = 0;
+
+	bool bHasStaleEntries = false;
+
+	// Whether this frame's steps run on the fixed-rate clocks
+	bool bFixedStep = false;
+
+	// Scratch buffers reused across frames
+	TArray<FUpdateSlot> UpdateOrder;
+	TArray<FEnemyDecision> Decisions;
+	TArray<float> DeltaTimes;
+	TArray<bool> BrainDriven;
+	TArray<EAISightGridResult> GridSight;
+
+	// Moving average of the cost of one enemy update in the parallel path, used to size each frame's batch
+	double AverageParallelUpdateSeconds = 0.00002;
+
+	FEnemyUpdateStats Stats;
+
+	FBrainMeasurement BrainMeasurement;
+};
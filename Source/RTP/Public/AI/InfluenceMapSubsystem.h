@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InfluenceMap.h"
+#include "FixedStepClock.h"
+#include "InfluenceMapSubsystem.generated.h"
+
+class ABaseEnemy;
+
+/**
+ * Coarse 2D influence map over the navigable area of the level.
+ * Player heat is deposited where enemies see or hear the player or get lit by the flashlight, enemy coverage
+ * where registered enemies stand. Both decay and spread on a fixed-rate clock, over the dirty tiles only.
+ * Investigating and wandering enemies pick their next search target from it with a single lookup.
+ */
+UCLASS()
+class RTP_API UInfluenceMapSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	void RegisterEnemy(ABaseEnemy* Enemy);
+
+	void UnregisterEnemy(ABaseEnemy* Enemy);
+
+	// Raise the player heat at Location, Strength 0-1, e.g. 1 for a sighting and the loudness for a noise
+	void AddPlayerEvidence(const FVector& Location, float Strength);
+
+	// Most promising place to search within Radius of From: hot and not recently covered by enemies
+	bool FindSearchTarget(const FVector& From, float Radius, FVector& OutLocation) const;
+
+	// Write the map's size, its dirty tiles and the hottest cells to the log
+	void LogInfluence() const;
+
+	static bool IsEnabled();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	static FInfluenceMapSettings GetSettings(float StepInterval);
+
+	// Mark the cells the registered enemies stand in
+	void DepositEnemyCoverage(float StepInterval);
+
+	FInfluenceMap Map;
+
+	FFixedStepClock Clock;
+
+	TArray<TWeakObjectPtr<ABaseEnemy>> Enemies;
+};
@@ -0,0 +1,235 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <coroutine>
+
+class ULatentBehaviorSubsystem;
+struct FLatentPromise;
+
+/**
+ * Free lists of coroutine frames in fixed size classes, so starting a latent behaviour does not
+ * allocate once the pool has grown to the peak number of live behaviours. Game thread only.
+ */
+struct RTP_API FLatentFramePool
+{
+    static void* Allocate(SIZE_T Size);
+
+    static void Free(void* Frame, SIZE_T Size);
+
+    // Frames currently owned by a behaviour
+    static int32 GetNumLiveFrames();
+
+    // Frames waiting in the free lists
+    static int32 GetNumPooledFrames();
+
+    // Heap allocations made so far, including frames too large to pool
+    static int32 GetNumHeapAllocations();
+};
+
+/**
+ * A latent AI behaviour: a C++20 coroutine written as sequential code that co_awaits delays
+ * (FLatentDelay), signals raised by its owner (FLatentSignal) or other behaviours, which then run
+ * as its children. A suspended behaviour is not ticked, it is resumed by whatever it waits on.
+ *
+ * Behaviours start suspended and run from Start(), or when awaited. Destroying or replacing the
+ * owning FLatentBehavior cancels the behaviour and its children wherever they are suspended, but a
+ * behaviour must never cancel itself while running, it ends by returning.
+ */
+class RTP_API FLatentBehavior
+{
+public:
+    using promise_type = FLatentPromise;
+    using FHandle = std::coroutine_handle<FLatentPromise>;
+
+    FLatentBehavior() = default;
+
+    explicit FLatentBehavior(FHandle InHandle) : Handle(InHandle) {}
+
+    FLatentBehavior(FLatentBehavior&& Other) : Handle(Other.Handle) { Other.Handle = nullptr; }
+
+    FLatentBehavior& operator=(FLatentBehavior&& Other);
+
+    ~FLatentBehavior() { Reset(); }
+
+    FLatentBehavior(const FLatentBehavior&) = delete;
+    FLatentBehavior& operator=(const FLatentBehavior&) = delete;
+
+    // Run the behaviour up to its first suspension
+    void Start();
+
+    // Cancel the behaviour, if it has not finished, and free its frame
+    void Reset();
+
+    bool IsRunning() const { return Handle && !Handle.done(); }
+
+    // Seconds left in the timed wait the behaviour, or its innermost child, is suspended in, 0 when not in one
+    float GetWaitRemaining(double Now) const;
+
+    // Awaiting a behaviour runs it as a child, the awaiting behaviour resumes once it finishes
+    bool await_ready() const { return !Handle || Handle.done(); }
+    std::coroutine_handle<> await_suspend(FHandle Parent);
+    void await_resume();
+
+private:
+    FHandle Handle;
+};
+
+// Coroutine promise of FLatentBehavior, its frame comes from FLatentFramePool
+struct RTP_API FLatentPromise
+{
+    // Hand control back to the awaiting parent behaviour, if there is one
+    struct FFinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(FLatentBehavior::FHandle Finished) noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    FLatentBehavior get_return_object() { return FLatentBehavior(FLatentBehavior::FHandle::from_promise(*this)); }
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    FFinalAwaiter final_suspend() const noexcept { return {}; }
+
+    void return_void() const {}
+
+    // Exceptions are disabled, nothing can reach here
+    void unhandled_exception() const { checkNoEntry(); }
+
+    static void* operator new(std::size_t Size) { return FLatentFramePool::Allocate(Size); }
+
+    static void operator delete(void* Frame, std::size_t Size) { FLatentFramePool::Free(Frame, Size); }
+
+    // Behaviour awaiting this one
+    FLatentBehavior::FHandle Continuation;
+
+    // Child behaviour this one is awaiting
+    FLatentPromise* Child = nullptr;
+
+    // World time the current timed wait ends, negative when not in one
+    double WakeTime = -1.0;
+
+    bool bStarted = false;
+};
+
+/**
+ * Base of the awaitables: suspends the behaviour and optionally resumes it after a timeout,
+ * through ULatentBehaviorSubsystem. Destroying a suspended behaviour destroys its wait, which
+ * unregisters itself, so a cancelled behaviour is never resumed.
+ */
+class RTP_API FLatentWait
+{
+public:
+    // A negative timeout waits without a time limit
+    FLatentWait(const UObject* WorldContextObject, float InTimeout);
+
+    virtual ~FLatentWait();
+
+    UE_NONCOPYABLE(FLatentWait);
+
+    bool await_ready() const { return false; }
+
+protected:
+    // Suspend the behaviour and arm the timeout
+    void Suspend(FLatentBehavior::FHandle InHandle);
+
+    // Disarm the timeout and resume the behaviour, the wait may be destroyed before this returns
+    void Resume();
+
+    // Called by ULatentBehaviorSubsystem when the timeout has passed
+    virtual void OnTimeout() { Resume(); }
+
+private:
+    friend class ULatentBehaviorSubsystem;
+
+    void DisarmTimeout();
+
+    FLatentBehavior::FHandle Handle;
+
+    TWeakObjectPtr<ULatentBehaviorSubsystem> Subsystem;
+
+    float Timeout = -1.0f;
+
+    int32 TimeoutId = INDEX_NONE;
+};
+
+// co_await FLatentDelay(this, Seconds) resumes the behaviour after Seconds of world time
+class RTP_API FLatentDelay : public FLatentWait
+{
+public:
+    FLatentDelay(const UObject* WorldContextObject, float Seconds)
+        : FLatentWait(WorldContextObject, FMath::Max(0.0f, Seconds))
+    {
+    }
+
+    void await_suspend(FLatentBehavior::FHandle InHandle) { Suspend(InHandle); }
+
+    void await_resume() const {}
+};
+
+class FLatentSignalWait;
+
+/**
+ * A wakeup raised by the object that owns it, e.g. an enemy's move completion or perception.
+ * At most one behaviour waits on a signal at a time, triggering it with nobody waiting does nothing.
+ */
+class RTP_API FLatentSignal
+{
+public:
+    FLatentSignal() = default;
+
+    ~FLatentSignal();
+
+    UE_NONCOPYABLE(FLatentSignal);
+
+    // Resume the waiting behaviour with Value
+    void Trigger(int32 Value = 0);
+
+    // co_await the result to wait for the next Trigger, which gives its value, or the timeout, which gives an unset result
+    FLatentSignalWait Wait(const UObject* WorldContextObject, float Timeout = -1.0f);
+
+    bool HasWaiter() const { return Waiter != nullptr; }
+
+private:
+    friend class FLatentSignalWait;
+
+    FLatentSignalWait* Waiter = nullptr;
+};
+
+class RTP_API FLatentSignalWait : public FLatentWait
+{
+public:
+    FLatentSignalWait(FLatentSignal& InSignal, const UObject* WorldContextObject, float Timeout)
+        : FLatentWait(WorldContextObject, Timeout)
+        , Signal(&InSignal)
+    {
+    }
+
+    virtual ~FLatentSignalWait() override { Detach(); }
+
+    void await_suspend(FLatentBehavior::FHandle InHandle);
+
+    TOptional<int32> await_resume() const { return Result; }
+
+protected:
+    virtual void OnTimeout() override;
+
+private:
+    friend class FLatentSignal;
+
+    // Called by the signal's Trigger
+    void Fire(int32 Value);
+
+    void Detach();
+
+    FLatentSignal* Signal;
+
+    TOptional<int32> Result;
+};
+
+inline FLatentSignalWait FLatentSignal::Wait(const UObject* WorldContextObject, float Timeout)
+{
+    return FLatentSignalWait(*this, WorldContextObject, Timeout);
+}
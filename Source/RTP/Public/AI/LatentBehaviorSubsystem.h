@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LatentBehaviorSubsystem.generated.h"
+
+class FLatentWait;
+
+/**
+ * Timeout queue for latent AI behaviours. Suspended behaviours sit in a min-heap keyed on their
+ * wake time, so a frame only looks at the waits that are due rather than at every waiting enemy.
+ */
+UCLASS()
+class RTP_API ULatentBehaviorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	// Call Wait's OnTimeout at world time WakeTime, returns the id used to remove it
+	int32 AddTimeout(FLatentWait* Wait, double WakeTime);
+
+	void RemoveTimeout(int32 TimeoutId);
+
+	int32 GetNumTimeouts() const { return Timeouts.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FTimeout
+	{
+		FLatentWait* Wait;
+		uint64 Serial;
+	};
+
+	struct FQueuedTimeout
+	{
+		double WakeTime;
+		int32 TimeoutId;
+		uint64 Serial;
+
+		// Earliest first, and in the order they were added when due together
+		bool operator<(const FQueuedTimeout& Other) const
+		{
+			return WakeTime < Other.WakeTime || (WakeTime == Other.WakeTime && Serial < Other.Serial);
+		}
+	};
+
+	// Registered timeouts, removal frees the slot and leaves the queue entry to be skipped
+	TSparseArray<FTimeout> Timeouts;
+
+	TArray<FQueuedTimeout> Queue;
+
+	uint64 NextSerial = 0;
+};
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AI/EnemySpatialHash.h"
+#include "NoiseSubsystem.generated.h"
+
+class ABaseEnemy;
+
+/**
+ * Queues gameplay noises and delivers them once per frame to the enemies that can hear them.
+ * Listeners are looked up through a spatial hash, so hearing costs O(noises x nearby enemies)
+ * instead of every sensor polling every noise.
+ */
+UCLASS()
+class RTP_API UNoiseSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	void RegisterListener(ABaseEnemy* Enemy);
+
+	void UnregisterListener(ABaseEnemy* Enemy);
+
+	// Queue a noise, Loudness 0-1 scales each listener's hearing range
+	UFUNCTION(BlueprintCallable, Category = "AI")
+	void ReportNoise(AActor* NoiseInstigator, const FVector& Location, float Loudness);
+
+	// Append every registered enemy within Radius of Location
+	void GatherEnemiesInRadius(const FVector& Location, float Radius, TArray<ABaseEnemy*>& OutEnemies);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FNoiseEvent
+	{
+		TWeakObjectPtr<AActor> Instigator;
+		FVector Location;
+		float Loudness;
+	};
+
+	// Rebuild the spatial hash from current listener positions, at most once per frame
+	void UpdateSpatialHash();
+
+	TArray<TWeakObjectPtr<ABaseEnemy>> Listeners;
+
+	TArray<FNoiseEvent> PendingNoises;
+
+	FEnemySpatialHash SpatialHash;
+	uint64 SpatialHashFrame = MAX_uint64;
+
+	// Longest hearing range among the listeners, bounds every noise query
+	float MaxHearingRange = 0.0f;
+
+	// Scratch buffers reused across frames
+	TArray<FNoiseEvent> DispatchNoises;
+	TArray<ABaseEnemy*> NearbyEnemies;
+	TMap<ABaseEnemy*, int32> LoudestNoiseByEnemy;
+};
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "VisibilityGridAsset.generated.h"
+
+/**
+ * Static occluders of one level voxelized into a two-level bitset.
+ * The grid is split into 8x8x8 voxel bricks; bricks without any occluder are not stored, every other
+ * brick is 512 bits. Baked by UBakeVisibilityGridCommandlet.
+ */
+UCLASS(BlueprintType)
+class RTP_API UVisibilityGridAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr int32 BrickShift = 3;
+	static constexpr int32 BrickSize = 1 << BrickShift;
+	static constexpr int32 BrickMask = BrickSize - 1;
+	static constexpr int32 WordsPerBrick = BrickSize * BrickSize * BrickSize / 64;
+
+	// Whether the voxel at the given grid coordinates contains a static occluder, outside the grid is empty
+	FORCEINLINE bool IsVoxelOccupied(int32 X, int32 Y, int32 Z) const
+	{
+		if (static_cast<uint32>(X) >= static_cast<uint32>(Dimensions.X)
+			|| static_cast<uint32>(Y) >= static_cast<uint32>(Dimensions.Y)
+			|| static_cast<uint32>(Z) >= static_cast<uint32>(Dimensions.Z))
+		{
+			return false;
+		}
+
+		const int32 BrickIndex = BrickTable[(X >> BrickShift) + BrickCounts.X * ((Y >> BrickShift) + BrickCounts.Y * (Z >> BrickShift))];
+		if (BrickIndex == INDEX_NONE)
+		{
+			return false;
+		}
+
+		const uint32 Bit = (X & BrickMask) | (Y & BrickMask) << BrickShift | (Z & BrickMask) << (2 * BrickShift);
+		return (BrickBits[BrickIndex * WordsPerBrick + (Bit >> 6)] >> (Bit & 63)) & 1;
+	}
+
+	// Whether the brick table and bits match the grid's size, so IsVoxelOccupied stays in bounds.
+	// A stale or damaged bake fails this and must not be queried
+	bool HasValidLayout() const
+	{
+		const int64 NumBricks = static_cast<int64>(BrickCounts.X) * BrickCounts.Y * BrickCounts.Z;
+		if (BrickCounts.X <= 0 || BrickCounts.Y <= 0 || BrickCounts.Z <= 0
+			|| Dimensions != BrickCounts * BrickSize
+			|| BrickTable.Num() != NumBricks
+			|| BrickBits.Num() % WordsPerBrick != 0
+			|| VoxelSize <= 0.0f)
+		{
+			return false;
+		}
+
+		const int32 NumStoredBricks = BrickBits.Num() / WordsPerBrick;
+		for (const int32 BrickIndex : BrickTable)
+		{
+			if (BrickIndex != INDEX_NONE && (BrickIndex < 0 || BrickIndex >= NumStoredBricks))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// World position of the grid's minimum corner
+	UPROPERTY(VisibleAnywhere, Category = "Visibility Grid")
+	FVector Origin = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, Category = "Visibility Grid")
+	float VoxelSize = 50.0f;
+
+	// Size of the grid in voxels, a multiple of BrickSize
+	UPROPERTY(VisibleAnywhere, Category = "Visibility Grid")
+	FIntVector Dimensions = FIntVector::ZeroValue;
+
+	// Size of the grid in bricks
+	UPROPERTY(VisibleAnywhere, Category = "Visibility Grid")
+	FIntVector BrickCounts = FIntVector::ZeroValue;
+
+	// Per brick, INDEX_NONE when empty or the brick's index into BrickBits
+	UPROPERTY()
+	TArray<int32> BrickTable;
+
+	// WordsPerBrick words per stored brick, bit = x | y << 3 | z << 6
+	UPROPERTY()
+	TArray<uint64> BrickBits;
+};
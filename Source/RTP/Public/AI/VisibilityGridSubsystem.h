@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VisibilityGridSubsystem.generated.h"
+
+class UVisibilityGridAsset;
+
+/**
+ * Answers line of sight against the level's baked visibility grid instead of the physics scene.
+ * Segments are walked through the voxel grid with a 3D-DDA, four rays at a time in SIMD lanes.
+ * The grid only knows static occluders, dynamic ones still need a physics trace. Voxelizing over-approximates
+ * them, so a clear segment is final for static geometry but a blocked one is only a candidate for a full trace.
+ */
+UCLASS()
+class RTP_API UVisibilityGridSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// Package path of the grid baked for a map, /Game/AI/VisibilityGrids/VG_<MapName>
+	static FString GetGridPackagePath(const FString& MapName);
+
+	void SetGrid(UVisibilityGridAsset* NewGrid) { Grid = NewGrid; }
+
+	bool HasGrid() const { return Grid != nullptr; }
+
+	// Whether the grid is loaded and enabled for AI sight
+	bool IsActive() const;
+
+	// For each segment, true when no voxel it passes through holds a baked static occluder, its start and end voxels included.
+	// The enemy decide phase tests every sight segment of an update round here in one call
+	void TestSegments(TConstArrayView<FVector> Starts, TConstArrayView<FVector> Ends, TArrayView<bool> OutClear) const;
+
+	bool IsSegmentClear(const FVector& Start, const FVector& End) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	UPROPERTY()
+	UVisibilityGridAsset* Grid = nullptr;
+};
@@ -4,11 +4,33 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Components/FlashlightComponent.h"
 #include "PlayerAnimationInstance.generated.h"
 
 class APlayerCharacter;
 class UCharacterMovementComponent;
 
+// Copies the player's animation inputs on the game thread so the update can run on a worker thread
+USTRUCT()
+struct RTP_API FPlayerAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FPlayerAnimInstanceProxy() {}
+
+	FPlayerAnimInstanceProxy(UAnimInstance* InAnimInstance)
+		: FAnimInstanceProxy(InAnimInstance)
+	{
+	}
+
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	bool bIsHoldingFlashlight = false;
+	EFlashlightMode FlashlightMode = EFlashlightMode::Off;
+	float Speed = 0.0f;
+};
+
 /**
  * 
  */
@@ -18,9 +40,11 @@ class RTP_API UPlayerAnimationInstance : public UAnimInstance
 	GENERATED_BODY()
 	
 public:
+	UPlayerAnimationInstance();
+
 	virtual void NativeInitializeAnimation() override;
 
-	virtual void NativeUpdateAnimation(float DeltaTime) override;
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaTime) override;
 
 	UPROPERTY(BlueprintReadOnly)
 	APlayerCharacter* PlayerCharacter;
@@ -30,4 +54,22 @@ public:
 
 	UPROPERTY(BlueprintReadOnly, Category="Flashlight")
 	bool isHoldingFlashlight;
+
+	UPROPERTY(BlueprintReadOnly, Category="Flashlight")
+	EFlashlightMode FlashlightMode = EFlashlightMode::Off;
+
+	UPROPERTY(BlueprintReadOnly, Category="Movement")
+	float Speed = 0.0f;
+
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override { return &Proxy; }
+
+	// The proxy is a member, so there is nothing to free
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override {}
+
+private:
+	UPROPERTY(Transient)
+	FPlayerAnimInstanceProxy Proxy;
+
+	friend struct FPlayerAnimInstanceProxy;
 };
@@ -6,24 +6,30 @@
 #include "GameFramework/Character.h"
 #include "BaseCharacter.generated.h"
 
+class UResourceComponent;
+
 UCLASS()
 class RTP_API ABaseCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
 public:
-	ABaseCharacter();
+	ABaseCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
 	virtual void Tick(float DeltaTime) override;
 
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent,
+		class AController* EventInstigator, AActor* DamageCauser) override;
+
+	FORCEINLINE UResourceComponent* GetHealth() const { return Health; }
+
 protected:
 	
-	float MaxHealth;
-	float CurrentHealth;
-	float HealthRecoveryRate;
-	float HealthRecoveryTimer;
+	// Health with delayed regeneration, computed on read instead of per frame
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Health")
+	UResourceComponent* Health;
 	
 	virtual void BeginPlay() override;
 
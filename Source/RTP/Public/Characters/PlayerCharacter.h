@@ -6,6 +6,7 @@
 #include "BaseCharacter.h"
 #include "Blueprint/UserWidget.h"
 #include "InputActionValue.h"
+#include "Components/FlashlightComponent.h"
 #include "PlayerCharacter.generated.h"
 
 class UCameraComponent;
@@ -14,19 +15,13 @@ class UInputMappingContext;
 class UInputAction;
 class UStaminaWidget;
 class UFlashlightWidget;
+class UPlayerHUDViewModel;
+class UResourceComponent;
+class USprintMovementComponent;
 class USpotLightComponent;
 class UAudioComponent;
-
-// Enum for flashlight modes
-UENUM(BlueprintType)
-enum class EFlashlightMode : uint8
-{
-    Off,
-    Low,
-    Medium,
-    High,
-    Strobe
-};
+struct FStreamableHandle;
+struct FPlayerCheckpoint;
 
 UCLASS()
 class RTP_API APlayerCharacter : public ABaseCharacter
@@ -34,124 +29,104 @@ class RTP_API APlayerCharacter : public ABaseCharacter
 	GENERATED_BODY()
 
 public:
-	APlayerCharacter();
-
-	virtual void Tick(float DeltaTime) override;
+	APlayerCharacter(const FObjectInitializer& ObjectInitializer);
 
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	// Copy the state saved in checkpoints, game thread only
+	void WriteCheckpoint(FPlayerCheckpoint& OutCheckpoint) const;
+
+	// Restore position, resources and flashlight mode from a checkpoint
+	void ReadCheckpoint(const FPlayerCheckpoint& Checkpoint);
+
 protected:
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Create the HUD once the widget classes have streamed in
+	void CreateHUDWidgets();
+
 	void Move(const FInputActionValue& Value);
 
 	void Look(const FInputActionValue& Value);
 
 	virtual void Jump() override;
 
+	virtual void Landed(const FHitResult& Hit) override;
+
 	void StartSprinting(const FInputActionValue& Value);
 	
 	void StopSprinting(const FInputActionValue& Value);
 
-	void UpdateStamina(float DeltaTime);
+	UFUNCTION()
+	void HandleStaminaChanged(float Value, float MaxValue);
+
+	UFUNCTION()
+	void HandleBatteryChanged(float Value, float MaxValue);
 
 	// Updated flashlight controls
 	void ToggleFlashlight(const FInputActionValue& Value);
 	void CycleFlashlightMode(const FInputActionValue& Value);
-	void UpdateFlashlight(float DeltaTime);
-	void SetFlashlightMode(EFlashlightMode NewMode);
+
+	UFUNCTION()
+	void HandleFlashlightModeChanged(EFlashlightMode NewMode);
+
+	// Emit a footstep each time the player has covered a stride on the ground
+	void UpdateFootsteps();
+
+	// Queue a noise at the player's location for nearby enemies
+	void EmitNoise(float Loudness);
 
 private:
 
-	bool bIsSprinting;
-	float CurrentStamina;
-	float MaxStamina;
-	float StaminaRecoveryRate;
-	float StaminaConsumptionRate;
-	float StaminaRegenDelay;
-	float StaminaRegenTimer;
-	float StaminaRecoveryBuffer;
-	float StaminaConsumptionBuffer;
-	float NormalSpeed;
-	float SprintSpeed;
+	// Predicted sprint and stamina simulation
+	UPROPERTY()
+	USprintMovementComponent* SprintMovement;
+
 		// Flashlight properties
 	bool bIsHoldingFlashlight;
 	
-	// Battery system
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float MaxBatteryLife = 100.0f;
-	
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float CurrentBatteryLife;
-	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float BatteryDrainRate = 1.0f;
-	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float BatteryRechargeRate = 0.5f;
-	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float BatteryDrainMultiplierHigh = 2.0f;
-	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float BatteryDrainMultiplierMedium = 1.0f;
-	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float BatteryDrainMultiplierLow = 0.5f;
-	
-		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float BatteryDrainMultiplierStrobe = 1.5f;
-	
-	// Flashlight mode
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	EFlashlightMode CurrentFlashlightMode = EFlashlightMode::Off;
-	
-	// Stores the last active mode when flashlight is turned off
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	EFlashlightMode LastUsedFlashlightMode = EFlashlightMode::Off;
-	
-	// Intensity settings for different modes
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float FlashlightIntensityHigh = 8000.0f;
-	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float FlashlightIntensityMedium = 4000.0f;
-	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float FlashlightIntensityLow = 2000.0f;
-	
-	// Strobe effect
-	float StrobeTimer = 0.0f;
-		UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float StrobeInterval = 0.2f;
-	
-	bool bStrobeState = false;
-	
-	// Low battery warning
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float LowBatteryThreshold = 20.0f;
-	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float LowBatteryFlickerFrequency = 3.0f;
-	
-	// Battery level at which the flashlight starts to dim
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	float DimmingStartThreshold = 30.0f;
-	
-	float LowBatteryFlickerTimer = 0.0f;
-	
-	// Track if the flashlight is currently flickering
-	bool bIsFlickering = false;
-	
-	// Flashlight audio
+	// Flashlight audio, not created on dedicated servers
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
 	UAudioComponent* FlashlightSound;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	USoundBase* FlashlightToggleSound;
+	TSoftObjectPtr<USoundBase> FlashlightToggleSound;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (AllowPrivateAccess = true))
-	USoundBase* FlashlightLowBatterySound;
+	TSoftObjectPtr<USoundBase> FlashlightLowBatterySound;
+	
+	// Sounds and widget classes streamed in at BeginPlay, held until EndPlay
+	TSharedPtr<FStreamableHandle> AssetsHandle;
+
+	// Distance walked between two footstep noises
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (AllowPrivateAccess = true))
+	float FootstepStrideLength = 150.0f;
+
+	// Footstep loudness at full walking speed, scaled down when moving slower
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (AllowPrivateAccess = true))
+	float WalkFootstepLoudness = 0.4f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (AllowPrivateAccess = true))
+	float SprintFootstepLoudness = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (AllowPrivateAccess = true))
+	float JumpNoiseLoudness = 0.5f;
+
+	// Landing loudness after a fall at LandNoiseFallSpeed or faster
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (AllowPrivateAccess = true))
+	float LandNoiseLoudness = 0.8f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (AllowPrivateAccess = true))
+	float LandNoiseFallSpeed = 1000.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (AllowPrivateAccess = true))
+	float FlashlightClickLoudness = 0.2f;
+
+	FTimerHandle FootstepTimerHandle;
+	FVector LastFootstepCheckLocation;
+	float DistanceSinceFootstep = 0.0f;
 
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Camera", meta = (AllowPrivateAccess = true))
 	UCameraComponent* ViewCamera;
@@ -159,12 +134,20 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Mesh", meta = (AllowPrivateAccess = true))
 	USkeletalMeshComponent* PlayerMesh;
 
+	// Spotlights driven by Flashlight, not created on dedicated servers
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Flashlight", meta = (AllowPrivateAccess = true))
 	USpotLightComponent* OuterFlashlight;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Flashlight", meta = (AllowPrivateAccess = true))
 	USpotLightComponent* InnerFlashlight;
 
+	// Battery, modes and light effects for the two spotlights
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Flashlight", meta = (AllowPrivateAccess = true))
+	UFlashlightComponent* Flashlight;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Flashlight", meta = (AllowPrivateAccess = true))
+	UResourceComponent* Battery;
+
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Input", meta = (AllowPrivateAccess = true))
 	UInputMappingContext* MappingContext;
 
@@ -186,20 +169,25 @@ private:
 	UPROPERTY(BlueprintReadOnly, EditAnywhere, Category = "Input", meta = (AllowPrivateAccess = true))
 	UInputAction* FlashlightModeAction;
 	UPROPERTY(EditAnywhere, Category = "UI")
-	TSubclassOf<UUserWidget> StaminaWidgetClass;
+	TSoftClassPtr<UUserWidget> StaminaWidgetClass;
 
 	UPROPERTY()
 	UStaminaWidget* StaminaWidget;
 	
 	UPROPERTY(EditAnywhere, Category = "UI")
-	TSubclassOf<UUserWidget> FlashlightWidgetClass;
+	TSoftClassPtr<UUserWidget> FlashlightWidgetClass;
 
 	UPROPERTY()
 	UFlashlightWidget* FlashlightWidget;
 
+	// Quantized HUD values shared by the stamina and flashlight widgets
+	UPROPERTY()
+	UPlayerHUDViewModel* HUDViewModel;
+
 public:
 	FORCEINLINE UCameraComponent* GetViewCamera() { return ViewCamera; }
 	FORCEINLINE bool GetIsHoldingFlashlight() { return bIsHoldingFlashlight; }
-	FORCEINLINE EFlashlightMode GetFlashlightMode() { return CurrentFlashlightMode; }
-	FORCEINLINE float GetBatteryPercentage() { return CurrentBatteryLife / MaxBatteryLife; }
+	FORCEINLINE UFlashlightComponent* GetFlashlight() { return Flashlight; }
+	FORCEINLINE EFlashlightMode GetFlashlightMode() { return Flashlight->GetMode(); }
+	FORCEINLINE float GetBatteryPercentage() { return Flashlight->GetBatteryPercent(); }
 };
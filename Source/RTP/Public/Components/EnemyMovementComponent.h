@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "EnemyMovementComponent.generated.h"
+
+/**
+ * Character movement for enemies, steered by UCrowdAvoidanceSubsystem.
+ * The path following velocity is recorded as the agent's preferred velocity, and the collision-free
+ * velocity the crowd solves for it is blended in on the ground, within the character's acceleration.
+ */
+UCLASS()
+class RTP_API UEnemyMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual void RequestDirectMove(const FVector& MoveVelocity, bool bForceMaxSpeed) override;
+
+	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration) override;
+
+	// Whether path following requested a velocity this frame or the last
+	bool HasPreferredVelocity() const;
+
+	FVector2f GetPreferredVelocity() const { return PreferredVelocity; }
+
+	// Velocity to steer towards until the next crowd pass
+	void SetAvoidanceVelocity(const FVector2f& InAvoidanceVelocity);
+
+	void ClearAvoidanceVelocity() { bHasAvoidanceVelocity = false; }
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	FVector2f PreferredVelocity = FVector2f::ZeroVector;
+	uint64 PreferredVelocityFrame = 0;
+
+	FVector2f AvoidanceVelocity = FVector2f::ZeroVector;
+	bool bHasAvoidanceVelocity = false;
+};
@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "FlashlightComponent.generated.h"
+
+class USpotLightComponent;
+class UResourceComponent;
+
+// Enum for flashlight modes
+UENUM(BlueprintType)
+enum class EFlashlightMode : uint8
+{
+    Off,
+    Low,
+    Medium,
+    High,
+    Strobe
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFlashlightModeChanged, EFlashlightMode, NewMode);
+
+/**
+ * Drives a pair of spotlights from a battery, mode and precomputed flicker timeline.
+ * Light parameters are only pushed to the render thread when they move past a threshold.
+ * The battery itself is a UResourceComponent, so the component only ticks while the light is on.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class RTP_API UFlashlightComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFlashlightComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Set the inner (hot spot) and outer (spill) lights driven by this component
+	void SetLights(USpotLightComponent* InInnerLight, USpotLightComponent* InOuterLight);
+
+	// Set the resource drained while the light is on
+	void SetBattery(UResourceComponent* InBattery);
+
+	// Switch to a mode and apply its light settings immediately
+	UFUNCTION(BlueprintCallable, Category = "Flashlight")
+	void SetMode(EFlashlightMode NewMode);
+
+	// Turn on to the last used mode, or off remembering the current one. Returns true if the light is now on
+	UFUNCTION(BlueprintCallable, Category = "Flashlight")
+	bool Toggle();
+
+	// Advance Low -> Medium -> High -> Strobe -> Low. Returns false if the light is off or empty
+	UFUNCTION(BlueprintCallable, Category = "Flashlight")
+	bool CycleMode();
+
+	// Rebuild the flicker timeline from a new seed
+	UFUNCTION(BlueprintCallable, Category = "Flashlight")
+	void SetFlickerSeed(int32 NewSeed);
+
+	UFUNCTION(BlueprintPure, Category = "Flashlight")
+	EFlashlightMode GetMode() const { return CurrentMode; }
+
+	UFUNCTION(BlueprintPure, Category = "Flashlight")
+	bool IsOn() const { return CurrentMode != EFlashlightMode::Off; }
+
+	UFUNCTION(BlueprintPure, Category = "Flashlight")
+	float GetBatteryPercent() const;
+
+	// Remaining battery in the same units as the low battery and dimming thresholds
+	UFUNCTION(BlueprintPure, Category = "Flashlight")
+	float GetBatteryLife() const;
+
+	// Steady intensity of the inner light for a mode, before dimming and flicker
+	UFUNCTION(BlueprintPure, Category = "Flashlight")
+	float GetModeIntensity(EFlashlightMode Mode) const;
+
+	// Broadcast whenever the mode changes, including when the battery runs out
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnFlashlightModeChanged OnModeChanged;
+
+protected:
+	virtual void BeginPlay() override;
+
+	// Intensity multiplier from battery dimming, low battery flicker and strobe at the current time
+	float EvaluateIntensityScale() const;
+
+	// Push light parameters, skipping changes smaller than IntensityChangeThreshold
+	void ApplyLightState(bool bForce = false);
+
+	// Precompute the flicker timeline from FlickerSeed
+	void BuildFlickerTimeline();
+
+	// Enable ticking only while there is something to simulate
+	void UpdateTickEnabled();
+
+	// Drain rate for the current mode, 0 while off so the battery recharges
+	float GetModeDrainRate() const;
+
+	UFUNCTION()
+	void HandleBatteryDepleted();
+
+	// Battery system
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Battery")
+	float BatteryDrainRate = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Battery")
+	float BatteryDrainMultiplierHigh = 2.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Battery")
+	float BatteryDrainMultiplierMedium = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Battery")
+	float BatteryDrainMultiplierLow = 0.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Battery")
+	float BatteryDrainMultiplierStrobe = 1.5f;
+
+	// Flashlight mode
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Flashlight")
+	EFlashlightMode CurrentMode = EFlashlightMode::Off;
+
+	// Stores the last active mode when flashlight is turned off
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Flashlight")
+	EFlashlightMode LastUsedMode = EFlashlightMode::Off;
+
+	// Intensity settings for different modes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight")
+	float FlashlightIntensityHigh = 8000.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight")
+	float FlashlightIntensityMedium = 4000.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight")
+	float FlashlightIntensityLow = 2000.0f;
+
+	// Strobe effect
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight")
+	float StrobeInterval = 0.2f;
+
+	// Low battery warning
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Battery")
+	float LowBatteryThreshold = 20.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Battery")
+	float LowBatteryFlickerFrequency = 3.0f;
+
+	// Battery level at which the flashlight starts to dim
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Battery")
+	float DimmingStartThreshold = 30.0f;
+
+	// Seed for the low battery flicker timeline
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Flicker")
+	int32 FlickerSeed = 1337;
+
+	// Number of flicker slots precomputed before the timeline repeats
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight|Flicker", meta = (ClampMin = 8))
+	int32 FlickerTimelineLength = 256;
+
+	// Relative intensity change below which the lights are left untouched
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Flashlight", meta = (ClampMin = 0.0))
+	float IntensityChangeThreshold = 0.02f;
+
+private:
+	UPROPERTY()
+	USpotLightComponent* InnerLight;
+
+	UPROPERTY()
+	USpotLightComponent* OuterLight;
+
+	UPROPERTY()
+	UResourceComponent* Battery;
+
+	// One random roll per flicker slot, compared against the battery-dependent flicker chance
+	TArray<float> FlickerTimeline;
+
+	// Time since the current mode was selected, drives strobe and flicker lookups
+	float ModeTime = 0.0f;
+
+	// Last values pushed to the lights
+	float AppliedInnerIntensity = -1.0f;
+	bool bAppliedVisible = false;
+};
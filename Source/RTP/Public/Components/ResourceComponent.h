@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ResourceSim.h"
+#include "ResourceComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnResourceValueChanged, float, Value, float, MaxValue);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnResourceThresholdCrossed, float, Threshold, bool, bRising);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnResourceEvent);
+
+// The resource's current linear segment, everything else is derived from it
+USTRUCT()
+struct RTP_API FResourceSegment
+{
+	GENERATED_BODY()
+
+	// Value when the segment started
+	UPROPERTY()
+	float AnchorValue = 0.0f;
+
+	// World time (server time when networked) when the segment started
+	UPROPERTY()
+	double AnchorTime = 0.0;
+
+	// Units drained per second, 0 means the resource regenerates instead
+	UPROPERTY()
+	float DrainRate = 0.0f;
+};
+
+/**
+ * A drainable, regenerating value such as stamina, battery or health.
+ * The value is never integrated per frame: it is computed exactly on read from the last change,
+ * and a single timer wakes the component up for the next event (depletion, regen start,
+ * full, a threshold or a change notification step).
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class RTP_API UResourceComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UResourceComponent();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Set up the resource, call from the owner's constructor
+	void InitializeResource(float InMaxValue, float InRegenRate, float InRegenDelay, float InRegenDelayBelowFraction = 1.0f);
+
+	// Current value, computed from the active segment
+	UFUNCTION(BlueprintPure, Category = "Resource")
+	float GetValue() const;
+
+	// Value at an arbitrary world time along the active segment
+	float GetValueAtTime(double Time) const;
+
+	UFUNCTION(BlueprintPure, Category = "Resource")
+	float GetFraction() const { return MaxValue > 0.0f ? GetValue() / MaxValue : 0.0f; }
+
+	UFUNCTION(BlueprintPure, Category = "Resource")
+	float GetMaxValue() const { return MaxValue; }
+
+	UFUNCTION(BlueprintPure, Category = "Resource")
+	bool IsDraining() const { return Segment.DrainRate > 0.0f; }
+
+	// Start draining at a constant rate, or stop draining and begin the regen delay with 0
+	UFUNCTION(BlueprintCallable, Category = "Resource")
+	void SetDrainRate(float NewDrainRate);
+
+	// Remove an amount instantly, restarting the regen delay
+	UFUNCTION(BlueprintCallable, Category = "Resource")
+	void Consume(float Amount);
+
+	// Add an amount instantly
+	UFUNCTION(BlueprintCallable, Category = "Resource")
+	void Restore(float Amount);
+
+	UFUNCTION(BlueprintCallable, Category = "Resource")
+	void SetValue(float NewValue);
+
+	// Fire OnThresholdCrossed when the value passes this level in either direction
+	UFUNCTION(BlueprintCallable, Category = "Resource")
+	void AddThreshold(float Threshold);
+
+	// Fire OnValueChanged each time the value crosses a multiple of Step, 0 only reports explicit changes
+	UFUNCTION(BlueprintCallable, Category = "Resource")
+	void SetChangeNotifyStep(float Step);
+
+	// Explicit changes and every ChangeNotifyStep crossing
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnResourceValueChanged OnValueChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnResourceThresholdCrossed OnThresholdCrossed;
+
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnResourceEvent OnDepleted;
+
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnResourceEvent OnFull;
+
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnResourceEvent OnRegenStarted;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UFUNCTION()
+	void OnRep_Segment();
+
+	// Start a new segment at the current time
+	void Reanchor(float NewValue, float NewDrainRate);
+
+	// Rule parameters and active segment in the form FResourceSim works on
+	FResourceParams GetParams() const;
+	FResourceLine GetLine() const;
+
+	// Time the value starts moving along the active segment and its slope from then on
+	double GetMoveStartTime() const;
+	float GetSlope() const;
+
+	// Earliest future time at which an event needs dispatching
+	double ComputeNextEventTime(double Now) const;
+
+	// Arm the single wakeup timer for the next event
+	void ScheduleNextWakeup();
+
+	void HandleWakeup();
+
+	// Broadcast every event between the last dispatched value and the current one
+	void DispatchEvents(bool bExplicitChange);
+
+	// World time, or server world time when a game state is available
+	double GetNow() const;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Resource")
+	float MaxValue = 100.0f;
+
+	// Units regenerated per second once the regen delay has passed
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Resource")
+	float RegenRate = 0.0f;
+
+	// Seconds after draining stops before regeneration begins
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Resource")
+	float RegenDelay = 0.0f;
+
+	// The regen delay only applies when draining stopped below this fraction of MaxValue
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Resource", meta = (ClampMin = 0.0, ClampMax = 1.0))
+	float RegenDelayBelowFraction = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Resource")
+	float ChangeNotifyStep = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Resource")
+	TArray<float> Thresholds;
+
+	UPROPERTY(ReplicatedUsing = OnRep_Segment)
+	FResourceSegment Segment;
+
+private:
+	FTimerHandle WakeupTimerHandle;
+
+	// Value at the last dispatch, used to detect crossings
+	float LastDispatchedValue = 0.0f;
+
+	// Whether OnRegenStarted has fired for the active segment
+	bool bRegenStartDispatched = false;
+};
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "SprintMovementComponent.generated.h"
+
+DECLARE_STATS_GROUP(TEXT("RTP Movement"), STATGROUP_RTPMovement, STATCAT_Advanced);
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnSprintStaminaChanged, float, Stamina, float, MaxStamina);
+
+// Server move response carrying the sprint state, so corrections also correct stamina
+struct FSprintMoveResponseDataContainer : public FCharacterMoveResponseDataContainer
+{
+	virtual void ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment) override;
+
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap) override;
+
+	bool bIsSprinting = false;
+	float Stamina = 0.0f;
+	float StaminaRegenDelayRemaining = 0.0f;
+};
+
+/**
+ * Character movement with predicted sprinting.
+ * The sprint request travels in the saved move's compressed flags and stamina is simulated
+ * inside each move, so client and server agree on speed and replays reproduce it exactly.
+ */
+UCLASS()
+class RTP_API USprintMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	USprintMovementComponent();
+
+	virtual float GetMaxSpeed() const override;
+
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	virtual void OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp,
+		FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName,
+		bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode, FVector ServerGravityDirection) override;
+
+	// Input side: request or release sprinting, applied by the next move
+	UFUNCTION(BlueprintCallable, Category = "Sprint")
+	void SetWantsToSprint(bool bNewWantsToSprint) { bWantsToSprint = bNewWantsToSprint; }
+
+	UFUNCTION(BlueprintPure, Category = "Sprint")
+	bool IsSprinting() const { return bIsSprinting; }
+
+	UFUNCTION(BlueprintPure, Category = "Sprint")
+	float GetStamina() const { return Stamina; }
+
+	UFUNCTION(BlueprintPure, Category = "Sprint")
+	float GetStaminaFraction() const { return Stamina / MaxStamina; }
+
+	// Overwrite the simulated stamina, e.g. when restoring a checkpoint, and stop sprinting
+	void SetStamina(float NewStamina);
+
+	// Broadcast when stamina crosses a multiple of StaminaNotifyStep, or after a correction
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnSprintStaminaChanged OnStaminaChanged;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sprint")
+	float SprintSpeed = 900.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sprint")
+	float MaxStamina = 100.0f;
+
+	// Stamina used per second while sprinting
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sprint")
+	float StaminaConsumptionRate = 10.0f;
+
+	// Stamina recovered per second while not sprinting
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sprint")
+	float StaminaRecoveryRate = 5.0f;
+
+	// Seconds to wait before recovering after stamina was exhausted
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sprint")
+	float StaminaRegenDelay = 2.0f;
+
+	// Below this fraction stamina counts as exhausted and must wait out the regen delay
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sprint")
+	float StaminaRecoveryBuffer = 0.01f;
+
+	// Fraction of stamina needed to start sprinting
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sprint")
+	float StaminaConsumptionBuffer = 0.3f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sprint")
+	float StaminaNotifyStep = 1.0f;
+
+protected:
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+	// Advance sprint state and stamina by one move
+	void SimulateStamina(float DeltaSeconds);
+
+	// Broadcast OnStaminaChanged if the notify step changed, or always when forced
+	void NotifyStaminaChanged(bool bForce = false);
+
+private:
+	friend class FSavedMove_Sprint;
+	friend struct FSprintMoveResponseDataContainer;
+
+	// Input request, sent to the server in the compressed flags
+	bool bWantsToSprint = false;
+
+	// Simulated state, saved and restored with every move
+	bool bIsSprinting = false;
+	float Stamina = 100.0f;
+	float StaminaRegenDelayRemaining = 0.0f;
+
+	int32 LastNotifiedStaminaStep = INDEX_NONE;
+
+	FSprintMoveResponseDataContainer SprintMoveResponseData;
+};
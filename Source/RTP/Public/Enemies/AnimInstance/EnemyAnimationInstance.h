@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Enemies/BaseEnemy.h"
+#include "EnemyAnimationInstance.generated.h"
+
+// Copies the enemy's animation inputs on the game thread so the update can run on a worker thread
+USTRUCT()
+struct RTP_API FEnemyAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FEnemyAnimInstanceProxy() {}
+
+	FEnemyAnimInstanceProxy(UAnimInstance* InAnimInstance)
+		: FAnimInstanceProxy(InAnimInstance)
+	{
+	}
+
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	EEnemyState EnemyState = EEnemyState::Idle;
+	float Speed = 0.0f;
+	float AIStepAlpha = 0.0f;
+};
+
+/**
+ * Native parent for enemy animation blueprints, updated off the game thread.
+ */
+UCLASS()
+class RTP_API UEnemyAnimationInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+	
+public:
+	UEnemyAnimationInstance();
+
+	virtual void NativeInitializeAnimation() override;
+
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaTime) override;
+
+	UPROPERTY(BlueprintReadOnly, Category="AI")
+	EEnemyState EnemyState = EEnemyState::Idle;
+
+	UPROPERTY(BlueprintReadOnly, Category="Combat")
+	bool bIsStunned = false;
+
+	UPROPERTY(BlueprintReadOnly, Category="Health")
+	bool bIsDead = false;
+
+	UPROPERTY(BlueprintReadOnly, Category="Movement")
+	float Speed = 0.0f;
+
+	// Progress between fixed AI decision steps, for blending state-driven poses smoothly
+	UPROPERTY(BlueprintReadOnly, Category="AI")
+	float AIStepAlpha = 0.0f;
+
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override { return &Proxy; }
+
+	// The proxy is a member, so there is nothing to free
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override {}
+
+private:
+	UPROPERTY(Transient)
+	ABaseEnemy* Enemy;
+
+	UPROPERTY(Transient)
+	FEnemyAnimInstanceProxy Proxy;
+
+	friend struct FEnemyAnimInstanceProxy;
+};
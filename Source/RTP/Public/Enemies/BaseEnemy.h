@@ -4,13 +4,24 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "AITypes.h"
+#include "AI/AISightSubsystem.h"
+#include "AI/LatentBehavior.h"
+#include "EnemySim.h"
 #include "BaseEnemy.generated.h"
 
 // Forward declarations
 class UAnimMontage;
 class UPawnSensingComponent;
+class UEnemyBrainComponent;
+class UEnemySquadSubsystem;
+class UInfluenceMapSubsystem;
 class USoundBase;
 class UAudioComponent;
+class UStaticMesh;
+class UImpostorAnimationSet;
+struct FEnemyCheckpoint;
+struct FPathFollowingResult;
 
 // Enemy states enum
 UENUM(BlueprintType)
@@ -24,6 +35,14 @@ enum class EEnemyState : uint8
     Dead
 };
 
+// World inputs shared by every enemy during the decide phase
+struct FEnemyWorldSnapshot
+{
+    APawn* Player = nullptr;
+    FVector PlayerLocation = FVector::ZeroVector;
+    double WorldTime = 0.0;
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnEnemyDeath);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnHealthChanged, float, CurrentHealth, float, MaxHealth);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStateChanged, EEnemyState, NewState);
@@ -36,12 +55,29 @@ class RTP_API ABaseEnemy : public ACharacter
 
 public:
 	// Sets default values for this character's properties
-	ABaseEnemy();
+	ABaseEnemy(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the enemy is removed from the world
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void PossessedBy(AController* NewController) override;
+
+	virtual void UnPossessed() override;
+
+	virtual void PostActorCreated() override;
+
+	virtual void PostLoad() override;
+
+	virtual void PostDuplicate(bool bDuplicateForPIE) override;
+
+#if WITH_EDITOR
+	virtual void PostEditImport() override;
+#endif
+
 	// Health variables
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
 	float MaxHealth = 100.0f;
@@ -49,30 +85,36 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Health")
 	float CurrentHealth;
 
-	// Death animation montage
+	// Death animation montage, montages are streamed with the enemy type's asset bundle
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimMontage* DeathMontage;
+	TSoftObjectPtr<UAnimMontage> DeathMontage;
 	
 	// Attack animation montage
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimMontage* AttackMontage;
+	TSoftObjectPtr<UAnimMontage> AttackMontage;
 	
 	// Stun animation montage
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation")
-	UAnimMontage* StunMontage;
+	TSoftObjectPtr<UAnimMontage> StunMontage;
 
 	// Death timer handle for cleanup
 	FTimerHandle DeathTimerHandle;
-		// Stun timer handle
-	FTimerHandle StunTimerHandle;
 	
 	// Attack cooldown timer
 	FTimerHandle AttackCooldownTimerHandle;
 
-	// Default death cleanup time
+	// Default death cleanup time, used when corpses are disabled
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
 	float DeathCleanupTime = 3.0f;
 	
+	// Static mesh authored in the final death pose, batched with other corpses when set
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
+	UStaticMesh* CorpseMesh;
+	
+	// Vertex-animated stand-in rendered instead of the skeletal mesh at a distance, none keeps the skeletal mesh
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Rendering")
+	UImpostorAnimationSet* ImpostorSet;
+	
 	// Default stun duration
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
 	float StunDuration = 3.0f;
@@ -89,6 +131,10 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI")
 	UPawnSensingComponent* PawnSensingComponent;
 	
+	// Optional StateTree brain, drives the enemy in place of the hand-written rules once given a tree
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI")
+	UEnemyBrainComponent* BrainComponent;
+	
 	// Detection range
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
 	float SightRadius = 1000.0f;
@@ -97,6 +143,10 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
 	float SightAngle = 90.0f;
 	
+	// Foliage density that hides the player when AI sight concealment is enabled
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float SightConcealmentThreshold = 1.0f;
+	
 	// Hearing range
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
 	float HearingRange = 800.0f;
@@ -134,23 +184,23 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
 	float AttackDamage = 20.0f;
 	
-	// Sound effects
+	// Sound effects, soft references streamed with the enemy type's asset bundle
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio")
-	USoundBase* AttackSound;
+	TSoftObjectPtr<USoundBase> AttackSound;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio")
-	USoundBase* DeathSound;
+	TSoftObjectPtr<USoundBase> DeathSound;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio")
-	USoundBase* SpotPlayerSound;
+	TSoftObjectPtr<USoundBase> SpotPlayerSound;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio")
-	USoundBase* StunnedSound;
+	TSoftObjectPtr<USoundBase> StunnedSound;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio")
-	USoundBase* IdleSound;
+	TSoftObjectPtr<USoundBase> IdleSound;
 	
-	// Audio component for playing sounds
+	// Audio component for playing sounds, not created on dedicated servers
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Audio")
 	UAudioComponent* AudioComponent;
 	
@@ -162,6 +212,84 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
 	float FlashlightSensitivity = 1.0f;
 
+	// Whether decision updates are driven by the world's UEnemyUpdateSubsystem instead of Tick
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	bool bUseUpdateScheduler = true;
+	
+	// Seed for this enemy's random stream, 0 derives one from the actor name
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	int32 RandomSeed = 0;
+	
+	// Matches this enemy with its checkpoint record across save and load, unique per placed or spawned enemy
+	UPROPERTY(VisibleAnywhere, AdvancedDisplay, Category = "AI", TextExportTransient, NonPIEDuplicateTransient)
+	FGuid EnemyId;
+	
+	// Enemies with the same squad name share player sightings, empty groups the enemy with those that spawned nearby
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	FName SquadName;
+	
+	// Squad memory joined at BeginPlay, read during the decide phase
+	UPROPERTY(Transient)
+	UEnemySquadSubsystem* SquadSubsystem;
+	
+	int32 SquadIndex = INDEX_NONE;
+	
+	// Investigating and wandering enemies search the hottest uncovered influence map cell within this distance, in centimeters
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float SearchRadius = 1500.0f;
+	
+	// Influence map cells searched after reaching the investigated location, before returning to the default behavior
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	int32 MaxSearchLegs = 3;
+	
+	UPROPERTY(Transient)
+	UInfluenceMapSubsystem* InfluenceMap;
+	
+	// Per-enemy random stream used for every AI roll, so results do not depend on thread scheduling
+	FRandomStream RandomStream;
+	
+	// Simulated time and interval of the latest fixed AI step
+	double AIStepTime = 0.0;
+	float AIStepInterval = 0.0f;
+	
+	// Go idle and optionally wander, towards where the player was likely last or to a random nearby point
+	void ApplyDefaultBehavior(bool bWander);
+	
+	// Most promising place within SearchRadius to look for the player, from the influence map
+	bool FindSearchTarget(FVector& OutLocation) const;
+	
+	// Switch to investigating once the player has been out of sight for Duration seconds
+	void StartMemoryTimer(float Duration);
+	
+	// Investigate Location and search on from there, returning to the default behavior once the trail is cold
+	void StartInvestigating(const FVector& Location);
+	
+	// Make Behavior the active latent behavior, cancelling the one it replaces. Never called from the active behavior itself
+	void StartBehavior(FLatentBehavior&& Behavior);
+	
+	void StopBehavior() { ActiveBehavior.Reset(); }
+	
+	// Latent behaviors, each a sequence written as a coroutine that suspends without ticking
+	FLatentBehavior StunBehavior(float Duration);
+	FLatentBehavior AttackRecoveryBehavior();
+	FLatentBehavior LoseSightBehavior(float MemoryTime);
+	FLatentBehavior InvestigateBehavior();
+	
+	// Whether the controller is following a path
+	bool IsFollowingPath() const;
+	
+	// Path following finished a move request, bound while possessed by an AI controller
+	void OnMoveRequestFinished(FAIRequestID RequestID, const FPathFollowingResult& Result);
+	
+	// The running multi-step behavior: stun, attack recovery, losing sight of the player or investigating
+	FLatentBehavior ActiveBehavior;
+	
+	// Triggered with the result flags whenever a move request finishes
+	FLatentSignal MoveFinishedSignal;
+	
+	// Triggered whenever the player is seen
+	FLatentSignal PlayerSeenSignal;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -169,6 +297,71 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	// Run the state-specific decision logic, DeltaTime is the time since the previous decision update
+	virtual void UpdateDecision(float DeltaTime);
+	
+	// Hand-written decide and apply for one update, run when no brain drives the enemy
+	void RunDecisionRules(float DeltaTime);
+	
+	// Whether a running StateTree brain makes this enemy's decisions
+	bool IsBrainDriven() const;
+	
+	// Whether the target is in attack range and the attack is off cooldown
+	bool CanAttack(const AActor* Target) const;
+	
+	// Whether a squad mate saw the player recently enough to count as this enemy seeing them
+	bool DoesSquadSeePlayer() const;
+	
+	// Chase the player in sight, remembering where they were
+	void PursuePlayer(APawn* Player, bool bReportSighting);
+	
+	// Head for where the player was last seen, and start forgetting them unless a behaviour is already running
+	void PursueLastKnownLocation();
+	
+	// Go back to chasing a player seen again while investigating
+	void ResumeChase(APawn* Player);
+	
+	// Capture the world inputs shared by every enemy's decide phase
+	static FEnemyWorldSnapshot CaptureWorldSnapshot(const UObject* WorldContextObject);
+	
+	// Read-only decide phase, safe to run on worker threads. GridSight is the sight segment to the player
+	// already tested against the visibility grid, see GetSightSegment
+	virtual void DecideUpdate(const FEnemyWorldSnapshot& Snapshot, float DeltaTime, FEnemyDecision& OutDecision,
+		EAISightGridResult GridSight = EAISightGridResult::Untested) const;
+	
+	// The eye to player segment the decide phase may trace, false when this update cannot look for the player
+	bool GetSightSegment(const FEnemyWorldSnapshot& Snapshot, FVector& OutStart, FVector& OutEnd) const;
+	
+	// Serial apply phase: movement requests, sounds, montages and delegate broadcasts
+	virtual void ApplyDecision(const FEnemyDecision& Decision);
+
+	// Soft-referenced assets UEnemyAssetPreloader streams in before enemies of this type need them
+	virtual void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const;
+	
+	// Play one of the enemy's sounds, a no-op on dedicated servers
+	void PlayEnemySound(const TSoftObjectPtr<USoundBase>& Sound);
+	
+	// Play a montage that only matters visually, returns the time until its final pose. A no-op on dedicated servers
+	float PlayCosmeticMontage(const TSoftObjectPtr<UAnimMontage>& Montage);
+	
+	// Play the death montage and start the corpse hand-off or cleanup timer once its final pose is reached
+	void PlayDeathPresentation();
+
+	const FGuid& GetEnemyId() const { return EnemyId; }
+	
+	// Give an enemy respawned from a checkpoint the identity of the one it replaces, before it finishes spawning
+	void SetEnemyId(const FGuid& InEnemyId) { EnemyId = InEnemyId; }
+
+	// Copy the state saved in checkpoints, game thread only
+	void WriteCheckpoint(FEnemyCheckpoint& OutCheckpoint) const;
+	
+	// Restore state from a checkpoint, including the remaining stun, memory and cooldown timers.
+	// A corpse stays dead; UCheckpointSubsystem respawns enemies saved alive that have died since
+	virtual void ReadCheckpoint(const FEnemyCheckpoint& Checkpoint);
+	
+	// Whether a checkpoint record describes a living enemy
+	static bool IsCheckpointAlive(const FEnemyCheckpoint& Checkpoint);
+
 	// Handle damage received
 	UFUNCTION(BlueprintCallable, Category = "Health")
 	virtual float TakeDamageCustom(float DamageAmount, bool bIgnoreInvulnerability = false);
@@ -188,6 +381,11 @@ public:
 	// Check if enemy is dead
 	UFUNCTION(BlueprintPure, Category = "Health")
 	bool IsDead() const { return bIsDead; }
+	
+	UStaticMesh* GetCorpseMesh() const { return CorpseMesh; }
+	
+	// Keep the body in its current pose with no tick, collision, animation or controller, called by UCorpseSubsystem
+	void FreezeAsCorpse();
 
 	// Get current health percentage
 	UFUNCTION(BlueprintPure, Category = "Health")
@@ -201,6 +399,13 @@ public:
 	UFUNCTION(BlueprintPure, Category = "AI")
 	EEnemyState GetEnemyState() const { return CurrentState; }
 	
+	// Progress from the last fixed AI step towards the next, for smoothing presentation between decision steps
+	UFUNCTION(BlueprintPure, Category = "AI")
+	float GetAIStepAlpha() const;
+	
+	// Record the simulated time of the step about to run, called by UEnemyUpdateSubsystem
+	void SetAIStepTiming(double StepTime, float StepInterval) { AIStepTime = StepTime; AIStepInterval = StepInterval; }
+	
 	// Handle being stunned
 	UFUNCTION(BlueprintCallable, Category = "Combat")
 	virtual void Stun(float Duration = -1.0f);
@@ -224,6 +429,12 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "AI|Movement")
 	virtual void MoveToLocation(const FVector& Location);
 	
+	// Deliver a noise this enemy is within hearing range of, called by UNoiseSubsystem
+	void HearNoise(APawn* NoiseInstigator, const FVector& Location, float Volume) { OnNoiseHeard(NoiseInstigator, Location, Volume); }
+	
+	UFUNCTION(BlueprintPure, Category = "AI")
+	float GetHearingRange() const { return HearingRange; }
+	
 	// React to sound stimulus
 	UFUNCTION(BlueprintCallable, Category = "AI")
 	virtual void ReactToSound(AActor* SoundSource, const FVector& SoundLocation);
@@ -232,10 +443,22 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "AI")
 	virtual void ReactToSeeingPlayer(APawn* PlayerPawn);
 	
+	// React to a nearby squad mate seeing or hearing the player, called by UEnemySquadSubsystem
+	virtual void ReceiveSquadAlert(APawn* PlayerPawn, const FVector& Location, bool bSeen);
+	
+	FName GetSquadName() const { return SquadName; }
+	
+	int32 GetSquadIndex() const { return SquadIndex; }
+	
 	// Check line of sight to target
 	UFUNCTION(BlueprintCallable, Category = "AI")
 	bool HasLineOfSightTo(AActor* Target) const;
 	
+	// Line of sight with the segment's visibility grid result when it was tested in a batch
+	bool HasLineOfSightTo(AActor* Target, EAISightGridResult GridSight) const;
+	
+	FVector GetEyeLocation() const { return GetActorLocation() + FVector(0, 0, BaseEyeHeight); }
+	
 	// Reset to default behavior
 	UFUNCTION(BlueprintCallable, Category = "AI")
 	virtual void ReturnToDefaultBehavior();
@@ -269,4 +492,7 @@ protected:
 	// Called when a sound is heard
 	UFUNCTION()
 	virtual void OnNoiseHeard(APawn* NoiseInstigator, const FVector& Location, float Volume);
+	
+	// Share a sighting or sound of the player with this enemy's squad
+	void ReportPlayerToSquad(APawn* PlayerPawn, const FVector& Location, bool bSeen);
 };
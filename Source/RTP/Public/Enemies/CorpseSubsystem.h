@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CorpseSubsystem.generated.h"
+
+class ABaseEnemy;
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/**
+ * Keeps dead enemies around as cheap scenery.
+ * Enemies with an authored corpse mesh become an instance in one shared instanced static mesh
+ * per mesh and their actor is destroyed; others are frozen in their final pose with nothing
+ * left ticking. The number of corpses is capped and the oldest one is recycled first.
+ */
+UCLASS()
+class RTP_API UCorpseSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Whether dead enemies should be handed over instead of destroyed after their cleanup time
+	static bool IsEnabled();
+
+	// Turn a dead enemy that has reached its final pose into a corpse
+	void AddCorpse(ABaseEnemy* Enemy);
+
+	// Remove every corpse
+	void ClearCorpses();
+
+	int32 GetNumCorpses() const { return Corpses.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FCorpseRecord
+	{
+		// Instance slot in a shared mesh, or a frozen enemy when Instances is null
+		TWeakObjectPtr<UInstancedStaticMeshComponent> Instances;
+		int32 InstanceIndex = INDEX_NONE;
+		TWeakObjectPtr<ABaseEnemy> FrozenEnemy;
+	};
+
+	struct FCorpseBatch
+	{
+		UInstancedStaticMeshComponent* Instances = nullptr;
+
+		// Hidden instance slots left by recycled corpses, reused before adding new instances
+		TArray<int32> FreeSlots;
+	};
+
+	// Shared instanced mesh for a corpse mesh, created on first use
+	FCorpseBatch& FindOrAddBatch(UStaticMesh* Mesh);
+
+	// Remove the oldest corpse, freeing its instance slot or destroying its frozen actor
+	void RecycleOldest();
+
+	// Owner of the instanced mesh components
+	UPROPERTY()
+	AActor* CorpseActor = nullptr;
+
+	UPROPERTY()
+	TArray<UInstancedStaticMeshComponent*> BatchComponents;
+
+	TMap<UStaticMesh*, FCorpseBatch> Batches;
+
+	// Oldest corpse first
+	TArray<FCorpseRecord> Corpses;
+};
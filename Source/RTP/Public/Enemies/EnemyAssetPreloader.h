@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "UObject/ObjectKey.h"
+#include "EnemyAssetPreloader.generated.h"
+
+class ABaseEnemy;
+
+/**
+ * Keeps each enemy type's soft-referenced montages and sounds resident while the type is in use.
+ * A type's bundle is the list returned by ABaseEnemy::GetPreloadAssets on its class defaults. Bundles
+ * are streamed asynchronously on request, held while enemies of the type are alive, and released a
+ * while after the last one is gone.
+ */
+UCLASS()
+class RTP_API UEnemyAssetPreloader : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Start streaming an enemy type's bundle; OnLoaded runs once it is resident, right away if it already is
+	void Preload(TSubclassOf<ABaseEnemy> EnemyClass, FStreamableDelegate OnLoaded = FStreamableDelegate());
+
+	bool IsLoaded(TSubclassOf<ABaseEnemy> EnemyClass) const;
+
+	// Live enemies hold their type's bundle, the first user starts loading it
+	void AddUser(TSubclassOf<ABaseEnemy> EnemyClass);
+
+	void RemoveUser(TSubclassOf<ABaseEnemy> EnemyClass);
+
+	// Log every bundle with its users, load time and resident size
+	void LogBundles() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FEnemyBundle
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		TArray<FStreamableDelegate> PendingCallbacks;
+		int32 NumUsers = 0;
+		bool bLoaded = false;
+		double RequestTime = 0.0;
+		double LoadSeconds = 0.0;
+
+		// World time the bundle was last preloaded or lost its last user
+		double UnusedSince = 0.0;
+	};
+
+	FEnemyBundle& FindOrRequestBundle(UClass* EnemyClass);
+
+	void HandleBundleLoaded(TObjectKey<UClass> EnemyClass);
+
+	// Start the release delay of a bundle nobody uses right now
+	void MarkUnused(FEnemyBundle& Bundle);
+
+	// Drop bundles that have had no users for longer than the release delay
+	void ReleaseUnusedBundles();
+
+	TMap<TObjectKey<UClass>, FEnemyBundle> Bundles;
+
+	FTimerHandle ReleaseTimerHandle;
+};
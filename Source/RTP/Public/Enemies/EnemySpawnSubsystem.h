@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemySpawnSubsystem.generated.h"
+
+class ABaseEnemy;
+
+DECLARE_DELEGATE_OneParam(FOnEnemySpawned, ABaseEnemy*);
+
+/**
+ * Spreads enemy spawns over frames within a per-frame time budget.
+ * A spawn runs in two steps on different frames: the deferred spawn constructs the actor, and
+ * finishing it registers components, spawns the AI controller and runs BeginPlay. A request only
+ * starts once its type's asset bundle is resident, so no spawn waits on a load.
+ */
+UCLASS()
+class RTP_API UEnemySpawnSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	// Queue a spawn, OnSpawned runs on the frame the enemy has begun play
+	void RequestSpawn(TSubclassOf<ABaseEnemy> EnemyClass, const FTransform& Transform, FOnEnemySpawned OnSpawned = FOnEnemySpawned());
+
+	int32 GetNumPending() const { return Requests.Num() + Deferred.Num(); }
+
+	// Most expensive frame of spawn work since the queue last drained, in milliseconds
+	double GetWorstFrameMs() const { return WorstFrameMs; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FSpawnRequest
+	{
+		TSubclassOf<ABaseEnemy> EnemyClass;
+		FTransform Transform;
+		FOnEnemySpawned OnSpawned;
+	};
+
+	struct FDeferredSpawn
+	{
+		TSubclassOf<ABaseEnemy> EnemyClass;
+		TWeakObjectPtr<ABaseEnemy> Enemy;
+		FTransform Transform;
+		FOnEnemySpawned OnSpawned;
+	};
+
+	// Requests not yet constructed, in arrival order
+	TArray<FSpawnRequest> Requests;
+
+	// Constructed actors waiting to finish spawning
+	TArray<FDeferredSpawn> Deferred;
+
+	// Stats for the current wave, reported when the queue drains
+	double WorstFrameMs = 0.0;
+	int32 WaveSpawns = 0;
+	int32 WaveFrames = 0;
+};
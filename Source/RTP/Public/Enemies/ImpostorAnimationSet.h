@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ImpostorLOD.h"
+#include "ImpostorAnimationSet.generated.h"
+
+class UMaterialInterface;
+class UStaticMesh;
+class UTexture2D;
+
+// Frame range of one locomotion cycle within the vertex animation textures
+USTRUCT()
+struct RTP_API FImpostorClipInfo
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, Category = "Impostor")
+	int32 StartFrame = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Impostor")
+	int32 NumFrames = 1;
+
+	// Ground speed the cycle was authored for, the play rate scales with the actual speed
+	UPROPERTY(EditAnywhere, Category = "Impostor")
+	float ReferenceSpeed = 0.0f;
+};
+
+/**
+ * Vertex animation textures of an enemy's idle, walk and run cycles, baked by UBakeImpostorCommandlet.
+ * Texel (Column, Frame * RowsPerFrame + Row) stores the offset from the reference pose of the vertex
+ * whose second UV channel addresses (Column, Row) in the impostor mesh.
+ *
+ * The material reads its textures and layout from the parameters named below and the instance's
+ * playback from per-instance custom data: clip start frame, clip frame count, play rate and phase.
+ */
+UCLASS(BlueprintType)
+class RTP_API UImpostorAnimationSet : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UImpostorAnimationSet();
+
+	static const FName PositionTextureParameter;
+	static const FName NormalTextureParameter;
+	static const FName RowsPerFrameParameter;
+	static const FName TextureHeightParameter;
+	static const FName SampleRateParameter;
+
+	static constexpr int32 NumCustomDataFloats = 4;
+
+	const FImpostorClipInfo& GetClip(EImpostorClip Clip) const { return Clips[static_cast<int32>(Clip)]; }
+
+	// Seconds per loop of a clip at play rate 1
+	float GetCycleLength(EImpostorClip Clip) const { return GetClip(Clip).NumFrames / SampleRate; }
+
+	// Static mesh in the reference pose, UV channel 1 addresses each vertex's texel column and row
+	UPROPERTY(EditAnywhere, Category = "Impostor")
+	UStaticMesh* Mesh;
+
+	// Material that applies the vertex animation, expects the parameters above
+	UPROPERTY(EditAnywhere, Category = "Impostor")
+	UMaterialInterface* Material;
+
+	UPROPERTY(VisibleAnywhere, Category = "Impostor")
+	UTexture2D* PositionTexture;
+
+	UPROPERTY(VisibleAnywhere, Category = "Impostor")
+	UTexture2D* NormalTexture;
+
+	// Texel rows used by one frame when the vertices do not fit in a single row
+	UPROPERTY(VisibleAnywhere, Category = "Impostor")
+	int32 RowsPerFrame = 1;
+
+	UPROPERTY(VisibleAnywhere, Category = "Impostor")
+	int32 TextureHeight = 1;
+
+	// Baked frames per second
+	UPROPERTY(VisibleAnywhere, Category = "Impostor")
+	float SampleRate = 15.0f;
+
+	// Indexed by EImpostorClip
+	UPROPERTY(EditAnywhere, Category = "Impostor", EditFixedSize)
+	TArray<FImpostorClipInfo> Clips;
+};
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ImpostorLOD.h"
+#include "ImpostorSubsystem.generated.h"
+
+class ABaseEnemy;
+class UImpostorAnimationSet;
+class UInstancedStaticMeshComponent;
+
+/**
+ * Renders distant enemies as instances of a shared vertex-animated mesh.
+ * An impostor enemy's skeletal mesh is hidden and stops animating; its instance plays the baked cycle
+ * entirely on the GPU, so the only CPU work left is copying moved transforms. LOD decisions are
+ * time-sliced across frames and follow FImpostorLODPolicy.
+ */
+UCLASS()
+class RTP_API UImpostorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	void RegisterEnemy(ABaseEnemy* Enemy, UImpostorAnimationSet* AnimationSet);
+
+	// Stop managing an enemy, restoring its skeletal mesh
+	void UnregisterEnemy(ABaseEnemy* Enemy);
+
+	// Re-evaluate an enemy's representation immediately, e.g. when it starts attacking
+	void EvaluateNow(ABaseEnemy* Enemy);
+
+	bool IsImpostor(const ABaseEnemy* Enemy) const;
+
+	int32 GetNumImpostors() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FImpostorAgent
+	{
+		TWeakObjectPtr<ABaseEnemy> Enemy;
+		UImpostorAnimationSet* AnimationSet = nullptr;
+
+		// Instance in the animation set's batch while rendered as an impostor
+		int32 InstanceIndex = INDEX_NONE;
+		FImpostorAnimState Anim;
+		FTransform LastTransform;
+	};
+
+	struct FImpostorBatch
+	{
+		UInstancedStaticMeshComponent* Instances = nullptr;
+		FImpostorInstanceTable Table;
+	};
+
+	static FImpostorLODSettings GetSettings();
+
+	// View location the LOD distances are measured from, false without a local player
+	bool GetViewLocation(FVector& OutLocation) const;
+
+	// Shared instanced mesh for an animation set, created on first use
+	FImpostorBatch& FindOrAddBatch(UImpostorAnimationSet* AnimationSet);
+
+	void EvaluateAgent(int32 AgentId, const FVector& ViewLocation, const FImpostorLODSettings& Settings, float Time);
+
+	void SwitchToImpostor(int32 AgentId, const FImpostorLODSettings& Settings, float Time);
+
+	void SwitchToSkeletal(int32 AgentId);
+
+	// Remove an agent's instance, moving the batch's last instance into its slot
+	void RemoveInstance(FImpostorAgent& Agent);
+
+	// Pick the clip and play rate for the enemy's speed, only touching the instance when they change noticeably
+	void UpdateAnimation(FImpostorAgent& Agent, const FImpostorLODSettings& Settings, float Time);
+
+	void WriteCustomData(const FImpostorAgent& Agent);
+
+	// Copy moved impostor transforms to their instances
+	void SyncTransforms();
+
+	// Owner of the instanced mesh components
+	UPROPERTY()
+	AActor* ImpostorActor = nullptr;
+
+	UPROPERTY()
+	TArray<UInstancedStaticMeshComponent*> BatchComponents;
+
+	UPROPERTY()
+	TArray<UImpostorAnimationSet*> BatchAnimationSets;
+
+	TMap<UImpostorAnimationSet*, FImpostorBatch> Batches;
+
+	TSparseArray<FImpostorAgent> Agents;
+	TMap<ABaseEnemy*, int32> AgentIds;
+
+	// Next agent id to evaluate, agents are visited round robin within the per-frame budget
+	int32 EvaluationCursor = 0;
+};
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MovementLOD.h"
+#include "MovementLODSubsystem.generated.h"
+
+class ABaseEnemy;
+
+/**
+ * Scales enemy character movement with distance to the players.
+ * Nearby and fighting enemies walk with the full simulation, distant ones NavWalk along the navmesh
+ * at a reduced tick rate without floor sweeps, and far idle ones stop simulating movement entirely.
+ * Tiers follow FMovementLODPolicy and are re-evaluated time-sliced across frames.
+ */
+UCLASS()
+class RTP_API UMovementLODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	void RegisterEnemy(ABaseEnemy* Enemy);
+
+	// Stop managing an enemy, restoring full movement
+	void UnregisterEnemy(ABaseEnemy* Enemy);
+
+	// Re-evaluate an enemy's tier immediately, e.g. when it enters combat
+	void EvaluateNow(ABaseEnemy* Enemy);
+
+	EEnemyMovementLOD GetMovementLOD(const ABaseEnemy* Enemy) const;
+
+	// Compare average frame time with the LOD disabled and enabled over the given number of frames each
+	void StartMeasurement(int32 FramesPerPhase);
+
+	// Log how many enemies are in each tier
+	void LogTiers() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FMovementAgent
+	{
+		TWeakObjectPtr<ABaseEnemy> Enemy;
+		EEnemyMovementLOD LOD = EEnemyMovementLOD::Full;
+	};
+
+	struct FMeasurement
+	{
+		// Frames left in the current phase, the disabled phase runs first
+		int32 FramesRemaining = 0;
+		int32 FramesPerPhase = 0;
+		bool bLODPhase = false;
+		double Seconds[2] = { 0.0, 0.0 };
+	};
+
+	static FMovementLODSettings GetSettings();
+
+	bool IsLODEnabled() const;
+
+	// Locations of every player pawn, false when there are none
+	bool GetPlayerLocations(TArray<FVector, TInlineAllocator<4>>& OutLocations) const;
+
+	void EvaluateAgent(FMovementAgent& Agent, TConstArrayView<FVector> PlayerLocations, const FMovementLODSettings& Settings);
+
+	void ApplyLOD(FMovementAgent& Agent, EEnemyMovementLOD NewLOD);
+
+	void UpdateMeasurement();
+
+	TSparseArray<FMovementAgent> Agents;
+	TMap<ABaseEnemy*, int32> AgentIds;
+
+	// Number of agents in each tier
+	int32 NumPerLOD[3] = { 0, 0, 0 };
+
+	// Next agent id to evaluate, agents are visited round robin within the per-frame budget
+	int32 EvaluationCursor = 0;
+
+	FMeasurement Measurement;
+};
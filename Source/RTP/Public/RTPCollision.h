@@ -0,0 +1,16 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Trace channel used for enemy line of sight, registered as "AISight" in Config/DefaultEngine.ini
+#define ECC_AISight ECC_GameTraceChannel1
+
+// Object channel for enemy capsules, so enemies can ignore each other while still blocking the player and the world.
+// Registered as "Enemy" with the "Enemy" collision profile in Config/DefaultEngine.ini. Enemy capsules are no longer
+// ECC_Pawn objects: a query by object type that should find enemies must ask for ECC_Enemy as well as ECC_Pawn
+#define ECC_Enemy ECC_GameTraceChannel2
+
+// Collision profile of enemy capsules, Pawn responses on the ECC_Enemy object type
+#define RTP_ENEMY_COLLISION_PROFILE TEXT("Enemy")
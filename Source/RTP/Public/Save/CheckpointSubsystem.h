@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "Save/CheckpointTypes.h"
+#include "CheckpointSubsystem.generated.h"
+
+class ABaseEnemy;
+
+DECLARE_STATS_GROUP(TEXT("RTP Save"), STATGROUP_RTPSave, STATCAT_Advanced);
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnCheckpointCompleted, bool, bSuccess);
+
+// Timings of the last save and load, in milliseconds
+USTRUCT(BlueprintType)
+struct RTP_API FCheckpointStats
+{
+	GENERATED_BODY()
+
+	// Game thread time spent copying the snapshot
+	UPROPERTY(BlueprintReadOnly, Category = "Save")
+	float CaptureMs = 0.0f;
+
+	// Background time spent serializing, compressing and writing
+	UPROPERTY(BlueprintReadOnly, Category = "Save")
+	float WriteMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Save")
+	int32 RawBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Save")
+	int32 CompressedBytes = 0;
+
+	// Background time spent reading, decompressing and deserializing
+	UPROPERTY(BlueprintReadOnly, Category = "Save")
+	float ReadMs = 0.0f;
+
+	// Game thread time spent applying the snapshot, summed over all frames
+	UPROPERTY(BlueprintReadOnly, Category = "Save")
+	float ApplyMs = 0.0f;
+
+	// Frames the apply was spread over
+	UPROPERTY(BlueprintReadOnly, Category = "Save")
+	int32 ApplyFrames = 0;
+};
+
+/**
+ * Checkpoint save and load for the player and every enemy.
+ * Saving copies a plain snapshot on the game thread and hands it to a background task that
+ * serializes, compresses and writes it. Loading reads on a background task and applies the
+ * result a few enemies per frame.
+ */
+UCLASS()
+class RTP_API UCheckpointSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	// Capture the current state and write it in the background, fails if a save or load is in progress
+	UFUNCTION(BlueprintCallable, Category = "Save")
+	bool SaveCheckpoint(const FString& SlotName);
+
+	// Read a checkpoint in the background and apply it over the following frames
+	UFUNCTION(BlueprintCallable, Category = "Save")
+	bool LoadCheckpoint(const FString& SlotName);
+
+	UFUNCTION(BlueprintPure, Category = "Save")
+	bool IsBusy() const { return SaveTask.IsValid() || LoadTask.IsValid() || bApplying; }
+
+	UFUNCTION(BlueprintPure, Category = "Save")
+	const FCheckpointStats& GetStats() const { return Stats; }
+
+	// Copy the player and every enemy into a snapshot, game thread only
+	void CaptureSnapshot(FCheckpointSnapshot& OutSnapshot) const;
+
+	// Full path of a checkpoint slot on disk
+	static FString GetSlotPath(const FString& SlotName);
+
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnCheckpointCompleted OnSaveCompleted;
+
+	// Broadcast once the whole snapshot has been applied
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnCheckpointCompleted OnLoadCompleted;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FWriteResult
+	{
+		bool bSuccess = false;
+		int32 RawBytes = 0;
+		int32 CompressedBytes = 0;
+		double Seconds = 0.0;
+	};
+
+	struct FReadResult
+	{
+		bool bSuccess = false;
+		double Seconds = 0.0;
+		FCheckpointSnapshot Snapshot;
+	};
+
+	// Background work, no UObject access
+	static FWriteResult WriteSnapshot(FCheckpointSnapshot& Snapshot, const FString& Path);
+	static FReadResult ReadSnapshot(const FString& Path);
+
+	void FinishSave();
+	void BeginApply(FCheckpointSnapshot&& Snapshot);
+
+	// Apply the player and the next batch of enemies, returns true once everything is applied
+	bool ApplyNextBatch();
+
+	// Spawn a fresh enemy of the saved class in place of one that died or was removed since the save
+	ABaseEnemy* RespawnEnemy(const FEnemyCheckpoint& Checkpoint);
+
+	void FinishApply(bool bSuccess);
+
+	UE::Tasks::TTask<FWriteResult> SaveTask;
+	UE::Tasks::TTask<FReadResult> LoadTask;
+
+	// Snapshot being applied and the enemies it maps to
+	FCheckpointSnapshot PendingSnapshot;
+	TMap<FGuid, TWeakObjectPtr<ABaseEnemy>> PendingEnemies;
+	int32 NextEnemyIndex = 0;
+	bool bApplying = false;
+
+	FCheckpointStats Stats;
+};
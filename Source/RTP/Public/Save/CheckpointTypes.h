@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Bump when the layout of the checkpoint records changes, older files are rejected
+constexpr uint32 RTPCheckpointVersion = 2;
+
+// Plain copy of one enemy's saved state, captured on the game thread without touching UObject serialization
+struct FEnemyCheckpoint
+{
+    // Matched back up with ABaseEnemy::GetEnemyId, which survives level reloads
+    FGuid EnemyId;
+    
+    // Class path used to respawn the enemy when it has died or been removed since the save
+    FString EnemyClass;
+    
+    FVector Location = FVector::ZeroVector;
+    FRotator Rotation = FRotator::ZeroRotator;
+    FVector LastKnownPlayerLocation = FVector::ZeroVector;
+    float Health = 0.0f;
+    uint8 State = 0;
+    
+    // Remaining time on the stun or lose-sight timer, 0 when inactive
+    float StateTimerRemaining = 0.0f;
+    
+    // Remaining attack cooldown, 0 when the enemy can attack
+    float AttackCooldownRemaining = 0.0f;
+    
+    int32 RandomSeed = 0;
+
+    friend FArchive& operator<<(FArchive& Ar, FEnemyCheckpoint& Checkpoint)
+    {
+        Ar << Checkpoint.EnemyId;
+        Ar << Checkpoint.EnemyClass;
+        Ar << Checkpoint.Location;
+        Ar << Checkpoint.Rotation;
+        Ar << Checkpoint.LastKnownPlayerLocation;
+        Ar << Checkpoint.Health;
+        Ar << Checkpoint.State;
+        Ar << Checkpoint.StateTimerRemaining;
+        Ar << Checkpoint.AttackCooldownRemaining;
+        Ar << Checkpoint.RandomSeed;
+        return Ar;
+    }
+};
+
+// Plain copy of the player's saved state
+struct FPlayerCheckpoint
+{
+    FVector Location = FVector::ZeroVector;
+    FRotator ControlRotation = FRotator::ZeroRotator;
+    float Health = 0.0f;
+    float Stamina = 0.0f;
+    float Battery = 0.0f;
+    uint8 FlashlightMode = 0;
+
+    friend FArchive& operator<<(FArchive& Ar, FPlayerCheckpoint& Checkpoint)
+    {
+        Ar << Checkpoint.Location;
+        Ar << Checkpoint.ControlRotation;
+        Ar << Checkpoint.Health;
+        Ar << Checkpoint.Stamina;
+        Ar << Checkpoint.Battery;
+        Ar << Checkpoint.FlashlightMode;
+        return Ar;
+    }
+};
+
+// Everything a checkpoint restores, owned by value so it can be handed to a background task
+struct FCheckpointSnapshot
+{
+    uint32 Version = RTPCheckpointVersion;
+    bool bHasPlayer = false;
+    FPlayerCheckpoint Player;
+    TArray<FEnemyCheckpoint> Enemies;
+
+    friend FArchive& operator<<(FArchive& Ar, FCheckpointSnapshot& Snapshot)
+    {
+        Ar << Snapshot.Version;
+        if (Snapshot.Version != RTPCheckpointVersion)
+        {
+            Ar.SetError();
+            return Ar;
+        }
+        
+        Ar << Snapshot.bHasPlayer;
+        Ar << Snapshot.Player;
+        Ar << Snapshot.Enemies;
+        return Ar;
+    }
+};
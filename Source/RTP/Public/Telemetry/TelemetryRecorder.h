@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+// Set to 0 to compile every telemetry call site out
+#ifndef RTP_WITH_TELEMETRY
+#define RTP_WITH_TELEMETRY 1
+#endif
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+
+// Gameplay events captured by the recorder, stored as uint16 in the file so only append new values
+enum class ETelemetryEventType : uint16
+{
+    // Payload: previous state << 8 | new state
+    EnemyStateChanged,
+    PlayerSighted,
+    EnemyAttack,
+    // Payload: stun duration in milliseconds
+    EnemyStunned,
+    EnemyDied,
+    // Payload: new flashlight mode
+    FlashlightModeChanged
+};
+
+// One fixed-size record, written to the file as-is
+struct FTelemetryEvent
+{
+    // FPlatformTime::Cycles64() when the event was recorded
+    uint64 Cycles;
+    // Actor unique id of the enemy or player
+    uint32 SubjectId;
+    ETelemetryEventType Type;
+    uint16 Reserved;
+    FVector3f Location;
+    uint32 Payload;
+};
+static_assert(sizeof(FTelemetryEvent) == 32, "Telemetry records are written to disk verbatim");
+
+// File header, followed by FTelemetryEvent records until the end of the file
+struct FTelemetryFileHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    // Cycle count and wall clock at the start of the session, to turn record cycles into time
+    uint64 StartCycles;
+    double SecondsPerCycle;
+    int64 StartUtcTicks;
+};
+
+constexpr uint32 TelemetryFileMagic = 0x4C455452; // "RTEL"
+constexpr uint32 TelemetryFileVersion = 1;
+
+/**
+ * Low-overhead gameplay event recorder.
+ * Each thread writes into its own single-producer ring buffer without locks or allocations,
+ * and a background thread drains every ring into a binary file. Events are dropped, and
+ * counted, when a ring is full.
+ */
+class RTP_API FTelemetryRecorder : public FRunnable
+{
+public:
+    static FTelemetryRecorder& Get();
+
+    // Start a session writing to the given file, or Saved/Telemetry/<timestamp>.rtptel when empty
+    bool StartSession(const FString& FilePath = FString());
+
+    // Flush everything recorded so far and close the file
+    void StopSession();
+
+    static bool IsRecording() { return bRecording.load(std::memory_order_relaxed); }
+
+    // Record an event on the calling thread, does nothing unless a session is running
+    static void Record(ETelemetryEventType Type, uint32 SubjectId, const FVector& Location, uint32 Payload = 0)
+    {
+        if (IsRecording())
+        {
+            Get().RecordEvent(Type, SubjectId, Location, Payload);
+        }
+    }
+
+    uint64 GetNumRecorded() const { return NumWritten.load(std::memory_order_relaxed); }
+    uint64 GetNumDropped() const;
+
+    // FRunnable, the flush thread
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FThreadBuffer;
+
+    FTelemetryRecorder() = default;
+    virtual ~FTelemetryRecorder() override;
+
+    void RecordEvent(ETelemetryEventType Type, uint32 SubjectId, const FVector& Location, uint32 Payload);
+
+    // The calling thread's ring, created on first use
+    FThreadBuffer& GetThreadBuffer();
+
+    // Move everything currently queued to the file, flush thread or StopSession() only
+    void Drain();
+
+    // Block until no thread is part way through recording an event, after recording was switched off
+    void WaitForWriters() const;
+
+    static std::atomic<bool> bRecording;
+
+    // Guards buffer registration and draining, never taken on the recording fast path
+    mutable FCriticalSection BuffersLock;
+    TArray<TUniquePtr<FThreadBuffer>> Buffers;
+
+    FRunnableThread* FlushThread = nullptr;
+    FEvent* FlushEvent = nullptr;
+    std::atomic<bool> bStopRequested{false};
+
+    TUniquePtr<IFileHandle> FileHandle;
+    TArray<FTelemetryEvent> DrainScratch;
+    std::atomic<uint64> NumWritten{0};
+};
+
+#if RTP_WITH_TELEMETRY
+#define RTP_TELEMETRY(Type, Subject, Location, ...) FTelemetryRecorder::Record(ETelemetryEventType::Type, (Subject)->GetUniqueID(), Location, ##__VA_ARGS__)
+#else
+#define RTP_TELEMETRY(...)
+#endif
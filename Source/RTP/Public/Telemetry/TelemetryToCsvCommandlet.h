@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TelemetryToCsvCommandlet.generated.h"
+
+/**
+ * Converts a binary telemetry recording to CSV.
+ * Usage: -run=TelemetryToCsv -In=<file.rtptel> [-Out=<file.csv>]
+ */
+UCLASS()
+class RTP_API UTelemetryToCsvCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UTelemetryToCsvCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
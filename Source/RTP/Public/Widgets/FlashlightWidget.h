@@ -4,11 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "Blueprint/UserWidget.h"
-#include "Characters/PlayerCharacter.h" // Added to access flashlight enums
+#include "Components/FlashlightComponent.h" // Added to access flashlight enums
 #include "FlashlightWidget.generated.h"
 
 class UTextBlock;
 class UProgressBar;
+class UPlayerHUDViewModel;
 
 /**
  * 
@@ -25,7 +26,20 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "UI")
 	void UpdateFlashlightMode(EFlashlightMode CurrentMode);
 
+	// Subscribe to battery and mode changes, the widget is then only updated when a displayed value changes
+	UFUNCTION(BlueprintCallable, Category = "UI")
+	void SetViewModel(UPlayerHUDViewModel* InViewModel);
+
 protected:
+	UFUNCTION()
+	void HandleBatteryChanged(int32 Percent);
+
+	UFUNCTION()
+	void HandleFlashlightModeChanged(EFlashlightMode NewMode);
+
+	UPROPERTY()
+	UPlayerHUDViewModel* ViewModel;
+
 	UPROPERTY(meta = (BindWidget))
 	UProgressBar* BatteryProgressBar;
 	
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Components/FlashlightComponent.h"
+#include "PlayerHUDViewModel.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHUDPercentChanged, int32, Percent);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHUDFlashlightModeChanged, EFlashlightMode, NewMode);
+
+/**
+ * Values displayed by the player HUD, quantized to whole percents.
+ * Widgets subscribe to the change events and are only touched when a displayed value changes.
+ */
+UCLASS(BlueprintType)
+class RTP_API UPlayerHUDViewModel : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	// Set stamina as a 0-1 fraction, notifies only when the displayed percent changes
+	UFUNCTION(BlueprintCallable, Category = "UI")
+	void SetStaminaFraction(float Fraction);
+
+	// Set battery as a 0-1 fraction, notifies only when the displayed percent changes
+	UFUNCTION(BlueprintCallable, Category = "UI")
+	void SetBatteryFraction(float Fraction);
+
+	UFUNCTION(BlueprintCallable, Category = "UI")
+	void SetFlashlightMode(EFlashlightMode NewMode);
+
+	UFUNCTION(BlueprintPure, Category = "UI")
+	int32 GetStaminaPercent() const { return StaminaPercent; }
+
+	UFUNCTION(BlueprintPure, Category = "UI")
+	int32 GetBatteryPercent() const { return BatteryPercent; }
+
+	UFUNCTION(BlueprintPure, Category = "UI")
+	EFlashlightMode GetFlashlightMode() const { return FlashlightMode; }
+
+	// Pre-built "Stamina: N%" text
+	static const FText& GetStaminaText(int32 Percent);
+
+	// Pre-built "Battery: N%" text
+	static const FText& GetBatteryText(int32 Percent);
+
+	// Pre-built "Mode: X" text
+	static const FText& GetFlashlightModeText(EFlashlightMode Mode);
+
+	// Convert a 0-1 fraction to the whole percent shown on the HUD
+	static int32 QuantizePercent(float Fraction);
+
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnHUDPercentChanged OnStaminaChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnHUDPercentChanged OnBatteryChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "Events")
+	FOnHUDFlashlightModeChanged OnFlashlightModeChanged;
+
+private:
+	int32 StaminaPercent = 100;
+	int32 BatteryPercent = 100;
+	EFlashlightMode FlashlightMode = EFlashlightMode::Off;
+};
@@ -6,6 +6,8 @@
 #include "Blueprint/UserWidget.h"
 #include "StaminaWidget.generated.h"
 
+class UPlayerHUDViewModel;
+
 /**
  * 
  */
@@ -18,10 +20,20 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "UI")
 	void UpdateStaminaBar(float StaminaPercent);
 
+	// Subscribe to stamina changes, the widget is then only updated when the displayed percent changes
+	UFUNCTION(BlueprintCallable, Category = "UI")
+	void SetViewModel(UPlayerHUDViewModel* InViewModel);
+
 protected:
+	UFUNCTION()
+	void HandleStaminaChanged(int32 Percent);
+
 	UPROPERTY(meta = (BindWidget))
 	class UProgressBar* StaminaProgressBar;
 
 	UPROPERTY(meta = (BindWidget))
 	class UTextBlock* StaminaText;
+
+	UPROPERTY()
+	UPlayerHUDViewModel* ViewModel;
 };
@@ -3,4 +3,6 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "RTPCollision.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogRTP, Log, All);
@@ -11,5 +11,6 @@ public class RTPEditorTarget : TargetRules
 		DefaultBuildSettings = BuildSettingsVersion.V5;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_5;
 		ExtraModuleNames.Add("RTP");
+		ExtraModuleNames.Add("RTPEditor");
 	}
 }
@@ -0,0 +1,332 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BakeImpostorCommandlet.h"
+#include "Enemies/ImpostorAnimationSet.h"
+#include "Animation/AnimSequence.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInterface.h"
+#include "MeshDescription.h"
+#include "Misc/PackageName.h"
+#include "Rendering/SkeletalMeshRenderData.h"
+#include "StaticMeshAttributes.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "RTPEditor.h"
+
+namespace
+{
+    // Widest texture row, meshes with more vertices wrap onto several rows per frame
+    constexpr int32 MaxTextureWidth = 4096;
+    constexpr int32 MaxTextureHeight = 16384;
+    
+    bool SavePackage(UPackage* Package, UObject* Asset)
+    {
+        Package->MarkPackageDirty();
+        const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+        FSavePackageArgs SaveArgs;
+        SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+        if (!UPackage::SavePackage(Package, Asset, *Filename, SaveArgs))
+        {
+            UE_LOG(LogRTPEditor, Error, TEXT("Could not save %s"), *Filename);
+            return false;
+        }
+        return true;
+    }
+    
+    UTexture2D* CreateDataTexture(const FString& PackagePath, int32 Width, int32 Height, const TArray<FFloat16Color>& Texels)
+    {
+        UPackage* Package = CreatePackage(*PackagePath);
+        UTexture2D* Texture = NewObject<UTexture2D>(Package, *FPackageName::GetShortName(PackagePath), RF_Public | RF_Standalone);
+        Texture->Source.Init(Width, Height, 1, 1, TSF_RGBA16F, reinterpret_cast<const uint8*>(Texels.GetData()));
+        
+        // Raw data read per vertex: no compression, filtering, mips, sRGB or streaming
+        Texture->CompressionSettings = TC_HDR;
+        Texture->SRGB = false;
+        Texture->Filter = TF_Nearest;
+        Texture->MipGenSettings = TMGS_NoMipmaps;
+        Texture->NeverStream = true;
+        Texture->PostEditChange();
+        
+        return SavePackage(Package, Texture) ? Texture : nullptr;
+    }
+}
+
+UBakeImpostorCommandlet::UBakeImpostorCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+}
+
+int32 UBakeImpostorCommandlet::Main(const FString& Params)
+{
+    FString MeshPath;
+    FString OutPath;
+    FString ClipPaths[static_cast<int32>(EImpostorClip::Num)];
+    if (!FParse::Value(*Params, TEXT("Mesh="), MeshPath)
+        || !FParse::Value(*Params, TEXT("Idle="), ClipPaths[static_cast<int32>(EImpostorClip::Idle)])
+        || !FParse::Value(*Params, TEXT("Walk="), ClipPaths[static_cast<int32>(EImpostorClip::Walk)])
+        || !FParse::Value(*Params, TEXT("Run="), ClipPaths[static_cast<int32>(EImpostorClip::Run)])
+        || !FParse::Value(*Params, TEXT("Out="), OutPath))
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("Usage: -run=BakeImpostor -Mesh=<SkeletalMesh> -Idle=<Anim> -Walk=<Anim> -Run=<Anim> -Out=<PackagePath> [-Material=<Material>] [-LOD=1] [-SampleRate=15] [-WalkSpeed=150] [-RunSpeed=450]"));
+        return 1;
+    }
+    
+    int32 LODIndex = 1;
+    float SampleRate = 15.0f;
+    float WalkSpeed = 150.0f;
+    float RunSpeed = 450.0f;
+    FString MaterialPath;
+    FParse::Value(*Params, TEXT("LOD="), LODIndex);
+    FParse::Value(*Params, TEXT("SampleRate="), SampleRate);
+    FParse::Value(*Params, TEXT("WalkSpeed="), WalkSpeed);
+    FParse::Value(*Params, TEXT("RunSpeed="), RunSpeed);
+    FParse::Value(*Params, TEXT("Material="), MaterialPath);
+    SampleRate = FMath::Clamp(SampleRate, 1.0f, 60.0f);
+    
+    USkeletalMesh* SkeletalMesh = LoadObject<USkeletalMesh>(nullptr, *MeshPath);
+    if (!SkeletalMesh)
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("Could not load skeletal mesh %s"), *MeshPath);
+        return 1;
+    }
+    
+    UAnimSequence* Clips[static_cast<int32>(EImpostorClip::Num)];
+    for (int32 ClipIndex = 0; ClipIndex < static_cast<int32>(EImpostorClip::Num); ++ClipIndex)
+    {
+        Clips[ClipIndex] = LoadObject<UAnimSequence>(nullptr, *ClipPaths[ClipIndex]);
+        if (!Clips[ClipIndex])
+        {
+            UE_LOG(LogRTPEditor, Error, TEXT("Could not load animation %s"), *ClipPaths[ClipIndex]);
+            return 1;
+        }
+    }
+    
+    UMaterialInterface* Material = MaterialPath.IsEmpty() ? nullptr : LoadObject<UMaterialInterface>(nullptr, *MaterialPath);
+    
+    // Impostors are only seen from afar, bake one of the reduced LODs
+    const FSkeletalMeshRenderData* RenderData = SkeletalMesh->GetResourceForRendering();
+    LODIndex = FMath::Clamp(LODIndex, 0, RenderData->LODRenderData.Num() - 1);
+    const FSkeletalMeshLODRenderData& LODData = RenderData->LODRenderData[LODIndex];
+    const FPositionVertexBuffer& PositionBuffer = LODData.StaticVertexBuffers.PositionVertexBuffer;
+    const FStaticMeshVertexBuffer& VertexBuffer = LODData.StaticVertexBuffers.StaticMeshVertexBuffer;
+    const FSkinWeightVertexBuffer& SkinWeights = *LODData.GetSkinWeightVertexBuffer();
+    const int32 NumVertices = LODData.GetNumVertices();
+    if (NumVertices == 0)
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("%s has no vertices in LOD %d"), *MeshPath, LODIndex);
+        return 1;
+    }
+    
+    const int32 TextureWidth = FMath::Min(NumVertices, MaxTextureWidth);
+    const int32 RowsPerFrame = FMath::DivideAndRoundUp(NumVertices, TextureWidth);
+    
+    UPackage* SetPackage = CreatePackage(*OutPath);
+    UImpostorAnimationSet* AnimationSet = NewObject<UImpostorAnimationSet>(SetPackage, *FPackageName::GetShortName(OutPath), RF_Public | RF_Standalone);
+    AnimationSet->Material = Material;
+    AnimationSet->SampleRate = SampleRate;
+    AnimationSet->RowsPerFrame = RowsPerFrame;
+    
+    int32 TotalFrames = 0;
+    for (int32 ClipIndex = 0; ClipIndex < static_cast<int32>(EImpostorClip::Num); ++ClipIndex)
+    {
+        // Looping cycles, the last frame would duplicate the first
+        FImpostorClipInfo& ClipInfo = AnimationSet->Clips[ClipIndex];
+        ClipInfo.StartFrame = TotalFrames;
+        ClipInfo.NumFrames = FMath::Max(1, FMath::RoundToInt32(Clips[ClipIndex]->GetPlayLength() * SampleRate));
+        TotalFrames += ClipInfo.NumFrames;
+    }
+    AnimationSet->Clips[static_cast<int32>(EImpostorClip::Walk)].ReferenceSpeed = WalkSpeed;
+    AnimationSet->Clips[static_cast<int32>(EImpostorClip::Run)].ReferenceSpeed = RunSpeed;
+    
+    const int32 TextureHeight = TotalFrames * RowsPerFrame;
+    if (TextureHeight > MaxTextureHeight)
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("%d frames of %d vertices need %d texture rows, lower -SampleRate or bake a smaller -LOD"), TotalFrames, NumVertices, TextureHeight);
+        return 1;
+    }
+    AnimationSet->TextureHeight = TextureHeight;
+    
+    // Each vertex's section bone map translates its skin weight indices into mesh bones
+    TArray<const TArray<FBoneIndexType>*> VertexBoneMaps;
+    VertexBoneMaps.SetNumZeroed(NumVertices);
+    for (const FSkelMeshRenderSection& Section : LODData.RenderSections)
+    {
+        for (uint32 Vertex = 0; Vertex < Section.NumVertices; ++Vertex)
+        {
+            VertexBoneMaps[Section.BaseVertexIndex + Vertex] = &Section.BoneMap;
+        }
+    }
+    
+    // Poses come from a skeletal mesh component evaluated synchronously in a preview world
+    UWorld* World = UWorld::CreateWorld(EWorldType::EditorPreview, false);
+    USkeletalMeshComponent* Component = NewObject<USkeletalMeshComponent>(World);
+    Component->SetSkeletalMesh(SkeletalMesh);
+    Component->SetForcedLOD(1);
+    Component->bEnableUpdateRateOptimizations = false;
+    Component->RegisterComponentWithWorld(World);
+    Component->SetAnimationMode(EAnimationMode::AnimationSingleNode);
+    
+    const TArray<FMatrix44f>& RefBasesInvMatrix = SkeletalMesh->GetRefBasesInvMatrix();
+    TArray<FMatrix44f> RefToLocals;
+    RefToLocals.SetNumUninitialized(RefBasesInvMatrix.Num());
+    
+    TArray<FFloat16Color> PositionTexels;
+    TArray<FFloat16Color> NormalTexels;
+    PositionTexels.SetNumZeroed(TextureWidth * TextureHeight);
+    NormalTexels.SetNumZeroed(TextureWidth * TextureHeight);
+    
+    FBox3f RefBounds(ForceInit);
+    FBox3f AnimatedBounds(ForceInit);
+    for (int32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+    {
+        RefBounds += PositionBuffer.VertexPosition(Vertex);
+    }
+    
+    const uint32 MaxInfluences = SkinWeights.GetMaxBoneInfluences();
+    
+    for (int32 ClipIndex = 0; ClipIndex < static_cast<int32>(EImpostorClip::Num); ++ClipIndex)
+    {
+        const FImpostorClipInfo& ClipInfo = AnimationSet->Clips[ClipIndex];
+        Component->SetAnimation(Clips[ClipIndex]);
+        
+        for (int32 Frame = 0; Frame < ClipInfo.NumFrames; ++Frame)
+        {
+            Component->SetPosition(Frame / SampleRate, false);
+            Component->TickAnimation(0.0f, false);
+            Component->RefreshBoneTransforms();
+            
+            const TArray<FTransform>& ComponentSpace = Component->GetComponentSpaceTransforms();
+            for (int32 BoneIndex = 0; BoneIndex < RefToLocals.Num(); ++BoneIndex)
+            {
+                RefToLocals[BoneIndex] = RefBasesInvMatrix[BoneIndex] * FMatrix44f(ComponentSpace[BoneIndex].ToMatrixWithScale());
+            }
+            
+            const int32 FrameRow = (ClipInfo.StartFrame + Frame) * RowsPerFrame;
+            for (int32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+            {
+                const FVector3f RefPosition = PositionBuffer.VertexPosition(Vertex);
+                const FVector3f RefNormal = VertexBuffer.VertexTangentZ(Vertex);
+                
+                // Linear blend skinning on the CPU, weights normalized whatever their bit depth
+                FVector3f Position = FVector3f::ZeroVector;
+                FVector3f Normal = FVector3f::ZeroVector;
+                float TotalWeight = 0.0f;
+                for (uint32 Influence = 0; Influence < MaxInfluences; ++Influence)
+                {
+                    const float Weight = SkinWeights.GetBoneWeight(Vertex, Influence);
+                    if (Weight > 0.0f)
+                    {
+                        const FMatrix44f& RefToLocal = RefToLocals[(*VertexBoneMaps[Vertex])[SkinWeights.GetBoneIndex(Vertex, Influence)]];
+                        Position += RefToLocal.TransformPosition(RefPosition) * Weight;
+                        Normal += RefToLocal.TransformVector(RefNormal) * Weight;
+                        TotalWeight += Weight;
+                    }
+                }
+                Position = TotalWeight > 0.0f ? Position / TotalWeight : RefPosition;
+                Normal = TotalWeight > 0.0f ? Normal.GetSafeNormal() : RefNormal;
+                AnimatedBounds += Position;
+                
+                const int32 Texel = (FrameRow + Vertex / TextureWidth) * TextureWidth + Vertex % TextureWidth;
+                const FVector3f Offset = Position - RefPosition;
+                PositionTexels[Texel] = FFloat16Color(FLinearColor(Offset.X, Offset.Y, Offset.Z, 1.0f));
+                NormalTexels[Texel] = FFloat16Color(FLinearColor(Normal.X, Normal.Y, Normal.Z, 0.0f));
+            }
+        }
+    }
+    
+    Component->UnregisterComponent();
+    World->DestroyWorld(false);
+    
+    const FString OutDirectory = FPackageName::GetLongPackagePath(OutPath);
+    const FString BaseName = FPackageName::GetShortName(OutPath);
+    AnimationSet->PositionTexture = CreateDataTexture(OutDirectory / (BaseName + TEXT("_Position")), TextureWidth, TextureHeight, PositionTexels);
+    AnimationSet->NormalTexture = CreateDataTexture(OutDirectory / (BaseName + TEXT("_Normal")), TextureWidth, TextureHeight, NormalTexels);
+    if (!AnimationSet->PositionTexture || !AnimationSet->NormalTexture)
+    {
+        return 1;
+    }
+    
+    // Reference pose mesh whose second UV channel holds each vertex's texel column and row within a frame
+    FMeshDescription MeshDescription;
+    FStaticMeshAttributes Attributes(MeshDescription);
+    Attributes.Register();
+    TVertexAttributesRef<FVector3f> VertexPositions = Attributes.GetVertexPositions();
+    TVertexInstanceAttributesRef<FVector3f> InstanceNormals = Attributes.GetVertexInstanceNormals();
+    TVertexInstanceAttributesRef<FVector2f> InstanceUVs = Attributes.GetVertexInstanceUVs();
+    InstanceUVs.SetNumChannels(2);
+    
+    MeshDescription.ReserveNewVertices(NumVertices);
+    MeshDescription.ReserveNewVertexInstances(NumVertices);
+    TArray<FVertexInstanceID> VertexInstances;
+    VertexInstances.Reserve(NumVertices);
+    for (int32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+    {
+        const FVertexID VertexID = MeshDescription.CreateVertex();
+        VertexPositions[VertexID] = PositionBuffer.VertexPosition(Vertex);
+        
+        const FVertexInstanceID InstanceID = MeshDescription.CreateVertexInstance(VertexID);
+        InstanceNormals[InstanceID] = VertexBuffer.VertexTangentZ(Vertex);
+        InstanceUVs.Set(InstanceID, 0, VertexBuffer.GetVertexUV(Vertex, 0));
+        InstanceUVs.Set(InstanceID, 1, FVector2f((Vertex % TextureWidth + 0.5f) / TextureWidth, static_cast<float>(Vertex / TextureWidth)));
+        VertexInstances.Add(InstanceID);
+    }
+    
+    const FPolygonGroupID PolygonGroup = MeshDescription.CreatePolygonGroup();
+    Attributes.GetPolygonGroupMaterialSlotNames()[PolygonGroup] = TEXT("Impostor");
+    
+    const FRawStaticIndexBuffer16or32Interface* IndexBuffer = LODData.MultiSizeIndexContainer.GetIndexBuffer();
+    for (const FSkelMeshRenderSection& Section : LODData.RenderSections)
+    {
+        for (uint32 Triangle = 0; Triangle < Section.NumTriangles; ++Triangle)
+        {
+            const uint32 FirstIndex = Section.BaseIndex + Triangle * 3;
+            const FVertexInstanceID Corners[3] =
+            {
+                VertexInstances[IndexBuffer->Get(FirstIndex)],
+                VertexInstances[IndexBuffer->Get(FirstIndex + 1)],
+                VertexInstances[IndexBuffer->Get(FirstIndex + 2)]
+            };
+            MeshDescription.CreateTriangle(PolygonGroup, Corners);
+        }
+    }
+    
+    const FString MeshPackagePath = OutDirectory / (BaseName + TEXT("_Mesh"));
+    UPackage* MeshPackage = CreatePackage(*MeshPackagePath);
+    UStaticMesh* StaticMesh = NewObject<UStaticMesh>(MeshPackage, *FPackageName::GetShortName(MeshPackagePath), RF_Public | RF_Standalone);
+    StaticMesh->GetStaticMaterials().Add(FStaticMaterial(Material, TEXT("Impostor"), TEXT("Impostor")));
+    
+    // Vertices are addressed through UV1, which must survive the build exactly
+    FStaticMeshSourceModel& SourceModel = StaticMesh->AddSourceModel();
+    SourceModel.BuildSettings.bRecomputeNormals = false;
+    SourceModel.BuildSettings.bRecomputeTangents = true;
+    SourceModel.BuildSettings.bUseFullPrecisionUVs = true;
+    SourceModel.BuildSettings.bRemoveDegenerates = false;
+    SourceModel.BuildSettings.bGenerateLightmapUVs = false;
+    
+    *StaticMesh->CreateMeshDescription(0) = MoveTemp(MeshDescription);
+    StaticMesh->CommitMeshDescription(0);
+    
+    // The animated vertices leave the reference pose bounds
+    StaticMesh->SetPositiveBoundsExtension(FVector(FVector3f::Max(AnimatedBounds.Max - RefBounds.Max, FVector3f::ZeroVector)));
+    StaticMesh->SetNegativeBoundsExtension(FVector(FVector3f::Max(RefBounds.Min - AnimatedBounds.Min, FVector3f::ZeroVector)));
+    StaticMesh->Build(true);
+    StaticMesh->PostEditChange();
+    
+    if (!SavePackage(MeshPackage, StaticMesh))
+    {
+        return 1;
+    }
+    AnimationSet->Mesh = StaticMesh;
+    
+    UE_LOG(LogRTPEditor, Display, TEXT("Baked %d frames of %d vertices (LOD %d) into %dx%d textures"), TotalFrames, NumVertices, LODIndex, TextureWidth, TextureHeight);
+    
+    return SavePackage(SetPackage, AnimationSet) ? 0 : 1;
+}
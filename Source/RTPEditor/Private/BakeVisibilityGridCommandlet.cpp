@@ -0,0 +1,188 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BakeVisibilityGridCommandlet.h"
+#include "AI/AISightSubsystem.h"
+#include "AI/VisibilityGridAsset.h"
+#include "AI/VisibilityGridSubsystem.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "RTPCollision.h"
+#include "RTPEditor.h"
+
+UBakeVisibilityGridCommandlet::UBakeVisibilityGridCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+}
+
+int32 UBakeVisibilityGridCommandlet::Main(const FString& Params)
+{
+    FString MapPath;
+    if (!FParse::Value(*Params, TEXT("Map="), MapPath))
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("Usage: -run=BakeVisibilityGrid -Map=/Game/Maps/<Map> [-VoxelSize=50] [-Out=<PackagePath>]"));
+        return 1;
+    }
+    
+    float VoxelSize = 50.0f;
+    FParse::Value(*Params, TEXT("VoxelSize="), VoxelSize);
+    VoxelSize = FMath::Max(VoxelSize, 10.0f);
+    
+    FString OutPath;
+    if (!FParse::Value(*Params, TEXT("Out="), OutPath))
+    {
+        OutPath = UVisibilityGridSubsystem::GetGridPackagePath(FPackageName::GetShortName(MapPath));
+    }
+    
+    UPackage* MapPackage = LoadPackage(nullptr, *MapPath, LOAD_None);
+    UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+    if (!World)
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("Could not load map %s"), *MapPath);
+        return 1;
+    }
+    
+    // Bring the level up with a physics scene so occluders can be queried, nothing else is needed
+    World->WorldType = EWorldType::Editor;
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Editor);
+    WorldContext.SetCurrentWorld(World);
+    World->InitWorld(UWorld::InitializationValues()
+        .CreatePhysicsScene(true)
+        .ShouldSimulatePhysics(false)
+        .EnableTraceCollision(true)
+        .AllowAudioPlayback(false)
+        .RequiresHitProxies(false)
+        .CreateNavigation(false)
+        .CreateAISystem(false));
+    World->UpdateWorldComponents(true, false);
+    
+    // Match runtime sight collision: foliage never blocks, and only static blockers are baked
+    FBox Bounds(ForceInit);
+    for (TActorIterator<AActor> It(World); It; ++It)
+    {
+        TInlineComponentArray<UPrimitiveComponent*> Components(*It);
+        for (UPrimitiveComponent* Component : Components)
+        {
+            UInstancedStaticMeshComponent* Instanced = Cast<UInstancedStaticMeshComponent>(Component);
+            if (Instanced && UAISightSubsystem::IsScatteredComponent(Instanced) && UAISightSubsystem::Classify(Instanced) == EAISightOcclusion::Foliage)
+            {
+                Instanced->SetCollisionResponseToChannel(ECC_AISight, ECR_Ignore);
+                continue;
+            }
+            
+            if (Component->Mobility == EComponentMobility::Static
+                && Component->IsQueryCollisionEnabled()
+                && Component->GetCollisionResponseToChannel(ECC_AISight) == ECR_Block)
+            {
+                Bounds += Component->Bounds.GetBox();
+            }
+        }
+    }
+    
+    if (!Bounds.IsValid)
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("%s has no static AI sight occluders"), *MapPath);
+        return 1;
+    }
+    
+    UPackage* GridPackage = CreatePackage(*OutPath);
+    UVisibilityGridAsset* Grid = NewObject<UVisibilityGridAsset>(GridPackage, *FPackageName::GetShortName(OutPath), RF_Public | RF_Standalone);
+    
+    const FVector Size = Bounds.GetSize();
+    const int32 BrickVoxels = UVisibilityGridAsset::BrickSize;
+    Grid->VoxelSize = VoxelSize;
+    Grid->Origin = Bounds.Min;
+    Grid->BrickCounts = FIntVector(
+        FMath::CeilToInt32(Size.X / (VoxelSize * BrickVoxels)),
+        FMath::CeilToInt32(Size.Y / (VoxelSize * BrickVoxels)),
+        FMath::CeilToInt32(Size.Z / (VoxelSize * BrickVoxels)));
+    Grid->Dimensions = Grid->BrickCounts * BrickVoxels;
+    
+    const int64 NumBricks = static_cast<int64>(Grid->BrickCounts.X) * Grid->BrickCounts.Y * Grid->BrickCounts.Z;
+    if (NumBricks > MAX_int32 / 2)
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("Grid of %lld bricks is too large, raise -VoxelSize"), NumBricks);
+        return 1;
+    }
+    
+    Grid->BrickTable.Init(INDEX_NONE, static_cast<int32>(NumBricks));
+    
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(BakeVisibilityGrid), false);
+    QueryParams.MobilityType = EQueryMobilityType::Static;
+    
+    const double StartTime = FPlatformTime::Seconds();
+    const FVector BrickExtent(VoxelSize * BrickVoxels * 0.5);
+    const FVector VoxelExtent(VoxelSize * 0.5);
+    
+    for (int32 BrickZ = 0; BrickZ < Grid->BrickCounts.Z; ++BrickZ)
+    {
+        for (int32 BrickY = 0; BrickY < Grid->BrickCounts.Y; ++BrickY)
+        {
+            for (int32 BrickX = 0; BrickX < Grid->BrickCounts.X; ++BrickX)
+            {
+                const FVector BrickMin = Grid->Origin + FVector(BrickX, BrickY, BrickZ) * VoxelSize * BrickVoxels;
+                
+                // One overlap rejects a whole empty brick, most of the volume is air
+                if (!World->OverlapBlockingTestByChannel(BrickMin + BrickExtent, FQuat::Identity, ECC_AISight, FCollisionShape::MakeBox(BrickExtent), QueryParams))
+                {
+                    continue;
+                }
+                
+                uint64 Words[UVisibilityGridAsset::WordsPerBrick] = {};
+                bool bAnyOccupied = false;
+                
+                for (int32 Bit = 0; Bit < UVisibilityGridAsset::BrickSize * UVisibilityGridAsset::BrickSize * UVisibilityGridAsset::BrickSize; ++Bit)
+                {
+                    const FVector Voxel(
+                        Bit & UVisibilityGridAsset::BrickMask,
+                        (Bit >> UVisibilityGridAsset::BrickShift) & UVisibilityGridAsset::BrickMask,
+                        Bit >> (2 * UVisibilityGridAsset::BrickShift));
+                    const FVector Center = BrickMin + (Voxel + FVector(0.5)) * VoxelSize;
+                    
+                    if (World->OverlapBlockingTestByChannel(Center, FQuat::Identity, ECC_AISight, FCollisionShape::MakeBox(VoxelExtent), QueryParams))
+                    {
+                        Words[Bit >> 6] |= uint64(1) << (Bit & 63);
+                        bAnyOccupied = true;
+                    }
+                }
+                
+                if (bAnyOccupied)
+                {
+                    Grid->BrickTable[BrickX + Grid->BrickCounts.X * (BrickY + Grid->BrickCounts.Y * BrickZ)] = Grid->BrickBits.Num() / UVisibilityGridAsset::WordsPerBrick;
+                    Grid->BrickBits.Append(Words, UVisibilityGridAsset::WordsPerBrick);
+                }
+            }
+        }
+    }
+    
+    const int32 NumStoredBricks = Grid->BrickBits.Num() / UVisibilityGridAsset::WordsPerBrick;
+    UE_LOG(LogRTPEditor, Display, TEXT("Baked %dx%dx%d voxels of %.0f cm in %.1f s, %d of %lld bricks stored (%lld KB)"),
+        Grid->Dimensions.X, Grid->Dimensions.Y, Grid->Dimensions.Z, VoxelSize,
+        FPlatformTime::Seconds() - StartTime, NumStoredBricks, NumBricks,
+        (Grid->BrickTable.Num() * sizeof(int32) + Grid->BrickBits.Num() * sizeof(uint64)) / 1024);
+    
+    GridPackage->MarkPackageDirty();
+    const FString Filename = FPackageName::LongPackageNameToFilename(OutPath, FPackageName::GetAssetPackageExtension());
+    FSavePackageArgs SaveArgs;
+    SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+    const bool bSaved = UPackage::SavePackage(GridPackage, Grid, *Filename, SaveArgs);
+    
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+    
+    if (!bSaved)
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("Could not save %s"), *Filename);
+        return 1;
+    }
+    
+    return 0;
+}
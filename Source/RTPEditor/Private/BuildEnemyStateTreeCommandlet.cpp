@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuildEnemyStateTreeCommandlet.h"
+#include "AI/EnemyBrainComponent.h"
+#include "AI/EnemyStateTreeNodes.h"
+#include "AI/EnemyStateTreeSchema.h"
+#include "Misc/PackageName.h"
+#include "StateTree.h"
+#include "StateTreeCompiler.h"
+#include "StateTreeCompilerLog.h"
+#include "StateTreeEditorData.h"
+#include "StateTreeState.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "RTPEditor.h"
+
+UBuildEnemyStateTreeCommandlet::UBuildEnemyStateTreeCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+}
+
+int32 UBuildEnemyStateTreeCommandlet::Main(const FString& Params)
+{
+    FString OutPath = TEXT("/Game/AI/ST_EnemyBrain");
+    FParse::Value(*Params, TEXT("Out="), OutPath);
+    
+    UPackage* TreePackage = CreatePackage(*OutPath);
+    UStateTree* StateTree = NewObject<UStateTree>(TreePackage, *FPackageName::GetShortName(OutPath), RF_Public | RF_Standalone);
+    UStateTreeEditorData* EditorData = NewObject<UStateTreeEditorData>(StateTree, NAME_None, RF_Transactional);
+    EditorData->Schema = NewObject<UEnemyStateTreeSchema>(EditorData);
+    StateTree->EditorData = EditorData;
+    
+    UStateTreeState& Root = EditorData->AddSubTree(TEXT("Root"));
+    
+    // One state per EEnemyState. Changes made outside the tree by perception, noise, damage and latent behaviours
+    // arrive as an event on the root, which selects the matching state, so the tree never has to poll for them
+    TMap<EEnemyState, UStateTreeState*> States;
+    const UEnum* StateEnum = StaticEnum<EEnemyState>();
+    for (int32 Index = 0; Index < StateEnum->NumEnums() - 1; ++Index)
+    {
+        const EEnemyState EnemyState = static_cast<EEnemyState>(StateEnum->GetValueByIndex(Index));
+        UStateTreeState& State = Root.AddChildState(*StateEnum->GetNameStringByIndex(Index));
+        States.Add(EnemyState, &State);
+        
+        FStateTreeTransition& Select = Root.AddTransition(EStateTreeTransitionTrigger::OnEvent, EStateTreeTransitionType::GotoState, &State);
+        Select.RequiredEvent.Tag = TAG_AI_Enemy_StateChanged;
+        Select.AddCondition<FEnemyStateCondition>().GetNode().State = EnemyState;
+    }
+    
+    // The combat loop is the tree's own: investigating watches for the player, chasing pursues them and attacks in range
+    UStateTreeState& Investigating = *States.FindChecked(EEnemyState::Investigating);
+    UStateTreeState& Chasing = *States.FindChecked(EEnemyState::Chasing);
+    UStateTreeState& Attacking = *States.FindChecked(EEnemyState::Attacking);
+    
+    Investigating.AddTask<FEnemyWatchTask>();
+    Investigating.AddTransition(EStateTreeTransitionTrigger::OnTick, EStateTreeTransitionType::GotoState, &Chasing)
+        .AddCondition<FEnemySeesPlayerCondition>();
+    
+    Chasing.AddTask<FEnemyChaseTask>();
+    Chasing.AddTransition(EStateTreeTransitionTrigger::OnTick, EStateTreeTransitionType::GotoState, &Attacking)
+        .AddCondition<FEnemyCanAttackCondition>();
+    
+    // The attack recovery returns to chasing through the state change event, a refused attack directly
+    Attacking.AddTask<FEnemyAttackTask>();
+    Attacking.AddTransition(EStateTreeTransitionTrigger::OnStateFailed, EStateTreeTransitionType::GotoState, &Chasing);
+    
+    // Idle, stunned and dead are left only through state changes made outside the tree
+    for (const TPair<EEnemyState, UStateTreeState*>& Pair : States)
+    {
+        if (Pair.Value->Tasks.Num() == 0)
+        {
+            Pair.Value->AddTask<FEnemyHoldStateTask>();
+        }
+    }
+    
+    FStateTreeCompilerLog Log;
+    FStateTreeCompiler Compiler(Log);
+    if (!Compiler.Compile(*StateTree))
+    {
+        Log.DumpToLog(LogRTPEditor);
+        UE_LOG(LogRTPEditor, Error, TEXT("Could not compile %s"), *OutPath);
+        return 1;
+    }
+    
+    UE_LOG(LogRTPEditor, Display, TEXT("Built %s with %d states"), *OutPath, Root.Children.Num());
+    
+    TreePackage->MarkPackageDirty();
+    const FString Filename = FPackageName::LongPackageNameToFilename(OutPath, FPackageName::GetAssetPackageExtension());
+    FSavePackageArgs SaveArgs;
+    SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+    if (!UPackage::SavePackage(TreePackage, StateTree, *Filename, SaveArgs))
+    {
+        UE_LOG(LogRTPEditor, Error, TEXT("Could not save %s"), *Filename);
+        return 1;
+    }
+    
+    return 0;
+}
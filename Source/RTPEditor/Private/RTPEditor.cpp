@@ -0,0 +1,8 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RTPEditor.h"
+#include "Modules/ModuleManager.h"
+
+DEFINE_LOG_CATEGORY(LogRTPEditor);
+
+IMPLEMENT_MODULE( FDefaultModuleImpl, RTPEditor );
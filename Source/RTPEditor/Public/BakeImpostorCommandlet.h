@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BakeImpostorCommandlet.generated.h"
+
+/**
+ * Bakes an enemy's idle, walk and run cycles into vertex animation textures and builds the matching
+ * impostor mesh and UImpostorAnimationSet. Cycles should be authored in place.
+ * Usage: -run=BakeImpostor -Mesh=<SkeletalMesh> -Idle=<Anim> -Walk=<Anim> -Run=<Anim> -Out=/Game/Enemies/Impostors/IA_<Name>
+ *        [-Material=<VAT material>] [-LOD=1] [-SampleRate=15] [-WalkSpeed=150] [-RunSpeed=450]
+ */
+UCLASS()
+class RTPEDITOR_API UBakeImpostorCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBakeImpostorCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BakeVisibilityGridCommandlet.generated.h"
+
+/**
+ * Voxelizes a level's static AI sight occluders into a UVisibilityGridAsset.
+ * Usage: -run=BakeVisibilityGrid -Map=/Game/Maps/<Map> [-VoxelSize=50] [-Out=/Game/AI/VisibilityGrids/VG_<Map>]
+ */
+UCLASS()
+class RTPEDITOR_API UBakeVisibilityGridCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBakeVisibilityGridCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
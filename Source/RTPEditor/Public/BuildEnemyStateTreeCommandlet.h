@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BuildEnemyStateTreeCommandlet.generated.h"
+
+/**
+ * Builds the enemy brain StateTree from EEnemyState: one state per enemy state, selected through an
+ * "Enemy State Is" condition whenever the enemy's state changes outside the tree. The tree makes the
+ * investigate, chase and attack transitions itself.
+ * Usage: -run=BuildEnemyStateTree [-Out=/Game/AI/ST_EnemyBrain]
+ */
+UCLASS()
+class RTPEDITOR_API UBuildEnemyStateTreeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBuildEnemyStateTreeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,18 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class RTPEditor : ModuleRules
+{
+	public RTPEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// Offline bakes and asset builders run as commandlets, nothing here ships with the game
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine" });
+
+		// Visibility grid bake in UBakeVisibilityGridCommandlet, impostor mesh building in UBakeImpostorCommandlet,
+		// enemy brain compilation in UBuildEnemyStateTreeCommandlet
+		PrivateDependencyModuleNames.AddRange(new string[] { "RTP", "MeshDescription", "StaticMeshDescription", "StateTreeModule", "StateTreeEditorModule", "GameplayTags" });
+	}
+}
@@ -0,0 +1,342 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrowdAvoidance.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    constexpr float LineEpsilon = 1.e-5f;
+
+    // Agents below this count are solved on the calling thread, the task overhead outweighs the work
+    constexpr int32 MinAgentsForParallelSolve = 64;
+
+    float Det(const FVector2f& A, const FVector2f& B)
+    {
+        return A.X * B.Y - A.Y * B.X;
+    }
+}
+
+FIntPoint FCrowdAvoidance::GetCell(const FVector2f& Position) const
+{
+    return FIntPoint(FMath::FloorToInt32(Position.X * InvCellSize), FMath::FloorToInt32(Position.Y * InvCellSize));
+}
+
+void FCrowdAvoidance::BuildGrid(TConstArrayView<FCrowdAgent> Agents, float CellSize)
+{
+    const float NewInvCellSize = 1.0f / FMath::Max(CellSize, 100.0f);
+    if (NewInvCellSize != InvCellSize)
+    {
+        InvCellSize = NewInvCellSize;
+        Cells.Reset();
+    }
+    
+    // Cells keep their memory between frames
+    for (TPair<FIntPoint, TArray<int32>>& Cell : Cells)
+    {
+        Cell.Value.Reset();
+    }
+    
+    for (int32 Index = 0; Index < Agents.Num(); ++Index)
+    {
+        Cells.FindOrAdd(GetCell(Agents[Index].Position)).Add(Index);
+    }
+}
+
+void FCrowdAvoidance::FindNeighbors(TConstArrayView<FCrowdAgent> Agents, int32 AgentIndex, const FCrowdAvoidanceSettings& Settings, TArray<int32, TInlineAllocator<16>>& OutNeighbors) const
+{
+    const FVector2f Position = Agents[AgentIndex].Position;
+    const float RadiusSquared = FMath::Square(Settings.NeighborRadius);
+    const FIntPoint MinCell = GetCell(Position - FVector2f(Settings.NeighborRadius));
+    const FIntPoint MaxCell = GetCell(Position + FVector2f(Settings.NeighborRadius));
+    
+    TArray<float, TInlineAllocator<16>> DistancesSquared;
+    for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+    {
+        for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+        {
+            const TArray<int32>* Cell = Cells.Find(FIntPoint(CellX, CellY));
+            if (!Cell)
+            {
+                continue;
+            }
+            
+            for (const int32 OtherIndex : *Cell)
+            {
+                const float DistanceSquared = FVector2f::DistSquared(Position, Agents[OtherIndex].Position);
+                if (OtherIndex == AgentIndex || DistanceSquared > RadiusSquared)
+                {
+                    continue;
+                }
+                
+                // Insertion into the short sorted list, dropping the farthest once full
+                int32 Slot = DistancesSquared.Num();
+                while (Slot > 0 && DistancesSquared[Slot - 1] > DistanceSquared)
+                {
+                    --Slot;
+                }
+                
+                if (Slot < Settings.MaxNeighbors)
+                {
+                    DistancesSquared.Insert(DistanceSquared, Slot);
+                    OutNeighbors.Insert(OtherIndex, Slot);
+                    if (OutNeighbors.Num() > Settings.MaxNeighbors)
+                    {
+                        DistancesSquared.Pop(EAllowShrinking::No);
+                        OutNeighbors.Pop(EAllowShrinking::No);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void FCrowdAvoidance::Solve(TConstArrayView<FCrowdAgent> Agents, const FCrowdAvoidanceSettings& Settings, float DeltaTime, TArray<FVector2f>& OutVelocities)
+{
+    OutVelocities.SetNumUninitialized(Agents.Num());
+    if (Agents.Num() == 0)
+    {
+        return;
+    }
+    
+    // Nothing moves on a paused or zero time dilation frame, agents keep what they asked for
+    if (DeltaTime <= 0.0f)
+    {
+        for (int32 Index = 0; Index < Agents.Num(); ++Index)
+        {
+            OutVelocities[Index] = Agents[Index].bResponsive ? Agents[Index].PreferredVelocity : Agents[Index].Velocity;
+        }
+        return;
+    }
+    
+    BuildGrid(Agents, Settings.NeighborRadius);
+    
+    const EParallelForFlags Flags = Agents.Num() < MinAgentsForParallelSolve ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+    ParallelFor(TEXT("CrowdAvoidance"), Agents.Num(), 16, [&](int32 Index)
+    {
+        const FCrowdAgent& Agent = Agents[Index];
+        if (!Agent.bResponsive)
+        {
+            OutVelocities[Index] = Agent.Velocity;
+            return;
+        }
+        
+        TArray<int32, TInlineAllocator<16>> Neighbors;
+        FindNeighbors(Agents, Index, Settings, Neighbors);
+        OutVelocities[Index] = SolveAgent(Agents, Index, Neighbors, Settings, DeltaTime);
+    }, Flags);
+}
+
+FVector2f FCrowdAvoidance::SolveAgent(TConstArrayView<FCrowdAgent> Agents, int32 AgentIndex, TConstArrayView<int32> Neighbors, const FCrowdAvoidanceSettings& Settings, float DeltaTime)
+{
+    const FCrowdAgent& Agent = Agents[AgentIndex];
+    const float InvTimeHorizon = 1.0f / FMath::Max(Settings.TimeHorizon, DeltaTime);
+    const float InvTimeStep = 1.0f / DeltaTime;
+    
+    FLineArray Lines;
+    for (const int32 NeighborIndex : Neighbors)
+    {
+        const FCrowdAgent& Other = Agents[NeighborIndex];
+        const FVector2f RelativePosition = Other.Position - Agent.Position;
+        const FVector2f RelativeVelocity = Agent.Velocity - Other.Velocity;
+        const float DistanceSquared = RelativePosition.SizeSquared();
+        const float CombinedRadius = Agent.Radius + Other.Radius;
+        const float CombinedRadiusSquared = FMath::Square(CombinedRadius);
+        
+        FOrcaLine Line;
+        FVector2f U;
+        
+        if (DistanceSquared > CombinedRadiusSquared)
+        {
+            // Vector from the cutoff circle's center to the relative velocity
+            const FVector2f W = RelativeVelocity - InvTimeHorizon * RelativePosition;
+            const float WLengthSquared = W.SizeSquared();
+            const float Dot1 = W | RelativePosition;
+            
+            if (Dot1 < 0.0f && FMath::Square(Dot1) > CombinedRadiusSquared * WLengthSquared)
+            {
+                // Project on the cutoff circle
+                const float WLength = FMath::Sqrt(WLengthSquared);
+                const FVector2f UnitW = W / WLength;
+                Line.Direction = FVector2f(UnitW.Y, -UnitW.X);
+                U = (CombinedRadius * InvTimeHorizon - WLength) * UnitW;
+            }
+            else
+            {
+                // Project on the nearer leg of the velocity obstacle cone
+                const float Leg = FMath::Sqrt(DistanceSquared - CombinedRadiusSquared);
+                if (Det(RelativePosition, W) > 0.0f)
+                {
+                    Line.Direction = FVector2f(RelativePosition.X * Leg - RelativePosition.Y * CombinedRadius,
+                        RelativePosition.X * CombinedRadius + RelativePosition.Y * Leg) / DistanceSquared;
+                }
+                else
+                {
+                    Line.Direction = -FVector2f(RelativePosition.X * Leg + RelativePosition.Y * CombinedRadius,
+                        -RelativePosition.X * CombinedRadius + RelativePosition.Y * Leg) / DistanceSquared;
+                }
+                
+                U = (RelativeVelocity | Line.Direction) * Line.Direction - RelativeVelocity;
+            }
+        }
+        else
+        {
+            // Already overlapping, separate within this step
+            const FVector2f W = RelativeVelocity - InvTimeStep * RelativePosition;
+            const float WLength = W.Size();
+            const FVector2f UnitW = WLength > LineEpsilon ? W / WLength : FVector2f(1.0f, 0.0f);
+            Line.Direction = FVector2f(UnitW.Y, -UnitW.X);
+            U = (CombinedRadius * InvTimeStep - WLength) * UnitW;
+        }
+        
+        // Take half the correction when the other agent steers too, all of it otherwise
+        const float Responsibility = Other.bResponsive ? 0.5f : 1.0f;
+        Line.Point = Agent.Velocity + Responsibility * U;
+        Lines.Add(Line);
+    }
+    
+    FVector2f Result;
+    const int32 FailedLine = LinearProgram2(Lines, Agent.MaxSpeed, Agent.PreferredVelocity, false, Result);
+    if (FailedLine < Lines.Num())
+    {
+        LinearProgram3(Lines, FailedLine, Agent.MaxSpeed, Result);
+    }
+    return Result;
+}
+
+bool FCrowdAvoidance::LinearProgram1(const FLineArray& Lines, int32 LineIndex, float Radius, const FVector2f& OptVelocity, bool bDirectionOpt, FVector2f& Result)
+{
+    const FOrcaLine& Line = Lines[LineIndex];
+    const float Dot = Line.Point | Line.Direction;
+    const float Discriminant = FMath::Square(Dot) + FMath::Square(Radius) - Line.Point.SizeSquared();
+    if (Discriminant < 0.0f)
+    {
+        // The max speed circle fully invalidates this line
+        return false;
+    }
+    
+    const float SqrtDiscriminant = FMath::Sqrt(Discriminant);
+    float TLeft = -Dot - SqrtDiscriminant;
+    float TRight = -Dot + SqrtDiscriminant;
+    
+    for (int32 Index = 0; Index < LineIndex; ++Index)
+    {
+        const float Denominator = Det(Line.Direction, Lines[Index].Direction);
+        const float Numerator = Det(Lines[Index].Direction, Line.Point - Lines[Index].Point);
+        
+        if (FMath::Abs(Denominator) <= LineEpsilon)
+        {
+            // Parallel lines
+            if (Numerator < 0.0f)
+            {
+                return false;
+            }
+            continue;
+        }
+        
+        const float T = Numerator / Denominator;
+        if (Denominator >= 0.0f)
+        {
+            TRight = FMath::Min(TRight, T);
+        }
+        else
+        {
+            TLeft = FMath::Max(TLeft, T);
+        }
+        
+        if (TLeft > TRight)
+        {
+            return false;
+        }
+    }
+    
+    if (bDirectionOpt)
+    {
+        Result = Line.Point + ((OptVelocity | Line.Direction) > 0.0f ? TRight : TLeft) * Line.Direction;
+    }
+    else
+    {
+        const float T = FMath::Clamp(Line.Direction | (OptVelocity - Line.Point), TLeft, TRight);
+        Result = Line.Point + T * Line.Direction;
+    }
+    return true;
+}
+
+int32 FCrowdAvoidance::LinearProgram2(const FLineArray& Lines, float Radius, const FVector2f& OptVelocity, bool bDirectionOpt, FVector2f& Result)
+{
+    if (bDirectionOpt)
+    {
+        // OptVelocity is a unit direction here
+        Result = OptVelocity * Radius;
+    }
+    else if (OptVelocity.SizeSquared() > FMath::Square(Radius))
+    {
+        Result = OptVelocity.GetSafeNormal() * Radius;
+    }
+    else
+    {
+        Result = OptVelocity;
+    }
+    
+    for (int32 Index = 0; Index < Lines.Num(); ++Index)
+    {
+        if (Det(Lines[Index].Direction, Lines[Index].Point - Result) > 0.0f)
+        {
+            // Result violates this constraint, move it onto the line
+            const FVector2f PreviousResult = Result;
+            if (!LinearProgram1(Lines, Index, Radius, OptVelocity, bDirectionOpt, Result))
+            {
+                Result = PreviousResult;
+                return Index;
+            }
+        }
+    }
+    return Lines.Num();
+}
+
+void FCrowdAvoidance::LinearProgram3(const FLineArray& Lines, int32 BeginLine, float Radius, FVector2f& Result)
+{
+    float Distance = 0.0f;
+    
+    for (int32 Index = BeginLine; Index < Lines.Num(); ++Index)
+    {
+        if (Det(Lines[Index].Direction, Lines[Index].Point - Result) <= Distance)
+        {
+            continue;
+        }
+        
+        // Result does not satisfy this constraint within the current tolerance, project the earlier lines onto it
+        FLineArray ProjectedLines;
+        for (int32 Other = 0; Other < Index; ++Other)
+        {
+            FOrcaLine Line;
+            const float Determinant = Det(Lines[Index].Direction, Lines[Other].Direction);
+            
+            if (FMath::Abs(Determinant) <= LineEpsilon)
+            {
+                if ((Lines[Index].Direction | Lines[Other].Direction) > 0.0f)
+                {
+                    // Same direction, the other line adds nothing
+                    continue;
+                }
+                Line.Point = 0.5f * (Lines[Index].Point + Lines[Other].Point);
+            }
+            else
+            {
+                Line.Point = Lines[Index].Point + (Det(Lines[Other].Direction, Lines[Index].Point - Lines[Other].Point) / Determinant) * Lines[Index].Direction;
+            }
+            
+            Line.Direction = (Lines[Other].Direction - Lines[Index].Direction).GetSafeNormal();
+            ProjectedLines.Add(Line);
+        }
+        
+        const FVector2f PreviousResult = Result;
+        if (LinearProgram2(ProjectedLines, Radius, FVector2f(-Lines[Index].Direction.Y, Lines[Index].Direction.X), true, Result) < ProjectedLines.Num())
+        {
+            // Can only fail from floating point error, keep the previous result
+            Result = PreviousResult;
+        }
+        
+        Distance = Det(Lines[Index].Direction, Lines[Index].Point - Result);
+    }
+}
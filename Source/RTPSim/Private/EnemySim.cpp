@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemySim.h"
+
+void FEnemySim::Decide(const FEnemySimInput& Input, TFunctionRef<bool()> HasLineOfSightToPlayer, FRandomStream& Stream, FEnemyDecision& OutDecision)
+{
+    const int32 StartSeed = Stream.GetCurrentSeed();
+    
+    if (!Input.bIsDead)
+    {
+        switch (Input.State)
+        {
+            case EEnemySimState::Chasing:
+                // Check if we're in attack range of the player
+                if (Input.bHasPlayer)
+                {
+                    if (FVector::Dist(Input.Location, Input.PlayerLocation) <= Input.AttackRange && !Input.bAttackOnCooldown)
+                    {
+                        OutDecision.bAttack = true;
+                    }
+                    else if (Input.bSquadSeesPlayer || HasLineOfSightToPlayer())
+                    {
+                        // Update last known location if we or the squad can see the player, then move to the player
+                        OutDecision.bUpdateLastKnownLocation = true;
+                        OutDecision.LastKnownPlayerLocation = Input.PlayerLocation;
+                        OutDecision.bMoveToPlayer = true;
+                        OutDecision.bReportSighting = !Input.bSquadSeesPlayer;
+                    }
+                    else
+                    {
+                        // Move to last known location if we can't see the player and start forgetting them
+                        OutDecision.bMoveToLastKnownLocation = true;
+                        OutDecision.bStartMemoryTimer = true;
+                    }
+                }
+                break;
+                
+            case EEnemySimState::Investigating:
+                // If we can see the player again, go back to chasing. Reaching the investigation
+                // point is handled by the enemy's latent investigate behavior
+                if (Input.bHasPlayer && HasLineOfSightToPlayer())
+                {
+                    OutDecision.bResumeChase = true;
+                    OutDecision.bReportSighting = true;
+                }
+                break;
+                
+            default:
+                break;
+        }
+    }
+    
+    OutDecision.RandomSeed = Stream.GetCurrentSeed();
+    OutDecision.bAdvancedRandomStream = OutDecision.RandomSeed != StartSeed;
+}
+
+FFlashlightReaction FEnemySim::ReactToFlashlight(float Intensity, float Sensitivity, float StunDuration, bool bIsIdle, FRandomStream& Stream)
+{
+    FFlashlightReaction Reaction;
+    
+    // Calculate stun chance based on intensity and sensitivity
+    const float StunChance = FMath::Clamp(Intensity * Sensitivity / 8000.0f, 0.0f, 0.75f);
+    
+    if (Stream.FRand() < StunChance)
+    {
+        // Stun duration scales with intensity
+        Reaction.bStun = true;
+        Reaction.StunTime = FMath::Clamp(StunDuration * (Intensity / 8000.0f), 1.0f, StunDuration);
+    }
+    else if (bIsIdle)
+    {
+        // Even if not stunned, high intensity light might make the enemy investigate
+        Reaction.bInvestigate = Intensity > 4000.0f && Stream.FRand() < 0.5f;
+    }
+    
+    return Reaction;
+}
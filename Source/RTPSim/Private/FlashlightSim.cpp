@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlashlightSim.h"
+
+void FFlashlightSim::BuildFlickerTimeline(int32 Seed, int32 Length, TArray<float>& OutTimeline)
+{
+    FRandomStream FlickerStream(Seed);
+    
+    OutTimeline.SetNumUninitialized(Length);
+    for (float& Roll : OutTimeline)
+    {
+        Roll = FlickerStream.FRand();
+    }
+}
+
+float FFlashlightSim::EvaluateStrobeScale(float ModeTime, float StrobeInterval)
+{
+    const int32 StrobePhase = FMath::FloorToInt32(ModeTime / FMath::Max(StrobeInterval, KINDA_SMALL_NUMBER));
+    return (StrobePhase % 2 == 0) ? 1.0f : 0.0f;
+}
+
+float FFlashlightSim::EvaluateBatteryScale(const FFlashlightBatteryParams& Params, TConstArrayView<float> FlickerTimeline, float BatteryLife, float ModeTime)
+{
+    float Scale = 1.0f;
+    
+    // Gradual dimming from 1.0 at DimmingStartThreshold down to 0.1 at an empty battery
+    if (BatteryLife < Params.DimmingStartThreshold)
+    {
+        Scale *= FMath::Max(0.1f, BatteryLife / Params.DimmingStartThreshold);
+    }
+    
+    // Low battery flicker: each slot of the timeline flickers if its roll is under the flicker chance,
+    // which grows as the battery depletes
+    if (BatteryLife <= Params.LowBatteryThreshold && FlickerTimeline.Num() > 0 && Params.LowBatteryFlickerFrequency > 0.0f)
+    {
+        const bool bNearlyEmpty = BatteryLife < 5.0f;
+        const float FlickerChance = bNearlyEmpty ? 0.9f : 1.0f - (BatteryLife / Params.LowBatteryThreshold);
+        
+        const float SlotTime = ModeTime * Params.LowBatteryFlickerFrequency;
+        const int32 Slot = FMath::FloorToInt32(SlotTime);
+        const float TimeInSlot = (SlotTime - Slot) / Params.LowBatteryFlickerFrequency;
+        
+        // Longer and dimmer flickers for a nearly depleted battery
+        const float FlickerDuration = bNearlyEmpty ? 0.2f : 0.1f;
+        if (TimeInSlot < FlickerDuration && FlickerTimeline[Slot % FlickerTimeline.Num()] < FlickerChance)
+        {
+            Scale *= bNearlyEmpty ? 0.2f : 0.5f;
+        }
+    }
+    
+    return Scale;
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ImpostorLOD.h"
+
+bool FImpostorLODPolicy::ShouldUseImpostor(const FImpostorLODSettings& Settings, float DistanceSquared, bool bForceSkeletal, bool bIsImpostor)
+{
+    if (bForceSkeletal)
+    {
+        return false;
+    }
+    
+    const float Threshold = bIsImpostor ? Settings.ExitDistance : Settings.EnterDistance;
+    return DistanceSquared > FMath::Square(Threshold);
+}
+
+EImpostorClip FImpostorLODPolicy::SelectClip(const FImpostorLODSettings& Settings, float Speed)
+{
+    if (Speed >= Settings.RunSpeed)
+    {
+        return EImpostorClip::Run;
+    }
+    
+    return Speed >= Settings.WalkSpeed ? EImpostorClip::Walk : EImpostorClip::Idle;
+}
+
+float FImpostorLODPolicy::GetCyclePosition(const FImpostorAnimState& State, float CycleLength, float Time)
+{
+    if (CycleLength <= 0.0f)
+    {
+        return 0.0f;
+    }
+    
+    return FMath::Frac((Time * State.PlayRate + State.Phase) / CycleLength);
+}
+
+FImpostorAnimState FImpostorLODPolicy::Continue(const FImpostorAnimState& Current, float CurrentCycleLength,
+    EImpostorClip NewClip, float NewPlayRate, float NewCycleLength, float Time)
+{
+    // Solve Time * NewPlayRate + Phase = CyclePosition * NewCycleLength
+    const float CyclePosition = GetCyclePosition(Current, CurrentCycleLength, Time);
+    
+    FImpostorAnimState Result;
+    Result.Clip = NewClip;
+    Result.PlayRate = NewPlayRate;
+    Result.Phase = CyclePosition * NewCycleLength - Time * NewPlayRate;
+    
+    // Keep the phase small so the material's float math stays precise
+    if (NewCycleLength > 0.0f)
+    {
+        Result.Phase -= FMath::FloorToFloat(Result.Phase / NewCycleLength) * NewCycleLength;
+    }
+    
+    return Result;
+}
+
+int32 FImpostorInstanceTable::Add(int32 Owner)
+{
+    return Owners.Add(Owner);
+}
+
+int32 FImpostorInstanceTable::RemoveAtSwap(int32 InstanceIndex)
+{
+    check(Owners.IsValidIndex(InstanceIndex));
+    
+    const int32 LastIndex = Owners.Num() - 1;
+    const int32 MovedOwner = InstanceIndex != LastIndex ? Owners[LastIndex] : INDEX_NONE;
+    Owners.RemoveAtSwap(InstanceIndex, 1, EAllowShrinking::No);
+    return MovedOwner;
+}
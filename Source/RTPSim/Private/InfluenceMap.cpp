@@ -0,0 +1,320 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InfluenceMap.h"
+
+namespace
+{
+    // Keeps a map spanning a huge or missing bounds box from taking over memory
+    constexpr int32 MaxTilesPerSide = 64;
+}
+
+void FInfluenceMap::Init(const FVector2f& Min, const FVector2f& Max, float InCellSize)
+{
+    CellSize = FMath::Max(InCellSize, 50.0f);
+    InvCellSize = 1.0f / CellSize;
+    Origin = Min;
+    
+    const float TileExtent = CellSize * TileSize;
+    TilesX = FMath::Clamp(FMath::CeilToInt32((Max.X - Min.X) / TileExtent), 1, MaxTilesPerSide);
+    TilesY = FMath::Clamp(FMath::CeilToInt32((Max.Y - Min.Y) / TileExtent), 1, MaxTilesPerSide);
+    Width = TilesX * TileSize;
+    Height = TilesY * TileSize;
+    Stride = Width + 2 * RowPadding;
+    
+    for (FLayerData& Data : Layers)
+    {
+        Data.Reset();
+        Data.SetNumZeroed(Stride * (Height + 2));
+    }
+    
+    TileDirty.Init(false, TilesX * TilesY);
+    DirtyTiles.Reset();
+}
+
+void FInfluenceMap::Reset()
+{
+    for (FLayerData& Data : Layers)
+    {
+        Data.Empty();
+    }
+    TileDirty.Empty();
+    DirtyTiles.Empty();
+    StepTiles.Empty();
+    StepResults.Empty();
+    Width = Height = TilesX = TilesY = Stride = 0;
+}
+
+bool FInfluenceMap::GetCell(const FVector2f& Position, FIntPoint& OutCell) const
+{
+    OutCell.X = FMath::FloorToInt32((Position.X - Origin.X) * InvCellSize);
+    OutCell.Y = FMath::FloorToInt32((Position.Y - Origin.Y) * InvCellSize);
+    return OutCell.X >= 0 && OutCell.X < Width && OutCell.Y >= 0 && OutCell.Y < Height;
+}
+
+FVector2f FInfluenceMap::GetCellCenter(const FIntPoint& Cell) const
+{
+    return Origin + (FVector2f(Cell.X, Cell.Y) + 0.5f) * CellSize;
+}
+
+void FInfluenceMap::MarkTileDirty(int32 TileX, int32 TileY)
+{
+    if (TileX < 0 || TileX >= TilesX || TileY < 0 || TileY >= TilesY)
+    {
+        return;
+    }
+    
+    const int32 Tile = TileY * TilesX + TileX;
+    if (!TileDirty[Tile])
+    {
+        TileDirty[Tile] = true;
+        DirtyTiles.Add(Tile);
+    }
+}
+
+void FInfluenceMap::Add(EInfluenceLayer Layer, const FVector2f& Position, float Amount)
+{
+    FIntPoint Cell;
+    if (!IsValid() || Amount <= 0.0f || !GetCell(Position, Cell))
+    {
+        return;
+    }
+    
+    float& Value = Layers[static_cast<int32>(Layer)][GetIndex(Cell.X, Cell.Y)];
+    Value = FMath::Min(Value + Amount, 1.0f);
+    MarkTileDirty(Cell.X / TileSize, Cell.Y / TileSize);
+}
+
+float FInfluenceMap::GetValue(EInfluenceLayer Layer, const FVector2f& Position) const
+{
+    FIntPoint Cell;
+    return IsValid() && GetCell(Position, Cell) ? Layers[static_cast<int32>(Layer)][GetIndex(Cell.X, Cell.Y)] : 0.0f;
+}
+
+void FInfluenceMap::DiffuseTile(const FLayerData& Data, int32 TileX, int32 TileY, float Keep, float Spread, float* Out) const
+{
+    const VectorRegister4Float KeepFactor = VectorSetFloat1(Keep);
+    const VectorRegister4Float SpreadFactor = VectorSetFloat1(Spread);
+    
+    for (int32 Row = 0; Row < TileSize; ++Row)
+    {
+        // Rows start on a vector boundary, the left and right neighbors are the same row shifted by one cell
+        const float* Center = &Data[GetIndex(TileX * TileSize, TileY * TileSize + Row)];
+        const float* Up = Center - Stride;
+        const float* Down = Center + Stride;
+        float* Result = Out + Row * TileSize;
+        
+        for (int32 Column = 0; Column < TileSize; Column += 4)
+        {
+            const VectorRegister4Float Neighbors = VectorAdd(
+                VectorAdd(VectorLoad(Center + Column - 1), VectorLoad(Center + Column + 1)),
+                VectorAdd(VectorLoadAligned(Up + Column), VectorLoadAligned(Down + Column)));
+            
+            const VectorRegister4Float Value = VectorMultiplyAdd(Neighbors, SpreadFactor, VectorMultiply(VectorLoadAligned(Center + Column), KeepFactor));
+            VectorStoreAligned(Value, Result + Column);
+        }
+    }
+}
+
+void FInfluenceMap::Step(const FInfluenceMapSettings& Settings)
+{
+    if (DirtyTiles.Num() == 0)
+    {
+        return;
+    }
+    
+    // Tiles stay dirty only as long as their values or their neighbors' keep them so
+    Swap(StepTiles, DirtyTiles);
+    DirtyTiles.Reset();
+    for (int32 Tile : StepTiles)
+    {
+        TileDirty[Tile] = false;
+    }
+    
+    const float Diffusion = FMath::Clamp(Settings.Diffusion, 0.0f, 1.0f);
+    StepResults.SetNumUninitialized(StepTiles.Num() * NumLayers * CellsPerTile, EAllowShrinking::No);
+    
+    // Every tile reads the values from before the step, so results go to the scratch buffer first
+    for (int32 StepIndex = 0; StepIndex < StepTiles.Num(); ++StepIndex)
+    {
+        const int32 TileX = StepTiles[StepIndex] % TilesX;
+        const int32 TileY = StepTiles[StepIndex] / TilesX;
+        
+        for (int32 Layer = 0; Layer < NumLayers; ++Layer)
+        {
+            const float Decay = FMath::Clamp(Settings.Decay[Layer], 0.0f, 1.0f);
+            float* Out = &StepResults[(StepIndex * NumLayers + Layer) * CellsPerTile];
+            DiffuseTile(Layers[Layer], TileX, TileY, (1.0f - Diffusion) * Decay, 0.25f * Diffusion * Decay, Out);
+        }
+    }
+    
+    const VectorRegister4Float Zero = VectorZeroFloat();
+    
+    for (int32 StepIndex = 0; StepIndex < StepTiles.Num(); ++StepIndex)
+    {
+        const int32 TileX = StepTiles[StepIndex] % TilesX;
+        const int32 TileY = StepTiles[StepIndex] / TilesX;
+        
+        // Largest value on the whole tile and along each edge, over all layers
+        VectorRegister4Float TileMax = Zero;
+        VectorRegister4Float TopMax = Zero;
+        VectorRegister4Float BottomMax = Zero;
+        float LeftMax = 0.0f;
+        float RightMax = 0.0f;
+        
+        for (int32 Layer = 0; Layer < NumLayers; ++Layer)
+        {
+            const float* Result = &StepResults[(StepIndex * NumLayers + Layer) * CellsPerTile];
+            
+            for (int32 Row = 0; Row < TileSize; ++Row)
+            {
+                const float* RowResult = Result + Row * TileSize;
+                FMemory::Memcpy(&Layers[Layer][GetIndex(TileX * TileSize, TileY * TileSize + Row)], RowResult, TileSize * sizeof(float));
+                
+                VectorRegister4Float RowMax = Zero;
+                for (int32 Column = 0; Column < TileSize; Column += 4)
+                {
+                    RowMax = VectorMax(RowMax, VectorLoadAligned(RowResult + Column));
+                }
+                
+                TileMax = VectorMax(TileMax, RowMax);
+                if (Row == 0)
+                {
+                    TopMax = VectorMax(TopMax, RowMax);
+                }
+                else if (Row == TileSize - 1)
+                {
+                    BottomMax = VectorMax(BottomMax, RowMax);
+                }
+                LeftMax = FMath::Max(LeftMax, RowResult[0]);
+                RightMax = FMath::Max(RightMax, RowResult[TileSize - 1]);
+            }
+        }
+        
+        alignas(16) float Maxima[3][4];
+        VectorStoreAligned(TileMax, Maxima[0]);
+        VectorStoreAligned(TopMax, Maxima[1]);
+        VectorStoreAligned(BottomMax, Maxima[2]);
+        
+        auto HorizontalMax = [](const float (&Lanes)[4])
+        {
+            return FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
+        };
+        
+        if (HorizontalMax(Maxima[0]) < Settings.Epsilon)
+        {
+            // Keep the invariant that clean tiles hold zeros only
+            for (int32 Layer = 0; Layer < NumLayers; ++Layer)
+            {
+                for (int32 Row = 0; Row < TileSize; ++Row)
+                {
+                    FMemory::Memzero(&Layers[Layer][GetIndex(TileX * TileSize, TileY * TileSize + Row)], TileSize * sizeof(float));
+                }
+            }
+            continue;
+        }
+        
+        MarkTileDirty(TileX, TileY);
+        
+        // Influence reaching an edge spreads into the neighboring tile from the next step on
+        if (HorizontalMax(Maxima[1]) >= Settings.Epsilon)
+        {
+            MarkTileDirty(TileX, TileY - 1);
+        }
+        if (HorizontalMax(Maxima[2]) >= Settings.Epsilon)
+        {
+            MarkTileDirty(TileX, TileY + 1);
+        }
+        if (LeftMax >= Settings.Epsilon)
+        {
+            MarkTileDirty(TileX - 1, TileY);
+        }
+        if (RightMax >= Settings.Epsilon)
+        {
+            MarkTileDirty(TileX + 1, TileY);
+        }
+    }
+}
+
+bool FInfluenceMap::FindBestCell(const FVector2f& From, float Radius, float CoverageWeight, float MinScore, FVector2f& OutPosition) const
+{
+    FIntPoint FromCell;
+    if (!IsValid() || !GetCell(From, FromCell))
+    {
+        return false;
+    }
+    
+    const int32 Reach = FMath::Max(FMath::CeilToInt32(Radius * InvCellSize), 1);
+    const int32 ReachSquared = Reach * Reach;
+    const int32 MinX = FMath::Max(FromCell.X - Reach, 0);
+    const int32 MaxX = FMath::Min(FromCell.X + Reach, Width - 1);
+    const int32 MinY = FMath::Max(FromCell.Y - Reach, 0);
+    const int32 MaxY = FMath::Min(FromCell.Y + Reach, Height - 1);
+    
+    const FLayerData& Heat = Layers[static_cast<int32>(EInfluenceLayer::PlayerHeat)];
+    const FLayerData& Coverage = Layers[static_cast<int32>(EInfluenceLayer::EnemyCoverage)];
+    
+    float BestScore = MinScore;
+    FIntPoint BestCell(INDEX_NONE, INDEX_NONE);
+    
+    for (int32 Y = MinY; Y <= MaxY; ++Y)
+    {
+        for (int32 X = MinX; X <= MaxX; ++X)
+        {
+            // Clean tiles hold no heat
+            if (!TileDirty[(Y / TileSize) * TilesX + X / TileSize] || FMath::Square(X - FromCell.X) + FMath::Square(Y - FromCell.Y) > ReachSquared)
+            {
+                continue;
+            }
+            
+            const int32 Index = GetIndex(X, Y);
+            const float Score = Heat[Index] - CoverageWeight * Coverage[Index];
+            if (Score > BestScore && (X != FromCell.X || Y != FromCell.Y))
+            {
+                BestScore = Score;
+                BestCell = FIntPoint(X, Y);
+            }
+        }
+    }
+    
+    if (BestCell.X == INDEX_NONE)
+    {
+        return false;
+    }
+    
+    OutPosition = GetCellCenter(BestCell);
+    return true;
+}
+
+bool FInfluenceMap::FindMaxCell(EInfluenceLayer Layer, FVector2f& OutPosition, float& OutValue) const
+{
+    const FLayerData& Data = Layers[static_cast<int32>(Layer)];
+    FIntPoint BestCell(INDEX_NONE, INDEX_NONE);
+    OutValue = 0.0f;
+    
+    for (int32 Tile : DirtyTiles)
+    {
+        const int32 TileX = Tile % TilesX;
+        const int32 TileY = Tile / TilesX;
+        
+        for (int32 Y = TileY * TileSize; Y < (TileY + 1) * TileSize; ++Y)
+        {
+            for (int32 X = TileX * TileSize; X < (TileX + 1) * TileSize; ++X)
+            {
+                if (Data[GetIndex(X, Y)] > OutValue)
+                {
+                    OutValue = Data[GetIndex(X, Y)];
+                    BestCell = FIntPoint(X, Y);
+                }
+            }
+        }
+    }
+    
+    if (BestCell.X == INDEX_NONE)
+    {
+        return false;
+    }
+    
+    OutPosition = GetCellCenter(BestCell);
+    return true;
+}
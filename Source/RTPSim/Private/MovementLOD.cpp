@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementLOD.h"
+
+EEnemyMovementLOD FMovementLODPolicy::Select(const FMovementLODSettings& Settings, float DistanceSquared, bool bInCombat, bool bIsIdle, EEnemyMovementLOD Current)
+{
+    if (bInCombat)
+    {
+        return EEnemyMovementLOD::Full;
+    }
+    
+    // Already at or past a tier, stay there until the enemy is Hysteresis closer than its threshold
+    auto IsBeyond = [&](float Distance, EEnemyMovementLOD Tier)
+    {
+        const float Threshold = Current >= Tier ? FMath::Max(Distance - Settings.Hysteresis, 0.0f) : Distance;
+        return DistanceSquared > FMath::Square(Threshold);
+    };
+    
+    if (bIsIdle && IsBeyond(Settings.DormantDistance, EEnemyMovementLOD::Dormant))
+    {
+        return EEnemyMovementLOD::Dormant;
+    }
+    
+    return IsBeyond(Settings.ReducedDistance, EEnemyMovementLOD::Reduced) ? EEnemyMovementLOD::Reduced : EEnemyMovementLOD::Full;
+}
@@ -0,0 +1,8 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "RTPSim.h"
+#include "Modules/ModuleManager.h"
+
+DEFINE_LOG_CATEGORY(LogRTPSim);
+
+IMPLEMENT_MODULE( FDefaultModuleImpl, RTPSim );
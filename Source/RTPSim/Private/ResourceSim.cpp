@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ResourceSim.h"
+
+double FResourceSim::GetMoveStartTime(const FResourceParams& Params, const FResourceLine& Line)
+{
+    if (Line.DrainRate > 0.0f)
+    {
+        return Line.AnchorTime;
+    }
+    
+    // Regeneration waits out the delay unless the resource was left above RegenDelayBelowFraction
+    const bool bApplyDelay = Line.AnchorValue < Params.MaxValue * Params.RegenDelayBelowFraction;
+    return Line.AnchorTime + (bApplyDelay ? Params.RegenDelay : 0.0f);
+}
+
+float FResourceSim::GetSlope(const FResourceParams& Params, const FResourceLine& Line)
+{
+    return Line.DrainRate > 0.0f ? -Line.DrainRate : Params.RegenRate;
+}
+
+float FResourceSim::GetValueAtTime(const FResourceParams& Params, const FResourceLine& Line, double Time)
+{
+    const double MoveStartTime = GetMoveStartTime(Params, Line);
+    if (Time <= MoveStartTime)
+    {
+        return Line.AnchorValue;
+    }
+    
+    const float Value = Line.AnchorValue + GetSlope(Params, Line) * static_cast<float>(Time - MoveStartTime);
+    return FMath::Clamp(Value, 0.0f, Params.MaxValue);
+}
+
+double FResourceSim::ComputeNextEventTime(const FResourceParams& Params, const FResourceLine& Line, double Now,
+    TConstArrayView<float> Thresholds, float ChangeNotifyStep, bool bRegenStartDispatched)
+{
+    double NextTime = TNumericLimits<double>::Max();
+    
+    const double MoveStartTime = GetMoveStartTime(Params, Line);
+    const float Slope = GetSlope(Params, Line);
+    
+    // Regeneration starting after the delay
+    if (Line.DrainRate <= 0.0f && !bRegenStartDispatched && Params.RegenRate > 0.0f && Line.AnchorValue < Params.MaxValue && MoveStartTime > Now)
+    {
+        NextTime = MoveStartTime;
+    }
+    
+    if (Slope == 0.0f)
+    {
+        return NextTime;
+    }
+    
+    const float Value = GetValueAtTime(Params, Line, Now);
+    const float Bound = Slope < 0.0f ? 0.0f : Params.MaxValue;
+    if (Value == Bound)
+    {
+        return NextTime;
+    }
+    
+    auto ConsiderTarget = [&](float Target)
+    {
+        // Only levels strictly ahead of the value in the direction it is moving
+        const bool bAhead = Slope < 0.0f ? (Target < Value && Target >= Bound) : (Target > Value && Target <= Bound);
+        if (bAhead)
+        {
+            const double TargetTime = MoveStartTime + (Target - Line.AnchorValue) / Slope;
+            if (TargetTime > Now)
+            {
+                NextTime = FMath::Min(NextTime, TargetTime);
+            }
+        }
+    };
+    
+    ConsiderTarget(Bound);
+    
+    for (const float Threshold : Thresholds)
+    {
+        ConsiderTarget(Threshold);
+    }
+    
+    if (ChangeNotifyStep > 0.0f)
+    {
+        const float StepIndex = FMath::FloorToFloat(Value / ChangeNotifyStep);
+        ConsiderTarget(Slope < 0.0f ? StepIndex * ChangeNotifyStep : (StepIndex + 1.0f) * ChangeNotifyStep);
+        ConsiderTarget(Slope < 0.0f ? (StepIndex - 1.0f) * ChangeNotifyStep : (StepIndex + 2.0f) * ChangeNotifyStep);
+    }
+    
+    return NextTime;
+}
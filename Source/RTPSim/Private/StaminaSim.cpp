@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StaminaSim.h"
+
+void FStaminaSim::Step(FStaminaState& State, const FStaminaParams& Params, bool bWantsToSprint, float DeltaSeconds)
+{
+    const float StaminaFraction = State.Stamina / Params.MaxStamina;
+    
+    if (State.bIsSprinting && !bWantsToSprint)
+    {
+        // Stopped by the player, exhausted stamina waits out the regen delay first
+        State.bIsSprinting = false;
+        State.RegenDelayRemaining = StaminaFraction < Params.RecoveryBuffer ? Params.RegenDelay : 0.0f;
+    }
+    else if (!State.bIsSprinting && bWantsToSprint && StaminaFraction > Params.RecoveryBuffer && StaminaFraction > Params.ConsumptionBuffer)
+    {
+        State.bIsSprinting = true;
+    }
+    
+    if (State.bIsSprinting)
+    {
+        State.Stamina -= Params.ConsumptionRate * DeltaSeconds;
+        if (State.Stamina <= 0.0f)
+        {
+            State.Stamina = 0.0f;
+            State.bIsSprinting = false;
+            State.RegenDelayRemaining = Params.RegenDelay;
+        }
+    }
+    else if (State.RegenDelayRemaining > 0.0f)
+    {
+        State.RegenDelayRemaining -= DeltaSeconds;
+    }
+    else
+    {
+        State.Stamina = FMath::Min(State.Stamina + Params.RecoveryRate * DeltaSeconds, Params.MaxStamina);
+    }
+}
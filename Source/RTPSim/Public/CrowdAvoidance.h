@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// One crowd member, on the ground plane
+struct FCrowdAgent
+{
+    FVector2f Position = FVector2f::ZeroVector;
+    FVector2f Velocity = FVector2f::ZeroVector;
+
+    // Velocity the agent would take without anyone in the way
+    FVector2f PreferredVelocity = FVector2f::ZeroVector;
+
+    float Radius = 40.0f;
+    float MaxSpeed = 600.0f;
+
+    // Agents that do not steer (attacking, stunned) keep their velocity and the others avoid them alone
+    bool bResponsive = true;
+};
+
+struct FCrowdAvoidanceSettings
+{
+    // Only agents this close are considered
+    float NeighborRadius = 500.0f;
+
+    // Closest neighbors kept per agent
+    int32 MaxNeighbors = 10;
+
+    // Seconds ahead in which collisions with other agents are avoided
+    float TimeHorizon = 1.0f;
+};
+
+/**
+ * Engine-independent reciprocal velocity obstacle (ORCA) solver.
+ * Solve() indexes every agent in a uniform grid and computes all avoidance velocities in one batched pass,
+ * each agent only reading the shared inputs, so the pass runs in parallel.
+ */
+class RTPSIM_API FCrowdAvoidance
+{
+public:
+    // Write a collision-free velocity for every agent to OutVelocities, in agent order. A zero DeltaTime
+    // skips avoidance and writes the preferred velocity of responsive agents
+    void Solve(TConstArrayView<FCrowdAgent> Agents, const FCrowdAvoidanceSettings& Settings, float DeltaTime, TArray<FVector2f>& OutVelocities);
+
+private:
+    // Boundary of a half-plane of permitted velocities, the permitted side is left of Direction
+    struct FOrcaLine
+    {
+        FVector2f Point;
+        FVector2f Direction;
+    };
+
+    using FLineArray = TArray<FOrcaLine, TInlineAllocator<16>>;
+
+    FIntPoint GetCell(const FVector2f& Position) const;
+
+    void BuildGrid(TConstArrayView<FCrowdAgent> Agents, float CellSize);
+
+    // Closest agents within the neighbor radius, sorted by distance
+    void FindNeighbors(TConstArrayView<FCrowdAgent> Agents, int32 AgentIndex, const FCrowdAvoidanceSettings& Settings, TArray<int32, TInlineAllocator<16>>& OutNeighbors) const;
+
+    static FVector2f SolveAgent(TConstArrayView<FCrowdAgent> Agents, int32 AgentIndex, TConstArrayView<int32> Neighbors, const FCrowdAvoidanceSettings& Settings, float DeltaTime);
+
+    static bool LinearProgram1(const FLineArray& Lines, int32 LineIndex, float Radius, const FVector2f& OptVelocity, bool bDirectionOpt, FVector2f& Result);
+
+    // Returns the index of the first line that could not be satisfied, Lines.Num() on success
+    static int32 LinearProgram2(const FLineArray& Lines, float Radius, const FVector2f& OptVelocity, bool bDirectionOpt, FVector2f& Result);
+
+    // Velocity violating the half-planes from BeginLine on by the least amount, for dense crowds without a solution
+    static void LinearProgram3(const FLineArray& Lines, int32 BeginLine, float Radius, FVector2f& Result);
+
+    float InvCellSize = 0.0f;
+    TMap<FIntPoint, TArray<int32>> Cells;
+};
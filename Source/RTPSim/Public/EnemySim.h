@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Mirrors EEnemyState, which is a reflected enum of the game module
+enum class EEnemySimState : uint8
+{
+    Idle,
+    Investigating,
+    Chasing,
+    Attacking,
+    Stunned,
+    Dead
+};
+
+// Everything the decide phase reads about one enemy and the player
+struct FEnemySimInput
+{
+    EEnemySimState State = EEnemySimState::Idle;
+    bool bIsDead = false;
+    bool bHasPlayer = false;
+    bool bAttackOnCooldown = false;
+    
+    // A squad mate saw the player moments ago, so a chase can go on without a sight trace of its own
+    bool bSquadSeesPlayer = false;
+    float AttackRange = 150.0f;
+    FVector Location = FVector::ZeroVector;
+    FVector PlayerLocation = FVector::ZeroVector;
+    FVector LastKnownPlayerLocation = FVector::ZeroVector;
+};
+
+// Output of the read-only decide phase, executed by ABaseEnemy::ApplyDecision on the game thread
+struct FEnemyDecision
+{
+    bool bAttack = false;
+    bool bMoveToPlayer = false;
+    bool bMoveToLastKnownLocation = false;
+    bool bStartMemoryTimer = false;
+    bool bResumeChase = false;
+    bool bUpdateLastKnownLocation = false;
+    FVector LastKnownPlayerLocation = FVector::ZeroVector;
+    
+    // The enemy saw the player with its own trace, and shares the sighting with its squad
+    bool bReportSighting = false;
+    
+    // Random stream seed after the decide phase's rolls, only committed when the decide phase rolled at all
+    int32 RandomSeed = 0;
+    bool bAdvancedRandomStream = false;
+
+    bool operator==(const FEnemyDecision& Other) const
+    {
+        return bAttack == Other.bAttack
+            && bMoveToPlayer == Other.bMoveToPlayer
+            && bMoveToLastKnownLocation == Other.bMoveToLastKnownLocation
+            && bStartMemoryTimer == Other.bStartMemoryTimer
+            && bResumeChase == Other.bResumeChase
+            && bUpdateLastKnownLocation == Other.bUpdateLastKnownLocation
+            && LastKnownPlayerLocation == Other.LastKnownPlayerLocation
+            && bReportSighting == Other.bReportSighting
+            && RandomSeed == Other.RandomSeed
+            && bAdvancedRandomStream == Other.bAdvancedRandomStream;
+    }
+};
+
+// What a flashlight hit does to an enemy
+struct FFlashlightReaction
+{
+    bool bStun = false;
+    float StunTime = 0.0f;
+
+    // Not stunned, but curious enough to look towards the light
+    bool bInvestigate = false;
+};
+
+/**
+ * Enemy state machine rules.
+ */
+struct RTPSIM_API FEnemySim
+{
+    // Decide phase for one enemy. Line of sight is only queried when a rule needs it, and random rolls
+    // advance Stream, whose final seed is also written to OutDecision
+    static void Decide(const FEnemySimInput& Input, TFunctionRef<bool()> HasLineOfSightToPlayer, FRandomStream& Stream, FEnemyDecision& OutDecision);
+
+    // Stun chance and duration scale with the light's intensity, idle enemies may investigate instead
+    static FFlashlightReaction ReactToFlashlight(float Intensity, float Sensitivity, float StunDuration, bool bIsIdle, FRandomStream& Stream);
+};
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed-rate simulation clock, stepped from a variable frame rate.
+ * Steps are taken by the caller, so a frame that runs out of budget simply leaves them due for the next one.
+ * The interval may change between steps, e.g. when an enemy changes LOD tier.
+ */
+struct FFixedStepClock
+{
+    // Simulated time up to which steps have been taken
+    double StepTime = 0.0;
+
+    // Start the clock so the first step is due Phase (0-1) of an interval early, spreading clocks started together
+    void Reset(double Now, float Interval, float Phase = 0.0f)
+    {
+        StepTime = Now - Interval * FMath::Clamp(Phase, 0.0f, 1.0f);
+    }
+
+    // Whole steps due at Now
+    int32 GetDueSteps(double Now, float Interval) const
+    {
+        return Interval > 0.0f ? FMath::Max(0, FMath::FloorToInt32((Now - StepTime) / Interval)) : 1;
+    }
+
+    // Drop simulated time beyond MaxSteps, so a hitch never queues a burst of steps
+    void LimitCatchUp(double Now, float Interval, int32 MaxSteps)
+    {
+        StepTime = FMath::Max(StepTime, Now - static_cast<double>(Interval) * FMath::Max(MaxSteps, 1));
+    }
+
+    void ConsumeSteps(int32 Steps, float Interval)
+    {
+        StepTime += static_cast<double>(Interval) * Steps;
+    }
+
+    // Progress from the last step towards the next one, for interpolating between steps
+    float GetAlpha(double Now, float Interval) const
+    {
+        return Interval > 0.0f ? FMath::Clamp(static_cast<float>((Now - StepTime) / Interval), 0.0f, 1.0f) : 1.0f;
+    }
+};
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FFlashlightBatteryParams
+{
+    // Battery level at which the light starts to dim
+    float DimmingStartThreshold = 30.0f;
+
+    // Battery level at which the light starts to flicker
+    float LowBatteryThreshold = 20.0f;
+
+    // Flicker slots per second
+    float LowBatteryFlickerFrequency = 3.0f;
+};
+
+/**
+ * Flashlight intensity rules: strobe, battery dimming and the seeded low battery flicker.
+ */
+struct RTPSIM_API FFlashlightSim
+{
+    // One random roll per flicker slot, compared against the battery-dependent flicker chance
+    static void BuildFlickerTimeline(int32 Seed, int32 Length, TArray<float>& OutTimeline);
+
+    // Square wave starting in the on phase
+    static float EvaluateStrobeScale(float ModeTime, float StrobeInterval);
+
+    // Intensity multiplier from dimming and flicker for a steady mode, ModeTime is the time since it was selected
+    static float EvaluateBatteryScale(const FFlashlightBatteryParams& Params, TConstArrayView<float> FlickerTimeline, float BatteryLife, float ModeTime);
+};
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Locomotion cycles baked into an impostor's vertex animation texture
+enum class EImpostorClip : uint8
+{
+    Idle,
+    Walk,
+    Run,
+    Num
+};
+
+struct FImpostorLODSettings
+{
+    // Switch to the impostor beyond EnterDistance and back inside ExitDistance, the gap avoids flicker
+    float EnterDistance = 4000.0f;
+    float ExitDistance = 3500.0f;
+
+    // Ground speeds at which the walk and run cycles start
+    float WalkSpeed = 10.0f;
+    float RunSpeed = 350.0f;
+};
+
+// Playback of one impostor instance, evaluated entirely in the material from these values
+struct FImpostorAnimState
+{
+    EImpostorClip Clip = EImpostorClip::Idle;
+    float PlayRate = 1.0f;
+
+    // Seconds added to world time before sampling the clip
+    float Phase = 0.0f;
+};
+
+/**
+ * Engine-independent decisions for switching enemies between the skeletal mesh and the impostor.
+ */
+struct RTPSIM_API FImpostorLODPolicy
+{
+    // Whether an enemy at DistanceSquared from the viewer should render as an impostor
+    static bool ShouldUseImpostor(const FImpostorLODSettings& Settings, float DistanceSquared, bool bForceSkeletal, bool bIsImpostor);
+
+    static EImpostorClip SelectClip(const FImpostorLODSettings& Settings, float Speed);
+
+    // Change clip or play rate while keeping the normalized cycle position at Time, so the switch does not pop
+    static FImpostorAnimState Continue(const FImpostorAnimState& Current, float CurrentCycleLength,
+        EImpostorClip NewClip, float NewPlayRate, float NewCycleLength, float Time);
+
+    // Normalized 0-1 position within the cycle at Time
+    static float GetCyclePosition(const FImpostorAnimState& State, float CycleLength, float Time);
+};
+
+/**
+ * Dense mapping between instances of one instanced mesh and their owners.
+ * Removal moves the last instance into the freed slot, so the mesh never shifts more than one instance.
+ */
+class RTPSIM_API FImpostorInstanceTable
+{
+public:
+    // Append an instance for Owner and return its index
+    int32 Add(int32 Owner);
+
+    // Remove an instance; returns the owner of the last instance that now lives at InstanceIndex,
+    // or INDEX_NONE when the removed instance was the last one
+    int32 RemoveAtSwap(int32 InstanceIndex);
+
+    int32 GetOwner(int32 InstanceIndex) const { return Owners[InstanceIndex]; }
+
+    int32 Num() const { return Owners.Num(); }
+
+    const TArray<int32>& GetOwners() const { return Owners; }
+
+private:
+    TArray<int32> Owners;
+};
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EInfluenceLayer : uint8
+{
+    // Where the player is likely to be, from sightings, noises and flashlight activity
+    PlayerHeat,
+
+    // Where enemies have recently been
+    EnemyCoverage,
+
+    Num
+};
+
+struct FInfluenceMapSettings
+{
+    // Fraction of each cell's value exchanged with its four neighbors per step, 0-1
+    float Diffusion = 0.2f;
+
+    // Multiplier applied to each layer per step
+    float Decay[static_cast<int32>(EInfluenceLayer::Num)] = { 0.99f, 0.98f };
+
+    // Tiles whose values all fall below this are cleared and stop updating
+    float Epsilon = 0.01f;
+};
+
+/**
+ * Engine-independent coarse 2D influence map.
+ * Cells are grouped in square tiles and only tiles holding influence are dirty. Step() diffuses and decays the
+ * dirty tiles four cells at a time in vector registers, so a quiet map costs nothing to update.
+ * Values are kept in 0-1; tiles that are not dirty hold zeros only.
+ */
+class RTPSIM_API FInfluenceMap
+{
+public:
+    // Cells along each side of a tile, a multiple of the vector width
+    static constexpr int32 TileSize = 16;
+
+    // Cover the rectangle from Min to Max with cells of CellSize, clearing every layer
+    void Init(const FVector2f& Min, const FVector2f& Max, float CellSize);
+
+    void Reset();
+
+    bool IsValid() const { return Width > 0; }
+
+    // Add Amount to the cell at Position, saturating at 1
+    void Add(EInfluenceLayer Layer, const FVector2f& Position, float Amount);
+
+    // Diffuse and decay every dirty tile by one step
+    void Step(const FInfluenceMapSettings& Settings);
+
+    // Cell within Radius of From, other than From's own, with the most player heat net of CoverageWeight times the enemy coverage
+    bool FindBestCell(const FVector2f& From, float Radius, float CoverageWeight, float MinScore, FVector2f& OutPosition) const;
+
+    // Cell holding the most of Layer, false if the layer is empty
+    bool FindMaxCell(EInfluenceLayer Layer, FVector2f& OutPosition, float& OutValue) const;
+
+    float GetValue(EInfluenceLayer Layer, const FVector2f& Position) const;
+
+    FIntPoint GetSize() const { return FIntPoint(Width, Height); }
+
+    float GetCellSize() const { return CellSize; }
+
+    int32 GetNumTiles() const { return TilesX * TilesY; }
+
+    int32 GetNumDirtyTiles() const { return DirtyTiles.Num(); }
+
+private:
+    using FLayerData = TArray<float, TAlignedHeapAllocator<16>>;
+
+    static constexpr int32 NumLayers = static_cast<int32>(EInfluenceLayer::Num);
+    static constexpr int32 CellsPerTile = TileSize * TileSize;
+
+    // Zero columns left and right of each row, so the shifted loads at the borders stay in bounds
+    static constexpr int32 RowPadding = 4;
+
+    bool GetCell(const FVector2f& Position, FIntPoint& OutCell) const;
+
+    FVector2f GetCellCenter(const FIntPoint& Cell) const;
+
+    int32 GetIndex(int32 X, int32 Y) const { return (Y + 1) * Stride + RowPadding + X; }
+
+    void MarkTileDirty(int32 TileX, int32 TileY);
+
+    // Write the diffused and decayed cells of one tile to Out, reading the current values only
+    void DiffuseTile(const FLayerData& Data, int32 TileX, int32 TileY, float Keep, float Spread, float* Out) const;
+
+    FVector2f Origin = FVector2f::ZeroVector;
+    float CellSize = 0.0f;
+    float InvCellSize = 0.0f;
+
+    // Size in cells, whole tiles
+    int32 Width = 0;
+    int32 Height = 0;
+    int32 TilesX = 0;
+    int32 TilesY = 0;
+
+    // Floats per row, including the padding, with a zero row above and below the map
+    int32 Stride = 0;
+
+    FLayerData Layers[NumLayers];
+
+    TArray<bool> TileDirty;
+    TArray<int32> DirtyTiles;
+
+    // Scratch buffers reused across steps
+    TArray<int32> StepTiles;
+    FLayerData StepResults;
+};
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// How much of the character movement simulation an enemy runs
+enum class EEnemyMovementLOD : uint8
+{
+    // Walking with floor sweeps, step-ups and collision every frame
+    Full,
+
+    // NavWalking along the navmesh at a reduced tick rate, no per-tick floor sweeps
+    Reduced,
+
+    // No movement simulation at all
+    Dormant
+};
+
+struct FMovementLODSettings
+{
+    // Beyond this distance from every player enemies drop to Reduced
+    float ReducedDistance = 2500.0f;
+
+    // Beyond this distance idle enemies go Dormant
+    float DormantDistance = 5000.0f;
+
+    // Distance an enemy must come back inside a threshold before returning to the closer tier
+    float Hysteresis = 300.0f;
+};
+
+/**
+ * Engine-independent choice of an enemy's movement tier.
+ */
+struct RTPSIM_API FMovementLODPolicy
+{
+    // DistanceSquared is to the nearest player; combat always gets full movement, only idle enemies may go dormant
+    static EEnemyMovementLOD Select(const FMovementLODSettings& Settings, float DistanceSquared, bool bInCombat, bool bIsIdle, EEnemyMovementLOD Current);
+};
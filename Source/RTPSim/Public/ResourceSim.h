@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FResourceParams
+{
+    float MaxValue = 100.0f;
+
+    // Units regenerated per second once the regen delay has passed
+    float RegenRate = 0.0f;
+
+    // Seconds after draining stops before regeneration begins
+    float RegenDelay = 0.0f;
+
+    // The regen delay only applies when draining stopped below this fraction of MaxValue
+    float RegenDelayBelowFraction = 1.0f;
+};
+
+// One linear segment of a resource's value
+struct FResourceLine
+{
+    float AnchorValue = 0.0f;
+    double AnchorTime = 0.0;
+
+    // Units drained per second, 0 means the resource regenerates instead
+    float DrainRate = 0.0f;
+};
+
+/**
+ * Analytic drain and regeneration of a resource such as stamina or battery.
+ * The value is a function of time along the active line, nothing is integrated per frame.
+ */
+struct RTPSIM_API FResourceSim
+{
+    // Time the value starts moving along the line, after the regen delay when regenerating
+    static double GetMoveStartTime(const FResourceParams& Params, const FResourceLine& Line);
+
+    static float GetSlope(const FResourceParams& Params, const FResourceLine& Line);
+
+    static float GetValueAtTime(const FResourceParams& Params, const FResourceLine& Line, double Time);
+
+    // Earliest time after Now at which regeneration starts or the value reaches a bound, a threshold or
+    // a multiple of ChangeNotifyStep. TNumericLimits<double>::Max() when nothing is ahead
+    static double ComputeNextEventTime(const FResourceParams& Params, const FResourceLine& Line, double Now,
+        TConstArrayView<float> Thresholds, float ChangeNotifyStep, bool bRegenStartDispatched);
+};
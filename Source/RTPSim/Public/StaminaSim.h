@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FStaminaParams
+{
+    float MaxStamina = 100.0f;
+
+    // Stamina used per second while sprinting
+    float ConsumptionRate = 10.0f;
+
+    // Stamina recovered per second while not sprinting
+    float RecoveryRate = 5.0f;
+
+    // Seconds to wait before recovering after stamina was exhausted
+    float RegenDelay = 2.0f;
+
+    // Below this fraction stamina counts as exhausted and must wait out the regen delay
+    float RecoveryBuffer = 0.01f;
+
+    // Fraction of stamina needed to start sprinting
+    float ConsumptionBuffer = 0.3f;
+};
+
+struct FStaminaState
+{
+    bool bIsSprinting = false;
+    float Stamina = 100.0f;
+    float RegenDelayRemaining = 0.0f;
+};
+
+/**
+ * Sprint and stamina rules, stepped once per movement update.
+ */
+struct RTPSIM_API FStaminaSim
+{
+    // Advance sprint state and stamina by DeltaSeconds with the player's current sprint request
+    static void Step(FStaminaState& State, const FStaminaParams& Params, bool bWantsToSprint, float DeltaSeconds);
+};
@@ -0,0 +1,14 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class RTPSim : ModuleRules
+{
+	public RTPSim(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// Gameplay rules only: no UObjects and nothing from the engine beyond Core's math and containers
+		PublicDependencyModuleNames.AddRange(new string[] { "Core" });
+	}
+}
@@ -0,0 +1,235 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrowdAvoidance.h"
+#include "TestHarness.h"
+
+namespace
+{
+    FCrowdAgent MakeAgent(const FVector2f& Position, const FVector2f& PreferredVelocity)
+    {
+        FCrowdAgent Agent;
+        Agent.Position = Position;
+        Agent.Velocity = PreferredVelocity;
+        Agent.PreferredVelocity = PreferredVelocity;
+        return Agent;
+    }
+
+    // Advance the agents for Steps steps and return the closest any two came to each other, between their edges
+    float Simulate(TArray<FCrowdAgent>& Agents, int32 Steps, float DeltaTime)
+    {
+        FCrowdAvoidance Avoidance;
+        const FCrowdAvoidanceSettings Settings;
+        TArray<FVector2f> Velocities;
+        float MinGap = TNumericLimits<float>::Max();
+
+        for (int32 Step = 0; Step < Steps; ++Step)
+        {
+            Avoidance.Solve(Agents, Settings, DeltaTime, Velocities);
+            for (int32 Index = 0; Index < Agents.Num(); ++Index)
+            {
+                Agents[Index].Velocity = Velocities[Index];
+                Agents[Index].Position += Velocities[Index] * DeltaTime;
+            }
+
+            for (int32 A = 0; A < Agents.Num(); ++A)
+            {
+                for (int32 B = A + 1; B < Agents.Num(); ++B)
+                {
+                    const float Gap = FVector2f::Distance(Agents[A].Position, Agents[B].Position) - Agents[A].Radius - Agents[B].Radius;
+                    MinGap = FMath::Min(MinGap, Gap);
+                }
+            }
+        }
+        return MinGap;
+    }
+}
+
+TEST_CASE("RTPSim::CrowdAvoidance::A lone agent keeps its preferred velocity", "[RTPSim][CrowdAvoidance]")
+{
+    const FCrowdAgent Agents[] = { MakeAgent(FVector2f(0.0f, 0.0f), FVector2f(300.0f, 0.0f)) };
+
+    FCrowdAvoidance Avoidance;
+    TArray<FVector2f> Velocities;
+    Avoidance.Solve(Agents, FCrowdAvoidanceSettings(), 1.0f / 30.0f, Velocities);
+
+    REQUIRE(Velocities.Num() == 1);
+    CHECK(Velocities[0].Equals(FVector2f(300.0f, 0.0f), 0.01f));
+}
+
+TEST_CASE("RTPSim::CrowdAvoidance::Distant agents do not affect each other", "[RTPSim][CrowdAvoidance]")
+{
+    const FCrowdAgent Agents[] = {
+        MakeAgent(FVector2f(0.0f, 0.0f), FVector2f(300.0f, 0.0f)),
+        MakeAgent(FVector2f(0.0f, 5000.0f), FVector2f(-300.0f, 0.0f))
+    };
+
+    FCrowdAvoidance Avoidance;
+    TArray<FVector2f> Velocities;
+    Avoidance.Solve(Agents, FCrowdAvoidanceSettings(), 1.0f / 30.0f, Velocities);
+
+    REQUIRE(Velocities.Num() == 2);
+    CHECK(Velocities[0].Equals(Agents[0].PreferredVelocity, 0.01f));
+    CHECK(Velocities[1].Equals(Agents[1].PreferredVelocity, 0.01f));
+}
+
+TEST_CASE("RTPSim::CrowdAvoidance::Velocities never exceed the agent's max speed", "[RTPSim][CrowdAvoidance]")
+{
+    FRandomStream Stream(99);
+    TArray<FCrowdAgent> Agents;
+    for (int32 Index = 0; Index < 32; ++Index)
+    {
+        FCrowdAgent Agent = MakeAgent(FVector2f(Stream.FRandRange(-600.0f, 600.0f), Stream.FRandRange(-600.0f, 600.0f)),
+            FVector2f(Stream.FRandRange(-1000.0f, 1000.0f), Stream.FRandRange(-1000.0f, 1000.0f)));
+        Agent.MaxSpeed = Stream.FRandRange(200.0f, 600.0f);
+        Agents.Add(Agent);
+    }
+
+    FCrowdAvoidance Avoidance;
+    TArray<FVector2f> Velocities;
+    Avoidance.Solve(Agents, FCrowdAvoidanceSettings(), 1.0f / 30.0f, Velocities);
+
+    REQUIRE(Velocities.Num() == Agents.Num());
+    for (int32 Index = 0; Index < Agents.Num(); ++Index)
+    {
+        CHECK(Velocities[Index].Size() <= Agents[Index].MaxSpeed + 0.1f);
+    }
+}
+
+TEST_CASE("RTPSim::CrowdAvoidance::Unresponsive agents keep their velocity", "[RTPSim][CrowdAvoidance]")
+{
+    FCrowdAgent Agents[] = {
+        MakeAgent(FVector2f(0.0f, 0.0f), FVector2f(300.0f, 0.0f)),
+        MakeAgent(FVector2f(150.0f, 0.0f), FVector2f(-300.0f, 0.0f))
+    };
+    Agents[1].bResponsive = false;
+
+    FCrowdAvoidance Avoidance;
+    TArray<FVector2f> Velocities;
+    Avoidance.Solve(Agents, FCrowdAvoidanceSettings(), 1.0f / 30.0f, Velocities);
+
+    REQUIRE(Velocities.Num() == 2);
+    CHECK(Velocities[1] == Agents[1].Velocity);
+
+    // The responsive agent takes the whole avoidance effort
+    CHECK_FALSE(Velocities[0].Equals(Agents[0].PreferredVelocity, 1.0f));
+}
+
+TEST_CASE("RTPSim::CrowdAvoidance::A zero delta frame writes every velocity", "[RTPSim][CrowdAvoidance]")
+{
+    // Close enough that a solve would change the responsive agent's velocity
+    FCrowdAgent Agents[] = {
+        MakeAgent(FVector2f(0.0f, 0.0f), FVector2f(300.0f, 0.0f)),
+        MakeAgent(FVector2f(150.0f, 0.0f), FVector2f(-300.0f, 0.0f))
+    };
+    Agents[1].bResponsive = false;
+    Agents[1].Velocity = FVector2f(-120.0f, 40.0f);
+
+    // Poison the reused array, the solve must not leave stale values behind
+    FCrowdAvoidance Avoidance;
+    TArray<FVector2f> Velocities;
+    Velocities.Init(FVector2f(12345.0f, -12345.0f), 2);
+    Avoidance.Solve(Agents, FCrowdAvoidanceSettings(), 0.0f, Velocities);
+
+    REQUIRE(Velocities.Num() == 2);
+    CHECK(Velocities[0] == Agents[0].PreferredVelocity);
+    CHECK(Velocities[1] == Agents[1].Velocity);
+}
+
+TEST_CASE("RTPSim::CrowdAvoidance::Head-on agents pass without touching", "[RTPSim][CrowdAvoidance]")
+{
+    TArray<FCrowdAgent> Agents = {
+        MakeAgent(FVector2f(-1000.0f, 0.0f), FVector2f(300.0f, 0.0f)),
+        MakeAgent(FVector2f(1000.0f, 1.0f), FVector2f(-300.0f, 0.0f))
+    };
+
+    const float MinGap = Simulate(Agents, 300, 1.0f / 30.0f);
+    CHECK(MinGap > -1.0f);
+
+    // Both got past each other
+    CHECK(Agents[0].Position.X > 1000.0f);
+    CHECK(Agents[1].Position.X < -1000.0f);
+}
+
+TEST_CASE("RTPSim::CrowdAvoidance::A ring of agents crossing the center does not overlap", "[RTPSim][CrowdAvoidance]")
+{
+    // Below the parallel solve threshold, the low level tests run single-threaded
+    constexpr int32 NumAgents = 24;
+    constexpr float RingRadius = 800.0f;
+
+    TArray<FCrowdAgent> Agents;
+    TArray<FVector2f> Goals;
+    for (int32 Index = 0; Index < NumAgents; ++Index)
+    {
+        const float Angle = UE_TWO_PI * Index / NumAgents;
+        const FVector2f Position(RingRadius * FMath::Cos(Angle), RingRadius * FMath::Sin(Angle));
+        Agents.Add(MakeAgent(Position, -Position.GetSafeNormal() * 300.0f));
+        Goals.Add(-Position);
+    }
+
+    FCrowdAvoidance Avoidance;
+    const FCrowdAvoidanceSettings Settings;
+    TArray<FVector2f> Velocities;
+    constexpr float DeltaTime = 1.0f / 30.0f;
+    float MinGap = TNumericLimits<float>::Max();
+
+    for (int32 Step = 0; Step < 600; ++Step)
+    {
+        for (int32 Index = 0; Index < NumAgents; ++Index)
+        {
+            const FVector2f ToGoal = Goals[Index] - Agents[Index].Position;
+            Agents[Index].PreferredVelocity = ToGoal.Size() > 300.0f * DeltaTime ? ToGoal.GetSafeNormal() * 300.0f : ToGoal / DeltaTime;
+        }
+
+        Avoidance.Solve(Agents, Settings, DeltaTime, Velocities);
+        for (int32 Index = 0; Index < NumAgents; ++Index)
+        {
+            Agents[Index].Velocity = Velocities[Index];
+            Agents[Index].Position += Velocities[Index] * DeltaTime;
+        }
+
+        for (int32 A = 0; A < NumAgents; ++A)
+        {
+            for (int32 B = A + 1; B < NumAgents; ++B)
+            {
+                MinGap = FMath::Min(MinGap, FVector2f::Distance(Agents[A].Position, Agents[B].Position) - Agents[A].Radius - Agents[B].Radius);
+            }
+        }
+    }
+
+    // ORCA allows slight overlaps from the discrete step, never agents walking through each other
+    CHECK(MinGap > -5.0f);
+
+    int32 Arrived = 0;
+    for (int32 Index = 0; Index < NumAgents; ++Index)
+    {
+        Arrived += FVector2f::Distance(Agents[Index].Position, Goals[Index]) < 100.0f;
+    }
+    CHECK(Arrived == NumAgents);
+}
+
+TEST_CASE("RTPSim::CrowdAvoidance::Solve is deterministic", "[RTPSim][CrowdAvoidance]")
+{
+    FRandomStream Stream(5);
+    TArray<FCrowdAgent> Agents;
+    for (int32 Index = 0; Index < 48; ++Index)
+    {
+        Agents.Add(MakeAgent(FVector2f(Stream.FRandRange(-800.0f, 800.0f), Stream.FRandRange(-800.0f, 800.0f)),
+            FVector2f(Stream.FRandRange(-400.0f, 400.0f), Stream.FRandRange(-400.0f, 400.0f))));
+    }
+
+    FCrowdAvoidance AvoidanceA;
+    FCrowdAvoidance AvoidanceB;
+    TArray<FVector2f> VelocitiesA;
+    TArray<FVector2f> VelocitiesB;
+    AvoidanceA.Solve(Agents, FCrowdAvoidanceSettings(), 1.0f / 30.0f, VelocitiesA);
+    AvoidanceB.Solve(Agents, FCrowdAvoidanceSettings(), 1.0f / 30.0f, VelocitiesB);
+
+    // The solver is reused across frames, a second solve on it must not see the first one's grid
+    TArray<FVector2f> VelocitiesC;
+    AvoidanceA.Solve(Agents, FCrowdAvoidanceSettings(), 1.0f / 30.0f, VelocitiesC);
+
+    REQUIRE(VelocitiesA.Num() == Agents.Num());
+    CHECK(VelocitiesA == VelocitiesB);
+    CHECK(VelocitiesA == VelocitiesC);
+}
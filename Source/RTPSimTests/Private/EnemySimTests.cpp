@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemySim.h"
+#include "TestHarness.h"
+
+namespace
+{
+    // A chasing enemy out of attack range with the player ahead of it
+    FEnemySimInput MakeChaseInput()
+    {
+        FEnemySimInput Input;
+        Input.State = EEnemySimState::Chasing;
+        Input.bHasPlayer = true;
+        Input.AttackRange = 150.0f;
+        Input.Location = FVector(0.0f, 0.0f, 0.0f);
+        Input.PlayerLocation = FVector(1000.0f, 0.0f, 0.0f);
+        Input.LastKnownPlayerLocation = FVector(500.0f, 0.0f, 0.0f);
+        return Input;
+    }
+
+    FEnemyDecision Decide(const FEnemySimInput& Input, bool bLineOfSight, int32* OutSightQueries = nullptr)
+    {
+        FRandomStream Stream(7);
+        FEnemyDecision Decision;
+        FEnemySim::Decide(Input, [bLineOfSight, OutSightQueries]()
+        {
+            if (OutSightQueries)
+            {
+                ++*OutSightQueries;
+            }
+            return bLineOfSight;
+        }, Stream, Decision);
+        return Decision;
+    }
+}
+
+TEST_CASE("RTPSim::EnemySim::Chasing attacks in range", "[RTPSim][EnemySim]")
+{
+    FEnemySimInput Input = MakeChaseInput();
+    Input.PlayerLocation = FVector(100.0f, 0.0f, 0.0f);
+
+    int32 SightQueries = 0;
+    const FEnemyDecision Decision = Decide(Input, true, &SightQueries);
+    CHECK(Decision.bAttack);
+    CHECK_FALSE(Decision.bMoveToPlayer);
+    CHECK(SightQueries == 0);
+
+    SECTION("but not while the attack is on cooldown")
+    {
+        Input.bAttackOnCooldown = true;
+        const FEnemyDecision CooldownDecision = Decide(Input, true);
+        CHECK_FALSE(CooldownDecision.bAttack);
+        CHECK(CooldownDecision.bMoveToPlayer);
+    }
+}
+
+TEST_CASE("RTPSim::EnemySim::Chasing follows a visible player", "[RTPSim][EnemySim]")
+{
+    const FEnemySimInput Input = MakeChaseInput();
+    const FEnemyDecision Decision = Decide(Input, true);
+
+    CHECK(Decision.bMoveToPlayer);
+    CHECK(Decision.bUpdateLastKnownLocation);
+    CHECK(Decision.LastKnownPlayerLocation == Input.PlayerLocation);
+    CHECK(Decision.bReportSighting);
+    CHECK_FALSE(Decision.bStartMemoryTimer);
+}
+
+TEST_CASE("RTPSim::EnemySim::Chasing on a squad sighting skips the sight query", "[RTPSim][EnemySim]")
+{
+    FEnemySimInput Input = MakeChaseInput();
+    Input.bSquadSeesPlayer = true;
+
+    int32 SightQueries = 0;
+    const FEnemyDecision Decision = Decide(Input, false, &SightQueries);
+    CHECK(SightQueries == 0);
+    CHECK(Decision.bMoveToPlayer);
+
+    // The squad already knows, the sighting is not reported back to it
+    CHECK_FALSE(Decision.bReportSighting);
+}
+
+TEST_CASE("RTPSim::EnemySim::Chasing a hidden player falls back to memory", "[RTPSim][EnemySim]")
+{
+    const FEnemyDecision Decision = Decide(MakeChaseInput(), false);
+
+    CHECK(Decision.bMoveToLastKnownLocation);
+    CHECK(Decision.bStartMemoryTimer);
+    CHECK_FALSE(Decision.bMoveToPlayer);
+    CHECK_FALSE(Decision.bUpdateLastKnownLocation);
+    CHECK_FALSE(Decision.bReportSighting);
+}
+
+TEST_CASE("RTPSim::EnemySim::Investigating resumes the chase on sight", "[RTPSim][EnemySim]")
+{
+    FEnemySimInput Input = MakeChaseInput();
+    Input.State = EEnemySimState::Investigating;
+
+    const FEnemyDecision Seen = Decide(Input, true);
+    CHECK(Seen.bResumeChase);
+    CHECK(Seen.bReportSighting);
+
+    const FEnemyDecision Hidden = Decide(Input, false);
+    CHECK(Hidden == Decide(FEnemySimInput(), false));
+}
+
+TEST_CASE("RTPSim::EnemySim::Other states make no decision", "[RTPSim][EnemySim]")
+{
+    const EEnemySimState States[] = { EEnemySimState::Idle, EEnemySimState::Attacking, EEnemySimState::Stunned, EEnemySimState::Dead };
+    for (const EEnemySimState State : States)
+    {
+        FEnemySimInput Input = MakeChaseInput();
+        Input.State = State;
+        Input.bIsDead = State == EEnemySimState::Dead;
+
+        int32 SightQueries = 0;
+        const FEnemyDecision Decision = Decide(Input, true, &SightQueries);
+        CHECK(SightQueries == 0);
+        CHECK_FALSE(Decision.bAttack);
+        CHECK_FALSE(Decision.bMoveToPlayer);
+        CHECK_FALSE(Decision.bMoveToLastKnownLocation);
+        CHECK_FALSE(Decision.bResumeChase);
+    }
+
+    SECTION("a dead enemy ignores its state")
+    {
+        FEnemySimInput Input = MakeChaseInput();
+        Input.bIsDead = true;
+        CHECK_FALSE(Decide(Input, true).bMoveToPlayer);
+    }
+}
+
+TEST_CASE("RTPSim::EnemySim::Decide is a pure function of its input and stream", "[RTPSim][EnemySim]")
+{
+    FRandomStream SetupStream(1234);
+    for (int32 Iteration = 0; Iteration < 1000; ++Iteration)
+    {
+        FEnemySimInput Input;
+        Input.State = static_cast<EEnemySimState>(SetupStream.RandRange(0, static_cast<int32>(EEnemySimState::Dead)));
+        Input.bIsDead = Input.State == EEnemySimState::Dead;
+        Input.bHasPlayer = SetupStream.FRand() < 0.9f;
+        Input.bAttackOnCooldown = SetupStream.FRand() < 0.5f;
+        Input.bSquadSeesPlayer = SetupStream.FRand() < 0.2f;
+        Input.PlayerLocation = FVector(SetupStream.FRandRange(-400.0f, 400.0f), SetupStream.FRandRange(-400.0f, 400.0f), 0.0f);
+        const bool bLineOfSight = SetupStream.FRand() < 0.5f;
+        const int32 Seed = SetupStream.RandHelper(MAX_int32);
+
+        FRandomStream StreamA(Seed);
+        FRandomStream StreamB(Seed);
+        FEnemyDecision DecisionA;
+        FEnemyDecision DecisionB;
+        FEnemySim::Decide(Input, [bLineOfSight]() { return bLineOfSight; }, StreamA, DecisionA);
+        FEnemySim::Decide(Input, [bLineOfSight]() { return bLineOfSight; }, StreamB, DecisionB);
+
+        REQUIRE(DecisionA == DecisionB);
+        CHECK(DecisionA.RandomSeed == StreamA.GetCurrentSeed());
+        CHECK(DecisionA.bAdvancedRandomStream == (StreamA.GetCurrentSeed() != Seed));
+    }
+}
+
+TEST_CASE("RTPSim::EnemySim::Flashlight stun chance", "[RTPSim][EnemySim]")
+{
+    constexpr int32 Rolls = 10000;
+
+    SECTION("no light never stuns")
+    {
+        FRandomStream Stream(1);
+        for (int32 Roll = 0; Roll < Rolls; ++Roll)
+        {
+            CHECK_FALSE(FEnemySim::ReactToFlashlight(0.0f, 1.0f, 3.0f, false, Stream).bStun);
+        }
+    }
+
+    SECTION("stuns are capped at three in four and last between 1 second and the stun duration")
+    {
+        FRandomStream Stream(2);
+        int32 Stuns = 0;
+        for (int32 Roll = 0; Roll < Rolls; ++Roll)
+        {
+            const FFlashlightReaction Reaction = FEnemySim::ReactToFlashlight(100000.0f, 10.0f, 3.0f, false, Stream);
+            if (Reaction.bStun)
+            {
+                ++Stuns;
+                CHECK(Reaction.StunTime >= 1.0f);
+                CHECK(Reaction.StunTime <= 3.0f);
+            }
+        }
+        CHECK(FMath::Abs(Stuns / static_cast<float>(Rolls) - 0.75f) < 0.03f);
+    }
+
+    SECTION("only idle enemies investigate bright light")
+    {
+        FRandomStream Stream(3);
+        int32 Investigations = 0;
+        for (int32 Roll = 0; Roll < Rolls; ++Roll)
+        {
+            CHECK_FALSE(FEnemySim::ReactToFlashlight(5000.0f, 0.0f, 3.0f, false, Stream).bInvestigate);
+            Investigations += FEnemySim::ReactToFlashlight(5000.0f, 0.0f, 3.0f, true, Stream).bInvestigate;
+            CHECK_FALSE(FEnemySim::ReactToFlashlight(3000.0f, 0.0f, 3.0f, true, Stream).bInvestigate);
+        }
+        CHECK(FMath::Abs(Investigations / static_cast<float>(Rolls) - 0.5f) < 0.03f);
+    }
+}
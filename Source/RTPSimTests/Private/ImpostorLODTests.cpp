@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ImpostorLOD.h"
+#include "TestHarness.h"
+
+TEST_CASE("RTPSim::ImpostorLOD::Swap in and out with hysteresis", "[RTPSim][ImpostorLOD]")
+{
+    const FImpostorLODSettings Settings;
+
+    SECTION("a skeletal enemy swaps in beyond the enter distance only")
+    {
+        CHECK_FALSE(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(3000.0f), false, false));
+        CHECK_FALSE(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(3800.0f), false, false));
+        CHECK_FALSE(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(4000.0f), false, false));
+        CHECK(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(4001.0f), false, false));
+    }
+
+    SECTION("an impostor swaps out inside the exit distance only")
+    {
+        CHECK(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(5000.0f), false, true));
+        CHECK(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(3800.0f), false, true));
+        CHECK_FALSE(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(3500.0f), false, true));
+        CHECK_FALSE(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(3000.0f), false, true));
+    }
+
+    SECTION("forced skeletal wins at any distance")
+    {
+        CHECK_FALSE(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(100000.0f), true, false));
+        CHECK_FALSE(FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(100000.0f), true, true));
+    }
+
+    SECTION("an enemy jittering around the threshold switches once")
+    {
+        bool bIsImpostor = false;
+        int32 Switches = 0;
+        for (int32 Frame = 0; Frame < 1000; ++Frame)
+        {
+            // Within the hysteresis band after the first crossing
+            const float Distance = Frame == 0 ? 4100.0f : 3750.0f + 200.0f * FMath::Sin(Frame * 0.37f);
+            const bool bUseImpostor = FImpostorLODPolicy::ShouldUseImpostor(Settings, FMath::Square(Distance), false, bIsImpostor);
+            Switches += bUseImpostor != bIsImpostor;
+            bIsImpostor = bUseImpostor;
+        }
+        CHECK(Switches == 1);
+        CHECK(bIsImpostor);
+    }
+}
+
+TEST_CASE("RTPSim::ImpostorLOD::Clip selection", "[RTPSim][ImpostorLOD]")
+{
+    const FImpostorLODSettings Settings;
+    CHECK(FImpostorLODPolicy::SelectClip(Settings, 0.0f) == EImpostorClip::Idle);
+    CHECK(FImpostorLODPolicy::SelectClip(Settings, 9.0f) == EImpostorClip::Idle);
+    CHECK(FImpostorLODPolicy::SelectClip(Settings, 10.0f) == EImpostorClip::Walk);
+    CHECK(FImpostorLODPolicy::SelectClip(Settings, 200.0f) == EImpostorClip::Walk);
+    CHECK(FImpostorLODPolicy::SelectClip(Settings, 350.0f) == EImpostorClip::Run);
+    CHECK(FImpostorLODPolicy::SelectClip(Settings, 900.0f) == EImpostorClip::Run);
+}
+
+TEST_CASE("RTPSim::ImpostorLOD::Continue keeps the cycle position", "[RTPSim][ImpostorLOD]")
+{
+    FImpostorAnimState Walk;
+    Walk.Clip = EImpostorClip::Walk;
+    Walk.PlayRate = 0.8f;
+    Walk.Phase = 0.3f;
+    constexpr float WalkLength = 1.2f;
+    constexpr float RunLength = 0.7f;
+
+    const float Times[] = { 0.0f, 1.37f, 95.2f, 600.5f };
+    for (const float Time : Times)
+    {
+        const float Position = FImpostorLODPolicy::GetCyclePosition(Walk, WalkLength, Time);
+        const FImpostorAnimState Run = FImpostorLODPolicy::Continue(Walk, WalkLength, EImpostorClip::Run, 1.3f, RunLength, Time);
+
+        CHECK(Run.Clip == EImpostorClip::Run);
+        CHECK(Run.PlayRate == 1.3f);
+
+        // The switch does not pop, allowing for the wrap at the cycle end
+        const float Delta = FMath::Abs(FImpostorLODPolicy::GetCyclePosition(Run, RunLength, Time) - Position);
+        CHECK(FMath::Min(Delta, 1.0f - Delta) < 1.e-3f);
+
+        // The phase stays within one cycle so the material's float math keeps its precision
+        CHECK(Run.Phase >= 0.0f);
+        CHECK(Run.Phase <= RunLength);
+    }
+
+    SECTION("a zero length cycle is held at its start")
+    {
+        CHECK(FImpostorLODPolicy::GetCyclePosition(Walk, 0.0f, 12.0f) == 0.0f);
+    }
+}
+
+TEST_CASE("RTPSim::ImpostorLOD::Instance table bookkeeping", "[RTPSim][ImpostorLOD]")
+{
+    FImpostorInstanceTable Table;
+
+    SECTION("removing the last instance moves nothing")
+    {
+        CHECK(Table.Add(7) == 0);
+        CHECK(Table.Add(9) == 1);
+        CHECK(Table.RemoveAtSwap(1) == INDEX_NONE);
+        REQUIRE(Table.Num() == 1);
+        CHECK(Table.GetOwner(0) == 7);
+    }
+
+    SECTION("removing from the middle moves the last instance into the gap")
+    {
+        Table.Add(3);
+        Table.Add(4);
+        Table.Add(5);
+        CHECK(Table.RemoveAtSwap(0) == 5);
+        REQUIRE(Table.Num() == 2);
+        CHECK(Table.GetOwner(0) == 5);
+        CHECK(Table.GetOwner(1) == 4);
+    }
+
+    SECTION("owners and their instance indices stay in sync over random swaps")
+    {
+        // Mirrors the impostor subsystem: every owner remembers its instance, INDEX_NONE while skeletal
+        constexpr int32 NumOwners = 64;
+        TArray<int32> InstanceIndices;
+        InstanceIndices.Init(INDEX_NONE, NumOwners);
+
+        FRandomStream Stream(2024);
+        for (int32 Step = 0; Step < 10000; ++Step)
+        {
+            const int32 Owner = Stream.RandHelper(NumOwners);
+            if (InstanceIndices[Owner] == INDEX_NONE)
+            {
+                InstanceIndices[Owner] = Table.Add(Owner);
+            }
+            else
+            {
+                const int32 InstanceIndex = InstanceIndices[Owner];
+                InstanceIndices[Owner] = INDEX_NONE;
+                const int32 MovedOwner = Table.RemoveAtSwap(InstanceIndex);
+                if (MovedOwner != INDEX_NONE)
+                {
+                    REQUIRE(InstanceIndices[MovedOwner] == Table.Num());
+                    InstanceIndices[MovedOwner] = InstanceIndex;
+                }
+            }
+        }
+
+        int32 NumImpostors = 0;
+        for (int32 Owner = 0; Owner < NumOwners; ++Owner)
+        {
+            if (InstanceIndices[Owner] != INDEX_NONE)
+            {
+                ++NumImpostors;
+                REQUIRE(Table.GetOwner(InstanceIndices[Owner]) == Owner);
+            }
+        }
+        CHECK(NumImpostors == Table.Num());
+    }
+}
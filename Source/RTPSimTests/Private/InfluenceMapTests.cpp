@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InfluenceMap.h"
+#include "TestHarness.h"
+
+namespace
+{
+    constexpr float CellSize = 100.0f;
+
+    // Two tiles side by side, 32 by 16 cells
+    FInfluenceMap MakeMap()
+    {
+        FInfluenceMap Map;
+        Map.Init(FVector2f(0.0f, 0.0f), FVector2f(2 * FInfluenceMap::TileSize * CellSize, FInfluenceMap::TileSize * CellSize), CellSize);
+        return Map;
+    }
+
+    FVector2f CellCenter(int32 X, int32 Y)
+    {
+        return (FVector2f(X, Y) + 0.5f) * CellSize;
+    }
+
+    // Diffusion only, nothing decays
+    FInfluenceMapSettings MakeLosslessSettings()
+    {
+        FInfluenceMapSettings Settings;
+        Settings.Decay[static_cast<int32>(EInfluenceLayer::PlayerHeat)] = 1.0f;
+        Settings.Decay[static_cast<int32>(EInfluenceLayer::EnemyCoverage)] = 1.0f;
+        return Settings;
+    }
+
+    float SumLayer(const FInfluenceMap& Map, EInfluenceLayer Layer)
+    {
+        float Sum = 0.0f;
+        for (int32 Y = 0; Y < Map.GetSize().Y; ++Y)
+        {
+            for (int32 X = 0; X < Map.GetSize().X; ++X)
+            {
+                Sum += Map.GetValue(Layer, CellCenter(X, Y));
+            }
+        }
+        return Sum;
+    }
+}
+
+TEST_CASE("RTPSim::InfluenceMap::Init covers the bounds with whole tiles", "[RTPSim][InfluenceMap]")
+{
+    const FInfluenceMap Map = MakeMap();
+    CHECK(Map.IsValid());
+    CHECK(Map.GetSize() == FIntPoint(32, 16));
+    CHECK(Map.GetNumTiles() == 2);
+    CHECK(Map.GetNumDirtyTiles() == 0);
+}
+
+TEST_CASE("RTPSim::InfluenceMap::Diffusion spreads mass to the four neighbors", "[RTPSim][InfluenceMap]")
+{
+    const FInfluenceMapSettings Settings = MakeLosslessSettings();
+
+    SECTION("inside a tile the mass is kept")
+    {
+        FInfluenceMap Map = MakeMap();
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(6, 6), 1.0f);
+        Map.Step(Settings);
+
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(6, 6)), 0.8f, 1.e-5f));
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(5, 6)), 0.05f, 1.e-5f));
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(7, 6)), 0.05f, 1.e-5f));
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(6, 5)), 0.05f, 1.e-5f));
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(6, 7)), 0.05f, 1.e-5f));
+        CHECK(FMath::IsNearlyEqual(SumLayer(Map, EInfluenceLayer::PlayerHeat), 1.0f, 1.e-5f));
+
+        // Layers diffuse independently
+        CHECK(SumLayer(Map, EInfluenceLayer::EnemyCoverage) == 0.0f);
+    }
+
+    SECTION("at the map corner the shifted loads read the zero padding")
+    {
+        FInfluenceMap Map = MakeMap();
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(0, 0), 1.0f);
+        Map.Step(Settings);
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(0, 0)), 0.8f, 1.e-5f));
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(1, 0)), 0.05f, 1.e-5f));
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(0, 1)), 0.05f, 1.e-5f));
+
+        // Mass spread off the map is gone, nothing flows back from the padding
+        Map.Step(Settings);
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(0, 0)), 0.8f * 0.8f + 0.05f * (0.05f + 0.05f), 1.e-5f));
+    }
+
+    SECTION("at the far corner too")
+    {
+        FInfluenceMap Map = MakeMap();
+        const FIntPoint Last = Map.GetSize() - FIntPoint(1, 1);
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(Last.X, Last.Y), 1.0f);
+        Map.Step(Settings);
+        Map.Step(Settings);
+        CHECK(FMath::IsNearlyEqual(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(Last.X, Last.Y)), 0.8f * 0.8f + 0.05f * (0.05f + 0.05f), 1.e-5f));
+        CHECK(Map.GetNumDirtyTiles() == 1);
+    }
+}
+
+TEST_CASE("RTPSim::InfluenceMap::Mass spreads across a tile edge", "[RTPSim][InfluenceMap]")
+{
+    const FInfluenceMapSettings Settings = MakeLosslessSettings();
+    FInfluenceMap Map = MakeMap();
+
+    // Last column of the left tile
+    const int32 EdgeX = FInfluenceMap::TileSize - 1;
+    Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(EdgeX, 8), 1.0f);
+    REQUIRE(Map.GetNumDirtyTiles() == 1);
+
+    // Influence on the edge wakes the neighboring tile, which takes it in from the next step on
+    Map.Step(Settings);
+    CHECK(Map.GetNumDirtyTiles() == 2);
+    CHECK(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(EdgeX + 1, 8)) == 0.0f);
+
+    Map.Step(Settings);
+    CHECK(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(EdgeX + 1, 8)) > 0.0f);
+    CHECK(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(EdgeX + 2, 8)) == 0.0f);
+
+    Map.Step(Settings);
+    CHECK(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(EdgeX + 2, 8)) > 0.0f);
+
+    // Diffusion never creates mass, and values stay in range
+    CHECK(SumLayer(Map, EInfluenceLayer::PlayerHeat) <= 1.0f + 1.e-5f);
+    for (int32 X = 0; X < Map.GetSize().X; ++X)
+    {
+        const float Value = Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(X, 8));
+        CHECK(Value >= 0.0f);
+        CHECK(Value <= 1.0f);
+    }
+}
+
+TEST_CASE("RTPSim::InfluenceMap::Decay to zero clears the tile", "[RTPSim][InfluenceMap]")
+{
+    FInfluenceMapSettings Settings;
+    Settings.Decay[static_cast<int32>(EInfluenceLayer::PlayerHeat)] = 0.5f;
+    Settings.Decay[static_cast<int32>(EInfluenceLayer::EnemyCoverage)] = 0.5f;
+
+    SECTION("a decaying tile goes quiet and holds zeros only")
+    {
+        FInfluenceMap Map = MakeMap();
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(4, 4), 1.0f);
+        Map.Add(EInfluenceLayer::EnemyCoverage, CellCenter(10, 12), 1.0f);
+
+        int32 Steps = 0;
+        while (Map.GetNumDirtyTiles() > 0 && Steps < 100)
+        {
+            Map.Step(Settings);
+            ++Steps;
+        }
+        CHECK(Map.GetNumDirtyTiles() == 0);
+        CHECK(Steps < 20);
+
+        CHECK(SumLayer(Map, EInfluenceLayer::PlayerHeat) == 0.0f);
+        CHECK(SumLayer(Map, EInfluenceLayer::EnemyCoverage) == 0.0f);
+
+        FVector2f Position;
+        float Value = 0.0f;
+        CHECK_FALSE(Map.FindMaxCell(EInfluenceLayer::PlayerHeat, Position, Value));
+    }
+
+    SECTION("a tile below epsilon is cleared on its next step")
+    {
+        FInfluenceMap Map = MakeMap();
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(4, 4), 0.5f * Settings.Epsilon);
+        Map.Step(Settings);
+        CHECK(Map.GetNumDirtyTiles() == 0);
+        CHECK(Map.GetValue(EInfluenceLayer::PlayerHeat, CellCenter(4, 4)) == 0.0f);
+    }
+
+    SECTION("a quiet map does not change on a step")
+    {
+        FInfluenceMap Map = MakeMap();
+        Map.Step(Settings);
+        CHECK(Map.GetNumDirtyTiles() == 0);
+        CHECK(SumLayer(Map, EInfluenceLayer::PlayerHeat) == 0.0f);
+    }
+}
+
+TEST_CASE("RTPSim::InfluenceMap::FindBestCell", "[RTPSim][InfluenceMap]")
+{
+    FInfluenceMap Map = MakeMap();
+    const FVector2f From = CellCenter(8, 8);
+    FVector2f Position;
+
+    SECTION("the origin cell is skipped even when it holds the most heat")
+    {
+        Map.Add(EInfluenceLayer::PlayerHeat, From, 1.0f);
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(10, 8), 0.4f);
+        REQUIRE(Map.FindBestCell(From, 500.0f, 0.0f, 0.0f, Position));
+        CHECK(Position == CellCenter(10, 8));
+    }
+
+    SECTION("heat on the origin cell only finds nothing")
+    {
+        Map.Add(EInfluenceLayer::PlayerHeat, From, 1.0f);
+        CHECK_FALSE(Map.FindBestCell(From, 500.0f, 0.0f, 0.0f, Position));
+    }
+
+    SECTION("enemy coverage discounts a cell")
+    {
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(10, 8), 0.6f);
+        Map.Add(EInfluenceLayer::EnemyCoverage, CellCenter(10, 8), 0.5f);
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(6, 8), 0.4f);
+        REQUIRE(Map.FindBestCell(From, 500.0f, 1.0f, 0.0f, Position));
+        CHECK(Position == CellCenter(6, 8));
+    }
+
+    SECTION("cells beyond the radius or below the minimum score are ignored")
+    {
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(20, 8), 1.0f);
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(9, 8), 0.2f);
+        CHECK_FALSE(Map.FindBestCell(From, 500.0f, 0.0f, 0.3f, Position));
+        REQUIRE(Map.FindBestCell(From, 500.0f, 0.0f, 0.1f, Position));
+        CHECK(Position == CellCenter(9, 8));
+    }
+
+    SECTION("a position off the map finds nothing")
+    {
+        Map.Add(EInfluenceLayer::PlayerHeat, CellCenter(0, 0), 1.0f);
+        CHECK_FALSE(Map.FindBestCell(FVector2f(-500.0f, -500.0f), 1000.0f, 0.0f, 0.0f, Position));
+    }
+}
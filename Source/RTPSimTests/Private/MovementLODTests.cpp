@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementLOD.h"
+#include "TestHarness.h"
+
+namespace
+{
+    EEnemyMovementLOD Select(float Distance, bool bInCombat, bool bIsIdle, EEnemyMovementLOD Current)
+    {
+        return FMovementLODPolicy::Select(FMovementLODSettings(), FMath::Square(Distance), bInCombat, bIsIdle, Current);
+    }
+}
+
+TEST_CASE("RTPSim::MovementLOD::Tier thresholds", "[RTPSim][MovementLOD]")
+{
+    CHECK(Select(0.0f, false, true, EEnemyMovementLOD::Full) == EEnemyMovementLOD::Full);
+    CHECK(Select(2500.0f, false, true, EEnemyMovementLOD::Full) == EEnemyMovementLOD::Full);
+    CHECK(Select(2501.0f, false, true, EEnemyMovementLOD::Full) == EEnemyMovementLOD::Reduced);
+    CHECK(Select(5000.0f, false, true, EEnemyMovementLOD::Full) == EEnemyMovementLOD::Reduced);
+    CHECK(Select(5001.0f, false, true, EEnemyMovementLOD::Full) == EEnemyMovementLOD::Dormant);
+}
+
+TEST_CASE("RTPSim::MovementLOD::Hysteresis", "[RTPSim][MovementLOD]")
+{
+    SECTION("a reduced enemy returns to full only well inside the threshold")
+    {
+        CHECK(Select(2400.0f, false, false, EEnemyMovementLOD::Reduced) == EEnemyMovementLOD::Reduced);
+        CHECK(Select(2201.0f, false, false, EEnemyMovementLOD::Reduced) == EEnemyMovementLOD::Reduced);
+        CHECK(Select(2200.0f, false, false, EEnemyMovementLOD::Reduced) == EEnemyMovementLOD::Full);
+    }
+
+    SECTION("a dormant enemy wakes to reduced, not full")
+    {
+        CHECK(Select(4800.0f, false, true, EEnemyMovementLOD::Dormant) == EEnemyMovementLOD::Dormant);
+        CHECK(Select(4700.0f, false, true, EEnemyMovementLOD::Dormant) == EEnemyMovementLOD::Reduced);
+        CHECK(Select(2300.0f, false, true, EEnemyMovementLOD::Dormant) == EEnemyMovementLOD::Reduced);
+        CHECK(Select(2100.0f, false, true, EEnemyMovementLOD::Dormant) == EEnemyMovementLOD::Full);
+    }
+
+    SECTION("an enemy jittering around the threshold switches once")
+    {
+        EEnemyMovementLOD Current = EEnemyMovementLOD::Full;
+        int32 Switches = 0;
+        for (int32 Frame = 0; Frame < 1000; ++Frame)
+        {
+            // Within the hysteresis band after the first crossing
+            const float Distance = Frame == 0 ? 2600.0f : 2350.0f + 140.0f * FMath::Sin(Frame * 0.37f);
+            const EEnemyMovementLOD Selected = Select(Distance, false, false, Current);
+            Switches += Selected != Current;
+            Current = Selected;
+        }
+        CHECK(Switches == 1);
+        CHECK(Current == EEnemyMovementLOD::Reduced);
+    }
+}
+
+TEST_CASE("RTPSim::MovementLOD::Combat always runs full movement", "[RTPSim][MovementLOD]")
+{
+    const EEnemyMovementLOD Tiers[] = { EEnemyMovementLOD::Full, EEnemyMovementLOD::Reduced, EEnemyMovementLOD::Dormant };
+    for (const EEnemyMovementLOD Current : Tiers)
+    {
+        CHECK(Select(100000.0f, true, false, Current) == EEnemyMovementLOD::Full);
+        CHECK(Select(100000.0f, true, true, Current) == EEnemyMovementLOD::Full);
+    }
+}
+
+TEST_CASE("RTPSim::MovementLOD::Only idle enemies go dormant", "[RTPSim][MovementLOD]")
+{
+    CHECK(Select(100000.0f, false, false, EEnemyMovementLOD::Full) == EEnemyMovementLOD::Reduced);
+    CHECK(Select(100000.0f, false, true, EEnemyMovementLOD::Full) == EEnemyMovementLOD::Dormant);
+
+    // A dormant enemy that stops idling wakes up even far away
+    CHECK(Select(100000.0f, false, false, EEnemyMovementLOD::Dormant) == EEnemyMovementLOD::Reduced);
+}
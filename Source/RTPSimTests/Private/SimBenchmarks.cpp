@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemySim.h"
+#include "FlashlightSim.h"
+#include "ResourceSim.h"
+#include "StaminaSim.h"
+#include "TestHarness.h"
+
+THIRD_PARTY_INCLUDES_START
+#include <catch2/benchmark/catch_benchmark.hpp>
+THIRD_PARTY_INCLUDES_END
+
+// Times the engine-independent gameplay rules on the calling thread.
+// The cases are hidden, run them with the [benchmark] tag.
+
+namespace
+{
+    // Updates timed per benchmark run
+    constexpr int32 BenchmarkUpdates = 1000000;
+
+    // Distinct enemies cycled through by the enemy benchmark, enough to defeat branch prediction on a fixed pattern
+    constexpr int32 NumBenchmarkEnemies = 4096;
+}
+
+TEST_CASE("RTPSim::Benchmark::Enemy decide", "[RTPSim][.benchmark]")
+{
+    FRandomStream SetupStream(42);
+    TArray<FEnemySimInput> Inputs;
+    TArray<FRandomStream> Streams;
+    Inputs.SetNum(NumBenchmarkEnemies);
+    Streams.SetNum(NumBenchmarkEnemies);
+
+    for (int32 Index = 0; Index < NumBenchmarkEnemies; ++Index)
+    {
+        FEnemySimInput& Input = Inputs[Index];
+        Input.State = static_cast<EEnemySimState>(SetupStream.RandRange(0, static_cast<int32>(EEnemySimState::Dead)));
+        Input.bIsDead = Input.State == EEnemySimState::Dead;
+        Input.bHasPlayer = true;
+        Input.bAttackOnCooldown = SetupStream.FRand() < 0.5f;
+        Input.Location = FVector(SetupStream.FRandRange(-5000.0f, 5000.0f), SetupStream.FRandRange(-5000.0f, 5000.0f), 0.0f);
+        Input.LastKnownPlayerLocation = Input.Location + FVector(SetupStream.FRandRange(-200.0f, 200.0f), 0.0f, 0.0f);
+        Streams[Index].Initialize(Index + 1);
+    }
+
+    BENCHMARK("Enemy")
+    {
+        int32 NumDecisions = 0;
+        for (int32 Update = 0; Update < BenchmarkUpdates; ++Update)
+        {
+            const int32 Index = Update % NumBenchmarkEnemies;
+
+            // Stand-in for the sight trace, which is not part of the rules being measured
+            FEnemyDecision Decision;
+            FEnemySim::Decide(Inputs[Index], [Update]() { return (Update & 3) != 0; }, Streams[Index], Decision);
+            NumDecisions += Decision.bAttack + Decision.bMoveToPlayer + Decision.bMoveToLastKnownLocation + Decision.bResumeChase;
+        }
+        return NumDecisions;
+    };
+}
+
+TEST_CASE("RTPSim::Benchmark::Stamina step", "[RTPSim][.benchmark]")
+{
+    const FStaminaParams Params;
+
+    BENCHMARK("Stamina")
+    {
+        FStaminaState State;
+        for (int32 Update = 0; Update < BenchmarkUpdates; ++Update)
+        {
+            // Hold sprint for 5 seconds out of every 8 at 60 Hz
+            FStaminaSim::Step(State, Params, Update % 480 < 300, 1.0f / 60.0f);
+        }
+        return State.Stamina;
+    };
+}
+
+TEST_CASE("RTPSim::Benchmark::Flashlight battery scale", "[RTPSim][.benchmark]")
+{
+    const FFlashlightBatteryParams Params;
+    TArray<float> Timeline;
+    FFlashlightSim::BuildFlickerTimeline(1337, 256, Timeline);
+
+    BENCHMARK("Flashlight")
+    {
+        double Sum = 0.0;
+        for (int32 Update = 0; Update < BenchmarkUpdates; ++Update)
+        {
+            // Battery sweeping through the dimming and flicker range
+            const float BatteryLife = 30.0f * (1.0f - static_cast<float>(Update % 10000) / 10000.0f);
+            Sum += FFlashlightSim::EvaluateBatteryScale(Params, Timeline, BatteryLife, Update / 60.0f);
+        }
+        return Sum;
+    };
+}
+
+TEST_CASE("RTPSim::Benchmark::Resource line", "[RTPSim][.benchmark]")
+{
+    FResourceParams Params;
+    Params.RegenRate = 5.0f;
+    Params.RegenDelay = 2.0f;
+    FResourceLine Line;
+    Line.AnchorValue = 60.0f;
+    Line.DrainRate = 1.0f;
+    const float Thresholds[] = { 20.0f, 50.0f };
+
+    BENCHMARK("Resource")
+    {
+        double Sum = 0.0;
+        for (int32 Update = 0; Update < BenchmarkUpdates; ++Update)
+        {
+            const double Now = (Update % 3600) / 60.0;
+            Sum += FResourceSim::GetValueAtTime(Params, Line, Now);
+            Sum += FResourceSim::ComputeNextEventTime(Params, Line, Now, Thresholds, 1.0f, false) - Now;
+        }
+        return Sum;
+    };
+}
@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StaminaSim.h"
+#include "TestHarness.h"
+
+namespace
+{
+    // Client move as USprintMovementComponent saves it: the sprint request as input and the stamina state at its start
+    struct FStaminaMove
+    {
+        bool bWantsToSprint = false;
+        float DeltaSeconds = 0.0f;
+        FStaminaState Start;
+        FStaminaState End;
+    };
+
+    bool IsSameState(const FStaminaState& A, const FStaminaState& B)
+    {
+        return A.bIsSprinting == B.bIsSprinting && A.Stamina == B.Stamina && A.RegenDelayRemaining == B.RegenDelayRemaining;
+    }
+
+    // Sprint held and released in long enough stretches to run stamina dry and wait out the regen delay
+    TArray<FStaminaMove> MakeInput(int32 Seed, int32 NumMoves)
+    {
+        FRandomStream Stream(Seed);
+        TArray<FStaminaMove> Moves;
+        bool bWantsToSprint = false;
+        int32 HoldRemaining = 0;
+        for (int32 Index = 0; Index < NumMoves; ++Index)
+        {
+            if (HoldRemaining-- <= 0)
+            {
+                bWantsToSprint = !bWantsToSprint;
+                HoldRemaining = Stream.RandRange(10, bWantsToSprint ? 900 : 300);
+            }
+
+            FStaminaMove& Move = Moves.AddDefaulted_GetRef();
+            Move.bWantsToSprint = bWantsToSprint;
+
+            // Client frame rates vary from move to move
+            Move.DeltaSeconds = 1.0f / Stream.FRandRange(30.0f, 144.0f);
+        }
+        return Moves;
+    }
+
+    // Combine consecutive moves the way FSavedMove_Sprint::CanCombineWith allows: same request, same starting sprint state
+    TArray<FStaminaMove> CombineMoves(const TArray<FStaminaMove>& Moves, const FStaminaParams& Params, FStaminaState State)
+    {
+        TArray<FStaminaMove> Combined;
+        for (const FStaminaMove& Move : Moves)
+        {
+            FStaminaMove* Pending = Combined.Num() > 0 ? &Combined.Last() : nullptr;
+            if (Pending && Pending->bWantsToSprint == Move.bWantsToSprint && Pending->Start.bIsSprinting == State.bIsSprinting)
+            {
+                // Replay the combined move from the older move's start
+                Pending->DeltaSeconds += Move.DeltaSeconds;
+                State = Pending->Start;
+                FStaminaSim::Step(State, Params, Pending->bWantsToSprint, Pending->DeltaSeconds);
+                Pending->End = State;
+                continue;
+            }
+
+            FStaminaMove& NewMove = Combined.Add_GetRef(Move);
+            NewMove.Start = State;
+            FStaminaSim::Step(State, Params, NewMove.bWantsToSprint, NewMove.DeltaSeconds);
+            NewMove.End = State;
+        }
+        return Combined;
+    }
+
+    // Predict every move on the client, saving its start and end state
+    FStaminaState Predict(TArray<FStaminaMove>& Moves, const FStaminaParams& Params, FStaminaState State)
+    {
+        for (FStaminaMove& Move : Moves)
+        {
+            Move.Start = State;
+            FStaminaSim::Step(State, Params, Move.bWantsToSprint, Move.DeltaSeconds);
+            Move.End = State;
+        }
+        return State;
+    }
+}
+
+TEST_CASE("RTPSim::StaminaPrediction::The server agrees with the client's prediction", "[RTPSim][StaminaPrediction]")
+{
+    const FStaminaParams Params;
+    TArray<FStaminaMove> Moves = MakeInput(31, 4000);
+    Predict(Moves, Params, FStaminaState());
+
+    // The server runs the same moves as they arrive, some frames behind the client
+    constexpr int32 LatencyMoves = 12;
+    FStaminaState ServerState;
+    int32 NumMismatches = 0;
+    for (int32 ClientFrame = 0; ClientFrame < Moves.Num() + LatencyMoves; ++ClientFrame)
+    {
+        const int32 Arrived = ClientFrame - LatencyMoves;
+        if (Arrived >= 0)
+        {
+            FStaminaSim::Step(ServerState, Params, Moves[Arrived].bWantsToSprint, Moves[Arrived].DeltaSeconds);
+            NumMismatches += !IsSameState(ServerState, Moves[Arrived].End);
+        }
+    }
+    CHECK(NumMismatches == 0);
+
+    // The input actually covered exhaustion and recovery
+    bool bExhausted = false;
+    bool bRecovered = false;
+    for (const FStaminaMove& Move : Moves)
+    {
+        bExhausted |= Move.End.RegenDelayRemaining > 0.0f;
+        bRecovered |= bExhausted && Move.End.Stamina == Params.MaxStamina;
+    }
+    CHECK(bExhausted);
+    CHECK(bRecovered);
+}
+
+TEST_CASE("RTPSim::StaminaPrediction::Combined moves replay to the same state on both ends", "[RTPSim][StaminaPrediction]")
+{
+    const FStaminaParams Params;
+    const TArray<FStaminaMove> Moves = CombineMoves(MakeInput(32, 4000), Params, FStaminaState());
+    REQUIRE(Moves.Num() > 0);
+
+    FStaminaState ServerState;
+    for (const FStaminaMove& Move : Moves)
+    {
+        REQUIRE(IsSameState(ServerState, Move.Start));
+        FStaminaSim::Step(ServerState, Params, Move.bWantsToSprint, Move.DeltaSeconds);
+        REQUIRE(IsSameState(ServerState, Move.End));
+    }
+}
+
+TEST_CASE("RTPSim::StaminaPrediction::Replaying pending moves after an ack reproduces the prediction", "[RTPSim][StaminaPrediction]")
+{
+    const FStaminaParams Params;
+    TArray<FStaminaMove> Moves = MakeInput(33, 2000);
+    const FStaminaState Predicted = Predict(Moves, Params, FStaminaState());
+
+    // The server acks move by move, the client rewinds to each acked state and replays the moves still in flight
+    for (int32 Acked = 0; Acked < Moves.Num(); Acked += 97)
+    {
+        FStaminaState State = Moves[Acked].End;
+        for (int32 Pending = Acked + 1; Pending < Moves.Num(); ++Pending)
+        {
+            FStaminaSim::Step(State, Params, Moves[Pending].bWantsToSprint, Moves[Pending].DeltaSeconds);
+        }
+        REQUIRE(IsSameState(State, Predicted));
+    }
+}
+
+TEST_CASE("RTPSim::StaminaPrediction::A correction converges on the server's state", "[RTPSim][StaminaPrediction]")
+{
+    const FStaminaParams Params;
+    TArray<FStaminaMove> ClientMoves = MakeInput(34, 2000);
+
+    // The server drained stamina the client does not know about, e.g. a gameplay effect before the first move
+    FStaminaState ServerStart;
+    ServerStart.Stamina = 35.0f;
+    TArray<FStaminaMove> ServerMoves = ClientMoves;
+    const FStaminaState ServerFinal = Predict(ServerMoves, Params, ServerStart);
+    Predict(ClientMoves, Params, FStaminaState());
+
+    // Find the first move the server rejects and correct the client there, as ClientAdjustPosition does
+    int32 Corrected = INDEX_NONE;
+    for (int32 Index = 0; Index < ClientMoves.Num(); ++Index)
+    {
+        if (!IsSameState(ClientMoves[Index].End, ServerMoves[Index].End))
+        {
+            Corrected = Index;
+            break;
+        }
+    }
+    REQUIRE(Corrected != INDEX_NONE);
+
+    FStaminaState State = ServerMoves[Corrected].End;
+    for (int32 Pending = Corrected + 1; Pending < ClientMoves.Num(); ++Pending)
+    {
+        FStaminaSim::Step(State, Params, ClientMoves[Pending].bWantsToSprint, ClientMoves[Pending].DeltaSeconds);
+    }
+    CHECK(IsSameState(State, ServerFinal));
+}
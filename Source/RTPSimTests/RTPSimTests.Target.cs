@@ -0,0 +1,20 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+// Low Level Tests and microbenchmarks for RTPSim, a plain executable that starts neither the engine nor the editor.
+// Build with RunUBT RTPSimTests <Platform> Development -Project=RTP.uproject, then run Binaries/<Platform>/RTPSimTests/RTPSimTests.
+// Benchmarks are hidden from a plain run, select them with the [benchmark] tag.
+public class RTPSimTestsTarget : TestTargetRules
+{
+	public RTPSimTestsTarget(TargetInfo Target) : base(Target)
+	{
+		DefaultBuildSettings = BuildSettingsVersion.V5;
+		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_5;
+
+		bCompileAgainstEngine = false;
+		bCompileAgainstCoreUObject = false;
+		bCompileAgainstApplicationCore = false;
+	}
+}